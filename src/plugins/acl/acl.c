@@ -2580,6 +2580,25 @@ acl_set_aclplugin_fn (vlib_main_t * vm,
       am->use_hash_acl_matching = (val != 0);
       goto done;
     }
+  if (unformat (input, "lookup-context %u classifier", &val))
+    {
+      acl_lc_classifier_t classifier;
+
+      if (unformat (input, "bitmap"))
+	classifier = ACL_LC_CLASSIFIER_BITMAP;
+      else if (unformat (input, "default"))
+	classifier = ACL_LC_CLASSIFIER_DEFAULT;
+      else
+	{
+	  error = clib_error_return (0,
+				     "expecting bitmap or default, got `%U`",
+				     format_unformat_error, input);
+	  goto done;
+	}
+      if (acl_plugin_set_lookup_context_classifier (val, classifier))
+	error = clib_error_return (0, "invalid lookup context %u", val);
+      goto done;
+    }
   if (unformat (input, "l4-match-nonfirst-fragment %u", &val))
     {
       am->l4_match_nonfirst_fragment = (val != 0);
@@ -32,6 +32,7 @@
 #include "types.h"
 #include "fa_node.h"
 #include "hash_lookup_types.h"
+#include "bitmap_lookup_types.h"
 #include "lookup_context.h"
 
 #define  ACL_PLUGIN_VERSION_MAJOR 1
@@ -189,6 +190,11 @@ typedef struct {
   /* vec of vectors of all info of all mask types present in ACEs contained in each lc_index */
   hash_applied_mask_info_t **hash_applied_mask_info_vec_by_lc_index;
 
+  /* bitmap classifiers of the lookup contexts using one, NULL otherwise */
+  acl_bm_classifier_t **bm_classifier_by_lc_index;
+  /* lookup contexts whose bitmap classifier is waiting to be built */
+  uword *bm_lc_pending;
+
   /*
    * Classify tables used to grab the packets for the ACL check,
    * and serving as the 5-tuple session tables at the same time
@@ -0,0 +1,783 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2024 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <vlib/vlib.h>
+#include <vppinfra/random.h>
+#include <acl/acl.h>
+
+#include "bitmap_lookup.h"
+#include "public_inlines.h"
+
+static int
+acl_bm_u64_cmp (void *a1, void *a2)
+{
+  u64 *v1 = a1, *v2 = a2;
+
+  return (*v1 > *v2) - (*v1 < *v2);
+}
+
+/* index of the point equal to v in a sorted vector of unique points */
+static u32
+acl_bm_find_point (u64 * points, u64 v)
+{
+  u32 lo = 0, hi = vec_len (points);
+
+  while (hi - lo > 1)
+    {
+      u32 mid = (lo + hi) / 2;
+      if (points[mid] <= v)
+	lo = mid;
+      else
+	hi = mid;
+    }
+  ASSERT (points[lo] == v);
+  return lo;
+}
+
+static void
+acl_bm_prefix_range (u64 v, int len, int width, u64 * lo, u64 * hi)
+{
+  u64 max = (width == 64) ? ~0ULL : (1ULL << width) - 1;
+  u64 mask = len ? (max << (width - len)) & max : 0;
+
+  *lo = v & mask;
+  *hi = *lo | (max & ~mask);
+}
+
+static u64
+acl_bm_dim_max (int is_ip6, int d)
+{
+  if (is_ip6)
+    {
+      switch (d)
+	{
+	case ACL_BM_DIM_IP6_PROTO:
+	  return 0xff;
+	case ACL_BM_DIM_IP6_SPORT:
+	case ACL_BM_DIM_IP6_DPORT:
+	  return 0xffff;
+	default:
+	  return ~0ULL;
+	}
+    }
+  switch (d)
+    {
+    case ACL_BM_DIM_IP4_PROTO:
+      return 0xff;
+    case ACL_BM_DIM_IP4_SPORT:
+    case ACL_BM_DIM_IP4_DPORT:
+      return 0xffff;
+    default:
+      return 0xffffffff;
+    }
+}
+
+/*
+ * The range of a rule in each dimension. Returns 0 if the rule can never
+ * match, for an inverted port range.
+ */
+static int
+acl_bm_rule_ranges (acl_rule_t * r, int is_ip6, u64 * lo, u64 * hi)
+{
+  int proto_dim, sport_dim, dport_dim;
+
+  if (is_ip6)
+    {
+      int i, p;
+      ip6_address_t *a[2] = { &r->src.ip6, &r->dst.ip6 };
+      u8 len[2] = { r->src_prefixlen, r->dst_prefixlen };
+
+      for (i = 0; i < 2; i++)
+	{
+	  p = clib_min (len[i], 128);
+	  acl_bm_prefix_range (clib_net_to_host_u64 (a[i]->as_u64[0]),
+			       clib_min (p, 64), 64, &lo[2 * i], &hi[2 * i]);
+	  acl_bm_prefix_range (clib_net_to_host_u64 (a[i]->as_u64[1]),
+			       p > 64 ? p - 64 : 0, 64, &lo[2 * i + 1],
+			       &hi[2 * i + 1]);
+	}
+      proto_dim = ACL_BM_DIM_IP6_PROTO;
+      sport_dim = ACL_BM_DIM_IP6_SPORT;
+      dport_dim = ACL_BM_DIM_IP6_DPORT;
+    }
+  else
+    {
+      acl_bm_prefix_range (clib_net_to_host_u32 (r->src.ip4.as_u32),
+			   clib_min (r->src_prefixlen, 32), 32,
+			   &lo[ACL_BM_DIM_IP4_SRC], &hi[ACL_BM_DIM_IP4_SRC]);
+      acl_bm_prefix_range (clib_net_to_host_u32 (r->dst.ip4.as_u32),
+			   clib_min (r->dst_prefixlen, 32), 32,
+			   &lo[ACL_BM_DIM_IP4_DST], &hi[ACL_BM_DIM_IP4_DST]);
+      proto_dim = ACL_BM_DIM_IP4_PROTO;
+      sport_dim = ACL_BM_DIM_IP4_SPORT;
+      dport_dim = ACL_BM_DIM_IP4_DPORT;
+    }
+
+  if (r->proto)
+    {
+      if (r->src_port_or_type_first > r->src_port_or_type_last ||
+	  r->dst_port_or_code_first > r->dst_port_or_code_last)
+	return 0;
+      lo[proto_dim] = hi[proto_dim] = r->proto;
+      lo[sport_dim] = r->src_port_or_type_first;
+      hi[sport_dim] = r->src_port_or_type_last;
+      lo[dport_dim] = r->dst_port_or_code_first;
+      hi[dport_dim] = r->dst_port_or_code_last;
+    }
+  else
+    {
+      /* the ports are not looked at */
+      lo[proto_dim] = lo[sport_dim] = lo[dport_dim] = 0;
+      hi[proto_dim] = 0xff;
+      hi[sport_dim] = hi[dport_dim] = 0xffff;
+    }
+  return 1;
+}
+
+/* add a bitmap to the dimension, or find an identical one */
+static u32
+acl_bm_dim_add_bitmap (acl_bm_set_t * set, acl_bm_dim_t * dim, u64 * words,
+		       uword ** seen)
+{
+  u32 n_words = set->n_words;
+  u32 n_summary_words = set->n_summary_words;
+  uword digest = hash_memory (words, n_words * sizeof (u64), 0);
+  uword *p = hash_get (*seen, digest);
+  u64 *summary;
+  u32 bi, w;
+
+  if (p && !memcmp (dim->bitmaps + p[0] * n_words, words,
+		    n_words * sizeof (u64)))
+    return p[0];
+
+  bi = vec_len (dim->bitmaps) / n_words;
+  vec_add (dim->bitmaps, words, n_words);
+  vec_add2 (dim->summaries, summary, n_summary_words);
+  clib_memset (summary, 0, n_summary_words * sizeof (u64));
+  for (w = 0; w < n_words; w++)
+    if (words[w])
+      summary[w / 64] |= 1ULL << (w % 64);
+
+  /* on a digest collision the new bitmap just does not get shared */
+  if (!p)
+    hash_set (*seen, digest, bi);
+  return bi;
+}
+
+/*
+ * Cut a dimension into elementary intervals and sweep over them, keeping
+ * the bitmap of the rules covering the current one. Adjacent intervals
+ * with the same bitmap are merged and identical bitmaps are stored once.
+ */
+static void
+acl_bm_dim_build (acl_bm_set_t * set, acl_bm_dim_t * dim, u64 * lo,
+		  u64 * hi, u64 max)
+{
+  u32 n_rules = vec_len (lo);
+  u32 n_words = set->n_words;
+  u64 *points = 0, *cur = 0;
+  u32 *n_starts = 0, *n_ends = 0, *starts = 0, *ends = 0, *start_at = 0,
+    *end_at = 0;
+  uword *seen = hash_create (0, sizeof (uword));
+  u32 i, j, n_points, prev_bi = ~0;
+
+  vec_add1 (points, 0);
+  for (i = 0; i < n_rules; i++)
+    {
+      vec_add1 (points, lo[i]);
+      if (hi[i] < max)
+	vec_add1 (points, hi[i] + 1);
+    }
+  vec_sort_with_function (points, acl_bm_u64_cmp);
+  for (i = 1, j = 1; i < vec_len (points); i++)
+    if (points[i] != points[j - 1])
+      points[j++] = points[i];
+  vec_set_len (points, j);
+  n_points = j;
+
+  /* the rules starting and ending at each point, bucketed by point */
+  vec_validate_init_empty (n_starts, n_points, 0);
+  vec_validate_init_empty (n_ends, n_points, 0);
+  vec_validate (start_at, n_rules - 1);
+  vec_validate (end_at, n_rules - 1);
+  for (i = 0; i < n_rules; i++)
+    {
+      start_at[i] = acl_bm_find_point (points, lo[i]);
+      end_at[i] =
+	(hi[i] < max) ? acl_bm_find_point (points, hi[i] + 1) : n_points;
+      n_starts[start_at[i]]++;
+      n_ends[end_at[i]]++;
+    }
+  for (i = 0, j = 0; i <= n_points; i++)
+    {
+      u32 n = n_starts[i];
+      n_starts[i] = j;
+      j += n;
+    }
+  for (i = 0, j = 0; i <= n_points; i++)
+    {
+      u32 n = n_ends[i];
+      n_ends[i] = j;
+      j += n;
+    }
+  vec_validate (starts, n_rules - 1);
+  vec_validate (ends, n_rules - 1);
+  /* bucket the rules in increasing order, then walk each bucket backwards */
+  for (i = 0; i < n_rules; i++)
+    starts[n_starts[start_at[i]]++] = i;
+  for (i = 0; i < n_rules; i++)
+    ends[n_ends[end_at[i]]++] = i;
+
+  vec_validate (cur, n_words - 1);
+  for (i = 0; i < n_points; i++)
+    {
+      u32 k, bi;
+
+      /* n_starts[i] is now the end of the bucket of point i */
+      for (k = i ? n_ends[i - 1] : 0; k < n_ends[i]; k++)
+	cur[ends[k] / 64] &= ~(1ULL << (ends[k] % 64));
+      for (k = i ? n_starts[i - 1] : 0; k < n_starts[i]; k++)
+	cur[starts[k] / 64] |= 1ULL << (starts[k] % 64);
+
+      if (prev_bi != ~0 && !memcmp (dim->bitmaps + prev_bi * n_words, cur,
+				    n_words * sizeof (u64)))
+	continue;
+
+      bi = acl_bm_dim_add_bitmap (set, dim, cur, &seen);
+      vec_add1 (dim->bounds, points[i]);
+      vec_add1 (dim->bitmap_by_interval, bi);
+      prev_bi = bi;
+    }
+
+  hash_free (seen);
+  vec_free (points);
+  vec_free (cur);
+  vec_free (n_starts);
+  vec_free (n_ends);
+  vec_free (starts);
+  vec_free (ends);
+  vec_free (start_at);
+  vec_free (end_at);
+}
+
+static void
+acl_bm_set_build (acl_bm_set_t * set, acl_bm_build_rule_t * brs, int is_ip6)
+{
+  int n_dims = is_ip6 ? ACL_BM_N_DIMS_IP6 : ACL_BM_N_DIMS_IP4;
+  u64 *lo[ACL_BM_MAX_DIMS] = { 0 }, *hi[ACL_BM_MAX_DIMS] = { 0 };
+  acl_bm_build_rule_t *br;
+  int d;
+
+  vec_foreach (br, brs)
+  {
+    u64 rlo[ACL_BM_MAX_DIMS], rhi[ACL_BM_MAX_DIMS];
+    acl_bm_rule_t *bmr;
+
+    if ((br->rule->is_ipv6 != 0) != is_ip6)
+      continue;
+    if (!acl_bm_rule_ranges (br->rule, is_ip6, rlo, rhi))
+      continue;
+
+    for (d = 0; d < n_dims; d++)
+      {
+	vec_add1 (lo[d], rlo[d]);
+	vec_add1 (hi[d], rhi[d]);
+      }
+    vec_add2 (set->rules, bmr, 1);
+    bmr->acl_index = br->acl_index;
+    bmr->ace_index = br->ace_index;
+    bmr->acl_position = br->acl_position;
+    bmr->action = br->rule->is_permit;
+    bmr->proto = br->rule->proto;
+    bmr->tcp_flags_value = br->rule->tcp_flags_value;
+    bmr->tcp_flags_mask = br->rule->tcp_flags_mask;
+  }
+
+  if (vec_len (set->rules))
+    {
+      set->n_words = round_pow2 (vec_len (set->rules), 64) / 64;
+      set->n_summary_words = round_pow2 (set->n_words, 64) / 64;
+      for (d = 0; d < n_dims; d++)
+	acl_bm_dim_build (set, &set->dims[d], lo[d], hi[d],
+			  acl_bm_dim_max (is_ip6, d));
+    }
+
+  for (d = 0; d < n_dims; d++)
+    {
+      vec_free (lo[d]);
+      vec_free (hi[d]);
+    }
+}
+
+acl_bm_classifier_t *
+acl_bm_classifier_build (acl_bm_build_rule_t * brs)
+{
+  acl_bm_classifier_t *bmc;
+
+  bmc = clib_mem_alloc (sizeof (*bmc));
+  clib_memset (bmc, 0, sizeof (*bmc));
+  acl_bm_set_build (&bmc->sets[0], brs, 0);
+  acl_bm_set_build (&bmc->sets[1], brs, 1);
+  return bmc;
+}
+
+void
+acl_bm_classifier_free (acl_bm_classifier_t * bmc)
+{
+  int i, d;
+
+  if (!bmc)
+    return;
+  for (i = 0; i < ARRAY_LEN (bmc->sets); i++)
+    {
+      acl_bm_set_t *set = &bmc->sets[i];
+      vec_free (set->rules);
+      for (d = 0; d < ACL_BM_MAX_DIMS; d++)
+	{
+	  vec_free (set->dims[d].bounds);
+	  vec_free (set->dims[d].bitmap_by_interval);
+	  vec_free (set->dims[d].bitmaps);
+	  vec_free (set->dims[d].summaries);
+	}
+    }
+  clib_mem_free (bmc);
+}
+
+static vlib_node_registration_t acl_bm_build_process_node;
+
+static acl_bm_classifier_t *
+acl_bm_lc_build (acl_main_t * am, acl_lookup_context_t * acontext)
+{
+  acl_bm_build_rule_t *brs = 0, *br;
+  acl_bm_classifier_t *bmc;
+  u32 i, j;
+
+  for (i = 0; i < vec_len (acontext->acl_indices); i++)
+    {
+      u32 acl_index = acontext->acl_indices[i];
+      acl_list_t *acl;
+
+      /* a missing ACL matches nothing, as with the linear matching */
+      if (pool_is_free_index (am->acls, acl_index))
+	continue;
+      acl = pool_elt_at_index (am->acls, acl_index);
+      for (j = 0; j < vec_len (acl->rules); j++)
+	{
+	  vec_add2 (brs, br, 1);
+	  br->rule = &acl->rules[j];
+	  br->acl_index = acl_index;
+	  br->ace_index = j;
+	  br->acl_position = i;
+	}
+    }
+  bmc = acl_bm_classifier_build (brs);
+  vec_free (brs);
+  return bmc;
+}
+
+void
+acl_bm_lc_update (acl_main_t * am, u32 lc_index)
+{
+  acl_lookup_context_t *acontext =
+    pool_elt_at_index (am->acl_lookup_contexts, lc_index);
+  acl_bm_classifier_t *old;
+
+  /*
+   * Updates run with the workers stopped, so the stale classifier can go
+   * at once; the context uses the default matching until the new one is
+   * published.
+   */
+  vec_validate (am->bm_classifier_by_lc_index, lc_index);
+  old = am->bm_classifier_by_lc_index[lc_index];
+  am->bm_classifier_by_lc_index[lc_index] = 0;
+  acl_bm_classifier_free (old);
+
+  if (acontext->classifier == ACL_LC_CLASSIFIER_BITMAP)
+    {
+      am->bm_lc_pending = clib_bitmap_set (am->bm_lc_pending, lc_index, 1);
+      vlib_process_signal_event (am->vlib_main,
+				 acl_bm_build_process_node.index, 0, 0);
+    }
+  else
+    am->bm_lc_pending = clib_bitmap_set (am->bm_lc_pending, lc_index, 0);
+}
+
+int
+acl_bm_lc_is_pending (acl_main_t * am, u32 lc_index)
+{
+  return clib_bitmap_get (am->bm_lc_pending, lc_index);
+}
+
+/*
+ * Builds the pending classifiers outside of the barrier. Only the main
+ * thread changes the ACLs and the process does not yield while it builds,
+ * so the rules stay put; the workers pick the classifier up once it is
+ * published.
+ */
+static uword
+acl_bm_build_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
+		      vlib_frame_t * f)
+{
+  acl_main_t *am = &acl_main;
+  acl_lookup_context_t *acontext;
+  acl_bm_classifier_t *bmc;
+  u32 lc_index;
+
+  while (1)
+    {
+      vlib_process_wait_for_event (vm);
+      vlib_process_get_events (vm, NULL);
+
+      clib_bitmap_foreach (lc_index, am->bm_lc_pending)
+	{
+	  if (pool_is_free_index (am->acl_lookup_contexts, lc_index))
+	    continue;
+	  acontext = pool_elt_at_index (am->acl_lookup_contexts, lc_index);
+	  if (acontext->classifier != ACL_LC_CLASSIFIER_BITMAP)
+	    continue;
+
+	  bmc = acl_bm_lc_build (am, acontext);
+	  ASSERT (0 == am->bm_classifier_by_lc_index[lc_index]);
+	  clib_atomic_store_rel_n (&am->bm_classifier_by_lc_index[lc_index],
+				   bmc);
+	}
+      clib_bitmap_zero (am->bm_lc_pending);
+    }
+  return 0;
+}
+
+VLIB_REGISTER_NODE (acl_bm_build_process_node, static) = {
+  .function = acl_bm_build_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "acl-plugin-bitmap-build-process",
+};
+
+static uword
+acl_bm_set_memory (acl_bm_set_t * set)
+{
+  uword bytes = vec_bytes (set->rules);
+  int d;
+
+  for (d = 0; d < ACL_BM_MAX_DIMS; d++)
+    bytes += vec_bytes (set->dims[d].bounds) +
+      vec_bytes (set->dims[d].bitmap_by_interval) +
+      vec_bytes (set->dims[d].bitmaps) + vec_bytes (set->dims[d].summaries);
+  return bytes;
+}
+
+u8 *
+format_acl_bm_classifier (u8 * s, va_list * args)
+{
+  acl_bm_classifier_t *bmc = va_arg (*args, acl_bm_classifier_t *);
+  static const char *ip4_dim_names[] = { "src", "dst", "proto", "sport",
+    "dport"
+  };
+  static const char *ip6_dim_names[] = { "src-hi", "src-lo", "dst-hi",
+    "dst-lo", "proto", "sport", "dport"
+  };
+  int is_ip6, d;
+
+  s = format (s, "memory %U", format_memory_size,
+	      acl_bm_set_memory (&bmc->sets[0]) +
+	      acl_bm_set_memory (&bmc->sets[1]));
+  for (is_ip6 = 0; is_ip6 < 2; is_ip6++)
+    {
+      acl_bm_set_t *set = &bmc->sets[is_ip6];
+      int n_dims = is_ip6 ? ACL_BM_N_DIMS_IP6 : ACL_BM_N_DIMS_IP4;
+
+      s = format (s, "\n    %s: %u rules", is_ip6 ? "ip6" : "ip4",
+		  vec_len (set->rules));
+      if (!vec_len (set->rules))
+	continue;
+      for (d = 0; d < n_dims; d++)
+	s = format (s, "\n      %s: %u intervals, %u bitmaps",
+		    is_ip6 ? ip6_dim_names[d] : ip4_dim_names[d],
+		    vec_len (set->dims[d].bounds),
+		    vec_len (set->dims[d].bitmaps) / set->n_words);
+    }
+  return s;
+}
+
+/*
+ * Benchmark against rule sets shaped like the ClassBench ACL seeds:
+ * prefixes of assorted lengths drawn around a few networks, mostly TCP
+ * and UDP, wildcard source ports, and a mix of exact, well-known and
+ * arbitrary range destination ports.
+ */
+
+static u32
+acl_bm_bench_prefixlen (u32 * seed, int is_src)
+{
+  u32 r = random_u32 (seed) % 100;
+
+  if (is_src)
+    return (r < 30) ? 0 : (r < 45) ? 8 + r % 9 : (r < 75) ? 17 + r % 8 : 32;
+  return (r < 5) ? 0 : (r < 25) ? 16 + r % 9 : (r < 45) ? 25 + r % 7 : 32;
+}
+
+static void
+acl_bm_bench_port_range (u32 * seed, int is_src, u16 * first, u16 * last)
+{
+  static const u16 well_known[] = { 22, 25, 53, 80, 110, 123, 143, 161,
+    443, 993, 1521, 3306, 5060, 8080
+  };
+  u32 r = random_u32 (seed) % 100;
+  u16 a, b;
+
+  if (is_src ? r < 80 : r < 25)
+    {
+      *first = 0;
+      *last = 65535;
+    }
+  else if (is_src ? r < 90 : r < 35)
+    {
+      *first = 1024;
+      *last = 65535;
+    }
+  else if (!is_src && r < 45)
+    {
+      *first = 0;
+      *last = 1023;
+    }
+  else if (!is_src && r < 85)
+    {
+      *first = *last = (r < 70) ?
+	well_known[random_u32 (seed) % ARRAY_LEN (well_known)] :
+	random_u32 (seed);
+    }
+  else
+    {
+      a = random_u32 (seed);
+      b = random_u32 (seed);
+      *first = clib_min (a, b);
+      *last = clib_max (a, b);
+    }
+}
+
+static void
+acl_bm_bench_make_rule (u32 * seed, u32 * networks, u32 n_networks,
+			acl_rule_t * r)
+{
+  u32 r100, len, addr, mask;
+  int i;
+
+  clib_memset (r, 0, sizeof (*r));
+  r->is_permit = random_u32 (seed) & 1;
+  for (i = 0; i < 2; i++)
+    {
+      len = acl_bm_bench_prefixlen (seed, i == 0);
+      addr = networks[random_u32 (seed) % n_networks] ^
+	(random_u32 (seed) & 0xffff);
+      mask = len ? ~0 << (32 - len) : 0;
+      if (i == 0)
+	{
+	  r->src.ip4.as_u32 = clib_host_to_net_u32 (addr & mask);
+	  r->src_prefixlen = len;
+	}
+      else
+	{
+	  r->dst.ip4.as_u32 = clib_host_to_net_u32 (addr & mask);
+	  r->dst_prefixlen = len;
+	}
+    }
+
+  r100 = random_u32 (seed) % 100;
+  r->proto = (r100 < 45) ? IP_PROTOCOL_TCP : (r100 < 80) ? IP_PROTOCOL_UDP :
+    (r100 < 88) ? IP_PROTOCOL_ICMP : 0;
+  if (r->proto == IP_PROTOCOL_TCP || r->proto == IP_PROTOCOL_UDP)
+    {
+      acl_bm_bench_port_range (seed, 1, &r->src_port_or_type_first,
+			       &r->src_port_or_type_last);
+      acl_bm_bench_port_range (seed, 0, &r->dst_port_or_code_first,
+			       &r->dst_port_or_code_last);
+    }
+  else if (r->proto == IP_PROTOCOL_ICMP)
+    {
+      r->src_port_or_type_first = r->src_port_or_type_last =
+	random_u32 (seed) % 16;
+      r->dst_port_or_code_last = 255;
+    }
+}
+
+static u32
+acl_bm_bench_in_range (u32 * seed, u32 lo, u32 hi)
+{
+  return lo + (u32) ((u64) random_u32 (seed) * ((u64) hi - lo + 1) >> 32);
+}
+
+/* a header matching a random rule, or now and then a random one */
+static void
+acl_bm_bench_make_packet (u32 * seed, acl_rule_t * rules, fa_5tuple_t * pkt)
+{
+  acl_rule_t *r = &rules[random_u32 (seed) % vec_len (rules)];
+  u64 lo[ACL_BM_MAX_DIMS], hi[ACL_BM_MAX_DIMS];
+  u32 src, dst;
+
+  clib_memset (pkt, 0, sizeof (*pkt));
+  pkt->pkt.l4_valid = 1;
+  if (random_u32 (seed) % 10 == 0)
+    {
+      pkt->ip4_addr[0].as_u32 = random_u32 (seed);
+      pkt->ip4_addr[1].as_u32 = random_u32 (seed);
+      pkt->l4.proto = IP_PROTOCOL_TCP;
+      pkt->l4.port[0] = random_u32 (seed);
+      pkt->l4.port[1] = random_u32 (seed);
+      return;
+    }
+
+  acl_bm_rule_ranges (r, 0, lo, hi);
+  src = acl_bm_bench_in_range (seed, lo[ACL_BM_DIM_IP4_SRC],
+			       hi[ACL_BM_DIM_IP4_SRC]);
+  dst = acl_bm_bench_in_range (seed, lo[ACL_BM_DIM_IP4_DST],
+			       hi[ACL_BM_DIM_IP4_DST]);
+  pkt->ip4_addr[0].as_u32 = clib_host_to_net_u32 (src);
+  pkt->ip4_addr[1].as_u32 = clib_host_to_net_u32 (dst);
+  pkt->l4.proto = r->proto ? r->proto : IP_PROTOCOL_UDP;
+  pkt->l4.port[0] = acl_bm_bench_in_range (seed, lo[ACL_BM_DIM_IP4_SPORT],
+					   hi[ACL_BM_DIM_IP4_SPORT]);
+  pkt->l4.port[1] = acl_bm_bench_in_range (seed, lo[ACL_BM_DIM_IP4_DPORT],
+					   hi[ACL_BM_DIM_IP4_DPORT]);
+}
+
+static clib_error_t *
+acl_bm_bench_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			 vlib_cli_command_t * cmd)
+{
+  u32 n_rules = 1000, n_packets = 100000, seed = 0xdeadbeef;
+  u32 networks[16], i, j, n_mismatches = 0, n_matches = 0;
+  acl_rule_t *rules = 0;
+  acl_bm_build_rule_t *brs = 0, *br;
+  acl_bm_classifier_t *bmc;
+  fa_5tuple_t *pkts = 0;
+  u32 *linear_result = 0, *bitmap_result = 0;
+  u64 t0, t1, t_build, t_linear, t_bitmap;
+  f64 ns_per_clock = 1e9 / vm->clib_time.clocks_per_second;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "rules %u", &n_rules))
+	;
+      else if (unformat (input, "packets %u", &n_packets))
+	;
+      else if (unformat (input, "seed %u", &seed))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+  if (!n_rules || !n_packets)
+    return clib_error_return (0, "need at least one rule and one packet");
+
+  for (i = 0; i < ARRAY_LEN (networks); i++)
+    networks[i] = random_u32 (&seed);
+
+  vec_validate (rules, n_rules - 1);
+  vec_validate (brs, n_rules - 1);
+  for (i = 0; i < n_rules; i++)
+    {
+      acl_bm_bench_make_rule (&seed, networks, ARRAY_LEN (networks),
+			      &rules[i]);
+      br = &brs[i];
+      br->rule = &rules[i];
+      br->acl_index = 0;
+      br->ace_index = i;
+      br->acl_position = 0;
+    }
+  /* the last rule catches everything, as in the ClassBench sets */
+  clib_memset (&rules[n_rules - 1], 0, sizeof (rules[0]));
+
+  vec_validate (pkts, n_packets - 1);
+  vec_validate (linear_result, n_packets - 1);
+  vec_validate (bitmap_result, n_packets - 1);
+  for (i = 0; i < n_packets; i++)
+    acl_bm_bench_make_packet (&seed, rules, &pkts[i]);
+
+  t0 = clib_cpu_time_now ();
+  bmc = acl_bm_classifier_build (brs);
+  t_build = clib_cpu_time_now () - t0;
+
+  t0 = clib_cpu_time_now ();
+  for (i = 0; i < n_packets; i++)
+    {
+      linear_result[i] = ~0;
+      for (j = 0; j < n_rules; j++)
+	if (single_rule_match_5tuple (&rules[j], 0, &pkts[i]))
+	  {
+	    linear_result[i] = j;
+	    break;
+	  }
+    }
+  t1 = clib_cpu_time_now ();
+  t_linear = t1 - t0;
+
+  t0 = clib_cpu_time_now ();
+  for (i = 0; i < n_packets; i++)
+    {
+      u64 key[ACL_BM_MAX_DIMS];
+      acl_bm_set_t *set = &bmc->sets[0];
+      u32 ri;
+
+      acl_bm_fill_key (&pkts[i], 0, key);
+      ri = acl_bm_set_match (set, key, ACL_BM_N_DIMS_IP4, &pkts[i]);
+      bitmap_result[i] = (ri == ~0) ? ~0 : set->rules[ri].ace_index;
+    }
+  t1 = clib_cpu_time_now ();
+  t_bitmap = t1 - t0;
+
+  for (i = 0; i < n_packets; i++)
+    {
+      n_mismatches += (linear_result[i] != bitmap_result[i]);
+      n_matches += (bitmap_result[i] != n_rules - 1);
+    }
+
+  vlib_cli_output (vm, "%u rules, %u packets, %u matching before the "
+		   "catch-all rule", n_rules, n_packets, n_matches);
+  vlib_cli_output (vm, "build: %.3f ms, %U", t_build * ns_per_clock / 1e6,
+		   format_acl_bm_classifier, bmc);
+  vlib_cli_output (vm, "linear: %.1f ns/lookup",
+		   t_linear * ns_per_clock / n_packets);
+  vlib_cli_output (vm, "bitmap: %.1f ns/lookup",
+		   t_bitmap * ns_per_clock / n_packets);
+  vlib_cli_output (vm, "mismatches: %u", n_mismatches);
+
+  acl_bm_classifier_free (bmc);
+  vec_free (rules);
+  vec_free (brs);
+  vec_free (pkts);
+  vec_free (linear_result);
+  vec_free (bitmap_result);
+
+  if (n_mismatches)
+    return clib_error_return (0, "%u lookups disagree with the linear "
+			      "matching", n_mismatches);
+  return 0;
+}
+
+/*?
+ * Builds the bitmap classifier over a generated ClassBench-like IPv4 rule
+ * set and times its lookups against the linear matching, checking that
+ * both find the same rule for every packet.
+ *
+ * @cliexpar
+ * @cliexcmd{test acl-plugin bitmap-classifier bench rules 10000 packets 100000}
+ ?*/
+VLIB_CLI_COMMAND (acl_bm_bench_command, static) = {
+  .path = "test acl-plugin bitmap-classifier bench",
+  .short_help = "test acl-plugin bitmap-classifier bench [rules <n>] "
+    "[packets <n>] [seed <n>]",
+  .function = acl_bm_bench_command_fn,
+};
@@ -0,0 +1,46 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2024 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#ifndef _ACL_BITMAP_LOOKUP_H_
+#define _ACL_BITMAP_LOOKUP_H_
+
+#include "acl.h"
+
+/* A rule to build the classifier from, in priority order */
+typedef struct {
+  acl_rule_t *rule;
+  u32 acl_index;
+  u32 ace_index;
+  u32 acl_position;
+} acl_bm_build_rule_t;
+
+acl_bm_classifier_t *acl_bm_classifier_build(acl_bm_build_rule_t *brs);
+void acl_bm_classifier_free(acl_bm_classifier_t *bmc);
+
+/*
+ * Drop the classifier of a lookup context after its ACLs, or their
+ * contents, changed and, if it uses the bitmap classifier, queue a rebuild.
+ * The rebuild runs in a process outside of the barrier and the result is
+ * swapped in; until then the context uses the default matching, so packets
+ * are never matched against a stale or half-built classifier.
+ */
+void acl_bm_lc_update(acl_main_t *am, u32 lc_index);
+int acl_bm_lc_is_pending(acl_main_t *am, u32 lc_index);
+
+format_function_t format_acl_bm_classifier;
+
+#endif
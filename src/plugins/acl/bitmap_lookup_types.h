@@ -0,0 +1,106 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2024 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#ifndef _ACL_BITMAP_LOOKUP_TYPES_H_
+#define _ACL_BITMAP_LOOKUP_TYPES_H_
+
+#include "types.h"
+
+/*
+ * The bitmap intersection classifier.
+ *
+ * Each field of the 5-tuple is a dimension, cut into the elementary
+ * intervals delimited by the rule boundaries in that dimension. Every
+ * interval carries a bitmap of the rules covering it, with the bit position
+ * being the rule priority (acl position in the lookup context, then ace
+ * position in the acl). A lookup is one binary search per dimension, an AND
+ * of the bitmaps found and a scan for the lowest set bit - so the cost
+ * depends on the number of dimensions and not on the shape of the rules.
+ *
+ * An IPv6 address is two 64-bit dimensions: a prefix is exactly the set of
+ * addresses whose upper half is in one range and whose lower half is in
+ * another, so the intersection stays exact.
+ *
+ * Every bitmap has a summary with a bit per non-zero 64-bit word
+ * (the "aggregated bit vector"), ANDed first so that only the words
+ * which may have a common bit are looked at.
+ */
+
+enum {
+  ACL_BM_DIM_IP4_SRC,
+  ACL_BM_DIM_IP4_DST,
+  ACL_BM_DIM_IP4_PROTO,
+  ACL_BM_DIM_IP4_SPORT,
+  ACL_BM_DIM_IP4_DPORT,
+  ACL_BM_N_DIMS_IP4,
+};
+
+enum {
+  ACL_BM_DIM_IP6_SRC_HI,
+  ACL_BM_DIM_IP6_SRC_LO,
+  ACL_BM_DIM_IP6_DST_HI,
+  ACL_BM_DIM_IP6_DST_LO,
+  ACL_BM_DIM_IP6_PROTO,
+  ACL_BM_DIM_IP6_SPORT,
+  ACL_BM_DIM_IP6_DPORT,
+  ACL_BM_N_DIMS_IP6,
+};
+
+#define ACL_BM_MAX_DIMS ACL_BM_N_DIMS_IP6
+
+/* The part of a rule not expressed by the dimensions, and its origin */
+typedef struct {
+  u32 acl_index;
+  u32 ace_index;
+  u32 acl_position;
+  u8 action;
+  u8 proto;
+  u8 tcp_flags_value;
+  u8 tcp_flags_mask;
+} acl_bm_rule_t;
+
+typedef struct {
+  /* sorted lower bounds of the intervals, the first one is always 0 */
+  u64 *bounds;
+  /* index of the bitmap of each interval */
+  u32 *bitmap_by_interval;
+  /* the distinct bitmaps, n_words each */
+  u64 *bitmaps;
+  /* their summaries, n_summary_words each */
+  u64 *summaries;
+} acl_bm_dim_t;
+
+typedef struct {
+  acl_bm_rule_t *rules;
+  u32 n_words;
+  u32 n_summary_words;
+  acl_bm_dim_t dims[ACL_BM_MAX_DIMS];
+} acl_bm_set_t;
+
+typedef struct {
+  /* rule sets by is_ip6 */
+  acl_bm_set_t sets[2];
+} acl_bm_classifier_t;
+
+/* Classifier used by a lookup context */
+typedef enum {
+  /* the hash or linear matching, as set globally */
+  ACL_LC_CLASSIFIER_DEFAULT = 0,
+  ACL_LC_CLASSIFIER_BITMAP,
+} acl_lc_classifier_t;
+
+#endif
@@ -229,6 +229,134 @@ process_established_session (vlib_main_t * vm, acl_main_t * am,
 
 #define ACL_PLUGIN_VECTOR_SIZE 4
 #define ACL_PLUGIN_PREFETCH_GAP 3
+/* distance of the session bihash data prefetch, the bucket one is twice it */
+#define ACL_PLUGIN_SESSION_PREFETCH_STRIDE 8
+/* distance of the session record prefetch */
+#define ACL_PLUGIN_SESSION_ENTRY_PREFETCH_GAP 4
+
+/*
+ * Look up the sessions of the whole frame, with the bucket and then the
+ * data of the bihash prefetched ahead of each search.
+ */
+always_inline void
+find_sessions_for_frame (acl_main_t * am, int is_ip6, u32 n_vectors,
+			 u32 * sw_if_index, u64 * hash,
+			 fa_5tuple_t * fa_5tuple, u64 * out_session_id)
+{
+  const u32 stride = ACL_PLUGIN_SESSION_PREFETCH_STRIDE;
+  u32 i;
+
+  for (i = 0; i < clib_min (n_vectors, 2 * stride); i++)
+    acl_fa_prefetch_session_bucket_for_hash (am, is_ip6, hash[i]);
+  for (i = 0; i < clib_min (n_vectors, stride); i++)
+    acl_fa_prefetch_session_data_for_hash (am, is_ip6, hash[i]);
+
+  for (i = 0; i < n_vectors; i++)
+    {
+      if (i + 2 * stride < n_vectors)
+	acl_fa_prefetch_session_bucket_for_hash (am, is_ip6,
+						 hash[i + 2 * stride]);
+      if (i + stride < n_vectors)
+	acl_fa_prefetch_session_data_for_hash (am, is_ip6, hash[i + stride]);
+      acl_fa_find_session_with_hash (am, is_ip6, sw_if_index[i], hash[i],
+				     &fa_5tuple[i], &out_session_id[i]);
+    }
+}
+
+always_inline void
+added_session_filter_set (acl_fa_per_worker_data_t * pw, u64 hash)
+{
+  u32 bit = hash >> (64 - ACL_FA_ADDED_SESSION_FILTER_LOG2_BITS);
+  pw->added_session_hash_filter[bit / BITS (uword)] |=
+    (uword) 1 << (bit % BITS (uword));
+}
+
+always_inline int
+added_session_filter_test (acl_fa_per_worker_data_t * pw, u64 hash)
+{
+  u32 bit = hash >> (64 - ACL_FA_ADDED_SESSION_FILTER_LOG2_BITS);
+  return (pw->added_session_hash_filter[bit / BITS (uword)] >>
+	  (bit % BITS (uword))) & 1;
+}
+
+/*
+ * Whether the packet's key is one of the two the session is hashed under:
+ * its own or, for the return traffic, the reversed one.
+ */
+always_inline int
+session_matches_5tuple (fa_session_t * sess, int is_ip6,
+			fa_5tuple_t * fa_5tuple0)
+{
+  u64 l4;
+
+  if (is_ip6)
+    {
+      u64 *sk = sess->info.kv_40_8.key, *pk = fa_5tuple0->kv_40_8.key;
+
+      if (PREDICT_TRUE (sk[0] == pk[0] && sk[1] == pk[1] && sk[2] == pk[2]
+			&& sk[3] == pk[3] && sk[4] == pk[4]))
+	return 1;
+      if (sk[0] != pk[2] || sk[1] != pk[3] || sk[2] != pk[0]
+	  || sk[3] != pk[1])
+	return 0;
+      l4 = sk[4];
+    }
+  else
+    {
+      u64 *sk = sess->info.kv_16_8.key, *pk = fa_5tuple0->kv_16_8.key;
+
+      if (PREDICT_TRUE (sk[0] == pk[0] && sk[1] == pk[1]))
+	return 1;
+      if (((sk[0] << 32) | (sk[0] >> 32)) != pk[0])
+	return 0;
+      l4 = sk[1];
+    }
+
+  if (PREDICT_FALSE (is_session_l4_key_u64_slowpath (l4)))
+    {
+      if (!reverse_l4_u64_slowpath_valid (l4, is_ip6, &l4))
+	return 0;
+    }
+  else
+    l4 = reverse_l4_u64_fastpath (l4, is_ip6);
+
+  return l4 == (is_ip6 ? fa_5tuple0->kv_40_8.key[4] :
+		fa_5tuple0->kv_16_8.key[1]);
+}
+
+/*
+ * The session found for a packet before the frame was processed may have
+ * been deleted since, or deleted and its slot reused by another flow, and a
+ * packet without a session may be matching one added since. Redo the lookup
+ * in all these cases.
+ */
+always_inline u64
+revalidate_session_id (acl_main_t * am, acl_fa_per_worker_data_t * pw,
+		       int is_ip6, u32 sw_if_index0, u64 hash0,
+		       fa_5tuple_t * fa_5tuple0, u64 session_id0)
+{
+  fa_full_session_id_t f_sess_id = {.as_u64 = session_id0 };
+  fa_session_t *sess;
+
+  if (f_sess_id.as_u64 == ~0ULL)
+    {
+      if (PREDICT_TRUE (!added_session_filter_test (pw, hash0)))
+	return f_sess_id.as_u64;
+    }
+  else
+    {
+      sess = get_session_ptr_no_check (am, f_sess_id.thread_index,
+				       f_sess_id.session_index);
+      if (PREDICT_TRUE (!sess->deleted
+			&& session_matches_5tuple (sess, is_ip6,
+						   fa_5tuple0)))
+	return f_sess_id.as_u64;
+    }
+
+  acl_fa_find_session_with_hash (am, is_ip6, sw_if_index0, hash0,
+				 fa_5tuple0, &f_sess_id.as_u64);
+  return f_sess_id.as_u64;
+}
 
 always_inline void
 acl_fa_node_common_prepare_fn (vlib_main_t * vm,
@@ -316,6 +444,11 @@ acl_fa_node_common_prepare_fn (vlib_main_t * vm,
       sw_if_index += vec_sz;
       hash += vec_sz;
     }
+
+  if (with_stateful_datapath)
+    find_sessions_for_frame (am, is_ip6, frame->n_vectors,
+			     pw->sw_if_indices, pw->hashes, pw->fa_5tuples,
+			     pw->session_ids);
 }
 
 
@@ -343,6 +476,8 @@ acl_fa_inner_node_fn (vlib_main_t * vm,
   u32 *sw_if_index;
   fa_5tuple_t *fa_5tuple;
   u64 *hash;
+  u64 *session_id;
+  int sessions_added = 0;
   /* for the delayed counters */
   u32 saved_matched_acl_index = 0;
   u32 saved_matched_ace_index = 0;
@@ -358,23 +493,14 @@ acl_fa_inner_node_fn (vlib_main_t * vm,
   sw_if_index = pw->sw_if_indices;
   fa_5tuple = pw->fa_5tuples;
   hash = pw->hashes;
+  session_id = pw->session_ids;
 
   /*
-   * Now the "hard" work of session lookups and ACL lookups for new sessions.
-   * Due to the complexity, do it for the time being in single loop with
-   * the pipeline of three prefetches:
-   *    1) bucket for the session bihash
-   *    2) data for the session bihash
-   *    3) worker session record
+   * Now the "hard" work of the ACL lookups and adding the new sessions.
+   * The sessions were looked up for the whole frame beforehand, only
+   * the worker session records are prefetched here.
    */
 
-  fa_full_session_id_t f_sess_id_next = {.as_u64 = ~0ULL };
-
-  /* find the "next" session so we can kickstart the pipeline */
-  if (with_stateful_datapath)
-    acl_fa_find_session_with_hash (am, is_ip6, sw_if_index[0], hash[0],
-				   &fa_5tuple[0], &f_sess_id_next.as_u64);
-
   n_left = frame->n_vectors;
   while (n_left > 0)
     {
@@ -391,73 +517,54 @@ acl_fa_inner_node_fn (vlib_main_t * vm,
 
       if (with_stateful_datapath)
 	{
-	  fa_full_session_id_t f_sess_id = f_sess_id_next;
-	  switch (n_left)
+	  const u32 gap = ACL_PLUGIN_SESSION_ENTRY_PREFETCH_GAP;
+	  fa_full_session_id_t f_sess_id;
+
+	  if (n_left > gap && session_id[gap] != ~0ULL)
+	    {
+	      fa_full_session_id_t f_sess_id_ahead = {.as_u64 =
+		  session_id[gap] };
+	      prefetch_session_entry (am, f_sess_id_ahead);
+	    }
+	  f_sess_id.as_u64 =
+	    revalidate_session_id (am, pw, is_ip6, sw_if_index[0], hash[0],
+				   &fa_5tuple[0], session_id[0]);
+	  if (f_sess_id.as_u64 != ~0ULL)
 	    {
-	    default:
-	      acl_fa_prefetch_session_bucket_for_hash (am, is_ip6, hash[5]);
-	      /* fallthrough */
-	    case 5:
-	    case 4:
-	      acl_fa_prefetch_session_data_for_hash (am, is_ip6, hash[3]);
-	      /* fallthrough */
-	    case 3:
-	    case 2:
-	      acl_fa_find_session_with_hash (am, is_ip6, sw_if_index[1],
-					     hash[1], &fa_5tuple[1],
-					     &f_sess_id_next.as_u64);
-	      if (f_sess_id_next.as_u64 != ~0ULL)
+	      if (node_trace_on)
 		{
-		  prefetch_session_entry (am, f_sess_id_next);
+		  trace_bitmap |= 0x80000000;
 		}
-	      /* fallthrough */
-	    case 1:
-	      if (f_sess_id.as_u64 != ~0ULL)
+	      ASSERT (f_sess_id.thread_index < vlib_get_n_threads ());
+	      b[0]->error = no_error_existing_session;
+	      acl_check_needed = 0;
+	      pkts_exist_session += 1;
+	      action =
+		process_established_session (vm, am, node->node_index,
+					     is_input, now, f_sess_id,
+					     &sw_if_index[0],
+					     &fa_5tuple[0],
+					     b[0]->current_length,
+					     node_trace_on,
+					     &trace_bitmap);
+
+	      /* expose the session id to the tracer */
+	      if (node_trace_on)
 		{
-		  if (node_trace_on)
-		    {
-		      trace_bitmap |= 0x80000000;
-		    }
-		  ASSERT (f_sess_id.thread_index < vlib_get_n_threads ());
-		  b[0]->error = no_error_existing_session;
-		  acl_check_needed = 0;
-		  pkts_exist_session += 1;
-		  action =
-		    process_established_session (vm, am, node->node_index,
-						 is_input, now, f_sess_id,
-						 &sw_if_index[0],
-						 &fa_5tuple[0],
-						 b[0]->current_length,
-						 node_trace_on,
-						 &trace_bitmap);
-
-		  /* expose the session id to the tracer */
-		  if (node_trace_on)
-		    {
-		      match_rule_index = f_sess_id.session_index;
-		    }
+		  match_rule_index = f_sess_id.session_index;
+		}
 
-		  if (reclassify_sessions)
+	      if (reclassify_sessions)
+		{
+		  if (PREDICT_FALSE
+		      (stale_session_deleted
+		       (am, is_input, pw, now, sw_if_index[0],
+			f_sess_id)))
 		    {
-		      if (PREDICT_FALSE
-			  (stale_session_deleted
-			   (am, is_input, pw, now, sw_if_index[0],
-			    f_sess_id)))
+		      acl_check_needed = 1;
+		      if (node_trace_on)
 			{
-			  acl_check_needed = 1;
-			  if (node_trace_on)
-			    {
-			      trace_bitmap |= 0x40000000;
-			    }
-			  /*
-			   * If we have just deleted the session, and the next
-			   * buffer is the same 5-tuple, that session prediction
-			   * is wrong, correct it.
-			   */
-			  if ((f_sess_id_next.as_u64 != ~0ULL)
-			      && 0 == memcmp (&fa_5tuple[1], &fa_5tuple[0],
-					      sizeof (fa_5tuple[1])))
-			    f_sess_id_next.as_u64 = ~0ULL;
+			  trace_bitmap |= 0x40000000;
 			}
 		    }
 		}
@@ -534,14 +641,9 @@ acl_fa_inner_node_fn (vlib_main_t * vm,
 						   node_trace_on,
 						   &trace_bitmap);
 		      pkts_new_session++;
-		      /*
-		       * If the next 5tuple is the same and we just added the session,
-		       * the f_sess_id_next can not be ~0. Correct it.
-		       */
-		      if ((f_sess_id_next.as_u64 == ~0ULL)
-			  && 0 == memcmp (&fa_5tuple[1], &fa_5tuple[0],
-					  sizeof (fa_5tuple[1])))
-			f_sess_id_next = f_sess_id;
+		      /* the later packets of the frame may match it */
+		      added_session_filter_set (pw, hash[0]);
+		      sessions_added = 1;
 		    }
 		  else
 		    {
@@ -574,10 +676,15 @@ acl_fa_inner_node_fn (vlib_main_t * vm,
 	  fa_5tuple++;
 	  sw_if_index++;
 	  hash++;
+	  session_id++;
 	  n_left -= 1;
 	}
     }
 
+  if (sessions_added)
+    clib_memset (pw->added_session_hash_filter, 0,
+		 sizeof (pw->added_session_hash_filter));
+
   /*
    * if we were had an acl match then we have a counter to increment.
    * else it is all zeroes, so this will be harmless.
@@ -165,6 +165,11 @@ CT_ASSERT_EQUAL(fa_5tuple_opaque_t_must_match_5tuple, sizeof(fa_5tuple_opaque_t)
 
 #define FA_SESSION_BOGUS_INDEX ~0
 
+/* The filter is indexed by the top bits of the session hash */
+#define ACL_FA_ADDED_SESSION_FILTER_LOG2_BITS 12
+#define ACL_FA_ADDED_SESSION_FILTER_WORDS \
+  ((1 << ACL_FA_ADDED_SESSION_FILTER_LOG2_BITS) / BITS (uword))
+
 typedef struct {
   /* The pool of sessions managed by this worker */
   fa_session_t *fa_sessions_pool;
@@ -231,6 +236,10 @@ typedef struct {
   fa_5tuple_t fa_5tuples[VLIB_FRAME_SIZE];
   u64 hashes[VLIB_FRAME_SIZE];
   u16 nexts[VLIB_FRAME_SIZE];
+  /* sessions found for the frame, looked up before processing it */
+  u64 session_ids[VLIB_FRAME_SIZE];
+  /* filter of the hashes of the sessions added while processing the frame */
+  uword added_session_hash_filter[ACL_FA_ADDED_SESSION_FILTER_WORDS];
 
 } acl_fa_per_worker_data_t;
 
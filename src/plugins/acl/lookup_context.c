@@ -18,6 +18,7 @@
 #include <vlib/unix/plugin.h>
 #include <plugins/acl/public_inlines.h>
 #include "hash_lookup.h"
+#include "bitmap_lookup.h"
 #include "elog_acl_trace.h"
 
 /* check if a given ACL exists */
@@ -114,6 +115,7 @@ static int acl_plugin_get_lookup_context_index (u32 acl_user_id, u32 val1, u32 v
   acontext->context_user_id = acl_user_id;
   acontext->user_val1 = val1;
   acontext->user_val2 = val2;
+  acontext->classifier = ACL_LC_CLASSIFIER_DEFAULT;
 
   u32 new_context_id = acontext - am->acl_lookup_contexts;
   vec_add1(am->acl_users[acl_user_id].lookup_contexts, new_context_id);
@@ -206,6 +208,8 @@ static void acl_plugin_put_lookup_context_index (u32 lc_index)
   unapply_acl_vec(lc_index, acontext->acl_indices);
   unlock_acl_vec(lc_index, acontext->acl_indices);
   vec_free(acontext->acl_indices);
+  acontext->classifier = ACL_LC_CLASSIFIER_DEFAULT;
+  acl_bm_lc_update(am, lc_index);
   pool_put(am->acl_lookup_contexts, acontext);
 }
 
@@ -258,6 +262,7 @@ static int acl_plugin_set_acl_vec_for_context (u32 lc_index, u32 *acl_list)
   unlock_acl_vec(lc_index, old_acl_vector);
   lock_acl_vec(lc_index, acontext->acl_indices);
   apply_acl_vec(lc_index, acontext->acl_indices);
+  acl_bm_lc_update(am, lc_index);
 
   vec_free(old_acl_vector);
 
@@ -280,6 +285,30 @@ void acl_plugin_lookup_context_notify_acl_change(u32 acl_num)
     /* this is a deletion notification */
     hash_acl_delete(am, acl_num);
   }
+  /* the bitmap classifiers are rebuilt as a whole */
+  if (acl_num < vec_len(am->lc_index_vec_by_acl)) {
+    u32 *lc_index;
+    vec_foreach(lc_index, am->lc_index_vec_by_acl[acl_num]) {
+      acl_bm_lc_update(am, *lc_index);
+    }
+  }
+}
+
+/*
+ * Select the classifier used for the lookups within a context.
+ */
+int acl_plugin_set_lookup_context_classifier (u32 lc_index, acl_lc_classifier_t classifier)
+{
+  acl_main_t *am = &acl_main;
+  acl_lookup_context_t *acontext;
+
+  if (!acl_lc_index_valid(am, lc_index))
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  acontext = pool_elt_at_index(am->acl_lookup_contexts, lc_index);
+  acontext->classifier = classifier;
+  acl_bm_lc_update(am, lc_index);
+  return 0;
 }
 
 
@@ -349,6 +378,11 @@ acl_plugin_show_lookup_context (u32 lc_index)
                        acontext->user_val1, acontext->user_val2,
                        format_vec32, acontext->acl_indices, "%d");
       }
+      acl_bm_classifier_t *bmc = acl_bm_lc_classifier(am, curr_lc_index);
+      if (bmc)
+        vlib_cli_output (vm, "  bitmap classifier: %U", format_acl_bm_classifier, bmc);
+      else if (acl_bm_lc_is_pending(am, curr_lc_index))
+        vlib_cli_output (vm, "  bitmap classifier: building");
     }
   }
 }
@@ -36,10 +36,14 @@ typedef struct {
   u32 user_val1;
   /* per-instance user value 2 */
   u32 user_val2;
+  /* acl_lc_classifier_t used for the lookups */
+  u8 classifier;
 } acl_lookup_context_t;
 
 void acl_plugin_lookup_context_notify_acl_change(u32 acl_num);
 
+int acl_plugin_set_lookup_context_classifier (u32 lc_index, acl_lc_classifier_t classifier);
+
 void acl_plugin_show_lookup_context (u32 lc_index);
 void acl_plugin_show_lookup_user (u32 user_index);
 
@@ -649,6 +649,147 @@ hash_multi_acl_match_5tuple (void *p_acl_main, u32 lc_index, fa_5tuple_t * pkt_5
 
 
 
+/*
+ * Bitmap intersection matching, see bitmap_lookup_types.h
+ */
+
+always_inline acl_bm_classifier_t *
+acl_bm_lc_classifier (acl_main_t * am, u32 lc_index)
+{
+  /* published by the build process while the workers run */
+  if (lc_index < vec_len (am->bm_classifier_by_lc_index))
+    return clib_atomic_load_acq_n (&am->bm_classifier_by_lc_index[lc_index]);
+  return 0;
+}
+
+/* The value of the packet in each dimension */
+always_inline int
+acl_bm_fill_key (fa_5tuple_t * pkt_5tuple, int is_ip6, u64 * key)
+{
+  if (is_ip6)
+    {
+      key[ACL_BM_DIM_IP6_SRC_HI] = clib_net_to_host_u64 (pkt_5tuple->ip6_addr[0].as_u64[0]);
+      key[ACL_BM_DIM_IP6_SRC_LO] = clib_net_to_host_u64 (pkt_5tuple->ip6_addr[0].as_u64[1]);
+      key[ACL_BM_DIM_IP6_DST_HI] = clib_net_to_host_u64 (pkt_5tuple->ip6_addr[1].as_u64[0]);
+      key[ACL_BM_DIM_IP6_DST_LO] = clib_net_to_host_u64 (pkt_5tuple->ip6_addr[1].as_u64[1]);
+      key[ACL_BM_DIM_IP6_PROTO] = pkt_5tuple->l4.proto;
+      key[ACL_BM_DIM_IP6_SPORT] = pkt_5tuple->l4.port[0];
+      key[ACL_BM_DIM_IP6_DPORT] = pkt_5tuple->l4.port[1];
+      return ACL_BM_N_DIMS_IP6;
+    }
+  key[ACL_BM_DIM_IP4_SRC] = clib_net_to_host_u32 (pkt_5tuple->ip4_addr[0].as_u32);
+  key[ACL_BM_DIM_IP4_DST] = clib_net_to_host_u32 (pkt_5tuple->ip4_addr[1].as_u32);
+  key[ACL_BM_DIM_IP4_PROTO] = pkt_5tuple->l4.proto;
+  key[ACL_BM_DIM_IP4_SPORT] = pkt_5tuple->l4.port[0];
+  key[ACL_BM_DIM_IP4_DPORT] = pkt_5tuple->l4.port[1];
+  return ACL_BM_N_DIMS_IP4;
+}
+
+/* index of the bitmap of the interval holding v */
+always_inline u32
+acl_bm_dim_lookup (acl_bm_dim_t * dim, u64 v)
+{
+  u64 *bounds = dim->bounds;
+  u32 base = 0, n = vec_len (bounds);
+
+  /* the last lower bound not above v; bounds[0] is 0 so there is one */
+  while (n > 1)
+    {
+      u32 half = n / 2;
+      base = (bounds[base + half] <= v) ? base + half : base;
+      n -= half;
+    }
+  return dim->bitmap_by_interval[base];
+}
+
+/* what the dimensions do not cover: l4 validity and the tcp flags */
+always_inline int
+acl_bm_rule_match_rest (acl_bm_rule_t * r, fa_5tuple_t * pkt_5tuple)
+{
+  if (!r->proto)
+    return 1;
+  if (PREDICT_FALSE (!pkt_5tuple->pkt.l4_valid))
+    return 0;
+  if (pkt_5tuple->pkt.tcp_flags_valid
+      && ((pkt_5tuple->pkt.tcp_flags & r->tcp_flags_mask) != r->tcp_flags_value))
+    return 0;
+  return 1;
+}
+
+/* returns the index of the first matching rule within the set, or ~0 */
+always_inline u32
+acl_bm_set_match (acl_bm_set_t * set, u64 * key, int n_dims, fa_5tuple_t * pkt_5tuple)
+{
+  u64 *bitmaps[ACL_BM_MAX_DIMS];
+  u64 *summaries[ACL_BM_MAX_DIMS];
+  u32 n_words = set->n_words;
+  u32 n_summary_words = set->n_summary_words;
+  int d;
+  u32 s;
+
+  if (PREDICT_FALSE (vec_len (set->rules) == 0))
+    return ~0;
+
+  for (d = 0; d < n_dims; d++)
+    {
+      acl_bm_dim_t *dim = &set->dims[d];
+      u32 bi = acl_bm_dim_lookup (dim, key[d]);
+      bitmaps[d] = dim->bitmaps + bi * n_words;
+      summaries[d] = dim->summaries + bi * n_summary_words;
+    }
+
+  for (s = 0; s < n_summary_words; s++)
+    {
+      u64 summary = summaries[0][s];
+      for (d = 1; d < n_dims; d++)
+        summary &= summaries[d][s];
+
+      while (summary)
+        {
+          u32 w = s * 64 + count_trailing_zeros (summary);
+          u64 word = bitmaps[0][w];
+          for (d = 1; d < n_dims; d++)
+            word &= bitmaps[d][w];
+
+          while (word)
+            {
+              u32 ri = w * 64 + count_trailing_zeros (word);
+              if (acl_bm_rule_match_rest (&set->rules[ri], pkt_5tuple))
+                return ri;
+              word = clear_lowest_set_bit (word);
+            }
+          summary = clear_lowest_set_bit (summary);
+        }
+    }
+  return ~0;
+}
+
+always_inline int
+bitmap_multi_acl_match_5tuple (void *p_acl_main, u32 lc_index, fa_5tuple_t * pkt_5tuple,
+                       int is_ip6, u8 *action, u32 *acl_pos_p, u32 * acl_match_p,
+                       u32 * rule_match_p, u32 * trace_bitmap)
+{
+  acl_main_t *am = p_acl_main;
+  acl_bm_classifier_t *bmc = acl_bm_lc_classifier (am, lc_index);
+  acl_bm_set_t *set = &bmc->sets[is_ip6 != 0];
+  u64 key[ACL_BM_MAX_DIMS];
+  int n_dims;
+  u32 ri;
+
+  n_dims = acl_bm_fill_key (pkt_5tuple, is_ip6, key);
+  ri = acl_bm_set_match (set, key, n_dims, pkt_5tuple);
+  if (ri != ~0) {
+    acl_bm_rule_t *r = vec_elt_at_index (set->rules, ri);
+    *acl_pos_p = r->acl_position;
+    *acl_match_p = r->acl_index;
+    *rule_match_p = r->ace_index;
+    *action = r->action;
+    return 1;
+  }
+  return 0;
+}
+
+
 always_inline int
 acl_plugin_match_5tuple_inline (void *p_acl_main, u32 lc_index,
                                            fa_5tuple_opaque_t * pkt_5tuple,
@@ -661,7 +802,12 @@ acl_plugin_match_5tuple_inline (void *p_acl_main, u32 lc_index,
   acl_main_t *am = p_acl_main;
   fa_5tuple_t * pkt_5tuple_internal = (fa_5tuple_t *)pkt_5tuple;
   pkt_5tuple_internal->pkt.lc_index = lc_index;
-  if (PREDICT_TRUE(am->use_hash_acl_matching)) {
+  if (PREDICT_FALSE(acl_bm_lc_classifier(am, lc_index) != 0) &&
+      PREDICT_TRUE(!pkt_5tuple_internal->pkt.is_nonfirst_fragment)) {
+    /* non-first fragments take the same path as with the hash matching below */
+    return bitmap_multi_acl_match_5tuple(p_acl_main, lc_index, pkt_5tuple_internal, is_ip6, r_action,
+                                 r_acl_pos_p, r_acl_match_p, r_rule_match_p, trace_bitmap);
+  } else if (PREDICT_TRUE(am->use_hash_acl_matching)) {
     if (PREDICT_FALSE(pkt_5tuple_internal->pkt.is_nonfirst_fragment)) {
       /*
        * tuplemerge does not take fragments into account,
@@ -696,7 +842,11 @@ acl_plugin_match_5tuple_inline_and_count (void *p_acl_main, u32 lc_index,
   int ret = 0;
   fa_5tuple_t * pkt_5tuple_internal = (fa_5tuple_t *)pkt_5tuple;
   pkt_5tuple_internal->pkt.lc_index = lc_index;
-  if (PREDICT_TRUE(am->use_hash_acl_matching)) {
+  if (PREDICT_FALSE(acl_bm_lc_classifier(am, lc_index) != 0) &&
+      PREDICT_TRUE(!pkt_5tuple_internal->pkt.is_nonfirst_fragment)) {
+    ret = bitmap_multi_acl_match_5tuple(p_acl_main, lc_index, pkt_5tuple_internal, is_ip6, r_action,
+                                 r_acl_pos_p, r_acl_match_p, r_rule_match_p, trace_bitmap);
+  } else if (PREDICT_TRUE(am->use_hash_acl_matching)) {
     if (PREDICT_FALSE(pkt_5tuple_internal->pkt.is_nonfirst_fragment)) {
       /*
        * tuplemerge does not take fragments into account,
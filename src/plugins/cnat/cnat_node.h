@@ -259,6 +259,48 @@ cnat_ip4_translate_l3 (ip4_header_t *ip4, ip4_address_t new_addr[VLIB_N_DIR],
   ip4->checksum = ip_csum_fold (sum);
 }
 
+/*
+ * TCP and UDP cover the addresses in their pseudo header, so the delta of
+ * the address rewrite is computed once and folded into both the IP and
+ * the L4 checksum.
+ */
+static_always_inline void
+cnat_ip4_translate_l3_l4 (ip4_header_t *ip4, udp_header_t *udp, u16 *l4_csum,
+			  ip4_address_t new_addr[VLIB_N_DIR],
+			  u16 new_port[VLIB_N_DIR], u32 oflags)
+{
+  ip_csum_t addr_delta = 0, sum;
+
+  addr_delta = ip_csum_update (addr_delta, ip4->dst_address.as_u32,
+			       new_addr[VLIB_TX].as_u32, ip4_header_t,
+			       dst_address);
+  addr_delta = ip_csum_update (addr_delta, ip4->src_address.as_u32,
+			       new_addr[VLIB_RX].as_u32, ip4_header_t,
+			       src_address);
+
+  if (oflags &
+      (VNET_BUFFER_OFFLOAD_F_TCP_CKSUM | VNET_BUFFER_OFFLOAD_F_UDP_CKSUM))
+    *l4_csum = ip4_pseudo_header_cksum2 (ip4, new_addr);
+  else
+    {
+      sum = ip_csum_with_carry (*l4_csum, addr_delta);
+      sum = ip_csum_update (sum, udp->dst_port, new_port[VLIB_TX],
+			    udp_header_t, dst_port);
+      sum = ip_csum_update (sum, udp->src_port, new_port[VLIB_RX],
+			    udp_header_t, src_port);
+      *l4_csum = ip_csum_fold (sum);
+    }
+
+  udp->dst_port = new_port[VLIB_TX];
+  udp->src_port = new_port[VLIB_RX];
+
+  /* the IP checksum is always computed, see cnat_ip4_translate_l3 */
+  sum = ip_csum_with_carry (ip4->checksum, addr_delta);
+  ip4->checksum = ip_csum_fold (sum);
+  ip4->dst_address = new_addr[VLIB_TX];
+  ip4->src_address = new_addr[VLIB_RX];
+}
+
 static_always_inline void
 cnat_tcp_update_session_lifetime (tcp_header_t * tcp, u32 index)
 {
@@ -388,19 +430,13 @@ cnat_translation_ip4 (const cnat_session_t *session, ip4_header_t *ip4,
 
   if (ip4->protocol == IP_PROTOCOL_TCP)
     {
-      ip_csum_t sum = tcp->checksum;
-      cnat_ip4_translate_l4 (ip4, udp, &sum, new_addr, new_port, oflags);
-      tcp->checksum = ip_csum_fold (sum);
-      cnat_ip4_translate_l3 (ip4, new_addr, oflags);
+      cnat_ip4_translate_l3_l4 (ip4, udp, &tcp->checksum, new_addr, new_port,
+				oflags);
       cnat_tcp_update_session_lifetime (tcp, session->value.cs_ts_index);
     }
   else if (ip4->protocol == IP_PROTOCOL_UDP)
-    {
-      ip_csum_t sum = udp->checksum;
-      cnat_ip4_translate_l4 (ip4, udp, &sum, new_addr, new_port, oflags);
-      udp->checksum = ip_csum_fold (sum);
-      cnat_ip4_translate_l3 (ip4, new_addr, oflags);
-    }
+    cnat_ip4_translate_l3_l4 (ip4, udp, &udp->checksum, new_addr, new_port,
+			      oflags);
   else if (ip4->protocol == IP_PROTOCOL_SCTP)
     {
       sctp_header_t *sctp = (sctp_header_t *) udp;
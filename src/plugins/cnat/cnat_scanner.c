@@ -27,8 +27,11 @@ cnat_scanner_process (vlib_main_t * vm,
 
   while (1)
     {
+      /* an unfinished pass resumes shortly, so that sessions in large
+       * tables do not wait for many timeouts to expire */
       if (enabled)
-	vlib_process_wait_for_event_or_clock (vm, cm->scanner_timeout);
+	vlib_process_wait_for_event_or_clock (
+	  vm, i ? CNAT_SCANNER_RESUME_TIMEOUT : cm->scanner_timeout);
       else
 	vlib_process_wait_for_event (vm);
 
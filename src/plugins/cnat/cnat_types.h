@@ -33,6 +33,8 @@
 /* lifetime of TCP conn NAT sessions after RST/FIN (seconds) */
 #define CNAT_DEFAULT_TCP_RST_TIMEOUT 5
 #define CNAT_DEFAULT_SCANNER_TIMEOUT (1.0)
+/* pause between the slices of an unfinished session scan */
+#define CNAT_SCANNER_RESUME_TIMEOUT (1e-3)
 
 #define CNAT_DEFAULT_SESSION_BUCKETS     1024
 #define CNAT_DEFAULT_TRANSLATION_BUCKETS 1024
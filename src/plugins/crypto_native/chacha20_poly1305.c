@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright(c) 2024 Cisco Systems, Inc.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/plugin/plugin.h>
+#include <vnet/crypto/crypto.h>
+#include <crypto_native/crypto_native.h>
+#include <vppinfra/crypto/chacha20.h>
+
+#if __GNUC__ > 4 && !__clang__ && CLIB_DEBUG == 0
+#pragma GCC optimize("O3")
+#endif
+
+static_always_inline u32
+chacha20_poly1305_ops (vlib_main_t *vm, vnet_crypto_op_t *ops[], u32 n_ops,
+		       clib_chacha20_poly1305_op_t op_type)
+{
+  crypto_native_main_t *cm = &crypto_native_main;
+  vnet_crypto_op_t *op = ops[0];
+  clib_chacha20_key_t *kd;
+  u32 n_left = n_ops;
+  int rv;
+
+next:
+  kd = (clib_chacha20_key_t *) cm->key_data[op->key_index];
+  rv = clib_chacha20_poly1305 (kd, op->iv, op->aad, op->aad_len, op->src,
+			       op->dst, op->len, op->tag, op->tag_len,
+			       op_type);
+
+  if (rv)
+    {
+      op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
+    }
+  else
+    {
+      op->status = VNET_CRYPTO_OP_STATUS_FAIL_BAD_HMAC;
+      n_ops--;
+    }
+
+  if (--n_left)
+    {
+      op += 1;
+      goto next;
+    }
+
+  return n_ops;
+}
+
+static u32
+chacha20_poly1305_ops_enc (vlib_main_t *vm, vnet_crypto_op_t *ops[],
+			   u32 n_ops)
+{
+  return chacha20_poly1305_ops (vm, ops, n_ops,
+				CLIB_CHACHA20_POLY1305_OP_ENCRYPT);
+}
+
+static u32
+chacha20_poly1305_ops_dec (vlib_main_t *vm, vnet_crypto_op_t *ops[],
+			   u32 n_ops)
+{
+  return chacha20_poly1305_ops (vm, ops, n_ops,
+				CLIB_CHACHA20_POLY1305_OP_DECRYPT);
+}
+
+static void *
+chacha20_poly1305_key_init (vnet_crypto_key_t *key)
+{
+  clib_chacha20_key_t *kd;
+
+  kd = clib_mem_alloc_aligned (sizeof (*kd), CLIB_CACHE_LINE_BYTES);
+
+  clib_chacha20_key_init (kd, key->data);
+
+  return kd;
+}
+
+clib_error_t *
+#if defined(__VAES__) && defined(__AVX512F__)
+crypto_native_chacha20_poly1305_init_icl (vlib_main_t *vm)
+#elif defined(__VAES__)
+crypto_native_chacha20_poly1305_init_adl (vlib_main_t *vm)
+#elif __AVX512F__
+crypto_native_chacha20_poly1305_init_skx (vlib_main_t *vm)
+#elif __AVX2__
+crypto_native_chacha20_poly1305_init_hsw (vlib_main_t *vm)
+#elif __aarch64__
+crypto_native_chacha20_poly1305_init_neon (vlib_main_t *vm)
+#else
+crypto_native_chacha20_poly1305_init_slm (vlib_main_t *vm)
+#endif
+{
+  crypto_native_main_t *cm = &crypto_native_main;
+
+  vnet_crypto_register_ops_handler (vm, cm->crypto_engine_index,
+				    VNET_CRYPTO_OP_CHACHA20_POLY1305_ENC,
+				    chacha20_poly1305_ops_enc);
+  vnet_crypto_register_ops_handler (vm, cm->crypto_engine_index,
+				    VNET_CRYPTO_OP_CHACHA20_POLY1305_DEC,
+				    chacha20_poly1305_ops_dec);
+  cm->key_fn[VNET_CRYPTO_ALG_CHACHA20_POLY1305] = chacha20_poly1305_key_init;
+  return 0;
+}
@@ -35,6 +35,8 @@ extern crypto_native_main_t crypto_native_main;
 #define _(v) \
 clib_error_t __clib_weak *crypto_native_aes_cbc_init_##v (vlib_main_t * vm); \
 clib_error_t __clib_weak *crypto_native_aes_gcm_init_##v (vlib_main_t * vm); \
+clib_error_t __clib_weak *crypto_native_chacha20_poly1305_init_##v (vlib_main_t * vm); \
+clib_error_t __clib_weak *crypto_native_sha2_init_##v (vlib_main_t * vm); \
 
 foreach_crypto_native_march_variant;
 #undef _
@@ -65,14 +65,14 @@ crypto_native_init (vlib_main_t * vm)
   crypto_native_main_t *cm = &crypto_native_main;
   clib_error_t *error = 0;
 
-  if (clib_cpu_supports_x86_aes () == 0 &&
-      clib_cpu_supports_aarch64_aes () == 0)
-    return 0;
-
   cm->crypto_engine_index =
     vnet_crypto_register_engine (vm, "native", 100,
 				 "Native ISA Optimized Crypto");
 
+  if (clib_cpu_supports_x86_aes () == 0 &&
+      clib_cpu_supports_aarch64_aes () == 0)
+    goto chacha20_poly1305;
+
   if (0);
 #if __x86_64__
   else if (crypto_native_aes_cbc_init_icl && clib_cpu_supports_vaes () &&
@@ -128,6 +128,54 @@ crypto_native_init (vlib_main_t * vm)
     return error;
 #endif
 
+chacha20_poly1305:
+  /* chacha20-poly1305 only needs the vector unit, not the AES instructions,
+   * the variant is picked by vector width */
+  if (0);
+#if __x86_64__
+  else if (crypto_native_chacha20_poly1305_init_icl &&
+	   clib_cpu_supports_avx512f () && clib_cpu_supports_vaes ())
+    error = crypto_native_chacha20_poly1305_init_icl (vm);
+  else if (crypto_native_chacha20_poly1305_init_adl &&
+	   clib_cpu_supports_vaes ())
+    error = crypto_native_chacha20_poly1305_init_adl (vm);
+  else if (crypto_native_chacha20_poly1305_init_skx &&
+	   clib_cpu_supports_avx512f ())
+    error = crypto_native_chacha20_poly1305_init_skx (vm);
+  else if (crypto_native_chacha20_poly1305_init_hsw &&
+	   clib_cpu_supports_avx2 ())
+    error = crypto_native_chacha20_poly1305_init_hsw (vm);
+  else if (crypto_native_chacha20_poly1305_init_slm)
+    error = crypto_native_chacha20_poly1305_init_slm (vm);
+#endif
+#if __aarch64__
+  else if (crypto_native_chacha20_poly1305_init_neon)
+    error = crypto_native_chacha20_poly1305_init_neon (vm);
+#endif
+
+  if (error)
+    return error;
+
+#if __x86_64__
+  if (clib_cpu_supports_sha ())
+    {
+      if (crypto_native_sha2_init_icl && clib_cpu_supports_vaes () &&
+	  clib_cpu_supports_avx512f ())
+	error = crypto_native_sha2_init_icl (vm);
+      else if (crypto_native_sha2_init_adl && clib_cpu_supports_vaes ())
+	error = crypto_native_sha2_init_adl (vm);
+      else if (crypto_native_sha2_init_skx && clib_cpu_supports_avx512f ())
+	error = crypto_native_sha2_init_skx (vm);
+      else if (crypto_native_sha2_init_hsw && clib_cpu_supports_avx2 ())
+	error = crypto_native_sha2_init_hsw (vm);
+      else if (crypto_native_sha2_init_slm)
+	error = crypto_native_sha2_init_slm (vm);
+
+      if (error)
+	return error;
+    }
+#endif
+
   vnet_crypto_register_key_handler (vm, cm->crypto_engine_index,
 				    crypto_native_key_handler);
   return 0;
@@ -0,0 +1,133 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright(c) 2024 Cisco Systems, Inc.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/plugin/plugin.h>
+#include <vnet/crypto/crypto.h>
+#include <crypto_native/crypto_native.h>
+#include <vppinfra/crypto/sha2.h>
+
+#if __GNUC__ > 4 && !__clang__ && CLIB_DEBUG == 0
+#pragma GCC optimize("O3")
+#endif
+
+/* only worth registering when the block function runs on the SHA
+ * extensions, the scalar code is slower than what other engines provide */
+#if defined(__SHA__) && defined(__x86_64__)
+
+static_always_inline u32
+crypto_native_ops_hmac_sha2 (vlib_main_t *vm, vnet_crypto_op_t *ops[],
+			     u32 n_ops, vnet_crypto_op_chunk_t *chunks,
+			     clib_sha2_type_t type)
+{
+  crypto_native_main_t *cm = &crypto_native_main;
+  vnet_crypto_op_t *op = ops[0];
+  clib_sha2_hmac_key_data_t *kd;
+  clib_sha2_ctx_t ctx;
+  u8 buffer[SHA2_MAX_DIGEST_SIZE];
+  u32 n_left = n_ops, sz;
+
+next:
+  kd = (clib_sha2_hmac_key_data_t *) cm->key_data[op->key_index];
+  clib_sha2_hmac_init (&ctx, type, kd);
+
+  if (op->flags & VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS)
+    {
+      vnet_crypto_op_chunk_t *chp = chunks + op->chunk_index;
+      for (int j = 0; j < op->n_chunks; j++, chp++)
+	clib_sha2_hmac_update (&ctx, type, chp->src, chp->len);
+    }
+  else
+    clib_sha2_hmac_update (&ctx, type, op->src, op->len);
+
+  clib_sha2_hmac_final (&ctx, type, kd, buffer);
+  sz = op->digest_len ? clib_min (op->digest_len, ctx.digest_size) :
+		       ctx.digest_size;
+
+  if (op->flags & VNET_CRYPTO_OP_FLAG_HMAC_CHECK)
+    {
+      if ((memcmp (op->digest, buffer, sz)))
+	{
+	  n_ops--;
+	  op->status = VNET_CRYPTO_OP_STATUS_FAIL_BAD_HMAC;
+	  goto done;
+	}
+    }
+  else
+    clib_memcpy_fast (op->digest, buffer, sz);
+
+  op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
+
+done:
+  if (--n_left)
+    {
+      op += 1;
+      goto next;
+    }
+
+  return n_ops;
+}
+
+static_always_inline void *
+crypto_native_hmac_sha2_key_data (vnet_crypto_key_t *key,
+				  clib_sha2_type_t type)
+{
+  clib_sha2_hmac_key_data_t *kd;
+
+  kd = clib_mem_alloc_aligned (sizeof (*kd), CLIB_CACHE_LINE_BYTES);
+  clib_sha2_hmac_key_data (type, key->data, vec_len (key->data), kd);
+
+  return kd;
+}
+
+#define foreach_crypto_native_hmac_sha2 _ (224) _ (256)
+
+#define _(b)                                                                  \
+  static u32 crypto_native_ops_hmac_sha##b (                                  \
+    vlib_main_t *vm, vnet_crypto_op_t *ops[], u32 n_ops)                      \
+  {                                                                           \
+    return crypto_native_ops_hmac_sha2 (vm, ops, n_ops, 0, CLIB_SHA2_##b);    \
+  }                                                                           \
+  static u32 crypto_native_ops_chained_hmac_sha##b (                          \
+    vlib_main_t *vm, vnet_crypto_op_t *ops[], vnet_crypto_op_chunk_t *chunks, \
+    u32 n_ops)                                                                \
+  {                                                                           \
+    return crypto_native_ops_hmac_sha2 (vm, ops, n_ops, chunks,               \
+					CLIB_SHA2_##b);                       \
+  }                                                                           \
+  static void *crypto_native_hmac_sha##b##_key_data (vnet_crypto_key_t *key)  \
+  {                                                                           \
+    return crypto_native_hmac_sha2_key_data (key, CLIB_SHA2_##b);             \
+  }
+
+foreach_crypto_native_hmac_sha2;
+#undef _
+
+clib_error_t *
+#if defined(__VAES__) && defined(__AVX512F__)
+crypto_native_sha2_init_icl (vlib_main_t *vm)
+#elif defined(__VAES__)
+crypto_native_sha2_init_adl (vlib_main_t *vm)
+#elif __AVX512F__
+crypto_native_sha2_init_skx (vlib_main_t *vm)
+#elif __AVX2__
+crypto_native_sha2_init_hsw (vlib_main_t *vm)
+#else
+crypto_native_sha2_init_slm (vlib_main_t *vm)
+#endif
+{
+  crypto_native_main_t *cm = &crypto_native_main;
+
+#define _(b)                                                                  \
+  vnet_crypto_register_ops_handlers (vm, cm->crypto_engine_index,             \
+				     VNET_CRYPTO_OP_SHA##b##_HMAC,            \
+				     crypto_native_ops_hmac_sha##b,           \
+				     crypto_native_ops_chained_hmac_sha##b);  \
+  cm->key_fn[VNET_CRYPTO_ALG_HMAC_SHA##b] = crypto_native_hmac_sha##b##_key_data;
+  foreach_crypto_native_hmac_sha2;
+#undef _
+  return 0;
+}
+
+#endif
@@ -21,10 +21,31 @@
 #define CRYPTO_SW_SCHEDULER_QUEUE_SIZE 64
 #define CRYPTO_SW_SCHEDULER_QUEUE_MASK (CRYPTO_SW_SCHEDULER_QUEUE_SIZE - 1)
 
+/* an idle worker steals up to half of the frames pending in the deepest
+ * queue of another thread, but never more than this in one go */
+#define CRYPTO_SW_SCHEDULER_STEAL_MAX (CRYPTO_SW_SCHEDULER_QUEUE_SIZE / 2)
+
 STATIC_ASSERT ((0 == (CRYPTO_SW_SCHEDULER_QUEUE_SIZE &
 		      (CRYPTO_SW_SCHEDULER_QUEUE_SIZE - 1))),
 	       "CRYPTO_SW_SCHEDULER_QUEUE_SIZE is not pow2");
 
+/* per thread metrics, exported as /crypto_sw_scheduler/<name>, one counter
+ * per thread index */
+#define foreach_crypto_sw_scheduler_stat                                      \
+  _ (FRAMES, "frames")                                                        \
+  _ (FRAMES_STOLEN, "frames-stolen")                                          \
+  _ (STEALS, "steals")                                                        \
+  _ (ENCRYPT_DEPTH, "encrypt-depth")                                          \
+  _ (DECRYPT_DEPTH, "decrypt-depth")
+
+typedef enum crypto_sw_scheduler_stat_t_
+{
+#define _(sym, str) CRYPTO_SW_SCHEDULER_STAT_##sym,
+  foreach_crypto_sw_scheduler_stat
+#undef _
+    CRYPTO_SW_SCHEDULER_N_STATS,
+} crypto_sw_scheduler_stat_t;
+
 typedef enum crypto_sw_scheduler_queue_type_t_
 {
   CRYPTO_SW_SCHED_QUEUE_TYPE_ENCRYPT = 0,
@@ -44,9 +65,16 @@ typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   crypto_sw_scheduler_queue_t queue[CRYPTO_SW_SCHED_QUEUE_N_TYPES];
-  u32 last_serve_lcore_id;
   u8 last_serve_encrypt;
   u8 last_return_queue;
+  /* frames claimed from another thread, processed one per dequeue call */
+  u8 n_stolen;
+  u8 next_stolen;
+  vnet_crypto_async_frame_t *stolen[CRYPTO_SW_SCHEDULER_STEAL_MAX];
+  /* counters */
+  u64 n_frames;
+  u64 n_frames_stolen;
+  u64 n_steals;
   vnet_crypto_op_t *crypto_ops;
   vnet_crypto_op_t *integ_ops;
   vnet_crypto_op_t *chained_crypto_ops;
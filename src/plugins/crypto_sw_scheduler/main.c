@@ -14,6 +14,7 @@
  */
 
 #include <vlib/vlib.h>
+#include <vlib/stats/stats.h>
 #include <vnet/plugin/plugin.h>
 #include <vpp/app/version.h>
 
@@ -446,131 +447,194 @@ crypto_sw_scheduler_process_aead (vlib_main_t *vm,
       return -1;
     }
 
-    static_always_inline vnet_crypto_async_frame_t *
-    crypto_sw_scheduler_dequeue (vlib_main_t *vm, u32 *nb_elts_processed,
-				 u32 *enqueue_thread_idx)
+static_always_inline u32
+crypto_sw_scheduler_queue_depth (crypto_sw_scheduler_queue_t *q)
+{
+  u32 depth = q->head - q->tail;
+
+  /* tail and head are not read atomically, stale reads can make no sense */
+  return depth > CRYPTO_SW_SCHEDULER_QUEUE_SIZE ? 0 : depth;
+}
+
+/* frames in the queue nobody has claimed yet */
+static_always_inline u32
+crypto_sw_scheduler_queue_pending (crypto_sw_scheduler_queue_t *q)
+{
+  u32 tail = q->tail, depth = crypto_sw_scheduler_queue_depth (q), n = 0;
+  vnet_crypto_async_frame_t *f;
+
+  for (u32 j = tail; j != tail + depth; j++)
     {
-      crypto_sw_scheduler_main_t *cm = &crypto_sw_scheduler_main;
-      crypto_sw_scheduler_per_thread_data_t *ptd =
-	cm->per_thread_data + vm->thread_index;
-      vnet_crypto_async_frame_t *f = 0;
-      crypto_sw_scheduler_queue_t *current_queue = 0;
-      u32 tail, head;
-      u8 found = 0;
+      f = q->jobs[j & CRYPTO_SW_SCHEDULER_QUEUE_MASK];
+      n += f && clib_atomic_load_relax_n (&f->state) ==
+		  VNET_CRYPTO_FRAME_STATE_PENDING;
+    }
 
-      /* get a pending frame to process */
-      if (ptd->self_crypto_enabled)
-	{
-	  u32 i = ptd->last_serve_lcore_id + 1;
+  return n;
+}
 
-	  while (1)
-	    {
-	      crypto_sw_scheduler_per_thread_data_t *st;
-	      u32 j;
+/* claim up to max_frames pending frames, oldest first */
+static_always_inline u32
+crypto_sw_scheduler_claim (crypto_sw_scheduler_queue_t *q,
+			   vnet_crypto_async_frame_t **frames, u32 max_frames)
+{
+  u32 tail = q->tail, depth = crypto_sw_scheduler_queue_depth (q), n = 0;
+  vnet_crypto_async_frame_t *f;
 
-	      if (i >= vec_len (cm->per_thread_data))
-		i = 0;
+  for (u32 j = tail; j != tail + depth && n < max_frames; j++)
+    {
+      f = q->jobs[j & CRYPTO_SW_SCHEDULER_QUEUE_MASK];
 
-	      st = cm->per_thread_data + i;
+      if (f && clib_atomic_bool_cmp_and_swap (
+		 &f->state, VNET_CRYPTO_FRAME_STATE_PENDING,
+		 VNET_CRYPTO_FRAME_STATE_WORK_IN_PROGRESS))
+	frames[n++] = f;
+    }
 
-	      if (ptd->last_serve_encrypt)
-		current_queue = &st->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_DECRYPT];
-	      else
-		current_queue = &st->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_ENCRYPT];
-
-	      tail = current_queue->tail;
-	      head = current_queue->head;
-
-	      /* Skip this queue unless tail < head or head has overflowed
-	       * and tail has not. At the point where tail overflows (== 0),
-	       * the largest possible value of head is (queue size - 1).
-	       * Prior to that, the largest possible value of head is
-	       * (queue size - 2).
-	       */
-	      if ((tail > head) && (head >= CRYPTO_SW_SCHEDULER_QUEUE_MASK))
-		goto skip_queue;
-
-	      for (j = tail; j != head; j++)
-		{
-
-		  f = current_queue->jobs[j & CRYPTO_SW_SCHEDULER_QUEUE_MASK];
-
-		  if (!f)
-		    continue;
-
-		  if (clib_atomic_bool_cmp_and_swap (
-			&f->state, VNET_CRYPTO_FRAME_STATE_PENDING,
-			VNET_CRYPTO_FRAME_STATE_WORK_IN_PROGRESS))
-		    {
-		      found = 1;
-		      break;
-		    }
-		}
-
-	    skip_queue:
-	      if (found || i == ptd->last_serve_lcore_id)
-		{
-		  CLIB_MEMORY_STORE_BARRIER ();
-		  ptd->last_serve_encrypt = !ptd->last_serve_encrypt;
-		  break;
-		}
-
-	      i++;
-	    }
+  return n;
+}
 
-	  ptd->last_serve_lcore_id = i;
-	}
+/*
+ * claim half of the pending frames of the most loaded queue of another
+ * thread. frames being processed or done but not yet returned still sit in
+ * the queue, they are not counted.
+ */
+static_always_inline u32
+crypto_sw_scheduler_steal (crypto_sw_scheduler_main_t *cm,
+			   crypto_sw_scheduler_per_thread_data_t *ptd)
+{
+  crypto_sw_scheduler_per_thread_data_t *st;
+  crypto_sw_scheduler_queue_t *q, *victim = 0;
+  u32 pending, max_pending = 0;
 
-      if (found)
-	{
-	  u32 crypto_op, auth_op_or_aad_len;
-	  u16 digest_len;
-	  u8 is_enc;
-	  int ret;
-
-	  ret = convert_async_crypto_id (
-	    f->op, &crypto_op, &auth_op_or_aad_len, &digest_len, &is_enc);
-
-	  if (ret == 1)
-	    crypto_sw_scheduler_process_aead (vm, ptd, f, crypto_op,
-					      auth_op_or_aad_len, digest_len);
-	  else if (ret == 0)
-	    crypto_sw_scheduler_process_link (vm, cm, ptd, f, crypto_op,
-					      auth_op_or_aad_len, digest_len,
-					      is_enc);
-
-	  *enqueue_thread_idx = f->enqueue_thread_index;
-	  *nb_elts_processed = f->n_elts;
-	}
+  vec_foreach (st, cm->per_thread_data)
+    {
+      if (st == ptd)
+	continue;
 
-      if (ptd->last_return_queue)
-	{
-	  current_queue = &ptd->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_DECRYPT];
-	  ptd->last_return_queue = 0;
-	}
-      else
+      for (int t = 0; t < CRYPTO_SW_SCHED_QUEUE_N_TYPES; t++)
 	{
-	  current_queue = &ptd->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_ENCRYPT];
-	  ptd->last_return_queue = 1;
+	  q = st->queue + t;
+	  pending = crypto_sw_scheduler_queue_pending (q);
+	  if (pending > max_pending)
+	    {
+	      max_pending = pending;
+	      victim = q;
+	    }
 	}
+    }
 
-      tail = current_queue->tail & CRYPTO_SW_SCHEDULER_QUEUE_MASK;
+  if (victim == 0)
+    return 0;
 
-      if (current_queue->jobs[tail] &&
-	  current_queue->jobs[tail]->state >= VNET_CRYPTO_FRAME_STATE_SUCCESS)
-	{
+  ptd->next_stolen = 0;
+  ptd->n_stolen = crypto_sw_scheduler_claim (
+    victim, ptd->stolen,
+    clib_clamp (max_pending / 2, 1, CRYPTO_SW_SCHEDULER_STEAL_MAX));
+
+  if (ptd->n_stolen)
+    {
+      ptd->n_steals++;
+      ptd->n_frames_stolen += ptd->n_stolen;
+    }
 
-	  CLIB_MEMORY_STORE_BARRIER ();
-	  current_queue->tail++;
-	  f = current_queue->jobs[tail];
-	  current_queue->jobs[tail] = 0;
+  return ptd->n_stolen;
+}
 
-	  return f;
-	}
+static_always_inline void
+crypto_sw_scheduler_process_frame (vlib_main_t *vm,
+				   crypto_sw_scheduler_main_t *cm,
+				   crypto_sw_scheduler_per_thread_data_t *ptd,
+				   vnet_crypto_async_frame_t *f)
+{
+  u32 crypto_op, auth_op_or_aad_len;
+  u16 digest_len;
+  u8 is_enc;
+  int ret;
+
+  ret = convert_async_crypto_id (f->op, &crypto_op, &auth_op_or_aad_len,
+				 &digest_len, &is_enc);
+
+  if (ret == 1)
+    crypto_sw_scheduler_process_aead (vm, ptd, f, crypto_op,
+				      auth_op_or_aad_len, digest_len);
+  else if (ret == 0)
+    crypto_sw_scheduler_process_link (vm, cm, ptd, f, crypto_op,
+				      auth_op_or_aad_len, digest_len, is_enc);
+
+  ptd->n_frames++;
+}
+
+static_always_inline vnet_crypto_async_frame_t *
+crypto_sw_scheduler_dequeue (vlib_main_t *vm, u32 *nb_elts_processed,
+			     u32 *enqueue_thread_idx)
+{
+  crypto_sw_scheduler_main_t *cm = &crypto_sw_scheduler_main;
+  crypto_sw_scheduler_per_thread_data_t *ptd =
+    cm->per_thread_data + vm->thread_index;
+  vnet_crypto_async_frame_t *f = 0;
+  crypto_sw_scheduler_queue_t *current_queue = 0;
+  u32 tail;
+
+  /*
+   * get a pending frame to process: frames left from the last steal first,
+   * even if crypto got disabled meanwhile, then own queues, which are hot
+   * in cache, and only when those are empty steal from the most loaded
+   * thread. frames are always returned in order by the thread which
+   * enqueued them, so stealing does not reorder packets of a SA.
+   */
+  if (ptd->next_stolen < ptd->n_stolen)
+    f = ptd->stolen[ptd->next_stolen++];
+  else if (ptd->self_crypto_enabled)
+    {
+      crypto_sw_scheduler_queue_type_t first, second;
+
+      first = ptd->last_serve_encrypt ? CRYPTO_SW_SCHED_QUEUE_TYPE_DECRYPT :
+					CRYPTO_SW_SCHED_QUEUE_TYPE_ENCRYPT;
+      second = first ^ 1;
+      ptd->last_serve_encrypt = !ptd->last_serve_encrypt;
+
+      if (crypto_sw_scheduler_claim (ptd->queue + first, &f, 1) == 0 &&
+	  crypto_sw_scheduler_claim (ptd->queue + second, &f, 1) == 0 &&
+	  crypto_sw_scheduler_steal (cm, ptd))
+	f = ptd->stolen[ptd->next_stolen++];
+    }
+
+  if (f)
+    {
+      crypto_sw_scheduler_process_frame (vm, cm, ptd, f);
+      *enqueue_thread_idx = f->enqueue_thread_index;
+      *nb_elts_processed = f->n_elts;
+    }
+
+  if (ptd->last_return_queue)
+    {
+      current_queue = &ptd->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_DECRYPT];
+      ptd->last_return_queue = 0;
+    }
+  else
+    {
+      current_queue = &ptd->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_ENCRYPT];
+      ptd->last_return_queue = 1;
+    }
+
+  tail = current_queue->tail & CRYPTO_SW_SCHEDULER_QUEUE_MASK;
 
-      return 0;
+  if (current_queue->jobs[tail] &&
+      current_queue->jobs[tail]->state >= VNET_CRYPTO_FRAME_STATE_SUCCESS)
+    {
+
+      CLIB_MEMORY_STORE_BARRIER ();
+      current_queue->tail++;
+      f = current_queue->jobs[tail];
+      current_queue->jobs[tail] = 0;
+
+      return f;
     }
 
+  return 0;
+}
+
 static clib_error_t *
 sw_scheduler_set_worker_crypto (vlib_main_t * vm, unformat_input_t * input,
 				vlib_cli_command_t * cmd)
@@ -644,13 +708,22 @@ sw_scheduler_show_workers (vlib_main_t * vm, unformat_input_t * input,
   crypto_sw_scheduler_main_t *cm = &crypto_sw_scheduler_main;
   u32 i;
 
-  vlib_cli_output (vm, "%-7s%-20s%-8s", "ID", "Name", "Crypto");
+  vlib_cli_output (vm, "%-7s%-20s%-8s%-10s%-10s%-12s%-12s%-10s", "ID",
+		   "Name", "Crypto", "Enc-depth", "Dec-depth", "Frames",
+		   "Stolen", "Steals");
   for (i = 1; i < vlib_thread_main.n_vlib_mains; i++)
     {
-      vlib_cli_output (vm, "%-7d%-20s%-8s", vlib_get_worker_index (i),
-		       (vlib_worker_threads + i)->name,
-		       cm->
-		       per_thread_data[i].self_crypto_enabled ? "on" : "off");
+      crypto_sw_scheduler_per_thread_data_t *ptd = cm->per_thread_data + i;
+
+      vlib_cli_output (
+	vm, "%-7d%-20s%-8s%-10u%-10u%-12lu%-12lu%-10lu",
+	vlib_get_worker_index (i), (vlib_worker_threads + i)->name,
+	ptd->self_crypto_enabled ? "on" : "off",
+	crypto_sw_scheduler_queue_depth (
+	  ptd->queue + CRYPTO_SW_SCHED_QUEUE_TYPE_ENCRYPT),
+	crypto_sw_scheduler_queue_depth (
+	  ptd->queue + CRYPTO_SW_SCHED_QUEUE_TYPE_DECRYPT),
+	ptd->n_frames, ptd->n_frames_stolen, ptd->n_steals);
     }
 
   return 0;
@@ -673,6 +746,60 @@ VLIB_CLI_COMMAND (cmd_show_sw_scheduler_workers, static) = {
 };
 /* *INDENT-ON* */
 
+static u64
+crypto_sw_scheduler_stat_get (crypto_sw_scheduler_per_thread_data_t *ptd,
+			      crypto_sw_scheduler_stat_t stat)
+{
+  switch (stat)
+    {
+    case CRYPTO_SW_SCHEDULER_STAT_FRAMES:
+      return ptd->n_frames;
+    case CRYPTO_SW_SCHEDULER_STAT_FRAMES_STOLEN:
+      return ptd->n_frames_stolen;
+    case CRYPTO_SW_SCHEDULER_STAT_STEALS:
+      return ptd->n_steals;
+    case CRYPTO_SW_SCHEDULER_STAT_ENCRYPT_DEPTH:
+      return crypto_sw_scheduler_queue_depth (
+	ptd->queue + CRYPTO_SW_SCHED_QUEUE_TYPE_ENCRYPT);
+    case CRYPTO_SW_SCHEDULER_STAT_DECRYPT_DEPTH:
+      return crypto_sw_scheduler_queue_depth (
+	ptd->queue + CRYPTO_SW_SCHED_QUEUE_TYPE_DECRYPT);
+    case CRYPTO_SW_SCHEDULER_N_STATS:
+      break;
+    }
+  return 0;
+}
+
+static void
+crypto_sw_scheduler_stats_collector_fn (vlib_stats_collector_data_t *d)
+{
+  crypto_sw_scheduler_main_t *cm = &crypto_sw_scheduler_main;
+  counter_t **counters = d->entry->data;
+  counter_t *cb = counters[0];
+  crypto_sw_scheduler_per_thread_data_t *ptd;
+
+  vec_foreach (ptd, cm->per_thread_data)
+    cb[ptd - cm->per_thread_data] =
+      crypto_sw_scheduler_stat_get (ptd, d->private_data);
+}
+
+static void
+crypto_sw_scheduler_stats_init (crypto_sw_scheduler_main_t *cm)
+{
+  vlib_stats_collector_reg_t r = {};
+
+  r.collect_fn = crypto_sw_scheduler_stats_collector_fn;
+
+#define _(sym, str)                                                           \
+  r.entry_index =                                                             \
+    vlib_stats_add_counter_vector ("/crypto_sw_scheduler/" str);              \
+  r.private_data = CRYPTO_SW_SCHEDULER_STAT_##sym;                            \
+  vlib_stats_validate (r.entry_index, 0, vec_len (cm->per_thread_data) - 1);  \
+  vlib_stats_register_collector_fn (&r);
+  foreach_crypto_sw_scheduler_stat
+#undef _
+}
+
 clib_error_t *
 sw_scheduler_cli_init (vlib_main_t * vm)
 {
@@ -724,6 +851,8 @@ crypto_sw_scheduler_init (vlib_main_t * vm)
 
   crypto_sw_scheduler_api_init (vm);
 
+  crypto_sw_scheduler_stats_init (cm);
+
   /* *INDENT-OFF* */
 #define _(n, s, k, t, a)                                                      \
   vnet_crypto_register_enqueue_handler (                                      \
@@ -0,0 +1,862 @@
+/*
+ * hqos.c - hierarchical QoS scheduler
+ *
+ * Copyright (c) 2024 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ * @brief Hierarchical QoS scheduler
+ */
+/*? %%clicmd:group_label Hierarchical QoS %% ?*/
+
+#include <vnet/vnet.h>
+#include <vnet/plugin/plugin.h>
+#include <vnet/feature/feature.h>
+#include <hqos/hqos.h>
+
+hqos_main_t hqos_main;
+
+/* 10ms worth of the rate, but at least a jumbo frame */
+static u32
+hqos_default_burst (u64 rate)
+{
+  return clib_max (rate / 8 / 100, 9216);
+}
+
+static hqos_port_t *
+hqos_port_get_by_sw_if_index (u32 sw_if_index)
+{
+  hqos_main_t *hm = &hqos_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  vnet_hw_interface_t *hw;
+  u32 port_index;
+
+  if (!vnet_sw_interface_is_valid (vnm, sw_if_index))
+    return 0;
+
+  hw = vnet_get_sup_hw_interface (vnm, sw_if_index);
+  if (!hw)
+    return 0;
+
+  if (hw->hw_if_index >= vec_len (hm->port_by_hw_if_index))
+    return 0;
+
+  port_index = hm->port_by_hw_if_index[hw->hw_if_index];
+  if (port_index == ~0)
+    return 0;
+
+  return pool_elt_at_index (hm->ports, port_index);
+}
+
+static void
+hqos_timer_stop (hqos_port_t *port, u32 *handle)
+{
+  hqos_main_t *hm = &hqos_main;
+  hqos_per_thread_data_t *ptd;
+
+  if (*handle == ~0)
+    return;
+
+  ptd = vec_elt_at_index (hm->per_thread_data, port->thread_index);
+  tw_timer_stop_2t_2w_512sl (&ptd->wheel, *handle);
+  *handle = ~0;
+}
+
+/* Remove a subport from its port's active list */
+static void
+hqos_port_unlink_subport (hqos_port_t *port, u32 sp_index)
+{
+  hqos_main_t *hm = &hqos_main;
+  hqos_subport_t *sp, *prev = 0;
+  u32 index = port->active_head;
+
+  while (index != sp_index)
+    {
+      prev = pool_elt_at_index (hm->subports, index);
+      index = prev->next_active;
+    }
+
+  sp = pool_elt_at_index (hm->subports, sp_index);
+  if (prev)
+    prev->next_active = sp->next_active;
+  else
+    port->active_head = sp->next_active;
+  if (port->active_tail == sp_index)
+    port->active_tail = prev ? prev - hm->subports : ~0;
+  sp->next_active = ~0;
+}
+
+/* Remove a pipe from its subport's active list */
+static void
+hqos_subport_unlink_pipe (hqos_subport_t *sp, u32 pipe_index)
+{
+  hqos_main_t *hm = &hqos_main;
+  hqos_pipe_t *pipe, *prev = 0;
+  u32 index = sp->active_head;
+
+  while (index != pipe_index)
+    {
+      prev = pool_elt_at_index (hm->pipes, index);
+      index = prev->next_active;
+    }
+
+  pipe = pool_elt_at_index (hm->pipes, pipe_index);
+  if (prev)
+    prev->next_active = pipe->next_active;
+  else
+    sp->active_head = pipe->next_active;
+  if (sp->active_tail == pipe_index)
+    sp->active_tail = prev ? prev - hm->pipes : ~0;
+  pipe->next_active = ~0;
+}
+
+int
+hqos_port_add_del (u32 sw_if_index, u64 rate, u32 burst, u32 queue_size,
+		   u32 worker_index, int is_add)
+{
+  hqos_main_t *hm = &hqos_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  hqos_per_thread_data_t *ptd;
+  vnet_sw_interface_t *sw;
+  hqos_port_t *port;
+  u32 port_index, thread_index, i;
+
+  if (!vnet_sw_interface_is_valid (vnm, sw_if_index))
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  /* Not a physical port? */
+  sw = vnet_get_sw_interface (vnm, sw_if_index);
+  if (sw->type != VNET_SW_INTERFACE_TYPE_HARDWARE)
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  port = hqos_port_get_by_sw_if_index (sw_if_index);
+
+  if (!is_add)
+    {
+      if (!port)
+	return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+      while (vec_len (port->subports))
+	hqos_subport_del (port->subports[0]);
+      vec_free (port->subports);
+
+      port_index = port - hm->ports;
+      ptd = vec_elt_at_index (hm->per_thread_data, port->thread_index);
+      i = vec_search (ptd->ports, port_index);
+      vec_del1 (ptd->ports, i);
+      if (vec_len (ptd->ports) == 0)
+	vlib_node_set_state (vlib_get_main_by_index (port->thread_index),
+			     hqos_dequeue_node.index,
+			     VLIB_NODE_STATE_DISABLED);
+
+      hm->port_by_hw_if_index[sw->hw_if_index] = ~0;
+      pool_put (hm->ports, port);
+      return 0;
+    }
+
+  if (port)
+    return VNET_API_ERROR_VALUE_EXIST;
+
+  if (queue_size == 0)
+    queue_size = HQOS_DEFAULT_QUEUE_SIZE;
+  if (!is_pow2 (queue_size) || queue_size > HQOS_MAX_QUEUE_SIZE)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  if (worker_index != ~0 && worker_index >= vlib_num_workers ())
+    return VNET_API_ERROR_INVALID_WORKER;
+
+  pool_get_zero (hm->ports, port);
+  port_index = port - hm->ports;
+
+  /* spread the ports over the workers unless told otherwise */
+  if (worker_index != ~0)
+    thread_index = vlib_get_worker_thread_index (worker_index);
+  else if (vlib_num_workers ())
+    thread_index = vlib_get_worker_thread_index (port_index %
+						 vlib_num_workers ());
+  else
+    thread_index = 0;
+
+  hqos_tb_init (&port->tb, rate, burst ? burst : hqos_default_burst (rate),
+		vlib_time_now (vlib_get_main ()));
+  port->sw_if_index = sw_if_index;
+  port->thread_index = thread_index;
+  port->queue_size = queue_size;
+  port->active_head = port->active_tail = ~0;
+  for (i = 0; i < ARRAY_LEN (port->tc_queue_by_qos); i++)
+    port->tc_queue_by_qos[i] = (HQOS_N_TC - 1) << 4;
+
+  vec_validate_init_empty (hm->port_by_hw_if_index, sw->hw_if_index, ~0);
+  hm->port_by_hw_if_index[sw->hw_if_index] = port_index;
+
+  ptd = vec_elt_at_index (hm->per_thread_data, thread_index);
+  if (!ptd->wheel.timers)
+    tw_timer_wheel_init_2t_2w_512sl (&ptd->wheel, 0 /* no callback */,
+				     HQOS_TIMER_TICK, 1024);
+  vec_add1 (ptd->ports, port_index);
+  if (vec_len (ptd->ports) == 1)
+    vlib_node_set_state (vlib_get_main_by_index (thread_index),
+			 hqos_dequeue_node.index, VLIB_NODE_STATE_POLLING);
+
+  return 0;
+}
+
+int
+hqos_port_set_tc_map (u32 sw_if_index, u8 qos_bits, u8 tc, u8 queue)
+{
+  hqos_port_t *port;
+
+  port = hqos_port_get_by_sw_if_index (sw_if_index);
+  if (!port)
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  if (tc >= HQOS_N_TC || queue >= HQOS_N_QUEUES_PER_TC)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  port->tc_queue_by_qos[qos_bits] = tc << 4 | queue;
+  return 0;
+}
+
+int
+hqos_subport_add (u32 port_sw_if_index, u64 rate, u32 burst,
+		  u32 *subport_index)
+{
+  hqos_main_t *hm = &hqos_main;
+  hqos_subport_t *sp;
+  hqos_port_t *port;
+
+  port = hqos_port_get_by_sw_if_index (port_sw_if_index);
+  if (!port || port->sw_if_index != port_sw_if_index)
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  pool_get_zero (hm->subports, sp);
+  hqos_tb_init (&sp->tb, rate, burst ? burst : hqos_default_burst (rate),
+		vlib_time_now (vlib_get_main ()));
+  sp->port_index = port - hm->ports;
+  sp->active_head = sp->active_tail = ~0;
+  sp->next_active = ~0;
+  sp->timer_handle = ~0;
+  sp->state = HQOS_SCHED_IDLE;
+
+  *subport_index = sp - hm->subports;
+  vec_add1 (port->subports, *subport_index);
+
+  return 0;
+}
+
+int
+hqos_subport_del (u32 subport_index)
+{
+  hqos_main_t *hm = &hqos_main;
+  hqos_subport_t *sp;
+  hqos_port_t *port;
+  u32 i;
+
+  if (pool_is_free_index (hm->subports, subport_index))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  sp = pool_elt_at_index (hm->subports, subport_index);
+  port = pool_elt_at_index (hm->ports, sp->port_index);
+
+  while (vec_len (sp->pipes))
+    hqos_pipe_del (sp->pipes[0]);
+  vec_free (sp->pipes);
+
+  if (sp->state == HQOS_SCHED_ACTIVE)
+    hqos_port_unlink_subport (port, subport_index);
+  hqos_timer_stop (port, &sp->timer_handle);
+
+  i = vec_search (port->subports, subport_index);
+  vec_del1 (port->subports, i);
+  pool_put (hm->subports, sp);
+
+  return 0;
+}
+
+int
+hqos_pipe_profile_add (u64 rate, u32 burst,
+		       const u8 weights[HQOS_N_QUEUES_PER_TC],
+		       u32 *profile_index)
+{
+  hqos_main_t *hm = &hqos_main;
+  hqos_pipe_profile_t *profile;
+  int i;
+
+  pool_get_zero (hm->profiles, profile);
+  profile->rate = rate;
+  profile->burst = burst ? burst : hqos_default_burst (rate);
+  for (i = 0; i < HQOS_N_QUEUES_PER_TC; i++)
+    profile->wrr_quantum[i] =
+      clib_max (weights[i], 1) * HQOS_WRR_BYTES_PER_WEIGHT;
+
+  *profile_index = profile - hm->profiles;
+  return 0;
+}
+
+int
+hqos_pipe_profile_del (u32 profile_index)
+{
+  hqos_main_t *hm = &hqos_main;
+  hqos_pipe_profile_t *profile;
+
+  if (pool_is_free_index (hm->profiles, profile_index))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  profile = pool_elt_at_index (hm->profiles, profile_index);
+  if (profile->n_pipes)
+    return VNET_API_ERROR_INSTANCE_IN_USE;
+
+  pool_put (hm->profiles, profile);
+  return 0;
+}
+
+int
+hqos_pipe_add (u32 subport_index, u32 profile_index, u32 sw_if_index,
+	       u32 *pipe_index)
+{
+  hqos_main_t *hm = &hqos_main;
+  hqos_pipe_profile_t *profile;
+  hqos_subport_t *sp;
+  hqos_pipe_t *pipe;
+  u32 i;
+
+  if (pool_is_free_index (hm->subports, subport_index))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+  if (pool_is_free_index (hm->profiles, profile_index))
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  sp = pool_elt_at_index (hm->subports, subport_index);
+
+  /* The interface has to be output on the subport's port */
+  if (hqos_port_get_by_sw_if_index (sw_if_index) !=
+      pool_elt_at_index (hm->ports, sp->port_index))
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  if (sw_if_index < vec_len (hm->pipe_by_sw_if_index) &&
+      hm->pipe_by_sw_if_index[sw_if_index] != ~0)
+    return VNET_API_ERROR_VALUE_EXIST;
+
+  profile = pool_elt_at_index (hm->profiles, profile_index);
+
+  pool_get_zero (hm->pipes, pipe);
+  hqos_tb_init (&pipe->tb, profile->rate, profile->burst,
+		vlib_time_now (vlib_get_main ()));
+  pipe->port_index = sp->port_index;
+  pipe->subport_index = subport_index;
+  pipe->profile_index = profile_index;
+  pipe->sw_if_index = sw_if_index;
+  pipe->next_active = ~0;
+  pipe->timer_handle = ~0;
+  pipe->state = HQOS_SCHED_IDLE;
+  profile->n_pipes++;
+
+  *pipe_index = pipe - hm->pipes;
+  vec_add1 (sp->pipes, *pipe_index);
+
+  for (i = 0; i < HQOS_N_COUNTER; i++)
+    {
+      vlib_validate_combined_counter (&hm->counters[i],
+				      (*pipe_index + 1) * HQOS_N_TC - 1);
+      for (u32 tc = 0; tc < HQOS_N_TC; tc++)
+	vlib_zero_combined_counter (&hm->counters[i],
+				    *pipe_index * HQOS_N_TC + tc);
+    }
+
+  vec_validate_init_empty (hm->pipe_by_sw_if_index, sw_if_index, ~0);
+  hm->pipe_by_sw_if_index[sw_if_index] = *pipe_index;
+
+  vnet_feature_enable_disable ("interface-output", "hqos-enqueue",
+			       sw_if_index, 1, 0, 0);
+
+  return 0;
+}
+
+int
+hqos_pipe_del (u32 pipe_index)
+{
+  hqos_main_t *hm = &hqos_main;
+  hqos_subport_t *sp;
+  hqos_port_t *port;
+  hqos_pipe_t *pipe;
+  hqos_queue_t *q;
+  u32 i, j, k;
+
+  if (pool_is_free_index (hm->pipes, pipe_index))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  pipe = pool_elt_at_index (hm->pipes, pipe_index);
+  sp = pool_elt_at_index (hm->subports, pipe->subport_index);
+  port = pool_elt_at_index (hm->ports, pipe->port_index);
+
+  vnet_feature_enable_disable ("interface-output", "hqos-enqueue",
+			       pipe->sw_if_index, 0, 0, 0);
+  hm->pipe_by_sw_if_index[pipe->sw_if_index] = ~0;
+
+  if (pipe->state == HQOS_SCHED_ACTIVE)
+    hqos_subport_unlink_pipe (sp, pipe_index);
+  hqos_timer_stop (port, &pipe->timer_handle);
+
+  /* a subport only stays on the active list with active pipes */
+  if (sp->state == HQOS_SCHED_ACTIVE && sp->active_head == ~0)
+    {
+      hqos_port_unlink_subport (port, pipe->subport_index);
+      sp->state = HQOS_SCHED_IDLE;
+    }
+
+  for (i = 0; i < HQOS_N_TC; i++)
+    for (j = 0; j < HQOS_N_QUEUES_PER_TC; j++)
+      {
+	q = &pipe->queues[i][j];
+	for (k = 0; k < q->n_entries; k++)
+	  vlib_buffer_free_one (
+	    vlib_get_main (),
+	    q->entries[(q->head + k) & (port->queue_size - 1)].buffer_index);
+	vec_free (q->entries);
+      }
+
+  pool_elt_at_index (hm->profiles, pipe->profile_index)->n_pipes--;
+
+  i = vec_search (sp->pipes, pipe_index);
+  vec_del1 (sp->pipes, i);
+  pool_put (hm->pipes, pipe);
+
+  return 0;
+}
+
+static u8 *
+format_hqos_sched_state (u8 *s, va_list *args)
+{
+  hqos_sched_state_t state = va_arg (*args, int);
+
+  switch (state)
+    {
+    case HQOS_SCHED_IDLE:
+      return format (s, "idle");
+    case HQOS_SCHED_ACTIVE:
+      return format (s, "active");
+    case HQOS_SCHED_WAITING:
+      return format (s, "waiting");
+    }
+  return format (s, "unknown");
+}
+
+static u8 *
+format_hqos_token_bucket (u8 *s, va_list *args)
+{
+  hqos_token_bucket_t *tb = va_arg (*args, hqos_token_bucket_t *);
+
+  if (tb->rate == 0)
+    return format (s, "unshaped");
+
+  return format (s, "rate %.0f bps burst %.0f tokens %.0f", tb->rate * 8,
+		 tb->burst, tb->tokens);
+}
+
+static u8 *
+format_hqos_pipe (u8 *s, va_list *args)
+{
+  hqos_main_t *hm = &hqos_main;
+  hqos_pipe_t *pipe = va_arg (*args, hqos_pipe_t *);
+  u32 pipe_index = pipe - hm->pipes;
+  vlib_counter_t tx, drop;
+  u32 tc;
+
+  s = format (s, "pipe %d: %U profile %d, %U, %U, %d buffered", pipe_index,
+	      format_vnet_sw_if_index_name, vnet_get_main (),
+	      pipe->sw_if_index, pipe->profile_index, format_hqos_token_bucket,
+	      &pipe->tb, format_hqos_sched_state, pipe->state,
+	      pipe->n_entries);
+
+  for (tc = 0; tc < HQOS_N_TC; tc++)
+    {
+      vlib_get_combined_counter (&hm->counters[HQOS_COUNTER_TX],
+				 pipe_index * HQOS_N_TC + tc, &tx);
+      vlib_get_combined_counter (&hm->counters[HQOS_COUNTER_DROP],
+				 pipe_index * HQOS_N_TC + tc, &drop);
+      if (tx.packets || drop.packets)
+	s = format (s, "\n      tc %d: tx %lld packets %lld bytes, "
+		       "drop %lld packets %lld bytes",
+		    tc, tx.packets, tx.bytes, drop.packets, drop.bytes);
+    }
+
+  return s;
+}
+
+static clib_error_t *
+hqos_port_command_fn (vlib_main_t *vm, unformat_input_t *input,
+		      vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  u32 sw_if_index = ~0, burst = 0, queue_size = 0, worker_index = ~0;
+  clib_error_t *error = 0;
+  u64 rate = 0;
+  int is_add = 1;
+  int rv;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U", unformat_vnet_sw_interface,
+		    vnet_get_main (), &sw_if_index))
+	;
+      else if (unformat (line_input, "rate %llu", &rate))
+	;
+      else if (unformat (line_input, "burst %u", &burst))
+	;
+      else if (unformat (line_input, "queue-size %u", &queue_size))
+	;
+      else if (unformat (line_input, "worker %u", &worker_index))
+	;
+      else if (unformat (line_input, "del"))
+	is_add = 0;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (sw_if_index == ~0)
+    {
+      error = clib_error_return (0, "Please specify an interface");
+      goto done;
+    }
+
+  rv = hqos_port_add_del (sw_if_index, rate, burst, queue_size, worker_index,
+			  is_add);
+  if (rv)
+    error = clib_error_return (0, "hqos port failed: %U", format_vnet_api_errno,
+			       rv);
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Shape and schedule the traffic output on a physical interface. A rate
+ * of 0 (bits per second) does not shape. The port is scheduled on one
+ * worker; packets output on the other workers are handed off to it.
+ *
+ * @cliexpar
+ * @cliexcmd{hqos port GigabitEthernet2/0/0 rate 1000000000 queue-size 128}
+?*/
+VLIB_CLI_COMMAND (hqos_port_command, static) = {
+  .path = "hqos port",
+  .short_help = "hqos port <interface> [rate <bps>] [burst <bytes>] "
+		"[queue-size <n>] [worker <n>] [del]",
+  .function = hqos_port_command_fn,
+};
+
+static clib_error_t *
+hqos_tc_map_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			vlib_cli_command_t *cmd)
+{
+  u32 sw_if_index = ~0, qos = ~0, tc = ~0, queue = 0;
+  int rv;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "%U", unformat_vnet_sw_interface, vnet_get_main (),
+		    &sw_if_index))
+	;
+      else if (unformat (input, "qos %u", &qos))
+	;
+      else if (unformat (input, "tc %u", &tc))
+	;
+      else if (unformat (input, "queue %u", &queue))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (sw_if_index == ~0 || qos > 255 || tc == ~0)
+    return clib_error_return (0, "Please specify interface, qos and tc");
+
+  rv = hqos_port_set_tc_map (sw_if_index, qos, tc, queue);
+  if (rv)
+    return clib_error_return (0, "hqos tc-map failed: %U",
+			      format_vnet_api_errno, rv);
+
+  return 0;
+}
+
+/*?
+ * Map the QoS bits recorded on a packet (see "qos record") to a traffic
+ * class and queue of the port. TC 0 has the highest priority. Packets
+ * without recorded QoS bits use the last traffic class.
+ *
+ * @cliexpar
+ * @cliexcmd{hqos tc-map GigabitEthernet2/0/0 qos 46 tc 0 queue 0}
+?*/
+VLIB_CLI_COMMAND (hqos_tc_map_command, static) = {
+  .path = "hqos tc-map",
+  .short_help = "hqos tc-map <interface> qos <bits> tc <tc> [queue <queue>]",
+  .function = hqos_tc_map_command_fn,
+};
+
+static clib_error_t *
+hqos_subport_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			 vlib_cli_command_t *cmd)
+{
+  u32 sw_if_index = ~0, burst = 0, subport_index = ~0;
+  u64 rate = 0;
+  int is_add = -1;
+  int rv;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "add"))
+	is_add = 1;
+      else if (unformat (input, "del %u", &subport_index))
+	is_add = 0;
+      else if (unformat (input, "port %U", unformat_vnet_sw_interface,
+			 vnet_get_main (), &sw_if_index))
+	;
+      else if (unformat (input, "rate %llu", &rate))
+	;
+      else if (unformat (input, "burst %u", &burst))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (is_add == 1)
+    {
+      if (sw_if_index == ~0)
+	return clib_error_return (0, "Please specify the port");
+      rv = hqos_subport_add (sw_if_index, rate, burst, &subport_index);
+      if (!rv)
+	vlib_cli_output (vm, "%d", subport_index);
+    }
+  else if (is_add == 0)
+    rv = hqos_subport_del (subport_index);
+  else
+    return clib_error_return (0, "Please specify add or del");
+
+  if (rv)
+    return clib_error_return (0, "hqos subport failed: %U",
+			      format_vnet_api_errno, rv);
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (hqos_subport_command, static) = {
+  .path = "hqos subport",
+  .short_help = "hqos subport [add port <interface> [rate <bps>] "
+		"[burst <bytes>] | del <index>]",
+  .function = hqos_subport_command_fn,
+};
+
+static clib_error_t *
+hqos_pipe_profile_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			      vlib_cli_command_t *cmd)
+{
+  u8 weights[HQOS_N_QUEUES_PER_TC] = { 1, 1, 1, 1 };
+  u32 burst = 0, profile_index = ~0;
+  u32 w0, w1, w2, w3;
+  u64 rate = 0;
+  int is_add = -1;
+  int rv;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "add"))
+	is_add = 1;
+      else if (unformat (input, "del %u", &profile_index))
+	is_add = 0;
+      else if (unformat (input, "rate %llu", &rate))
+	;
+      else if (unformat (input, "burst %u", &burst))
+	;
+      else if (unformat (input, "weights %u %u %u %u", &w0, &w1, &w2, &w3))
+	{
+	  weights[0] = clib_min (w0, 255);
+	  weights[1] = clib_min (w1, 255);
+	  weights[2] = clib_min (w2, 255);
+	  weights[3] = clib_min (w3, 255);
+	}
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (is_add == 1)
+    {
+      rv = hqos_pipe_profile_add (rate, burst, weights, &profile_index);
+      if (!rv)
+	vlib_cli_output (vm, "%d", profile_index);
+    }
+  else if (is_add == 0)
+    rv = hqos_pipe_profile_del (profile_index);
+  else
+    return clib_error_return (0, "Please specify add or del");
+
+  if (rv)
+    return clib_error_return (0, "hqos pipe-profile failed: %U",
+			      format_vnet_api_errno, rv);
+
+  return 0;
+}
+
+/*?
+ * A pipe profile holds the shaping rate and the weights of the queues
+ * within each traffic class, shared by the pipes using it.
+ *
+ * @cliexpar
+ * @cliexcmd{hqos pipe-profile add rate 20000000 weights 4 2 1 1}
+?*/
+VLIB_CLI_COMMAND (hqos_pipe_profile_command, static) = {
+  .path = "hqos pipe-profile",
+  .short_help = "hqos pipe-profile [add [rate <bps>] [burst <bytes>] "
+		"[weights <w0> <w1> <w2> <w3>] | del <index>]",
+  .function = hqos_pipe_profile_command_fn,
+};
+
+static clib_error_t *
+hqos_pipe_command_fn (vlib_main_t *vm, unformat_input_t *input,
+		      vlib_cli_command_t *cmd)
+{
+  u32 sw_if_index = ~0, subport_index = ~0, profile_index = ~0;
+  u32 pipe_index = ~0;
+  int is_add = -1;
+  int rv;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "add"))
+	is_add = 1;
+      else if (unformat (input, "del %u", &pipe_index))
+	is_add = 0;
+      else if (unformat (input, "subport %u", &subport_index))
+	;
+      else if (unformat (input, "profile %u", &profile_index))
+	;
+      else if (unformat (input, "%U", unformat_vnet_sw_interface,
+			 vnet_get_main (), &sw_if_index))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (is_add == 1)
+    {
+      if (sw_if_index == ~0)
+	return clib_error_return (0, "Please specify an interface");
+      rv = hqos_pipe_add (subport_index, profile_index, sw_if_index,
+			  &pipe_index);
+      if (!rv)
+	vlib_cli_output (vm, "%d", pipe_index);
+    }
+  else if (is_add == 0)
+    rv = hqos_pipe_del (pipe_index);
+  else
+    return clib_error_return (0, "Please specify add or del");
+
+  if (rv)
+    return clib_error_return (0, "hqos pipe failed: %U",
+			      format_vnet_api_errno, rv);
+
+  return 0;
+}
+
+/*?
+ * Schedule the packets output on an interface, typically a subscriber's
+ * sub-interface, in a pipe of a subport.
+ *
+ * @cliexpar
+ * @cliexcmd{hqos pipe add subport 0 profile 0 GigabitEthernet2/0/0.100}
+?*/
+VLIB_CLI_COMMAND (hqos_pipe_command, static) = {
+  .path = "hqos pipe",
+  .short_help = "hqos pipe [add subport <index> profile <index> <interface> "
+		"| del <index>]",
+  .function = hqos_pipe_command_fn,
+};
+
+static clib_error_t *
+show_hqos_command_fn (vlib_main_t *vm, unformat_input_t *input,
+		      vlib_cli_command_t *cmd)
+{
+  hqos_main_t *hm = &hqos_main;
+  hqos_port_t *port;
+  int verbose = 0;
+  u32 *spi, *pi;
+
+  if (unformat (input, "verbose"))
+    verbose = 1;
+
+  pool_foreach (port, hm->ports)
+    {
+      vlib_cli_output (vm, "port %U: %U, thread %d, queue-size %d",
+		       format_vnet_sw_if_index_name, vnet_get_main (),
+		       port->sw_if_index, format_hqos_token_bucket, &port->tb,
+		       port->thread_index, port->queue_size);
+      vec_foreach (spi, port->subports)
+	{
+	  hqos_subport_t *sp = pool_elt_at_index (hm->subports, spi[0]);
+
+	  vlib_cli_output (vm, "  subport %d: %U, %U, %d pipes", spi[0],
+			   format_hqos_token_bucket, &sp->tb,
+			   format_hqos_sched_state, sp->state,
+			   vec_len (sp->pipes));
+	  if (!verbose)
+	    continue;
+	  vec_foreach (pi, sp->pipes)
+	    vlib_cli_output (vm, "    %U", format_hqos_pipe,
+			     pool_elt_at_index (hm->pipes, pi[0]));
+	}
+    }
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (show_hqos_command, static) = {
+  .path = "show hqos",
+  .short_help = "show hqos [verbose]",
+  .function = show_hqos_command_fn,
+};
+
+static clib_error_t *
+hqos_init (vlib_main_t *vm)
+{
+  hqos_main_t *hm = &hqos_main;
+
+  hm->fq_index = vlib_frame_queue_main_init (hqos_enqueue_node.index, 0);
+  vec_validate (hm->per_thread_data, vlib_get_n_threads () - 1);
+
+  hm->counters[HQOS_COUNTER_TX].name = "hqos-tx";
+  hm->counters[HQOS_COUNTER_TX].stat_segment_name = "/hqos/tx";
+  hm->counters[HQOS_COUNTER_DROP].name = "hqos-drop";
+  hm->counters[HQOS_COUNTER_DROP].stat_segment_name = "/hqos/drop";
+
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (hqos_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
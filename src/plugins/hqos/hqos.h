@@ -0,0 +1,255 @@
+/*
+ * hqos.h - hierarchical QoS scheduler
+ *
+ * Copyright (c) 2024 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __included_hqos_h__
+#define __included_hqos_h__
+
+#include <vnet/vnet.h>
+#include <vppinfra/tw_timer_2t_2w_512sl.h>
+
+/*
+ * The scheduler hierarchy is port -> subport -> pipe -> traffic class ->
+ * queue.
+ *
+ * A port is a hardware interface. Its scheduler runs on one thread; packets
+ * output on other threads are handed off to it through a frame queue, so
+ * the scheduler state itself is never shared.
+ *
+ * Ports, subports and pipes each shape with a token bucket. A pipe is
+ * typically a subscriber and is bound to a (sub-)interface; a pipe profile
+ * holds the rate and weights shared by many pipes. Within a pipe the
+ * traffic classes are served in strict priority, TC 0 first, and the
+ * queues of a traffic class by deficit weighted round robin.
+ *
+ * Only backlogged entities with tokens are on the active lists. A pipe or
+ * subport that runs out of tokens is parked on the thread's timer wheel
+ * until it has some again, so the cost of a dequeue does not depend on the
+ * number of idle or shaped subscribers.
+ */
+
+#define HQOS_N_TC		   4
+#define HQOS_N_QUEUES_PER_TC	   4
+#define HQOS_DEFAULT_QUEUE_SIZE	   64
+#define HQOS_MAX_QUEUE_SIZE	   (1 << 15)
+#define HQOS_WRR_BYTES_PER_WEIGHT  2048
+#define HQOS_PIPE_BURST		   4  /**< packets dequeued per pipe visit */
+#define HQOS_TIMER_TICK		   10e-6
+#define HQOS_TIMER_MAX_TICKS	   ((TW_SLOTS_PER_RING * TW_SLOTS_PER_RING) - 1)
+
+/* timer ids, per scheduled object */
+#define HQOS_TIMER_PIPE	   0
+#define HQOS_TIMER_SUBPORT 1
+
+/* Bytes per second; a rate of 0 is not shaped */
+typedef struct
+{
+  f64 tokens;
+  f64 rate;
+  f64 burst;
+  f64 last_update;
+} hqos_token_bucket_t;
+
+typedef enum
+{
+  HQOS_SCHED_IDLE,    /**< no backlog, on no list */
+  HQOS_SCHED_ACTIVE,  /**< backlog and tokens, on its parent's active list */
+  HQOS_SCHED_WAITING, /**< backlog but no tokens, on the timer wheel */
+} hqos_sched_state_t;
+
+typedef struct
+{
+  u32 buffer_index;
+  u32 length;
+} hqos_queue_entry_t;
+
+typedef struct
+{
+  /* ring of port queue_size entries, allocated on first use */
+  hqos_queue_entry_t *entries;
+  u16 head;
+  u16 n_entries;
+  i32 deficit;
+} hqos_queue_t;
+
+typedef struct
+{
+  f64 rate;
+  f64 burst;
+  u32 wrr_quantum[HQOS_N_QUEUES_PER_TC];
+  u32 n_pipes;
+} hqos_pipe_profile_t;
+
+typedef struct
+{
+  hqos_token_bucket_t tb;
+  u32 port_index;
+  u32 subport_index;
+  u32 profile_index;
+  u32 sw_if_index;
+
+  /* next pipe on the subport's active list */
+  u32 next_active;
+  u32 timer_handle;
+  u32 n_entries;
+
+  u8 state;
+  /* traffic classes with a backlog */
+  u8 tc_mask;
+  u8 wrr_pos[HQOS_N_TC];
+
+  hqos_queue_t queues[HQOS_N_TC][HQOS_N_QUEUES_PER_TC];
+} hqos_pipe_t;
+
+typedef struct
+{
+  hqos_token_bucket_t tb;
+  u32 port_index;
+
+  /* active pipes */
+  u32 active_head;
+  u32 active_tail;
+
+  /* next subport on the port's active list */
+  u32 next_active;
+  u32 timer_handle;
+  u8 state;
+
+  u32 *pipes;
+} hqos_subport_t;
+
+typedef struct
+{
+  hqos_token_bucket_t tb;
+  u32 sw_if_index;
+  u32 thread_index;
+  u32 queue_size;
+
+  /* active subports */
+  u32 active_head;
+  u32 active_tail;
+
+  /* (tc << 4 | queue) by the qos bits recorded on the buffer */
+  u8 tc_queue_by_qos[256];
+
+  u32 *subports;
+} hqos_port_t;
+
+typedef struct
+{
+  TWT (tw_timer_wheel) wheel;
+  u32 *expired;
+
+  /* ports scheduled on this thread */
+  u32 *ports;
+
+  /* the port the next dequeue starts from, so all get a turn first */
+  u32 next_port;
+} hqos_per_thread_data_t;
+
+typedef enum
+{
+  HQOS_COUNTER_TX,
+  HQOS_COUNTER_DROP,
+  HQOS_N_COUNTER,
+} hqos_counter_t;
+
+typedef struct
+{
+  hqos_port_t *ports;
+  hqos_subport_t *subports;
+  hqos_pipe_t *pipes;
+  hqos_pipe_profile_t *profiles;
+
+  u32 *port_by_hw_if_index;
+  u32 *pipe_by_sw_if_index;
+
+  hqos_per_thread_data_t *per_thread_data;
+
+  /* frame queue for the handoff to the port's thread */
+  u32 fq_index;
+
+  /* per pipe and traffic class, pipe_index * HQOS_N_TC + tc */
+  vlib_combined_counter_main_t counters[HQOS_N_COUNTER];
+
+  /* API message ID base */
+  u16 msg_id_base;
+} hqos_main_t;
+
+extern hqos_main_t hqos_main;
+
+extern vlib_node_registration_t hqos_enqueue_node;
+extern vlib_node_registration_t hqos_dequeue_node;
+
+int hqos_port_add_del (u32 sw_if_index, u64 rate, u32 burst, u32 queue_size,
+		       u32 worker_index, int is_add);
+int hqos_port_set_tc_map (u32 sw_if_index, u8 qos_bits, u8 tc, u8 queue);
+int hqos_subport_add (u32 port_sw_if_index, u64 rate, u32 burst,
+		      u32 *subport_index);
+int hqos_subport_del (u32 subport_index);
+int hqos_pipe_profile_add (u64 rate, u32 burst,
+			   const u8 weights[HQOS_N_QUEUES_PER_TC],
+			   u32 *profile_index);
+int hqos_pipe_profile_del (u32 profile_index);
+int hqos_pipe_add (u32 subport_index, u32 profile_index, u32 sw_if_index,
+		   u32 *pipe_index);
+int hqos_pipe_del (u32 pipe_index);
+
+static_always_inline void
+hqos_tb_init (hqos_token_bucket_t *tb, u64 rate, u32 burst, f64 now)
+{
+  tb->rate = rate / 8.0;
+  tb->burst = burst;
+  tb->tokens = burst;
+  tb->last_update = now;
+}
+
+static_always_inline void
+hqos_tb_update (hqos_token_bucket_t *tb, f64 now)
+{
+  tb->tokens += (now - tb->last_update) * tb->rate;
+  if (tb->tokens > tb->burst)
+    tb->tokens = tb->burst;
+  tb->last_update = now;
+}
+
+/* A bucket may go into debt by one packet, it conforms while positive */
+static_always_inline int
+hqos_tb_conforms (hqos_token_bucket_t *tb)
+{
+  return tb->rate == 0 || tb->tokens > 0;
+}
+
+/* Timer ticks until a bucket in debt conforms again */
+static_always_inline u32
+hqos_tb_wait_ticks (hqos_token_bucket_t *tb)
+{
+  f64 ticks = (1.0 - tb->tokens) / (tb->rate * HQOS_TIMER_TICK);
+
+  if (ticks >= HQOS_TIMER_MAX_TICKS)
+    return HQOS_TIMER_MAX_TICKS;
+
+  return (u32) ticks + 1;
+}
+
+#endif /* __included_hqos_h__ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
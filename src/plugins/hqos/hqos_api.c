@@ -0,0 +1,180 @@
+/*
+ * hqos_api.c - hierarchical QoS scheduler API
+ *
+ * Copyright (c) 2024 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/vnet.h>
+#include <vnet/plugin/plugin.h> /* VLIB_PLUGIN_REGISTER */
+#include <hqos/hqos.h>
+#include <vlibapi/api.h>
+#include <vlibmemory/api.h>
+#include <vpp/app/version.h> /* VPP_BUILD_VER */
+
+#include <hqos/hqos.api_enum.h>
+#include <hqos/hqos.api_types.h>
+
+#define REPLY_MSG_ID_BASE hm->msg_id_base
+#include <vlibapi/api_helper_macros.h>
+
+static void
+vl_api_hqos_port_add_del_t_handler (vl_api_hqos_port_add_del_t *mp)
+{
+  hqos_main_t *hm = &hqos_main;
+  vl_api_hqos_port_add_del_reply_t *rmp;
+  int rv;
+
+  VALIDATE_SW_IF_INDEX (mp);
+
+  rv = hqos_port_add_del (ntohl (mp->sw_if_index), clib_net_to_host_u64 (
+			    mp->rate),
+			  ntohl (mp->burst), ntohl (mp->queue_size),
+			  ntohl (mp->worker_index), mp->is_add);
+
+  BAD_SW_IF_INDEX_LABEL;
+  REPLY_MACRO (VL_API_HQOS_PORT_ADD_DEL_REPLY);
+}
+
+static void
+vl_api_hqos_tc_map_set_t_handler (vl_api_hqos_tc_map_set_t *mp)
+{
+  hqos_main_t *hm = &hqos_main;
+  vl_api_hqos_tc_map_set_reply_t *rmp;
+  int rv;
+
+  VALIDATE_SW_IF_INDEX (mp);
+
+  rv = hqos_port_set_tc_map (ntohl (mp->sw_if_index), mp->qos_bits, mp->tc,
+			     mp->queue);
+
+  BAD_SW_IF_INDEX_LABEL;
+  REPLY_MACRO (VL_API_HQOS_TC_MAP_SET_REPLY);
+}
+
+static void
+vl_api_hqos_subport_add_t_handler (vl_api_hqos_subport_add_t *mp)
+{
+  hqos_main_t *hm = &hqos_main;
+  vl_api_hqos_subport_add_reply_t *rmp;
+  u32 subport_index = ~0;
+  int rv;
+
+  VALIDATE_SW_IF_INDEX (mp);
+
+  rv = hqos_subport_add (ntohl (mp->sw_if_index),
+			 clib_net_to_host_u64 (mp->rate), ntohl (mp->burst),
+			 &subport_index);
+
+  BAD_SW_IF_INDEX_LABEL;
+  REPLY_MACRO2 (VL_API_HQOS_SUBPORT_ADD_REPLY,
+		({ rmp->subport_index = htonl (subport_index); }));
+}
+
+static void
+vl_api_hqos_subport_del_t_handler (vl_api_hqos_subport_del_t *mp)
+{
+  hqos_main_t *hm = &hqos_main;
+  vl_api_hqos_subport_del_reply_t *rmp;
+  int rv;
+
+  rv = hqos_subport_del (ntohl (mp->subport_index));
+
+  REPLY_MACRO (VL_API_HQOS_SUBPORT_DEL_REPLY);
+}
+
+static void
+vl_api_hqos_pipe_profile_add_t_handler (vl_api_hqos_pipe_profile_add_t *mp)
+{
+  hqos_main_t *hm = &hqos_main;
+  vl_api_hqos_pipe_profile_add_reply_t *rmp;
+  u32 profile_index = ~0;
+  int rv;
+
+  rv = hqos_pipe_profile_add (clib_net_to_host_u64 (mp->rate),
+			      ntohl (mp->burst), mp->weights, &profile_index);
+
+  REPLY_MACRO2 (VL_API_HQOS_PIPE_PROFILE_ADD_REPLY,
+		({ rmp->profile_index = htonl (profile_index); }));
+}
+
+static void
+vl_api_hqos_pipe_profile_del_t_handler (vl_api_hqos_pipe_profile_del_t *mp)
+{
+  hqos_main_t *hm = &hqos_main;
+  vl_api_hqos_pipe_profile_del_reply_t *rmp;
+  int rv;
+
+  rv = hqos_pipe_profile_del (ntohl (mp->profile_index));
+
+  REPLY_MACRO (VL_API_HQOS_PIPE_PROFILE_DEL_REPLY);
+}
+
+static void
+vl_api_hqos_pipe_add_t_handler (vl_api_hqos_pipe_add_t *mp)
+{
+  hqos_main_t *hm = &hqos_main;
+  vl_api_hqos_pipe_add_reply_t *rmp;
+  u32 pipe_index = ~0;
+  int rv;
+
+  VALIDATE_SW_IF_INDEX (mp);
+
+  rv = hqos_pipe_add (ntohl (mp->subport_index), ntohl (mp->profile_index),
+		      ntohl (mp->sw_if_index), &pipe_index);
+
+  BAD_SW_IF_INDEX_LABEL;
+  REPLY_MACRO2 (VL_API_HQOS_PIPE_ADD_REPLY,
+		({ rmp->pipe_index = htonl (pipe_index); }));
+}
+
+static void
+vl_api_hqos_pipe_del_t_handler (vl_api_hqos_pipe_del_t *mp)
+{
+  hqos_main_t *hm = &hqos_main;
+  vl_api_hqos_pipe_del_reply_t *rmp;
+  int rv;
+
+  rv = hqos_pipe_del (ntohl (mp->pipe_index));
+
+  REPLY_MACRO (VL_API_HQOS_PIPE_DEL_REPLY);
+}
+
+/* API definitions */
+#include <vnet/format_fns.h>
+#include <hqos/hqos.api.c>
+
+/* Set up the API message handling tables */
+static clib_error_t *
+hqos_api_hookup (vlib_main_t *vm)
+{
+  hqos_main_t *hm = &hqos_main;
+
+  hm->msg_id_base = setup_message_id_table ();
+  return 0;
+}
+
+VLIB_API_INIT_FUNCTION (hqos_api_hookup);
+
+VLIB_PLUGIN_REGISTER () = {
+  .version = VPP_BUILD_VER,
+  .description = "Hierarchical QoS scheduler",
+};
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
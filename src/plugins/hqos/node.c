@@ -0,0 +1,610 @@
+/*
+ * node.c - hierarchical QoS scheduler enqueue and dequeue nodes
+ *
+ * Copyright (c) 2024 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+#include <vnet/feature/feature.h>
+#include <hqos/hqos.h>
+
+typedef struct
+{
+  u32 pipe_index;
+  u32 thread_index;
+  u8 tc;
+  u8 queue;
+  u8 is_drop;
+} hqos_enqueue_trace_t;
+
+typedef struct
+{
+  u32 pipe_index;
+  u8 tc;
+  u8 queue;
+} hqos_dequeue_trace_t;
+
+#ifndef CLIB_MARCH_VARIANT
+static u8 *
+format_hqos_enqueue_trace (u8 *s, va_list *args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  hqos_enqueue_trace_t *t = va_arg (*args, hqos_enqueue_trace_t *);
+
+  s = format (s, "hqos: pipe %d tc %d queue %d thread %d%s", t->pipe_index,
+	      t->tc, t->queue, t->thread_index, t->is_drop ? " dropped" : "");
+  return s;
+}
+
+static u8 *
+format_hqos_dequeue_trace (u8 *s, va_list *args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  hqos_dequeue_trace_t *t = va_arg (*args, hqos_dequeue_trace_t *);
+
+  s = format (s, "hqos: pipe %d tc %d queue %d", t->pipe_index, t->tc,
+	      t->queue);
+  return s;
+}
+#endif /* CLIB_MARCH_VARIANT */
+
+#define foreach_hqos_enqueue_error                                            \
+  _ (ENQUEUED, "packets enqueued")                                            \
+  _ (QUEUE_FULL, "queue full drops")                                          \
+  _ (NO_PIPE, "no pipe")                                                      \
+  _ (CONGESTION_DROP, "congestion drop on handoff")
+
+typedef enum
+{
+#define _(sym, str) HQOS_ENQUEUE_ERROR_##sym,
+  foreach_hqos_enqueue_error
+#undef _
+    HQOS_ENQUEUE_N_ERROR,
+} hqos_enqueue_error_t;
+
+#ifndef CLIB_MARCH_VARIANT
+static char *hqos_enqueue_error_strings[] = {
+#define _(sym, string) string,
+  foreach_hqos_enqueue_error
+#undef _
+};
+#endif /* CLIB_MARCH_VARIANT */
+
+#define foreach_hqos_dequeue_error _ (TRANSMITTED, "packets transmitted")
+
+typedef enum
+{
+#define _(sym, str) HQOS_DEQUEUE_ERROR_##sym,
+  foreach_hqos_dequeue_error
+#undef _
+    HQOS_DEQUEUE_N_ERROR,
+} hqos_dequeue_error_t;
+
+#ifndef CLIB_MARCH_VARIANT
+static char *hqos_dequeue_error_strings[] = {
+#define _(sym, string) string,
+  foreach_hqos_dequeue_error
+#undef _
+};
+#endif /* CLIB_MARCH_VARIANT */
+
+typedef enum
+{
+  HQOS_ENQUEUE_NEXT_DROP,
+  HQOS_ENQUEUE_N_NEXT,
+} hqos_enqueue_next_t;
+
+typedef enum
+{
+  HQOS_DEQUEUE_NEXT_OUTPUT,
+  HQOS_DEQUEUE_N_NEXT,
+} hqos_dequeue_next_t;
+
+static_always_inline void
+hqos_port_push_subport (hqos_main_t *hm, hqos_port_t *port, u32 sp_index)
+{
+  hqos_subport_t *sp = pool_elt_at_index (hm->subports, sp_index);
+
+  sp->next_active = ~0;
+  sp->state = HQOS_SCHED_ACTIVE;
+  if (port->active_head == ~0)
+    port->active_head = sp_index;
+  else
+    pool_elt_at_index (hm->subports, port->active_tail)->next_active =
+      sp_index;
+  port->active_tail = sp_index;
+}
+
+static_always_inline void
+hqos_port_pop_subport (hqos_main_t *hm, hqos_port_t *port, hqos_subport_t *sp)
+{
+  port->active_head = sp->next_active;
+  sp->next_active = ~0;
+}
+
+static_always_inline void
+hqos_subport_push_pipe (hqos_main_t *hm, hqos_subport_t *sp, u32 pipe_index)
+{
+  hqos_pipe_t *pipe = pool_elt_at_index (hm->pipes, pipe_index);
+
+  pipe->next_active = ~0;
+  pipe->state = HQOS_SCHED_ACTIVE;
+  if (sp->active_head == ~0)
+    sp->active_head = pipe_index;
+  else
+    pool_elt_at_index (hm->pipes, sp->active_tail)->next_active = pipe_index;
+  sp->active_tail = pipe_index;
+}
+
+static_always_inline void
+hqos_subport_pop_pipe (hqos_main_t *hm, hqos_subport_t *sp, hqos_pipe_t *pipe)
+{
+  sp->active_head = pipe->next_active;
+  pipe->next_active = ~0;
+}
+
+/* Put a pipe that has tokens and a backlog on its subport's active list */
+static_always_inline void
+hqos_pipe_activate (hqos_main_t *hm, hqos_pipe_t *pipe)
+{
+  hqos_subport_t *sp = pool_elt_at_index (hm->subports, pipe->subport_index);
+
+  hqos_subport_push_pipe (hm, sp, pipe - hm->pipes);
+
+  /* a waiting subport is made active when its timer expires */
+  if (sp->state == HQOS_SCHED_IDLE)
+    hqos_port_push_subport (hm, pool_elt_at_index (hm->ports, sp->port_index),
+			    pipe->subport_index);
+}
+
+static_always_inline void
+hqos_timer_start (hqos_per_thread_data_t *ptd, u32 index, u32 timer_id,
+		  hqos_token_bucket_t *tb, u32 *handle)
+{
+  *handle = tw_timer_start_2t_2w_512sl (&ptd->wheel, index, timer_id,
+					hqos_tb_wait_ticks (tb));
+}
+
+static_always_inline u32
+hqos_qos_to_tc_queue (hqos_port_t *port, vlib_buffer_t *b)
+{
+  if (b->flags & VNET_BUFFER_F_QOS_DATA_VALID)
+    return port->tc_queue_by_qos[vnet_buffer2 (b)->qos.bits];
+
+  /* lowest priority, first queue */
+  return (HQOS_N_TC - 1) << 4;
+}
+
+static_always_inline uword
+hqos_enqueue_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
+		     vlib_frame_t *frame, int is_trace)
+{
+  hqos_main_t *hm = &hqos_main;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
+  u32 handoff_bis[VLIB_FRAME_SIZE], drop_bis[VLIB_FRAME_SIZE];
+  u16 handoff_threads[VLIB_FRAME_SIZE];
+  u32 n_handoff = 0, n_drop = 0, n_enq = 0;
+  u32 thread_index = vm->thread_index;
+  u32 n_left, *from;
+
+  from = vlib_frame_vector_args (frame);
+  n_left = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left);
+  b = bufs;
+
+  while (n_left > 0)
+    {
+      hqos_pipe_t *pipe;
+      hqos_port_t *port;
+      hqos_queue_t *q;
+      u32 sw_if_index, pipe_index, tc_queue, tc, queue;
+      u8 is_drop = 0;
+
+      if (n_left > 2)
+	vlib_prefetch_buffer_header (b[2], LOAD);
+
+      sw_if_index = vnet_buffer (b[0])->sw_if_index[VLIB_TX];
+      pipe_index = vec_elt (hm->pipe_by_sw_if_index, sw_if_index);
+
+      /* the pipe was deleted while the packet was handed off */
+      if (PREDICT_FALSE (pipe_index == ~0))
+	{
+	  drop_bis[n_drop++] = from[0];
+	  b[0]->error = node->errors[HQOS_ENQUEUE_ERROR_NO_PIPE];
+	  goto next;
+	}
+
+      pipe = pool_elt_at_index (hm->pipes, pipe_index);
+      port = pool_elt_at_index (hm->ports, pipe->port_index);
+
+      tc_queue = hqos_qos_to_tc_queue (port, b[0]);
+      tc = tc_queue >> 4;
+      queue = tc_queue & 0xf;
+
+      if (port->thread_index != thread_index)
+	{
+	  handoff_bis[n_handoff] = from[0];
+	  handoff_threads[n_handoff] = port->thread_index;
+	  n_handoff++;
+	  goto trace;
+	}
+
+      q = &pipe->queues[tc][queue];
+
+      if (PREDICT_FALSE (q->n_entries >= port->queue_size))
+	{
+	  drop_bis[n_drop++] = from[0];
+	  b[0]->error = node->errors[HQOS_ENQUEUE_ERROR_QUEUE_FULL];
+	  vlib_increment_combined_counter (
+	    &hm->counters[HQOS_COUNTER_DROP], thread_index,
+	    pipe_index * HQOS_N_TC + tc, 1,
+	    vlib_buffer_length_in_chain (vm, b[0]));
+	  is_drop = 1;
+	  goto trace;
+	}
+
+      if (PREDICT_FALSE (!q->entries))
+	vec_validate (q->entries, port->queue_size - 1);
+
+      q->entries[(q->head + q->n_entries) & (port->queue_size - 1)] =
+	(hqos_queue_entry_t){
+	  .buffer_index = from[0],
+	  .length = vlib_buffer_length_in_chain (vm, b[0]),
+	};
+      q->n_entries++;
+      pipe->n_entries++;
+      pipe->tc_mask |= 1 << tc;
+      n_enq++;
+
+      if (pipe->state == HQOS_SCHED_IDLE)
+	hqos_pipe_activate (hm, pipe);
+
+    trace:
+      if (is_trace && (b[0]->flags & VLIB_BUFFER_IS_TRACED))
+	{
+	  hqos_enqueue_trace_t *t =
+	    vlib_add_trace (vm, node, b[0], sizeof (*t));
+	  t->pipe_index = pipe_index;
+	  t->thread_index = port->thread_index;
+	  t->tc = tc;
+	  t->queue = queue;
+	  t->is_drop = is_drop;
+	}
+
+    next:
+      from++;
+      b++;
+      n_left--;
+    }
+
+  if (n_drop)
+    vlib_buffer_enqueue_to_single_next (vm, node, drop_bis,
+					HQOS_ENQUEUE_NEXT_DROP, n_drop);
+
+  if (n_handoff)
+    {
+      u32 n_sent;
+
+      n_sent = vlib_buffer_enqueue_to_thread (vm, node, hm->fq_index,
+					      handoff_bis, handoff_threads,
+					      n_handoff, 1 /* drop on cong */);
+      if (n_sent < n_handoff)
+	vlib_node_increment_counter (vm, node->node_index,
+				     HQOS_ENQUEUE_ERROR_CONGESTION_DROP,
+				     n_handoff - n_sent);
+    }
+
+  vlib_node_increment_counter (vm, node->node_index,
+			       HQOS_ENQUEUE_ERROR_ENQUEUED, n_enq);
+
+  return frame->n_vectors;
+}
+
+VLIB_NODE_FN (hqos_enqueue_node)
+(vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)
+{
+  if (PREDICT_FALSE (node->flags & VLIB_NODE_FLAG_TRACE))
+    return hqos_enqueue_inline (vm, node, frame, 1 /* is_trace */);
+  else
+    return hqos_enqueue_inline (vm, node, frame, 0 /* is_trace */);
+}
+
+/* Deficit round robin over the queues of a backlogged traffic class */
+static_always_inline hqos_queue_t *
+hqos_pipe_wrr_select (hqos_pipe_t *pipe, hqos_pipe_profile_t *profile, u32 tc)
+{
+  hqos_queue_t *q;
+  u32 pos;
+
+  while (1)
+    {
+      pos = pipe->wrr_pos[tc];
+      q = &pipe->queues[tc][pos];
+
+      if (q->n_entries == 0)
+	q->deficit = 0;
+      else if (q->deficit >= (i32) q->entries[q->head].length)
+	return q;
+
+      pos = (pos + 1) % HQOS_N_QUEUES_PER_TC;
+      pipe->wrr_pos[tc] = pos;
+      pipe->queues[tc][pos].deficit += profile->wrr_quantum[pos];
+    }
+}
+
+/* Send up to HQOS_PIPE_BURST packets of a pipe while all levels conform */
+static_always_inline u32
+hqos_pipe_dequeue (vlib_main_t *vm, vlib_node_runtime_t *node,
+		   hqos_main_t *hm, hqos_port_t *port, hqos_subport_t *sp,
+		   hqos_pipe_t *pipe, u32 *bis, u32 max, int is_trace)
+{
+  hqos_pipe_profile_t *profile;
+  u32 pipe_index = pipe - hm->pipes;
+  u32 n = 0;
+
+  profile = pool_elt_at_index (hm->profiles, pipe->profile_index);
+  max = clib_min (max, HQOS_PIPE_BURST);
+
+  while (n < max && pipe->tc_mask && hqos_tb_conforms (&pipe->tb) &&
+	 hqos_tb_conforms (&sp->tb) && hqos_tb_conforms (&port->tb))
+    {
+      hqos_queue_entry_t *e;
+      hqos_queue_t *q;
+      u32 tc;
+
+      tc = count_trailing_zeros (pipe->tc_mask);
+      q = hqos_pipe_wrr_select (pipe, profile, tc);
+      e = &q->entries[q->head];
+
+      q->deficit -= e->length;
+      pipe->tb.tokens -= e->length;
+      sp->tb.tokens -= e->length;
+      port->tb.tokens -= e->length;
+
+      vlib_increment_combined_counter (&hm->counters[HQOS_COUNTER_TX],
+				       vm->thread_index,
+				       pipe_index * HQOS_N_TC + tc, 1,
+				       e->length);
+
+      if (is_trace)
+	{
+	  vlib_buffer_t *b = vlib_get_buffer (vm, e->buffer_index);
+
+	  if (b->flags & VLIB_BUFFER_IS_TRACED)
+	    {
+	      hqos_dequeue_trace_t *t = vlib_add_trace (vm, node, b, sizeof (*t));
+	      t->pipe_index = pipe_index;
+	      t->tc = tc;
+	      t->queue = q - pipe->queues[tc];
+	    }
+	}
+
+      bis[n++] = e->buffer_index;
+      q->head = (q->head + 1) & (port->queue_size - 1);
+      q->n_entries--;
+      pipe->n_entries--;
+
+      if (q->n_entries == 0)
+	{
+	  u32 i;
+
+	  for (i = 0; i < HQOS_N_QUEUES_PER_TC; i++)
+	    if (pipe->queues[tc][i].n_entries)
+	      break;
+	  if (i == HQOS_N_QUEUES_PER_TC)
+	    pipe->tc_mask &= ~(1 << tc);
+	}
+    }
+
+  return n;
+}
+
+static_always_inline u32
+hqos_port_dequeue (vlib_main_t *vm, vlib_node_runtime_t *node,
+		   hqos_main_t *hm, hqos_per_thread_data_t *ptd,
+		   hqos_port_t *port, f64 now, u32 *bis, u32 max, int is_trace)
+{
+  u32 n = 0;
+
+  hqos_tb_update (&port->tb, now);
+
+  while (n < max && port->active_head != ~0 && hqos_tb_conforms (&port->tb))
+    {
+      hqos_subport_t *sp;
+      hqos_pipe_t *pipe;
+      u32 sp_index, pipe_index;
+
+      sp_index = port->active_head;
+      sp = pool_elt_at_index (hm->subports, sp_index);
+      hqos_tb_update (&sp->tb, now);
+
+      if (!hqos_tb_conforms (&sp->tb))
+	{
+	  hqos_port_pop_subport (hm, port, sp);
+	  sp->state = HQOS_SCHED_WAITING;
+	  hqos_timer_start (ptd, sp_index, HQOS_TIMER_SUBPORT, &sp->tb,
+			    &sp->timer_handle);
+	  continue;
+	}
+
+      pipe_index = sp->active_head;
+      pipe = pool_elt_at_index (hm->pipes, pipe_index);
+      hqos_tb_update (&pipe->tb, now);
+
+      if (hqos_tb_conforms (&pipe->tb))
+	n += hqos_pipe_dequeue (vm, node, hm, port, sp, pipe, bis + n, max - n,
+				is_trace);
+
+      hqos_subport_pop_pipe (hm, sp, pipe);
+      if (pipe->n_entries == 0)
+	pipe->state = HQOS_SCHED_IDLE;
+      else if (!hqos_tb_conforms (&pipe->tb))
+	{
+	  pipe->state = HQOS_SCHED_WAITING;
+	  hqos_timer_start (ptd, pipe_index, HQOS_TIMER_PIPE, &pipe->tb,
+			    &pipe->timer_handle);
+	}
+      else
+	hqos_subport_push_pipe (hm, sp, pipe_index);
+
+      /* round robin over the subports */
+      hqos_port_pop_subport (hm, port, sp);
+      if (sp->active_head == ~0)
+	sp->state = HQOS_SCHED_IDLE;
+      else
+	hqos_port_push_subport (hm, port, sp_index);
+    }
+
+  return n;
+}
+
+static_always_inline void
+hqos_expire_timers (hqos_main_t *hm, hqos_per_thread_data_t *ptd, f64 now)
+{
+  u32 *handle;
+
+  vec_reset_length (ptd->expired);
+  ptd->expired =
+    tw_timer_expire_timers_vec_2t_2w_512sl (&ptd->wheel, now, ptd->expired);
+
+  vec_foreach (handle, ptd->expired)
+    {
+      u32 index = handle[0] & 0x7FFFFFFF;
+
+      if (handle[0] >> 31 == HQOS_TIMER_PIPE)
+	{
+	  hqos_pipe_t *pipe = pool_elt_at_index (hm->pipes, index);
+
+	  pipe->timer_handle = ~0;
+	  hqos_pipe_activate (hm, pipe);
+	}
+      else
+	{
+	  hqos_subport_t *sp = pool_elt_at_index (hm->subports, index);
+
+	  sp->timer_handle = ~0;
+	  if (sp->active_head == ~0)
+	    sp->state = HQOS_SCHED_IDLE;
+	  else
+	    hqos_port_push_subport (
+	      hm, pool_elt_at_index (hm->ports, sp->port_index), index);
+	}
+    }
+}
+
+static_always_inline uword
+hqos_dequeue_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
+		     int is_trace)
+{
+  hqos_main_t *hm = &hqos_main;
+  hqos_per_thread_data_t *ptd;
+  u32 bis[VLIB_FRAME_SIZE];
+  u32 i, n_ports, n = 0;
+  f64 now;
+
+  ptd = vec_elt_at_index (hm->per_thread_data, vm->thread_index);
+  n_ports = vec_len (ptd->ports);
+  if (n_ports == 0)
+    return 0;
+
+  now = vlib_time_now (vm);
+  hqos_expire_timers (hm, ptd, now);
+
+  /*
+   * Start one port further on each time, so a port that fills the frame
+   * does not keep the ones behind it waiting.
+   */
+  if (ptd->next_port >= n_ports)
+    ptd->next_port = 0;
+
+  for (i = 0; i < n_ports && n < VLIB_FRAME_SIZE; i++)
+    {
+      u32 port_index = ptd->ports[(ptd->next_port + i) % n_ports];
+      hqos_port_t *port = pool_elt_at_index (hm->ports, port_index);
+
+      n += hqos_port_dequeue (vm, node, hm, ptd, port, now, bis + n,
+			      VLIB_FRAME_SIZE - n, is_trace);
+    }
+
+  ptd->next_port++;
+
+  if (n)
+    {
+      vlib_buffer_enqueue_to_single_next (vm, node, bis,
+					  HQOS_DEQUEUE_NEXT_OUTPUT, n);
+      vlib_node_increment_counter (vm, node->node_index,
+				   HQOS_DEQUEUE_ERROR_TRANSMITTED, n);
+    }
+
+  return n;
+}
+
+VLIB_NODE_FN (hqos_dequeue_node)
+(vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)
+{
+  if (PREDICT_FALSE (node->flags & VLIB_NODE_FLAG_TRACE))
+    return hqos_dequeue_inline (vm, node, 1 /* is_trace */);
+  else
+    return hqos_dequeue_inline (vm, node, 0 /* is_trace */);
+}
+
+#ifndef CLIB_MARCH_VARIANT
+VLIB_REGISTER_NODE (hqos_enqueue_node) = {
+  .name = "hqos-enqueue",
+  .vector_size = sizeof (u32),
+  .format_trace = format_hqos_enqueue_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+
+  .n_errors = HQOS_ENQUEUE_N_ERROR,
+  .error_strings = hqos_enqueue_error_strings,
+
+  .n_next_nodes = HQOS_ENQUEUE_N_NEXT,
+  .next_nodes = {
+    [HQOS_ENQUEUE_NEXT_DROP] = "error-drop",
+  },
+};
+
+VLIB_REGISTER_NODE (hqos_dequeue_node) = {
+  .name = "hqos-dequeue",
+  .type = VLIB_NODE_TYPE_INPUT,
+  .format_trace = format_hqos_dequeue_trace,
+
+  /* Will be enabled on the threads that own a port */
+  .state = VLIB_NODE_STATE_DISABLED,
+
+  .n_errors = HQOS_DEQUEUE_N_ERROR,
+  .error_strings = hqos_dequeue_error_strings,
+
+  .n_next_nodes = HQOS_DEQUEUE_N_NEXT,
+  .next_nodes = {
+    [HQOS_DEQUEUE_NEXT_OUTPUT] = "interface-output-arc-end",
+  },
+};
+#endif /* CLIB_MARCH_VARIANT */
+
+VNET_FEATURE_INIT (hqos_enqueue_feat, static) = {
+  .arc_name = "interface-output",
+  .node_name = "hqos-enqueue",
+  .runs_before = VNET_FEATURES ("interface-output-arc-end"),
+};
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
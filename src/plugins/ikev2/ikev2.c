@@ -446,7 +446,9 @@ ikev2_complete_sa_data (ikev2_sa_t * sa, ikev2_sa_t * sai)
   sa->last_init_msg_id = sai->last_init_msg_id;
   sa->childs = _(sai->childs);
   sa->udp_encap = sai->udp_encap;
+  sa->multi_worker = sai->multi_worker;
   sa->ipsec_over_udp_port = sai->ipsec_over_udp_port;
+  sa->anti_replay_window_size = sai->anti_replay_window_size;
   sa->dst_port = sai->dst_port;
   sa->sw_if_index = sai->sw_if_index;
 #undef _
@@ -1842,7 +1844,9 @@ ikev2_sa_auth (ikev2_sa_t *sa)
     {
       ASSERT (sa->state == IKEV2_STATE_AUTHENTICATED);
       sa->udp_encap = sel_p->udp_encap;
+      sa->multi_worker = sel_p->multi_worker;
       sa->ipsec_over_udp_port = sel_p->ipsec_over_udp_port;
+      sa->anti_replay_window_size = sel_p->anti_replay_window_size;
 
       if (!sa->is_initiator)
 	{
@@ -1966,6 +1970,7 @@ typedef struct
   u16 ipsec_over_udp_port;
   u16 src_port;
   u16 dst_port;
+  u32 anti_replay_window_size;
 } ikev2_add_ipsec_tunnel_args_t;
 
 static void
@@ -2041,7 +2046,8 @@ ikev2_add_tunnel_from_main (ikev2_add_ipsec_tunnel_args_t * a)
   rv = ipsec_sa_add_and_lock (a->local_sa_id, a->local_spi, IPSEC_PROTOCOL_ESP,
 			      a->encr_type, &a->loc_ckey, a->integ_type,
 			      &a->loc_ikey, a->flags, a->salt_local,
-			      a->src_port, a->dst_port, &tun_out, NULL);
+			      a->src_port, a->dst_port,
+			      a->anti_replay_window_size, &tun_out, NULL);
   if (rv)
     goto err0;
 
@@ -2049,7 +2055,8 @@ ikev2_add_tunnel_from_main (ikev2_add_ipsec_tunnel_args_t * a)
     a->remote_sa_id, a->remote_spi, IPSEC_PROTOCOL_ESP, a->encr_type,
     &a->rem_ckey, a->integ_type, &a->rem_ikey,
     (a->flags | IPSEC_SA_FLAG_IS_INBOUND), a->salt_remote,
-    a->ipsec_over_udp_port, a->ipsec_over_udp_port, &tun_in, NULL);
+    a->ipsec_over_udp_port, a->ipsec_over_udp_port,
+    a->anti_replay_window_size, &tun_in, NULL);
   if (rv)
     goto err1;
 
@@ -2115,6 +2122,8 @@ ikev2_create_tunnel_interface (vlib_main_t *vm, ikev2_sa_t *sa,
     }
   if (ikev2_natt_active (sa))
     a.flags |= IPSEC_SA_FLAG_UDP_ENCAP;
+  if (sa->multi_worker)
+    a.flags |= IPSEC_SA_FLAG_MULTI_WORKER;
   a.is_rekey = is_rekey;
 
   tr = ikev2_sa_get_td_for_type (proposals, IKEV2_TRANSFORM_TYPE_ESN);
@@ -2303,6 +2312,7 @@ ikev2_create_tunnel_interface (vlib_main_t *vm, ikev2_sa_t *sa,
 
   a.sw_if_index = (sa->is_tun_itf_set ? sa->tun_itf : ~0);
   a.ipsec_over_udp_port = sa->ipsec_over_udp_port;
+  a.anti_replay_window_size = sa->anti_replay_window_size;
 
   vl_api_rpc_call_main_thread (ikev2_add_tunnel_from_main,
 			       (u8 *) & a, sizeof (a));
@@ -4069,6 +4079,7 @@ ikev2_add_del_profile (vlib_main_t * vm, u8 * name, int is_add)
       clib_memset (p, 0, sizeof (*p));
       p->name = vec_dup (name);
       p->ipsec_over_udp_port = IPSEC_UDP_PORT_NONE;
+      p->anti_replay_window_size = IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE;
       p->responder.sw_if_index = ~0;
       p->tun_itf = ~0;
       uword index = p - km->profiles;
@@ -4386,6 +4397,35 @@ ikev2_set_profile_udp_encap (vlib_main_t * vm, u8 * name)
   return 0;
 }
 
+clib_error_t *
+ikev2_set_profile_multi_worker (vlib_main_t *vm, u8 *name)
+{
+  ikev2_profile_t *p = ikev2_profile_index_by_name (name);
+
+  if (!p)
+    return clib_error_return (0, "unknown profile %v", name);
+
+  p->multi_worker = 1;
+  return 0;
+}
+
+clib_error_t *
+ikev2_set_profile_anti_replay_window_size (vlib_main_t *vm, u8 *name,
+					   u32 size)
+{
+  ikev2_profile_t *p = ikev2_profile_index_by_name (name);
+
+  if (!p)
+    return clib_error_return (0, "unknown profile %v", name);
+
+  if (size > IPSEC_SA_ANTI_REPLAY_WINDOW_MAX_SIZE ||
+      (size > IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE && !is_pow2 (size)))
+    return clib_error_return (0, "invalid anti-replay window size %u", size);
+
+  p->anti_replay_window_size = size;
+  return 0;
+}
+
 clib_error_t *
 ikev2_set_profile_sa_lifetime (vlib_main_t * vm, u8 * name,
 			       u64 lifetime, u32 jitter, u32 handover,
@@ -4534,9 +4574,11 @@ ikev2_initiate_sa_init (vlib_main_t * vm, u8 * name)
   sa.state = IKEV2_STATE_SA_INIT;
   sa.tun_itf = p->tun_itf;
   sa.udp_encap = p->udp_encap;
+  sa.multi_worker = p->multi_worker;
   if (p->natt_disabled)
     sa.natt_state = IKEV2_NATT_DISABLED;
   sa.ipsec_over_udp_port = p->ipsec_over_udp_port;
+  sa.anti_replay_window_size = p->anti_replay_window_size;
   sa.is_tun_itf_set = 1;
   sa.initial_contact = 1;
   sa.dst_port = IKEV2_PORT;
@@ -420,6 +420,9 @@ vnet_api_error_t ikev2_set_profile_ipsec_udp_port (vlib_main_t * vm,
 						   u8 * name, u16 port,
 						   u8 is_set);
 clib_error_t *ikev2_set_profile_udp_encap (vlib_main_t * vm, u8 * name);
+clib_error_t *ikev2_set_profile_multi_worker (vlib_main_t *vm, u8 *name);
+clib_error_t *ikev2_set_profile_anti_replay_window_size (vlib_main_t *vm,
+							 u8 *name, u32 size);
 clib_error_t *ikev2_initiate_sa_init (vlib_main_t * vm, u8 * name);
 clib_error_t *ikev2_initiate_delete_child_sa (vlib_main_t * vm, u32 ispi);
 clib_error_t *ikev2_initiate_delete_ike_sa (vlib_main_t * vm, u64 ispi);
@@ -536,6 +536,18 @@ ikev2_profile_add_del_command_fn (vlib_main_t * vm,
 	  r = ikev2_set_profile_udp_encap (vm, name);
 	  goto done;
 	}
+      else if (unformat (line_input, "set %U multi-worker",
+			 unformat_ikev2_token, &name))
+	{
+	  r = ikev2_set_profile_multi_worker (vm, name);
+	  goto done;
+	}
+      else if (unformat (line_input, "set %U anti-replay-window-size %u",
+			 unformat_ikev2_token, &name, &tmp1))
+	{
+	  r = ikev2_set_profile_anti_replay_window_size (vm, name, tmp1);
+	  goto done;
+	}
       else if (unformat (line_input, "set %U ipsec-over-udp port %u",
 			 unformat_ikev2_token, &name, &tmp1))
 	{
@@ -574,6 +586,8 @@ VLIB_CLI_COMMAND (ikev2_profile_add_del_command, static) = {
     "ikev2 profile set <id> id <local|remote> <type> <data>\n"
     "ikev2 profile set <id> tunnel <interface>\n"
     "ikev2 profile set <id> udp-encap\n"
+    "ikev2 profile set <id> multi-worker\n"
+    "ikev2 profile set <id> anti-replay-window-size <n>\n"
     "ikev2 profile set <id> traffic-selector <local|remote> ip-range "
     "<start-addr> - <end-addr> port-range <start-port> - <end-port> "
     "protocol <protocol-number>\n"
@@ -642,12 +656,19 @@ show_ikev2_profile_command_fn (vlib_main_t * vm,
     if (p->udp_encap)
       vlib_cli_output(vm, "  udp-encap");
 
+    if (p->multi_worker)
+      vlib_cli_output(vm, "  multi-worker");
+
     if (p->natt_disabled)
       vlib_cli_output(vm, "  NAT-T disabled");
 
     if (p->ipsec_over_udp_port != IPSEC_UDP_PORT_NONE)
       vlib_cli_output(vm, "  ipsec-over-udp port %d", p->ipsec_over_udp_port);
 
+    if (p->anti_replay_window_size != IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE)
+      vlib_cli_output(vm, "  anti-replay-window-size %u",
+                      p->anti_replay_window_size);
+
     if (p->ike_ts.crypto_alg || p->ike_ts.integ_alg || p->ike_ts.dh_type || p->ike_ts.crypto_key_size)
       vlib_cli_output(vm, "  ike-crypto-alg %U %u ike-integ-alg %U ike-dh %U",
                     format_ikev2_transform_encr_type, p->ike_ts.crypto_alg, p->ike_ts.crypto_key_size,
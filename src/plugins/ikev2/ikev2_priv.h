@@ -353,10 +353,12 @@ typedef struct
   u32 lifetime_jitter;
   u32 handover;
   u16 ipsec_over_udp_port;
+  u32 anti_replay_window_size;
 
   u32 tun_itf;
   u8 udp_encap;
   u8 natt_disabled;
+  u8 multi_worker;
 } ikev2_profile_t;
 
 typedef enum
@@ -448,7 +450,9 @@ typedef struct
   u8 is_tun_itf_set;
   u32 tun_itf;
   u8 udp_encap;
+  u8 multi_worker;
   u16 ipsec_over_udp_port;
+  u32 anti_replay_window_size;
 
   f64 old_id_expiration;
   u32 current_remote_id_mask;
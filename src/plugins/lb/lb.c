@@ -192,6 +192,33 @@ u8 *format_lb_as (u8 * s, va_list * args)
                 (as->flags & LB_AS_FLAGS_USED)?"used":"removed");
 }
 
+/*
+ * Number of live sticky entries of a VIP, across all the workers.
+ */
+static u32 lb_vip_sticky_elts (u32 vip_index)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main();
+  lb_main_t *lbm = &lb_main;
+  u32 now = lb_hash_time_now(vlib_get_main());
+  u32 thread_index, tot = 0;
+
+  for(thread_index = 0; thread_index < tm->n_vlib_mains; thread_index++ ) {
+    lb_hash_t *h = lbm->per_cpu[thread_index].sticky_ht;
+    lb_hash_bucket_t *b;
+    u32 i;
+
+    if (h == NULL)
+      continue;
+
+    lb_hash_foreach_valid_entry(h, b, i, now) {
+      if (b->vip[i] == vip_index)
+        tot++;
+    }
+  }
+
+  return tot;
+}
+
 u8 *format_lb_vip_detailed (u8 * s, va_list * args)
 {
   lb_main_t *lbm = &lb_main;
@@ -245,6 +272,15 @@ u8 *format_lb_vip_detailed (u8 * s, va_list * args)
                vlib_get_simple_counter(&lbm->vip_counters[i], vip - lbm->vips));
 
 
+  u32 n_sticky = lb_vip_sticky_elts (vip - lbm->vips);
+  s = format(s, "%U  memory: new flow table %U, %u sticky entries %U\n",
+             format_white_space, indent,
+             format_memory_size,
+             vec_len(vip->new_flow_table) * sizeof(lb_new_flow_entry_t),
+             n_sticky, format_memory_size,
+             (uword) n_sticky * (sizeof(lb_hash_bucket_t) /
+                                 LBHASH_ENTRY_PER_BUCKET));
+
   s = format(s, "%U  #as:%u\n",
              format_white_space, indent,
              pool_elts(vip->as_indexes));
@@ -41,6 +41,14 @@
  */
 #define LBHASH_ENTRY_PER_BUCKET 4
 
+/*
+ * @brief Number of consecutive buckets a flow may be stored in.
+ * When the bucket a flow hashes to is full, the flow overflows into the
+ * next one instead of being left untracked, so that it keeps its AS
+ * when the new flow table changes.
+ */
+#define LBHASH_BUCKETS_PER_FLOW 2
+
 #define LB_HASH_DO_NOT_USE_SSE_BUCKETS 0
 
 /*
@@ -62,7 +70,7 @@ typedef struct {
 } lb_hash_t;
 
 #define lb_hash_nbuckets(h) (((h)->buckets_mask) + 1)
-#define lb_hash_size(h) ((h)->buckets_mask + LBHASH_ENTRY_PER_BUCKET)
+#define lb_hash_size(h) (lb_hash_nbuckets(h) * LBHASH_ENTRY_PER_BUCKET)
 
 #define lb_hash_foreach_bucket(h, bucket) \
   for (bucket = (h)->buckets; \
@@ -102,83 +110,114 @@ void lb_hash_free(lb_hash_t *h)
   vec_free(mem);
 }
 
+/*
+ * @brief Bucket i of the buckets a flow may be stored in.
+ */
+static_always_inline
+lb_hash_bucket_t *lb_hash_bucket(lb_hash_t *ht, u32 hash, u32 i)
+{
+  return &ht->buckets[(hash + i) & ht->buckets_mask];
+}
+
 static_always_inline
 void lb_hash_prefetch_bucket(lb_hash_t *ht, u32 hash)
 {
-  lb_hash_bucket_t *bucket = &ht->buckets[hash & ht->buckets_mask];
-  CLIB_PREFETCH(bucket, sizeof(*bucket), READ);
+  u32 i;
+  for (i = 0; i < LBHASH_BUCKETS_PER_FLOW; i++)
+    CLIB_PREFETCH(lb_hash_bucket(ht, hash, i), sizeof(lb_hash_bucket_t),
+                  READ);
 }
 
+/*
+ * @brief Looks up a flow in the buckets it may be stored in.
+ * available_index is the first expired entry, counted across the
+ * buckets, and is ~0 when all of them are in use.
+ */
 static_always_inline
 void lb_hash_get(lb_hash_t *ht, u32 hash, u32 vip, u32 time_now,
 		 u32 *available_index, u32 *found_value)
 {
-  lb_hash_bucket_t *bucket = &ht->buckets[hash & ht->buckets_mask];
+  u32 b;
   *found_value = 0;
   *available_index = ~0;
+
+  for (b = 0; b < LBHASH_BUCKETS_PER_FLOW; b++) {
+    lb_hash_bucket_t *bucket = lb_hash_bucket(ht, hash, b);
 #if __SSE4_2__ && LB_HASH_DO_NOT_USE_SSE_BUCKETS == 0
-  u32 bitmask, found_index;
-  __m128i mask;
-
-  // mask[*] = timeout[*] > now
-  mask = _mm_cmpgt_epi32(_mm_loadu_si128 ((__m128i *) bucket->timeout),
-			 _mm_set1_epi32 (time_now));
-  // bitmask[*] = now <= timeout[*/4]
-  bitmask = (~_mm_movemask_epi8(mask)) & 0xffff;
-  // Get first index with now <= timeout[*], if any.
-  *available_index = (bitmask)?__builtin_ctz(bitmask)/4:*available_index;
-
-  // mask[*] = (timeout[*] > now) && (hash[*] == hash)
-  mask = _mm_and_si128(mask,
-		       _mm_cmpeq_epi32(
-			   _mm_loadu_si128 ((__m128i *) bucket->hash),
-			   _mm_set1_epi32 (hash)));
-
-  // Load the array of vip values
-  // mask[*] = (timeout[*] > now) && (hash[*] == hash) && (vip[*] == vip)
-  mask = _mm_and_si128(mask,
-		       _mm_cmpeq_epi32(
-			   _mm_loadu_si128 ((__m128i *) bucket->vip),
-			   _mm_set1_epi32 (vip)));
-
-  // mask[*] = (timeout[*x4] > now) && (hash[*x4] == hash) && (vip[*x4] == vip)
-  bitmask = _mm_movemask_epi8(mask);
-  // Get first index, if any
-  found_index = (bitmask)?__builtin_ctzll(bitmask)/4:0;
-  ASSERT(found_index < 4);
-  *found_value = (bitmask)?bucket->value[found_index]:*found_value;
-  bucket->timeout[found_index] =
-      (bitmask)?time_now + ht->timeout:bucket->timeout[found_index];
+    u32 bitmask, found_index;
+    __m128i mask;
+
+    // mask[*] = timeout[*] > now
+    mask = _mm_cmpgt_epi32(_mm_loadu_si128 ((__m128i *) bucket->timeout),
+			   _mm_set1_epi32 (time_now));
+    // bitmask[*] = now <= timeout[*/4]
+    bitmask = (~_mm_movemask_epi8(mask)) & 0xffff;
+    // Get first index with now <= timeout[*], if any.
+    if (bitmask && *available_index == ~0)
+      *available_index = b * LBHASH_ENTRY_PER_BUCKET + __builtin_ctz(bitmask)/4;
+
+    // mask[*] = (timeout[*] > now) && (hash[*] == hash)
+    mask = _mm_and_si128(mask,
+			 _mm_cmpeq_epi32(
+			     _mm_loadu_si128 ((__m128i *) bucket->hash),
+			     _mm_set1_epi32 (hash)));
+
+    // Load the array of vip values
+    // mask[*] = (timeout[*] > now) && (hash[*] == hash) && (vip[*] == vip)
+    mask = _mm_and_si128(mask,
+			 _mm_cmpeq_epi32(
+			     _mm_loadu_si128 ((__m128i *) bucket->vip),
+			     _mm_set1_epi32 (vip)));
+
+    // mask[*] = (timeout[*x4] > now) && (hash[*x4] == hash) && (vip[*x4] == vip)
+    bitmask = _mm_movemask_epi8(mask);
+    if (bitmask) {
+      found_index = __builtin_ctz(bitmask)/4;
+      ASSERT(found_index < 4);
+      *found_value = bucket->value[found_index];
+      bucket->timeout[found_index] = time_now + ht->timeout;
+      return;
+    }
 #else
-  u32 i;
-  for (i = 0; i < LBHASH_ENTRY_PER_BUCKET; i++) {
-      u8 cmp = (bucket->hash[i] == hash && bucket->vip[i] == vip);
+    u32 i;
+    for (i = 0; i < LBHASH_ENTRY_PER_BUCKET; i++) {
       u8 timeouted = clib_u32_loop_gt(time_now, bucket->timeout[i]);
-      *found_value = (cmp || timeouted)?*found_value:bucket->value[i];
-      bucket->timeout[i] = (cmp || timeouted)?time_now + ht->timeout:bucket->timeout[i];
-      *available_index = (timeouted && (*available_index == ~0))?i:*available_index;
 
-      if (!cmp)
-	return;
-  }
+      if (timeouted) {
+        if (*available_index == ~0)
+          *available_index = b * LBHASH_ENTRY_PER_BUCKET + i;
+        continue;
+      }
+
+      if (bucket->hash[i] == hash && bucket->vip[i] == vip) {
+        *found_value = bucket->value[i];
+        bucket->timeout[i] = time_now + ht->timeout;
+        return;
+      }
+    }
 #endif
+  }
 }
 
 static_always_inline
 u32 lb_hash_available_value(lb_hash_t *h, u32 hash, u32 available_index)
 {
-  return h->buckets[hash & h->buckets_mask].value[available_index];
+  lb_hash_bucket_t *bucket =
+      lb_hash_bucket(h, hash, available_index / LBHASH_ENTRY_PER_BUCKET);
+  return bucket->value[available_index % LBHASH_ENTRY_PER_BUCKET];
 }
 
 static_always_inline
 void lb_hash_put(lb_hash_t *h, u32 hash, u32 value, u32 vip,
 		 u32 available_index, u32 time_now)
 {
-  lb_hash_bucket_t *bucket = &h->buckets[hash & h->buckets_mask];
-  bucket->hash[available_index] = hash;
-  bucket->value[available_index] = value;
-  bucket->timeout[available_index] = time_now + h->timeout;
-  bucket->vip[available_index] = vip;
+  lb_hash_bucket_t *bucket =
+      lb_hash_bucket(h, hash, available_index / LBHASH_ENTRY_PER_BUCKET);
+  u32 i = available_index % LBHASH_ENTRY_PER_BUCKET;
+  bucket->hash[i] = hash;
+  bucket->value[i] = value;
+  bucket->timeout[i] = time_now + h->timeout;
+  bucket->vip[i] = vip;
 }
 
 static_always_inline
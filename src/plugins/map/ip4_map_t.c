@@ -428,66 +428,63 @@ static uword
 ip4_map_t_tcp_udp (vlib_main_t * vm,
 		   vlib_node_runtime_t * node, vlib_frame_t * frame)
 {
-  u32 n_left_from, *from, next_index, *to_next, n_left_to_next;
-  from = vlib_frame_vector_args (frame);
-  n_left_from = frame->n_vectors;
-  next_index = node->cached_next_index;
+  u32 n_left_from, *from;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
   vlib_node_runtime_t *error_node =
     vlib_node_get_runtime (vm, ip4_map_t_tcp_udp_node.index);
 
+  from = vlib_frame_vector_args (frame);
+  n_left_from = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left_from);
 
   while (n_left_from > 0)
     {
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
+      ip4_mapt_pseudo_header_t *pheader0;
 
-      while (n_left_from > 0 && n_left_to_next > 0)
+      /* headers are rewritten in place, fetch the next ones for writing */
+      if (n_left_from > 2)
 	{
-	  u32 pi0;
-	  vlib_buffer_t *p0;
-	  ip4_mapt_pseudo_header_t *pheader0;
-	  ip4_mapt_tcp_udp_next_t next0;
-
-	  pi0 = to_next[0] = from[0];
-	  from += 1;
-	  n_left_from -= 1;
-	  to_next += 1;
-	  n_left_to_next -= 1;
+	  vlib_prefetch_buffer_header (b[2], LOAD);
+	  CLIB_PREFETCH (vlib_buffer_get_current (b[1]),
+			 2 * CLIB_CACHE_LINE_BYTES, STORE);
+	}
 
-	  next0 = IP4_MAPT_TCP_UDP_NEXT_IP6_LOOKUP;
-	  p0 = vlib_get_buffer (vm, pi0);
+      next[0] = IP4_MAPT_TCP_UDP_NEXT_IP6_LOOKUP;
 
-	  //Accessing pseudo header
-	  pheader0 = vlib_buffer_get_current (p0);
-	  vlib_buffer_advance (p0, sizeof (*pheader0));
+      //Accessing pseudo header
+      pheader0 = vlib_buffer_get_current (b[0]);
+      vlib_buffer_advance (b[0], sizeof (*pheader0));
 
-	  if (map_ip4_to_ip6_tcp_udp (p0, pheader0))
+      if (map_ip4_to_ip6_tcp_udp (b[0], pheader0))
+	{
+	  b[0]->error = error_node->errors[MAP_ERROR_UNKNOWN];
+	  next[0] = IP4_MAPT_TCP_UDP_NEXT_DROP;
+	}
+      else
+	{
+	  if (vnet_buffer (b[0])->map_t.mtu < b[0]->current_length)
 	    {
-	      p0->error = error_node->errors[MAP_ERROR_UNKNOWN];
-	      next0 = IP4_MAPT_TCP_UDP_NEXT_DROP;
+	      //Send to fragmentation node if necessary
+	      vnet_buffer (b[0])->ip_frag.mtu = vnet_buffer (b[0])->map_t.mtu;
+	      vnet_buffer (b[0])->ip_frag.next_index = IP_FRAG_NEXT_IP6_LOOKUP;
+	      next[0] = IP4_MAPT_TCP_UDP_NEXT_IP6_FRAG;
 	    }
 	  else
 	    {
-	      if (vnet_buffer (p0)->map_t.mtu < p0->current_length)
-		{
-		  //Send to fragmentation node if necessary
-		  vnet_buffer (p0)->ip_frag.mtu = vnet_buffer (p0)->map_t.mtu;
-		  vnet_buffer (p0)->ip_frag.next_index =
-		    IP_FRAG_NEXT_IP6_LOOKUP;
-		  next0 = IP4_MAPT_TCP_UDP_NEXT_IP6_FRAG;
-		}
-	      else
-		{
-		  next0 = ip4_map_ip6_lookup_bypass (p0, NULL) ?
-		    IP4_MAPT_TCP_UDP_NEXT_IP6_REWRITE : next0;
-		}
+	      next[0] = ip4_map_ip6_lookup_bypass (b[0], NULL) ?
+			  IP4_MAPT_TCP_UDP_NEXT_IP6_REWRITE :
+			  next[0];
 	    }
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next, pi0,
-					   next0);
 	}
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+
+      b += 1;
+      next += 1;
+      n_left_from -= 1;
     }
 
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+
   return frame->n_vectors;
 }
 
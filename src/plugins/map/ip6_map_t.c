@@ -430,60 +430,57 @@ static uword
 ip6_map_t_tcp_udp (vlib_main_t * vm,
 		   vlib_node_runtime_t * node, vlib_frame_t * frame)
 {
-  u32 n_left_from, *from, next_index, *to_next, n_left_to_next;
+  u32 n_left_from, *from;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
   vlib_node_runtime_t *error_node =
     vlib_node_get_runtime (vm, ip6_map_t_tcp_udp_node.index);
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
-  next_index = node->cached_next_index;
+  vlib_get_buffers (vm, from, bufs, n_left_from);
+
   while (n_left_from > 0)
     {
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-
-      while (n_left_from > 0 && n_left_to_next > 0)
+      /* headers are rewritten in place, fetch the next ones for writing */
+      if (n_left_from > 2)
 	{
-	  u32 pi0;
-	  vlib_buffer_t *p0;
-	  ip6_mapt_tcp_udp_next_t next0;
-
-	  pi0 = to_next[0] = from[0];
-	  from += 1;
-	  n_left_from -= 1;
-	  to_next += 1;
-	  n_left_to_next -= 1;
-	  next0 = IP6_MAPT_TCP_UDP_NEXT_IP4_LOOKUP;
+	  vlib_prefetch_buffer_header (b[2], LOAD);
+	  CLIB_PREFETCH (vlib_buffer_get_current (b[1]),
+			 2 * CLIB_CACHE_LINE_BYTES, STORE);
+	}
 
-	  p0 = vlib_get_buffer (vm, pi0);
+      next[0] = IP6_MAPT_TCP_UDP_NEXT_IP4_LOOKUP;
 
-	  if (map_ip6_to_ip4_tcp_udp (vm, p0, true))
+      if (map_ip6_to_ip4_tcp_udp (vm, b[0], true))
+	{
+	  b[0]->error = error_node->errors[MAP_ERROR_UNKNOWN];
+	  next[0] = IP6_MAPT_TCP_UDP_NEXT_DROP;
+	}
+      else
+	{
+	  if (vnet_buffer (b[0])->map_t.mtu < b[0]->current_length)
 	    {
-	      p0->error = error_node->errors[MAP_ERROR_UNKNOWN];
-	      next0 = IP6_MAPT_TCP_UDP_NEXT_DROP;
+	      // Send to fragmentation node if necessary
+	      vnet_buffer (b[0])->ip_frag.mtu = vnet_buffer (b[0])->map_t.mtu;
+	      vnet_buffer (b[0])->ip_frag.next_index = IP_FRAG_NEXT_IP4_LOOKUP;
+	      next[0] = IP6_MAPT_TCP_UDP_NEXT_IP4_FRAG;
 	    }
 	  else
 	    {
-	      if (vnet_buffer (p0)->map_t.mtu < p0->current_length)
-		{
-		  // Send to fragmentation node if necessary
-		  vnet_buffer (p0)->ip_frag.mtu = vnet_buffer (p0)->map_t.mtu;
-		  vnet_buffer (p0)->ip_frag.next_index =
-		    IP_FRAG_NEXT_IP4_LOOKUP;
-		  next0 = IP6_MAPT_TCP_UDP_NEXT_IP4_FRAG;
-		}
-	      else
-		{
-		  next0 = ip6_map_ip4_lookup_bypass (p0, NULL) ?
-		    IP6_MAPT_TCP_UDP_NEXT_IP4_REWRITE : next0;
-		}
+	      next[0] = ip6_map_ip4_lookup_bypass (b[0], NULL) ?
+			  IP6_MAPT_TCP_UDP_NEXT_IP4_REWRITE :
+			  next[0];
 	    }
-
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next, pi0,
-					   next0);
 	}
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+
+      b += 1;
+      next += 1;
+      n_left_from -= 1;
     }
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+
   return frame->n_vectors;
 }
 
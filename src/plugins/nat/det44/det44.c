@@ -82,6 +82,19 @@ det44_add_del_addr_to_fib (ip4_address_t * addr, u8 p_len, u32 sw_if_index,
     }
 }
 
+static void
+snat_det_map_free (snat_det_map_t * mp)
+{
+  if (mp->sessions)
+    clib_mem_vm_free (mp->sessions, mp->sessions_size);
+  mp->sessions = 0;
+  if (mp->ses_used)
+    clib_mem_vm_free (mp->ses_used, mp->ses_used_size);
+  mp->ses_used = 0;
+  vec_free (mp->user_ses_num);
+  clib_bihash_free_16_8 (&mp->ses_hash);
+}
+
 /**
  * @brief Add/delete deterministic NAT mapping.
  *
@@ -99,7 +112,6 @@ int
 snat_det_add_map (ip4_address_t * in_addr, u8 in_plen,
 		  ip4_address_t * out_addr, u8 out_plen, int is_add)
 {
-  static snat_det_session_t empty_snat_det_session = { 0 };
   det44_main_t *dm = &det44_main;
   ip4_address_t in_cmp, out_cmp;
   det44_interface_t *i;
@@ -139,13 +151,28 @@ snat_det_add_map (ip4_address_t * in_addr, u8 in_plen,
       mp->sharing_ratio = (1 << (32 - in_plen)) / (1 << (32 - out_plen));
       mp->ports_per_host = (65535 - 1023) / mp->sharing_ratio;
 
-      vec_validate_init_empty (mp->sessions,
-			       DET44_SES_PER_USER * (1 << (32 - in_plen)) -
-			       1, empty_snat_det_session);
+      /* pages are zeroed and backed only once an inside address
+       * of the page gets a session */
+      mp->sessions_size = sizeof (snat_det_session_t) * DET44_SES_PER_USER *
+			  (1 << (32 - in_plen));
+      mp->sessions = clib_mem_vm_alloc (mp->sessions_size);
+      mp->ses_used_size = sizeof (u64) * DET44_SES_USED_WORDS *
+			  (1 << (32 - in_plen));
+      mp->ses_used = clib_mem_vm_alloc (mp->ses_used_size);
+      if (!mp->sessions || !mp->ses_used)
+	{
+	  snat_det_map_free (mp);
+	  vec_del1 (dm->det_maps, mp - dm->det_maps);
+	  return VNET_API_ERROR_TABLE_TOO_BIG;
+	}
+      vec_validate (mp->user_ses_num, (1 << (32 - in_plen)) - 1);
+      clib_bihash_init_16_8 (&mp->ses_hash, "det44-sessions",
+			     clib_clamp (1 << (32 - in_plen), 1024, 1 << 22),
+			     0);
     }
   else
     {
-      vec_free (mp->sessions);
+      snat_det_map_free (mp);
       vec_del1 (dm->det_maps, mp - dm->det_maps);
     }
 
@@ -323,6 +350,7 @@ det44_expire_walk_fn (vlib_main_t * vm, vlib_node_runtime_t * rt,
   det44_main_t *dm = &det44_main;
   snat_det_session_t *ses;
   snat_det_map_t *mp;
+  u32 user;
 
   while (1)
     {
@@ -337,12 +365,20 @@ det44_expire_walk_fn (vlib_main_t * vm, vlib_node_runtime_t * rt,
 
       pool_foreach (mp, dm->det_maps)
 	{
-	  vec_foreach (ses, mp->sessions)
+	  vec_foreach_index (user, mp->user_ses_num)
 	    {
-	      // close expired sessions
-	      if (ses->in_port && (ses->expire < now))
+	      // skip inside addresses without sessions, their pages
+	      // are never touched
+	      if (!mp->user_ses_num[user])
+		continue;
+	      ses = mp->sessions + user * DET44_SES_PER_USER;
+	      for (int i = 0; i < DET44_SES_PER_USER; i++, ses++)
 		{
-		  snat_det_ses_close (mp, ses);
+		  // close expired sessions
+		  if (ses->in_port && (ses->expire < now))
+		    {
+		      snat_det_ses_close (mp, ses);
+		    }
 		}
 	    }
 	}
@@ -444,7 +480,7 @@ det44_plugin_disable ()
   /* *INDENT-OFF* */
   pool_foreach (mp, dm->det_maps)
    {
-    vec_free (mp->sessions);
+    snat_det_map_free (mp);
   }
   /* *INDENT-ON* */
 
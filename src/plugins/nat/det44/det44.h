@@ -30,6 +30,7 @@
 #include <vnet/api_errno.h>
 #include <vnet/fib/fib_source.h>
 #include <vppinfra/dlist.h>
+#include <vppinfra/bihash_16_8.h>
 #include <vppinfra/error.h>
 #include <vlibapi/api.h>
 #include <vlib/log.h>
@@ -63,6 +64,8 @@ typedef enum
 } det44_session_state_t;
 
 #define DET44_SES_PER_USER 1000
+/* u64 words of the bitmap of the sessions in use of an inside address */
+#define DET44_SES_USED_WORDS ((DET44_SES_PER_USER + 63) / 64)
 
 typedef struct
 {
@@ -98,14 +101,14 @@ typedef struct
 
 typedef struct
 {
-  /* Inside network port */
-  u16 in_port;
   /* Outside network address and port */
   snat_det_out_key_t out;
-  /* Session state */
-  u8 state;
   /* Expire timeout */
   u32 expire;
+  /* Inside network port */
+  u16 in_port;
+  /* Session state */
+  u8 state;
 } snat_det_session_t;
 
 typedef struct
@@ -122,8 +125,18 @@ typedef struct
   u16 ports_per_host;
   /* session counter */
   u32 ses_num;
-  /* vector of sessions */
+  /* DET44_SES_PER_USER sessions per inside address, in anonymous memory
+   * so only the pages of inside addresses with sessions are backed */
   snat_det_session_t *sessions;
+  uword sessions_size;
+  /* DET44_SES_USED_WORDS per inside address, a bit is set while its
+   * session is in use; also in anonymous memory */
+  u64 *ses_used;
+  uword ses_used_size;
+  /* session counter of each inside address */
+  u16 *user_ses_num;
+  /* session index by inside and by outside key of the session */
+  clib_bihash_16_8_t ses_hash;
 } snat_det_map_t;
 
 typedef struct
@@ -334,26 +347,50 @@ snat_det_reverse (snat_det_map_t * dm, ip4_address_t * out_addr, u16 out_port,
 			  in_offset1 + in_offset2);
 }
 
+static_always_inline u32
+snat_det_user_index (ip4_address_t * addr, u8 plen)
+{
+  return clib_net_to_host_u32 (addr->as_u32) & pow2_mask (32 - plen);
+}
+
 static_always_inline u32
 snat_det_user_ses_offset (ip4_address_t * addr, u8 plen)
 {
-  return (clib_net_to_host_u32 (addr->as_u32) & pow2_mask (32 - plen)) *
-    DET44_SES_PER_USER;
+  return snat_det_user_index (addr, plen) * DET44_SES_PER_USER;
+}
+
+static_always_inline void
+snat_det_ses_in_kv (clib_bihash_kv_16_8_t * kv, u32 user_index, u16 in_port,
+		    ip4_address_t ext_host_addr, u16 ext_host_port)
+{
+  kv->key[0] = (u64) ext_host_addr.as_u32 << 32 |
+	       (u64) ext_host_port << 16 | in_port;
+  kv->key[1] = user_index;
+}
+
+static_always_inline void
+snat_det_ses_out_kv (clib_bihash_kv_16_8_t * kv, u32 user_index, u64 out_key)
+{
+  kv->key[0] = out_key;
+  kv->key[1] = 1ULL << 32 | user_index;
 }
 
+/* the hash is only a hint, sessions are closed without any lock */
 static_always_inline snat_det_session_t *
 snat_det_get_ses_by_out (snat_det_map_t * dm, ip4_address_t * in_addr,
 			 u64 out_key)
 {
-  u32 user_offset;
-  u16 i;
+  clib_bihash_kv_16_8_t kv, value;
+  snat_det_session_t *ses;
 
-  user_offset = snat_det_user_ses_offset (in_addr, dm->in_plen);
-  for (i = 0; i < DET44_SES_PER_USER; i++)
-    {
-      if (dm->sessions[i + user_offset].out.as_u64 == out_key)
-	return &dm->sessions[i + user_offset];
-    }
+  snat_det_ses_out_kv (&kv, snat_det_user_index (in_addr, dm->in_plen),
+		       out_key);
+  if (clib_bihash_search_16_8 (&dm->ses_hash, &kv, &value))
+    return 0;
+
+  ses = &dm->sessions[value.value];
+  if (ses->in_port && ses->out.as_u64 == out_key)
+    return ses;
 
   return 0;
 }
@@ -362,19 +399,19 @@ static_always_inline snat_det_session_t *
 snat_det_find_ses_by_in (snat_det_map_t * dm, ip4_address_t * in_addr,
 			 u16 in_port, snat_det_out_key_t out_key)
 {
+  clib_bihash_kv_16_8_t kv, value;
   snat_det_session_t *ses;
-  u32 user_offset;
-  u16 i;
 
-  user_offset = snat_det_user_ses_offset (in_addr, dm->in_plen);
-  for (i = 0; i < DET44_SES_PER_USER; i++)
-    {
-      ses = &dm->sessions[i + user_offset];
-      if (ses->in_port == in_port &&
-	  ses->out.ext_host_addr.as_u32 == out_key.ext_host_addr.as_u32 &&
-	  ses->out.ext_host_port == out_key.ext_host_port)
-	return &dm->sessions[i + user_offset];
-    }
+  snat_det_ses_in_kv (&kv, snat_det_user_index (in_addr, dm->in_plen),
+		      in_port, out_key.ext_host_addr, out_key.ext_host_port);
+  if (clib_bihash_search_16_8 (&dm->ses_hash, &kv, &value))
+    return 0;
+
+  ses = &dm->sessions[value.value];
+  if (ses->in_port == in_port &&
+      ses->out.ext_host_addr.as_u32 == out_key.ext_host_addr.as_u32 &&
+      ses->out.ext_host_port == out_key.ext_host_port)
+    return ses;
 
   return 0;
 }
@@ -384,26 +421,53 @@ snat_det_ses_create (u32 thread_index, snat_det_map_t * dm,
 		     ip4_address_t * in_addr, u16 in_port,
 		     snat_det_out_key_t * out)
 {
-  u32 user_offset;
-  u16 i;
-
-  user_offset = snat_det_user_ses_offset (in_addr, dm->in_plen);
-
-  for (i = 0; i < DET44_SES_PER_USER; i++)
-    {
-      if (!dm->sessions[i + user_offset].in_port)
-	{
-	  if (clib_atomic_bool_cmp_and_swap
-	      (&dm->sessions[i + user_offset].in_port, 0, in_port))
-	    {
-	      dm->sessions[i + user_offset].out.as_u64 = out->as_u64;
-	      dm->sessions[i + user_offset].state = DET44_SESSION_UNKNOWN;
-	      dm->sessions[i + user_offset].expire = 0;
-	      clib_atomic_add_fetch (&dm->ses_num, 1);
-	      return &dm->sessions[i + user_offset];
-	    }
-	}
-    }
+  u32 user_index, user_offset, i, w;
+  clib_bihash_kv_16_8_t kv;
+  snat_det_session_t *ses;
+  u64 *used, v, bit;
+
+  user_index = snat_det_user_index (in_addr, dm->in_plen);
+  user_offset = user_index * DET44_SES_PER_USER;
+  used = dm->ses_used + user_index * DET44_SES_USED_WORDS;
+
+  if (dm->user_ses_num[user_index] < DET44_SES_PER_USER)
+    for (w = 0; w < DET44_SES_USED_WORDS; w++)
+      {
+	v = clib_atomic_load_relax_n (&used[w]);
+	while (~v)
+	  {
+	    i = w * 64 + count_trailing_zeros (~v);
+	    if (i >= DET44_SES_PER_USER)
+	      break;
+	    bit = 1ULL << (i % 64);
+	    /* another thread may take the slot first, then try the next */
+	    if (!clib_atomic_bool_cmp_and_swap (&used[w], v, v | bit))
+	      {
+		v = clib_atomic_load_relax_n (&used[w]);
+		continue;
+	      }
+
+	    ses = &dm->sessions[i + user_offset];
+	    ses->out.as_u64 = out->as_u64;
+	    ses->state = DET44_SESSION_UNKNOWN;
+	    ses->expire = 0;
+
+	    snat_det_ses_in_kv (&kv, user_index, in_port,
+				out->ext_host_addr, out->ext_host_port);
+	    kv.value = i + user_offset;
+	    clib_bihash_add_del_16_8 (&dm->ses_hash, &kv, 1);
+	    snat_det_ses_out_kv (&kv, user_index, out->as_u64);
+	    kv.value = i + user_offset;
+	    clib_bihash_add_del_16_8 (&dm->ses_hash, &kv, 1);
+
+	    /* the session is found by lookups from now on */
+	    clib_atomic_store_rel_n (&ses->in_port, in_port);
+
+	    clib_atomic_add_fetch (&dm->user_ses_num[user_index], 1);
+	    clib_atomic_add_fetch (&dm->ses_num, 1);
+	    return ses;
+	  }
+      }
 
   nat_ipfix_logging_max_entries_per_user (thread_index,
 					  DET44_SES_PER_USER,
@@ -411,13 +475,36 @@ snat_det_ses_create (u32 thread_index, snat_det_map_t * dm,
   return 0;
 }
 
+/*
+ * Clearing in_port claims the close, so only one thread does it, and
+ * hides the session from lookups. The slot is only released for reuse
+ * once the session's keys are gone.
+ */
 static_always_inline void
 snat_det_ses_close (snat_det_map_t * dm, snat_det_session_t * ses)
 {
-  if (clib_atomic_bool_cmp_and_swap (&ses->in_port, ses->in_port, 0))
+  u32 i = ses - dm->sessions;
+  u32 user_index = i / DET44_SES_PER_USER;
+  snat_det_out_key_t out = ses->out;
+  u16 in_port = ses->in_port;
+  clib_bihash_kv_16_8_t kv;
+  u64 *used;
+
+  if (in_port && clib_atomic_bool_cmp_and_swap (&ses->in_port, in_port, 0))
     {
+      snat_det_ses_in_kv (&kv, user_index, in_port, out.ext_host_addr,
+			  out.ext_host_port);
+      clib_bihash_add_del_16_8 (&dm->ses_hash, &kv, 0);
+      snat_det_ses_out_kv (&kv, user_index, out.as_u64);
+      clib_bihash_add_del_16_8 (&dm->ses_hash, &kv, 0);
       ses->out.as_u64 = 0;
+
+      clib_atomic_add_fetch (&dm->user_ses_num[user_index], -1);
       clib_atomic_add_fetch (&dm->ses_num, -1);
+
+      i %= DET44_SES_PER_USER;
+      used = dm->ses_used + user_index * DET44_SES_USED_WORDS;
+      clib_atomic_fetch_and (&used[i / 64], ~(1ULL << (i % 64)));
     }
 }
 
@@ -189,12 +189,18 @@ det44_show_sessions_command_fn (vlib_main_t * vm,
   vlib_cli_output (vm, "NAT44 deterministic sessions:");
   pool_foreach (mp, dm->det_maps)
    {
-    int i;
-    vec_foreach_index (i, mp->sessions)
+    u32 user, i;
+    vec_foreach_index (user, mp->user_ses_num)
       {
-        ses = vec_elt_at_index (mp->sessions, i);
-        if (ses->in_port)
-          vlib_cli_output (vm, "  %U", format_det_map_ses, mp, ses, &i);
+        if (!mp->user_ses_num[user])
+          continue;
+        for (i = user * DET44_SES_PER_USER;
+             i < (user + 1) * DET44_SES_PER_USER; i++)
+          {
+            ses = mp->sessions + i;
+            if (ses->in_port)
+              vlib_cli_output (vm, "  %U", format_det_map_ses, mp, ses, &i);
+          }
       }
   }
   return 0;
@@ -207,6 +207,8 @@ void
 nat44_ed_free_session_data (snat_main_t *sm, snat_session_t *s,
 			    u32 thread_index, u8 is_ha)
 {
+  nat_ed_session_unpublish (
+    vec_elt_at_index (sm->per_thread_data, thread_index), s);
   per_vrf_sessions_unregister_session (s, thread_index);
 
   if (nat_ed_ses_i2o_flow_hash_add_del (sm, thread_index, s, 0))
@@ -231,7 +233,7 @@ nat44_ed_free_session_data (snat_main_t *sm, snat_session_t *s,
 			   s->out2in.port, &s->ext_host_addr, s->ext_host_port,
 			   s->proto, nat44_ed_is_twice_nat_session (s));
 
-  if (!is_ha)
+  if (!is_ha && !nat44_ed_is_port_block_session (s))
     {
       /* log NAT event */
       nat_ipfix_logging_nat44_ses_delete (
@@ -501,6 +503,175 @@ nat44_ed_add_del_sm_fib_reg_entries (u32 sw_if_index, u8 is_add)
     }
 }
 
+nat_ed_port_alloc_t *
+nat_ed_port_alloc_create (snat_main_t *sm, u32 thread_index,
+			  ip4_address_t addr)
+{
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, thread_index);
+  nat_ed_port_alloc_t *pa;
+
+  pool_get_zero (tsm->port_allocs, pa);
+  pa->addr = addr;
+  hash_set (tsm->port_alloc_by_addr, addr.as_u32, pa - tsm->port_allocs);
+
+  return pa;
+}
+
+u16 *
+nat_ed_port_alloc_proto_init (snat_main_t *sm, nat_ed_port_alloc_t *pa, u8 pi)
+{
+  vec_validate (pa->refcnt[pi], sm->port_per_thread - 1);
+  pa->free[pi] =
+    clib_bitmap_set_region (pa->free[pi], 0, 1, sm->port_per_thread);
+
+  return pa->refcnt[pi];
+}
+
+/* Log a port block reservation or release, the block covers the
+ * subscriber's sessions using its ports */
+static void
+nat_ed_port_block_log (snat_main_t *sm, u32 thread_index,
+		       nat_ed_port_alloc_t *pa, nat_ed_port_block_t *blk,
+		       u8 is_alloc)
+{
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, thread_index);
+  u16 start = ED_USER_PORT_OFFSET +
+	      sm->port_per_thread * tsm->snat_thread_index +
+	      blk->block_index * sm->port_block_size;
+  u16 end = start + sm->port_block_size - 1;
+  u32 in_addr = blk->subscriber >> 32;
+
+  if (is_alloc)
+    nat_ipfix_logging_nat44_port_block_alloc (
+      thread_index, in_addr, pa->addr.as_u32, start, end, blk->fib_index);
+  else
+    nat_ipfix_logging_nat44_port_block_dealloc (
+      thread_index, in_addr, pa->addr.as_u32, start, end, blk->fib_index);
+}
+
+static void
+nat_ed_port_alloc_free (snat_main_per_thread_data_t *tsm,
+			nat_ed_port_alloc_t *pa)
+{
+  snat_main_t *sm = &snat_main;
+  u32 pa_index = pa - tsm->port_allocs;
+  nat_ed_port_block_t *blk;
+  u32 *to_free = 0, *bi;
+  int i;
+
+  pool_foreach (blk, tsm->port_blocks)
+    {
+      if (blk->port_alloc_index == pa_index)
+	vec_add1 (to_free, blk - tsm->port_blocks);
+    }
+  vec_foreach (bi, to_free)
+    {
+      blk = pool_elt_at_index (tsm->port_blocks, bi[0]);
+      nat_ed_port_block_log (sm, tsm - sm->per_thread_data, pa, blk, 0);
+      hash_unset (tsm->port_block_by_subscriber, blk->subscriber);
+      pool_put (tsm->port_blocks, blk);
+    }
+  vec_free (to_free);
+
+  for (i = 0; i < NAT_ED_PORT_N_PROTO; i++)
+    {
+      vec_free (pa->refcnt[i]);
+      clib_bitmap_free (pa->free[i]);
+    }
+  clib_bitmap_free (pa->reserved_blocks);
+
+  hash_unset (tsm->port_alloc_by_addr, pa->addr.as_u32);
+  pool_put (tsm->port_allocs, pa);
+}
+
+static void
+nat_ed_port_alloc_free_all (snat_main_per_thread_data_t *tsm)
+{
+  nat_ed_port_alloc_t *pa;
+
+  pool_foreach (pa, tsm->port_allocs)
+    {
+      nat_ed_port_alloc_free (tsm, pa);
+    }
+}
+
+nat_ed_port_block_t *
+nat_ed_port_block_reserve (snat_main_t *sm, u32 thread_index,
+			   nat_ed_port_alloc_t *pa, u64 subscriber,
+			   u32 fib_index)
+{
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, thread_index);
+  u32 n_blocks = sm->port_per_thread / sm->port_block_size;
+  nat_ed_port_block_t *blk;
+  uword block_index;
+
+  if (pa->n_reserved_blocks >= n_blocks)
+    return 0;
+
+  block_index = clib_bitmap_next_clear (pa->reserved_blocks,
+					snat_random_port (0, n_blocks - 1));
+  if (block_index >= n_blocks)
+    block_index = clib_bitmap_first_clear (pa->reserved_blocks);
+
+  pa->reserved_blocks = clib_bitmap_set (pa->reserved_blocks, block_index, 1);
+  pa->n_reserved_blocks++;
+
+  pool_get_zero (tsm->port_blocks, blk);
+  blk->subscriber = subscriber;
+  blk->port_alloc_index = pa - tsm->port_allocs;
+  blk->block_index = block_index;
+  blk->fib_index = fib_index;
+  hash_set (tsm->port_block_by_subscriber, subscriber,
+	    blk - tsm->port_blocks);
+
+  nat_ed_port_block_log (sm, thread_index, pa, blk, 1);
+
+  return blk;
+}
+
+void
+nat_ed_port_block_release (snat_main_t *sm, u32 thread_index,
+			   nat_ed_port_block_t *blk)
+{
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, thread_index);
+  nat_ed_port_alloc_t *pa;
+
+  pa = pool_elt_at_index (tsm->port_allocs, blk->port_alloc_index);
+  pa->reserved_blocks =
+    clib_bitmap_set (pa->reserved_blocks, blk->block_index, 0);
+  pa->n_reserved_blocks--;
+
+  nat_ed_port_block_log (sm, thread_index, pa, blk, 0);
+
+  hash_unset (tsm->port_block_by_subscriber, blk->subscriber);
+  pool_put (tsm->port_blocks, blk);
+}
+
+int
+nat44_ed_set_port_block_size (u16 port_block_size)
+{
+  snat_main_t *sm = &snat_main;
+
+  if (vec_len (sm->addresses))
+    return VNET_API_ERROR_INSTANCE_IN_USE;
+
+  sm->port_block_size = port_block_size;
+  nat_ipfix_logging_port_blocks_enable_disable (port_block_size != 0);
+  return 0;
+}
+
+void
+nat44_ed_set_session_sharing (u8 is_enable)
+{
+  snat_main_t *sm = &snat_main;
+
+  sm->session_sharing_enabled = is_enable != 0;
+}
+
 int
 nat44_ed_add_address (ip4_address_t *addr, u32 vrf_id, u8 twice_nat)
 {
@@ -561,6 +732,7 @@ nat44_ed_del_address (ip4_address_t addr, u8 twice_nat)
   snat_session_t *ses;
   u32 *ses_to_be_removed = 0, *ses_index;
   snat_main_per_thread_data_t *tsm;
+  nat_ed_port_alloc_t *pa;
   int j;
 
   addresses = twice_nat ? sm->twice_nat_addresses : sm->addresses;
@@ -601,6 +773,10 @@ nat44_ed_del_address (ip4_address_t addr, u8 twice_nat)
 	  nat_ed_session_delete (sm, ses, tsm - sm->per_thread_data, 1);
 	}
       vec_free (ses_to_be_removed);
+
+      pa = nat_ed_port_alloc_get (tsm, addr);
+      if (pa)
+	nat_ed_port_alloc_free (tsm, pa);
     }
 
   if (!twice_nat)
@@ -2115,6 +2291,7 @@ int
 snat_set_workers (uword * bitmap)
 {
   snat_main_t *sm = &snat_main;
+  snat_main_per_thread_data_t *tsm;
   int i, j = 0;
 
   if (sm->num_workers < 2)
@@ -2134,6 +2311,20 @@ snat_set_workers (uword * bitmap)
 
   sm->port_per_thread = (65536 - ED_USER_PORT_OFFSET) / _vec_len (sm->workers);
 
+  /*
+   * The port ranges of the threads changed. Existing sessions keep their
+   * ports, still in the flow hash, but no longer hold a count in the new
+   * tables, so they must not release one either.
+   */
+  vec_foreach (tsm, sm->per_thread_data)
+    {
+      snat_session_t *s;
+
+      pool_foreach (s, tsm->sessions)
+	s->flags &= ~SNAT_SESSION_FLAG_PORT_ALLOCATED;
+      nat_ed_port_alloc_free_all (tsm);
+    }
+
   return 0;
 }
 
@@ -2384,6 +2575,9 @@ nat_init (vlib_main_t * vm)
     }
   num_threads = tm->n_vlib_mains - 1;
   sm->port_per_thread = 65536 - ED_USER_PORT_OFFSET;
+  sm->session_sharing_enabled = 0;
+  sm->flow_offload_threshold = NAT_ED_FLOW_OFFLOAD_THRESHOLD;
+  sm->flow_offload_idle_timeout = NAT_ED_FLOW_OFFLOAD_IDLE_TIMEOUT;
   vec_validate (sm->per_thread_data, num_threads);
 
   /* Use all available workers by default */
@@ -2701,6 +2895,8 @@ nat44_plugin_disable ()
   nat_affinity_disable ();
 
   sm->forwarding_enabled = 0;
+  sm->port_block_size = 0;
+  nat_ipfix_logging_port_blocks_enable_disable (0);
   sm->enabled = 0;
 
   return error;
@@ -2993,6 +3189,21 @@ nat44_ed_get_in2out_worker_index (vlib_buffer_t *b, ip4_header_t *ip,
 	    }
 	}
 
+      /* an offloaded flow, the NIC marked the packet with its session */
+      if (!is_output && PREDICT_FALSE (sm->flow_offload_id_count))
+	{
+	  u32 thread_index, session_index;
+
+	  session_index = nat44_ed_flow_offload_session (sm, b, ip, fib_index,
+							 &thread_index);
+	  if (session_index != ~0)
+	    {
+	      next_worker_index = thread_index;
+	      vnet_buffer2 (b)->nat.cached_session_index = session_index;
+	      goto out;
+	    }
+	}
+
       if (PREDICT_FALSE (ip->protocol == IP_PROTOCOL_ICMP))
 	{
 	  ip4_address_t lookup_saddr, lookup_daddr;
@@ -3086,6 +3297,24 @@ nat44_ed_get_out2in_worker_index (vlib_buffer_t *b, ip4_header_t *ip,
 
   proto = ip->protocol;
 
+  /* an offloaded flow, the NIC marked the packet with its session */
+  if (PREDICT_FALSE (sm->flow_offload_id_count))
+    {
+      u32 thread_index, session_index;
+
+      session_index = nat44_ed_flow_offload_session (sm, b, ip, rx_fib_index,
+						     &thread_index);
+      if (session_index != ~0)
+	{
+	  vnet_buffer2 (b)->nat.cached_session_index = session_index;
+	  nat_elog_debug_handoff (
+	    sm, "HANDOFF OUT2IN (flow offload)", thread_index, rx_fib_index,
+	    clib_net_to_host_u32 (ip->src_address.as_u32),
+	    clib_net_to_host_u32 (ip->dst_address.as_u32));
+	  return thread_index;
+	}
+    }
+
   if (PREDICT_FALSE (IP_PROTOCOL_ICMP == proto))
     {
       ip4_address_t lookup_saddr, lookup_daddr;
@@ -3122,6 +3351,16 @@ nat44_ed_get_out2in_worker_index (vlib_buffer_t *b, ip4_header_t *ip,
       vnet_buffer2 (b)->nat.cached_session_index =
 	ed_value_get_session_index (&value16);
       next_worker_index = ed_value_get_thread_index (&value16);
+      if (sm->session_sharing_enabled &&
+	  next_worker_index != vlib_get_thread_index () &&
+	  nat44_ed_o2i_session_shareable (
+	    sm, b, next_worker_index, ed_value_get_session_index (&value16),
+	    vlib_time_now (vlib_get_main ())))
+	{
+	  /* the out2in node translates it here, without a handoff */
+	  vnet_buffer2 (b)->nat.cached_session_index = ~0;
+	  next_worker_index = vlib_get_thread_index ();
+	}
       nat_elog_debug_handoff (sm, "HANDOFF OUT2IN (session)",
 			      next_worker_index, rx_fib_index,
 			      clib_net_to_host_u32 (ip->src_address.as_u32),
@@ -3275,12 +3514,24 @@ nat44_update_session_limit (u32 session_limit, u32 vrf_id)
 static void
 nat44_ed_worker_db_init (snat_main_per_thread_data_t *tsm, u32 translations)
 {
+  nat_ed_session_shared_t *sh;
   dlist_elt_t *head;
 
   pool_alloc (tsm->per_vrf_sessions_pool, translations);
   pool_alloc (tsm->sessions, translations);
   pool_alloc (tsm->lru_pool, translations);
 
+  /* nothing is published until the owner says so */
+  vec_validate_aligned (tsm->sessions_shared, translations - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (sh, tsm->sessions_shared)
+    {
+      sh->version = 1;
+      sh->flow_offload[NAT44_ED_DIR_I2O] = NAT_ED_FLOW_OFFLOAD_NONE;
+      sh->flow_offload[NAT44_ED_DIR_O2I] = NAT_ED_FLOW_OFFLOAD_NONE;
+    }
+  clib_spinlock_init (&tsm->flow_offload_lock);
+
   pool_get (tsm->lru_pool, head);
   tsm->tcp_trans_lru_head_index = head - tsm->lru_pool;
   clib_dlist_init (tsm->lru_pool, tsm->tcp_trans_lru_head_index);
@@ -3330,8 +3581,12 @@ nat44_ed_db_init ()
 static void
 nat44_ed_worker_db_free (snat_main_per_thread_data_t *tsm)
 {
+  nat_ed_port_alloc_free_all (tsm);
   pool_free (tsm->lru_pool);
   pool_free (tsm->sessions);
+  vec_free (tsm->sessions_shared);
+  clib_spinlock_free (&tsm->flow_offload_lock);
+  vec_free (tsm->flow_offload_requests);
   pool_free (tsm->per_vrf_sessions_pool);
 }
 
@@ -3349,6 +3604,9 @@ nat44_ed_db_free ()
   snat_main_t *sm = &snat_main;
   snat_main_per_thread_data_t *tsm;
 
+  /* the offloaded flows refer to the sessions */
+  nat44_ed_flow_offload_flush ();
+
   vec_foreach (tsm, sm->per_thread_data)
     {
       nat44_ed_worker_db_free (tsm);
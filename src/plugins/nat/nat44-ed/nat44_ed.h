@@ -46,6 +46,16 @@
  */
 #define ED_USER_PORT_OFFSET 1024
 
+/* port allocator bitmaps are kept per protocol, others share one */
+typedef enum
+{
+  NAT_ED_PORT_PROTO_TCP,
+  NAT_ED_PORT_PROTO_UDP,
+  NAT_ED_PORT_PROTO_ICMP,
+  NAT_ED_PORT_PROTO_OTHER,
+  NAT_ED_PORT_N_PROTO,
+} nat_ed_port_proto_t;
+
 /* NAT buffer flags */
 #define SNAT_FLAG_HAIRPINNING (1 << 0)
 
@@ -116,7 +126,8 @@ typedef enum
   _ (NON_SYN, "non-SYN packet try to create session")                         \
   _ (TCP_CLOSED, "drops due to TCP in transitory timeout")                    \
   _ (HASH_ADD_FAILED, "hash table add failed")                                \
-  _ (TRNSL_FAILED, "couldn't translate packet")
+  _ (TRNSL_FAILED, "couldn't translate packet")                              \
+  _ (CONGESTION_DROP, "congestion drop")
 
 typedef enum
 {
@@ -169,6 +180,8 @@ format_function_t format_nat44_ed_tcp_state;
 #define SNAT_SESSION_FLAG_AFFINITY	     (1 << 6)
 #define SNAT_SESSION_FLAG_EXACT_ADDRESS	     (1 << 7)
 #define SNAT_SESSION_FLAG_HAIRPINNING	     (1 << 8)
+#define SNAT_SESSION_FLAG_PORT_ALLOCATED     (1 << 9)
+#define SNAT_SESSION_FLAG_PORT_BLOCK	     (1 << 10)
 
 /* NAT interface flags */
 #define NAT_INTERFACE_FLAG_IS_INSIDE 1
@@ -447,11 +460,105 @@ typedef struct
   ip4_address_t addr;
 } snat_fib_entry_reg_t;
 
+/* Dynamic outside ports of one pool address in one thread's port range.
+ * Ports are numbered relative to the start of the thread's range. */
+typedef struct
+{
+  ip4_address_t addr;
+
+  /* sessions using the port, allocated on first use of the protocol */
+  u16 *refcnt[NAT_ED_PORT_N_PROTO];
+
+  /* ports without sessions outside of reserved blocks */
+  uword *free[NAT_ED_PORT_N_PROTO];
+
+  /* ports with at least one session */
+  u32 n_used[NAT_ED_PORT_N_PROTO];
+
+  /* port blocks reserved by subscribers */
+  uword *reserved_blocks;
+  u32 n_reserved_blocks;
+} nat_ed_port_alloc_t;
+
+/* Port block reserved by a subscriber on a pool address */
+typedef struct
+{
+  u64 subscriber;
+  u32 port_alloc_index;
+  u32 block_index;
+  u32 n_sessions;
+  /* of the session which reserved it, for logging */
+  u32 fib_index;
+} nat_ed_port_block_t;
+
+/*
+ * Session state shared with the other workers, kept aside from the packed
+ * session so it is naturally aligned for atomic access.
+ *
+ * Out2in packets of a published session may be translated by any worker
+ * instead of being handed off to the owner. The version is odd while the
+ * session's out2in flow can't be used that way: before the owner first
+ * forwards a packet of the session, and once it starts deleting it. Other
+ * workers copy the flow and check the version did not change meanwhile.
+ * They record their packets in the remote counters, which the owner folds
+ * into the session before it looks at its timeout.
+ *
+ * The flow offload state of each direction is either one of the
+ * NAT_ED_FLOW_OFFLOAD_* values or the index of the session's entry in the
+ * flow offload pool.
+ */
+typedef struct
+{
+  u32 version;
+  u32 remote_pkts;
+  u64 remote_bytes;
+  f64 remote_last_heard;
+  u32 flow_offload[NAT44_ED_N_DIR];
+} nat_ed_session_shared_t;
+
+#define NAT_ED_FLOW_OFFLOAD_NONE    ((u32) ~0)
+#define NAT_ED_FLOW_OFFLOAD_PENDING ((u32) ~0 - 1)
+/* not offloadable, the packets arrive on an interface without offload */
+#define NAT_ED_FLOW_OFFLOAD_NEVER ((u32) ~0 - 2)
+
+/* packets of a session before it is offloaded */
+#define NAT_ED_FLOW_OFFLOAD_THRESHOLD 1000
+/* seconds without packets before an offloaded flow is removed */
+#define NAT_ED_FLOW_OFFLOAD_IDLE_TIMEOUT 10
+
+/*
+ * A session flow programmed into a NIC to mark its packets with the
+ * session, so they are handed off and translated without a flow lookup.
+ * Main thread only.
+ */
+typedef struct
+{
+  u32 flow_index;
+  u32 hw_if_index;
+  u32 thread_index;
+  u32 session_index;
+  u8 dir;
+} nat_ed_flow_offload_t;
+
+typedef struct
+{
+  u32 session_index;
+  /* flow offload state of the session when requested */
+  u32 state;
+  /* interface to offload on, ~0 to remove the offload in state */
+  u32 hw_if_index;
+  u8 dir;
+} nat_ed_flow_offload_request_t;
+
 typedef struct
 {
   /* Session pool */
   snat_session_t *sessions;
 
+  /* shared state by session index, sized to the session limit like the
+   * session pool so neither ever moves */
+  nat_ed_session_shared_t *sessions_shared;
+
   /* Pool of doubly-linked list elements */
   dlist_elt_t *list_pool;
 
@@ -471,6 +578,18 @@ typedef struct
 
   per_vrf_sessions_t *per_vrf_sessions_pool;
 
+  /* outside port allocation by pool address */
+  nat_ed_port_alloc_t *port_allocs;
+  uword *port_alloc_by_addr;
+
+  /* port blocks by inside address << 32 | pool address */
+  nat_ed_port_block_t *port_blocks;
+  uword *port_block_by_subscriber;
+
+  /* flow offload requests for the main thread */
+  clib_spinlock_t flow_offload_lock;
+  nat_ed_flow_offload_request_t *flow_offload_requests;
+
 } snat_main_per_thread_data_t;
 
 struct snat_main_s;
@@ -507,6 +626,9 @@ typedef struct snat_main_s
   u32 *workers;
   u16 port_per_thread;
 
+  /* ports reserved per subscriber and pool address, 0 to not reserve */
+  u16 port_block_size;
+
   /* Per thread data */
   snat_main_per_thread_data_t *per_thread_data;
 
@@ -568,6 +690,23 @@ typedef struct snat_main_s
   /* If forwarding is enabled */
   u8 forwarding_enabled;
 
+  /* translate out2in packets of other workers' sessions in place */
+  u8 session_sharing_enabled;
+
+  /* flow offload */
+  u8 flow_offload_enabled;
+  /* by hw_if_index */
+  uword *flow_offload_interfaces;
+  nat_ed_flow_offload_t *flow_offloads;
+  /* packets of a session before it is offloaded */
+  u32 flow_offload_threshold;
+  /* seconds without packets before an offloaded flow is removed */
+  u32 flow_offload_idle_timeout;
+  /* flow ids marking the packets, one per session of each thread:
+   * start + thread index * max_translations_per_thread + session index */
+  u32 flow_offload_id_start;
+  u32 flow_offload_id_count;
+
   /* Is translation memory size calculated or user defined */
   u8 translation_memory_size_set;
 
@@ -742,6 +881,17 @@ nat44_ed_is_exact_address_session (snat_session_t *s)
   return s->flags & SNAT_SESSION_FLAG_EXACT_ADDRESS;
 }
 
+/** \brief Check if session uses a port of its subscriber's port block.
+    Such sessions are logged with the block, not one by one.
+    @param s SNAT session
+    @return true if port block session
+*/
+always_inline bool
+nat44_ed_is_port_block_session (snat_session_t *s)
+{
+  return s->flags & SNAT_SESSION_FLAG_PORT_BLOCK;
+}
+
 /** \brief Check if NAT interface is inside.
     @param i NAT interface
     @return true if inside interface
@@ -843,6 +993,28 @@ int nat44_ed_del_output_interface (u32 sw_if_index);
 
 int nat44_ed_add_address (ip4_address_t *addr, u32 vrf_id, u8 twice_nat);
 int nat44_ed_del_address (ip4_address_t addr, u8 twice_nat);
+int nat44_ed_set_port_block_size (u16 port_block_size);
+void nat44_ed_set_session_sharing (u8 is_enable);
+
+int nat44_ed_flow_offload_enable_disable (u32 sw_if_index, u8 is_enable);
+void nat44_ed_flow_offload_set_params (u32 threshold, u32 idle_timeout);
+void nat44_ed_flow_offload_request (snat_main_per_thread_data_t *tsm,
+				    u32 session_index, u32 state,
+				    u32 hw_if_index, u8 dir);
+void nat44_ed_flow_offload_flush (void);
+
+nat_ed_port_alloc_t *nat_ed_port_alloc_create (snat_main_t *sm,
+					       u32 thread_index,
+					       ip4_address_t addr);
+u16 *nat_ed_port_alloc_proto_init (snat_main_t *sm, nat_ed_port_alloc_t *pa,
+				   u8 pi);
+nat_ed_port_block_t *nat_ed_port_block_reserve (snat_main_t *sm,
+						u32 thread_index,
+						nat_ed_port_alloc_t *pa,
+						u64 subscriber, u32 fib_index);
+void nat_ed_port_block_release (snat_main_t *sm, u32 thread_index,
+				nat_ed_port_block_t *blk);
+format_function_t format_nat_ed_port_alloc;
 int nat44_ed_add_interface_address (u32 sw_if_index, u8 twice_nat);
 int nat44_ed_del_interface_address (u32 sw_if_index, u8 twice_nat);
 
@@ -611,6 +611,8 @@ nat44_show_addresses_command_fn (vlib_main_t * vm, unformat_input_t * input,
 				 vlib_cli_command_t * cmd)
 {
   snat_main_t *sm = &snat_main;
+  snat_main_per_thread_data_t *tsm;
+  nat_ed_port_alloc_t *pa;
   snat_address_t *ap;
 
   vlib_cli_output (vm, "NAT44 pool addresses:");
@@ -626,6 +628,14 @@ nat44_show_addresses_command_fn (vlib_main_t * vm, unformat_input_t * input,
 
       if (ap->addr_len != ~0)
 	vlib_cli_output (vm, "  synced with interface address");
+
+      vec_foreach (tsm, sm->per_thread_data)
+	{
+	  pa = nat_ed_port_alloc_get (tsm, ap->addr);
+	  if (pa)
+	    vlib_cli_output (vm, "  thread %u: %U", tsm->thread_index,
+			     format_nat_ed_port_alloc, pa);
+	}
     }
   vlib_cli_output (vm, "NAT44 twice-nat pool addresses:");
   vec_foreach (ap, sm->twice_nat_addresses)
@@ -1644,6 +1654,162 @@ done:
   return error;
 }
 
+static clib_error_t *
+nat44_set_port_block_size_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				      vlib_cli_command_t *cmd)
+{
+  u32 port_block_size = ~0;
+  int rv;
+
+  if (!unformat (input, "%u", &port_block_size) ||
+      port_block_size > CLIB_U16_MAX)
+    return clib_error_return (0, "missing or invalid port block size");
+
+  rv = nat44_ed_set_port_block_size (port_block_size);
+  if (rv == VNET_API_ERROR_INSTANCE_IN_USE)
+    return clib_error_return (0, "delete the pool addresses first");
+
+  return 0;
+}
+
+static clib_error_t *
+nat44_set_session_sharing_command_fn (vlib_main_t *vm,
+				      unformat_input_t *input,
+				      vlib_cli_command_t *cmd)
+{
+  if (unformat (input, "enable"))
+    nat44_ed_set_session_sharing (1);
+  else if (unformat (input, "disable"))
+    nat44_ed_set_session_sharing (0);
+  else
+    return clib_error_return (0, "expected enable | disable");
+
+  return 0;
+}
+
+static clib_error_t *
+nat44_flow_offload_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			       vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_main_t *vnm = vnet_get_main ();
+  clib_error_t *error = 0;
+  u32 sw_if_index = ~0;
+  u8 is_enable = 1;
+  int rv;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return clib_error_return (0, NAT44_ED_EXPECTED_ARGUMENT);
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (line_input, "del"))
+	is_enable = 0;
+      else
+	{
+	  error = clib_error_return (0, "unknown input '%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (sw_if_index == ~0)
+    {
+      error = clib_error_return (0, "missing interface");
+      goto done;
+    }
+
+  rv = nat44_ed_flow_offload_enable_disable (sw_if_index, is_enable);
+  switch (rv)
+    {
+    case 0:
+      break;
+    case VNET_API_ERROR_UNSUPPORTED:
+      error =
+	clib_error_return (0, "interface does not support flow offload");
+      break;
+    case VNET_API_ERROR_VALUE_EXIST:
+      error = clib_error_return (0, "flow offload already enabled");
+      break;
+    case VNET_API_ERROR_NO_SUCH_ENTRY:
+      error = clib_error_return (0, "flow offload not enabled");
+      break;
+    default:
+      error = clib_error_return (0, "nat44_ed_flow_offload_enable_disable "
+				    "returned %d",
+				 rv);
+      break;
+    }
+
+done:
+  unformat_free (line_input);
+
+  return error;
+}
+
+static clib_error_t *
+nat44_set_flow_offload_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				   vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  snat_main_t *sm = &snat_main;
+  u32 threshold = sm->flow_offload_threshold;
+  u32 idle_timeout = sm->flow_offload_idle_timeout;
+  clib_error_t *error = 0;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return clib_error_return (0, NAT44_ED_EXPECTED_ARGUMENT);
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "threshold %u", &threshold))
+	;
+      else if (unformat (line_input, "idle-timeout %u", &idle_timeout))
+	;
+      else
+	{
+	  error = clib_error_return (0, "unknown input '%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (!idle_timeout)
+    {
+      error = clib_error_return (0, "idle timeout must not be 0");
+      goto done;
+    }
+
+  nat44_ed_flow_offload_set_params (threshold, idle_timeout);
+
+done:
+  unformat_free (line_input);
+
+  return error;
+}
+
+static clib_error_t *
+nat44_show_flow_offload_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				    vlib_cli_command_t *cmd)
+{
+  snat_main_t *sm = &snat_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 hw_if_index;
+
+  vlib_cli_output (vm, "NAT44 flow offload interfaces:");
+  clib_bitmap_foreach (hw_if_index, sm->flow_offload_interfaces)
+    vlib_cli_output (vm, " %U", format_vnet_hw_if_index_name, vnm,
+		     hw_if_index);
+  vlib_cli_output (vm, "threshold %u packets, idle timeout %u sec",
+		   sm->flow_offload_threshold, sm->flow_offload_idle_timeout);
+  vlib_cli_output (vm, "%u flows offloaded", pool_elts (sm->flow_offloads));
+
+  return 0;
+}
+
 static clib_error_t *
 nat44_del_session_command_fn (vlib_main_t * vm,
 			      unformat_input_t * input,
@@ -2299,6 +2465,90 @@ VLIB_CLI_COMMAND (nat44_set_session_limit_command, static) = {
   .function = nat44_set_session_limit_command_fn,
 };
 
+/*?
+ * @cliexpar
+ * @cliexstart{set nat44 port-block-size}
+ * Reserve a block of outside ports per inside address on each pool address
+ * it is translated to. The subscriber's sessions use the ports of its block
+ * before any other. IPFIX logging reports the reservation and release of
+ * the block instead of each of those sessions. A size of 0, the default,
+ * does not reserve ports. Can only be changed while there are no pool
+ * addresses.
+ *  vpp# set nat44 port-block-size 512
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (nat44_set_port_block_size_command, static) = {
+  .path = "set nat44 port-block-size",
+  .short_help = "set nat44 port-block-size <size>",
+  .function = nat44_set_port_block_size_command_fn,
+};
+
+/*?
+ * @cliexpar
+ * @cliexstart{set nat44 session-sharing}
+ * With several workers, translate out2in packets of established TCP and of
+ * UDP sessions on the worker which received them instead of handing them
+ * off to the worker owning the session. Disabled by default.
+ *  vpp# set nat44 session-sharing enable
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (nat44_set_session_sharing_command, static) = {
+  .path = "set nat44 session-sharing",
+  .short_help = "set nat44 session-sharing enable|disable",
+  .function = nat44_set_session_sharing_command_fn,
+};
+
+/*?
+ * @cliexpar
+ * @cliexstart{nat44 flow-offload}
+ * Offload the flows of established TCP and of UDP sessions arriving on an
+ * interface to its NIC, once they have seen enough packets. The NIC marks
+ * their packets with the session so they are translated without a flow
+ * lookup. The interface must support flow offload.
+ *  vpp# nat44 flow-offload TenGigabitEthernet5/0/0
+ * To stop offloading the flows of an interface use:
+ *  vpp# nat44 flow-offload TenGigabitEthernet5/0/0 del
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (nat44_flow_offload_command, static) = {
+  .path = "nat44 flow-offload",
+  .short_help = "nat44 flow-offload <interface> [del]",
+  .function = nat44_flow_offload_command_fn,
+};
+
+/*?
+ * @cliexpar
+ * @cliexstart{set nat44 flow-offload}
+ * Set the number of packets of a session before its flow is offloaded, 1000
+ * by default, and the seconds without packets before an offloaded flow is
+ * removed again, 10 by default.
+ *  vpp# set nat44 flow-offload threshold 100 idle-timeout 30
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (nat44_set_flow_offload_command, static) = {
+  .path = "set nat44 flow-offload",
+  .short_help = "set nat44 flow-offload [threshold <packets>] "
+		"[idle-timeout <sec>]",
+  .function = nat44_set_flow_offload_command_fn,
+};
+
+/*?
+ * @cliexpar
+ * @cliexstart{show nat44 flow-offload}
+ * Show the interfaces with NAT44 flow offload and the offloaded flows.
+ *  vpp# show nat44 flow-offload
+ *  NAT44 flow offload interfaces:
+ *   TenGigabitEthernet5/0/0
+ *  threshold 1000 packets, idle timeout 10 sec
+ *  42 flows offloaded
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (nat44_show_flow_offload_command, static) = {
+  .path = "show nat44 flow-offload",
+  .short_help = "show nat44 flow-offload",
+  .function = nat44_show_flow_offload_command_fn,
+};
+
 /*?
  * @cliexpar
  * @cliexstart{nat44 del session}
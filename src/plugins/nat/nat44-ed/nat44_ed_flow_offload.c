@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file
+ * @brief NAT44 ED session flow offload to NICs
+ *
+ * Established sessions with enough packets get a flow programmed into the
+ * NIC they arrive on, marking their packets with the session. The handoff
+ * and translation nodes then find the session without a flow lookup.
+ * Workers only queue requests, the flows are programmed in batches by a
+ * process on the main thread under the barrier. Flows of sessions which
+ * went idle are removed again and the sessions fall back to software.
+ */
+
+#include <vnet/flow/flow.h>
+
+#include <nat/nat44-ed/nat44_ed.h>
+#include <nat/nat44-ed/nat44_ed_inlines.h>
+
+/* seconds between two batches */
+#define NAT_ED_FLOW_OFFLOAD_INTERVAL 1.0
+
+void
+nat44_ed_flow_offload_request (snat_main_per_thread_data_t *tsm,
+			       u32 session_index, u32 state, u32 hw_if_index,
+			       u8 dir)
+{
+  nat_ed_flow_offload_request_t *r;
+
+  clib_spinlock_lock (&tsm->flow_offload_lock);
+  vec_add2 (tsm->flow_offload_requests, r, 1);
+  r->session_index = session_index;
+  r->state = state;
+  r->hw_if_index = hw_if_index;
+  r->dir = dir;
+  clib_spinlock_unlock (&tsm->flow_offload_lock);
+}
+
+static void
+nat44_ed_flow_offload_del (snat_main_t *sm, nat_ed_flow_offload_t *fo)
+{
+  vnet_flow_del (vnet_get_main (), fo->flow_index);
+  pool_put (sm->flow_offloads, fo);
+}
+
+/* Reset the state of the session of an offloaded flow and remove the flow */
+static void
+nat44_ed_flow_offload_evict (snat_main_t *sm, nat_ed_flow_offload_t *fo)
+{
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, fo->thread_index);
+  snat_session_t *s = pool_elt_at_index (tsm->sessions, fo->session_index);
+  nat_ed_session_shared_t *sh = nat_ed_session_shared (tsm, s);
+
+  if (sh->flow_offload[fo->dir] == fo - sm->flow_offloads)
+    sh->flow_offload[fo->dir] = NAT_ED_FLOW_OFFLOAD_NONE;
+  nat44_ed_flow_offload_del (sm, fo);
+}
+
+static int
+nat44_ed_flow_offload_is_idle (snat_main_t *sm, nat_ed_flow_offload_t *fo,
+			       f64 now)
+{
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, fo->thread_index);
+  /* not pool_elt_at_index (), outside of the barrier the session may be
+   * gone already, its memory is preallocated and stays valid */
+  snat_session_t *s = tsm->sessions + fo->session_index;
+  nat_ed_session_shared_t *sh = nat_ed_session_shared (tsm, s);
+
+  return now - clib_max (s->last_heard, sh->remote_last_heard) >=
+	 sm->flow_offload_idle_timeout;
+}
+
+static void
+nat44_ed_flow_offload_add (snat_main_t *sm, u32 thread_index,
+			   nat_ed_flow_offload_request_t *r)
+{
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, thread_index);
+  vnet_main_t *vnm = vnet_get_main ();
+  nat_ed_session_shared_t *sh;
+  nat_ed_flow_offload_t *fo;
+  snat_session_t *s;
+  vnet_flow_t flow;
+  u32 flow_index;
+  nat_6t_t *m;
+
+  if (pool_is_free_index (tsm->sessions, r->session_index))
+    return;
+  s = pool_elt_at_index (tsm->sessions, r->session_index);
+  sh = nat_ed_session_shared (tsm, s);
+
+  /* the session was deleted or reused meanwhile */
+  if (sh->flow_offload[r->dir] != NAT_ED_FLOW_OFFLOAD_PENDING)
+    return;
+
+  sh->flow_offload[r->dir] = NAT_ED_FLOW_OFFLOAD_NEVER;
+  if (!sm->flow_offload_id_count ||
+      !clib_bitmap_get (sm->flow_offload_interfaces, r->hw_if_index))
+    return;
+
+  m = r->dir == NAT44_ED_DIR_I2O ? &s->i2o.match : &s->o2i.match;
+  clib_memset (&flow, 0, sizeof (flow));
+  flow.type = VNET_FLOW_TYPE_IP4_N_TUPLE;
+  flow.actions = VNET_FLOW_ACTION_MARK;
+  flow.mark_flow_id = sm->flow_offload_id_start +
+		      thread_index * sm->max_translations_per_thread +
+		      r->session_index;
+  flow.ip4_n_tuple.src_addr.addr = m->saddr;
+  flow.ip4_n_tuple.src_addr.mask.as_u32 = ~0;
+  flow.ip4_n_tuple.dst_addr.addr = m->daddr;
+  flow.ip4_n_tuple.dst_addr.mask.as_u32 = ~0;
+  flow.ip4_n_tuple.protocol.prot = m->proto;
+  flow.ip4_n_tuple.protocol.mask = 0xff;
+  flow.ip4_n_tuple.src_port.port = clib_net_to_host_u16 (m->sport);
+  flow.ip4_n_tuple.src_port.mask = 0xffff;
+  flow.ip4_n_tuple.dst_port.port = clib_net_to_host_u16 (m->dport);
+  flow.ip4_n_tuple.dst_port.mask = 0xffff;
+
+  if (vnet_flow_add (vnm, &flow, &flow_index))
+    return;
+  if (vnet_flow_enable (vnm, flow_index, r->hw_if_index))
+    {
+      vnet_flow_del (vnm, flow_index);
+      return;
+    }
+
+  pool_get (sm->flow_offloads, fo);
+  fo->flow_index = flow_index;
+  fo->hw_if_index = r->hw_if_index;
+  fo->thread_index = thread_index;
+  fo->session_index = r->session_index;
+  fo->dir = r->dir;
+  sh->flow_offload[r->dir] = fo - sm->flow_offloads;
+}
+
+/* Apply the queued requests and remove idle flows, under the barrier */
+static void
+nat44_ed_flow_offload_apply (snat_main_t *sm, u32 *idle, f64 now)
+{
+  nat_ed_flow_offload_request_t *r;
+  snat_main_per_thread_data_t *tsm;
+  u32 *fi;
+
+  if (!sm->flow_offload_id_count)
+    {
+      u32 count =
+	vec_len (sm->per_thread_data) * sm->max_translations_per_thread;
+
+      if (vnet_flow_get_range (vnet_get_main (), "nat44-ed", count,
+			       &sm->flow_offload_id_start) >= 0)
+	sm->flow_offload_id_count = count;
+    }
+
+  /* removals first, the flows of deleted sessions must be gone before
+   * their entries are looked at or reused */
+  vec_foreach (tsm, sm->per_thread_data)
+    vec_foreach (r, tsm->flow_offload_requests)
+      if (r->hw_if_index == ~0 && r->state < NAT_ED_FLOW_OFFLOAD_NEVER)
+	nat44_ed_flow_offload_del (
+	  sm, pool_elt_at_index (sm->flow_offloads, r->state));
+
+  /* sessions refreshed while waiting for the barrier stay offloaded */
+  vec_foreach (fi, idle)
+    if (!pool_is_free_index (sm->flow_offloads, *fi) &&
+	nat44_ed_flow_offload_is_idle (
+	  sm, pool_elt_at_index (sm->flow_offloads, *fi), now))
+      nat44_ed_flow_offload_evict (sm,
+				   pool_elt_at_index (sm->flow_offloads, *fi));
+
+  vec_foreach (tsm, sm->per_thread_data)
+    {
+      vec_foreach (r, tsm->flow_offload_requests)
+	if (r->hw_if_index != ~0)
+	  nat44_ed_flow_offload_add (sm, tsm - sm->per_thread_data, r);
+      vec_reset_length (tsm->flow_offload_requests);
+    }
+}
+
+void
+nat44_ed_flow_offload_flush (void)
+{
+  snat_main_t *sm = &snat_main;
+  nat_ed_flow_offload_request_t *r;
+  snat_main_per_thread_data_t *tsm;
+  nat_ed_flow_offload_t *fo;
+
+  vec_foreach (tsm, sm->per_thread_data)
+    {
+      vec_foreach (r, tsm->flow_offload_requests)
+	if (r->hw_if_index != ~0 &&
+	    !pool_is_free_index (tsm->sessions, r->session_index))
+	  {
+	    snat_session_t *s =
+	      pool_elt_at_index (tsm->sessions, r->session_index);
+	    nat_ed_session_shared (tsm, s)->flow_offload[r->dir] =
+	      NAT_ED_FLOW_OFFLOAD_NONE;
+	  }
+      vec_reset_length (tsm->flow_offload_requests);
+    }
+
+  /* this also covers the dropped removals of deleted sessions */
+  pool_foreach (fo, sm->flow_offloads)
+    {
+      tsm = vec_elt_at_index (sm->per_thread_data, fo->thread_index);
+      if (!pool_is_free_index (tsm->sessions, fo->session_index))
+	{
+	  snat_session_t *s =
+	    pool_elt_at_index (tsm->sessions, fo->session_index);
+	  nat_ed_session_shared_t *sh = nat_ed_session_shared (tsm, s);
+
+	  if (sh->flow_offload[fo->dir] == fo - sm->flow_offloads)
+	    sh->flow_offload[fo->dir] = NAT_ED_FLOW_OFFLOAD_NONE;
+	}
+      vnet_flow_del (vnet_get_main (), fo->flow_index);
+    }
+  pool_free (sm->flow_offloads);
+
+  /* the range depends on max_translations_per_thread */
+  sm->flow_offload_id_count = 0;
+}
+
+int
+nat44_ed_flow_offload_enable_disable (u32 sw_if_index, u8 is_enable)
+{
+  snat_main_t *sm = &snat_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  vlib_main_t *vm = vlib_get_main ();
+  vnet_hw_interface_t *hi;
+  vnet_device_class_t *dc;
+  nat_ed_flow_offload_t *fo;
+  u32 *evict = 0, *fi;
+
+  hi = vnet_get_sup_hw_interface_api_visible_or_null (vnm, sw_if_index);
+  if (!hi)
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  if (clib_bitmap_get (sm->flow_offload_interfaces, hi->hw_if_index) ==
+      is_enable)
+    return is_enable ? VNET_API_ERROR_VALUE_EXIST :
+		       VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  dc = vnet_get_device_class (vnm, hi->dev_class_index);
+  if (is_enable && !dc->flow_ops_function)
+    return VNET_API_ERROR_UNSUPPORTED;
+
+  vlib_worker_thread_barrier_sync (vm);
+
+  sm->flow_offload_interfaces = clib_bitmap_set (
+    sm->flow_offload_interfaces, hi->hw_if_index, is_enable);
+  sm->flow_offload_enabled =
+    clib_bitmap_count_set_bits (sm->flow_offload_interfaces) != 0;
+
+  if (!is_enable)
+    {
+      /* the queued removals may refer to the entries evicted here */
+      if (sm->enabled)
+	nat44_ed_flow_offload_apply (sm, 0, vlib_time_now (vm));
+
+      pool_foreach (fo, sm->flow_offloads)
+	if (fo->hw_if_index == hi->hw_if_index)
+	  vec_add1 (evict, fo - sm->flow_offloads);
+      vec_foreach (fi, evict)
+	nat44_ed_flow_offload_evict (sm,
+				     pool_elt_at_index (sm->flow_offloads, *fi));
+      vec_free (evict);
+    }
+
+  vlib_worker_thread_barrier_release (vm);
+
+  return 0;
+}
+
+void
+nat44_ed_flow_offload_set_params (u32 threshold, u32 idle_timeout)
+{
+  snat_main_t *sm = &snat_main;
+
+  sm->flow_offload_threshold = threshold;
+  sm->flow_offload_idle_timeout = idle_timeout;
+}
+
+static uword
+nat44_ed_flow_offload_process (vlib_main_t *vm, vlib_node_runtime_t *rt,
+			       vlib_frame_t *f)
+{
+  snat_main_t *sm = &snat_main;
+  snat_main_per_thread_data_t *tsm;
+  nat_ed_flow_offload_t *fo;
+  u32 *idle = 0, n_requests;
+  f64 now;
+
+  while (1)
+    {
+      vlib_process_wait_for_event_or_clock (vm, NAT_ED_FLOW_OFFLOAD_INTERVAL);
+      vlib_process_get_events (vm, 0);
+
+      if (!sm->enabled)
+	continue;
+
+      now = vlib_time_now (vm);
+      vec_reset_length (idle);
+      pool_foreach (fo, sm->flow_offloads)
+	if (nat44_ed_flow_offload_is_idle (sm, fo, now))
+	  vec_add1 (idle, fo - sm->flow_offloads);
+
+      n_requests = 0;
+      vec_foreach (tsm, sm->per_thread_data)
+	n_requests += vec_len (tsm->flow_offload_requests);
+
+      /* nothing to do, do not stop the workers */
+      if (!n_requests && !vec_len (idle))
+	continue;
+
+      vlib_worker_thread_barrier_sync (vm);
+      nat44_ed_flow_offload_apply (sm, idle, vlib_time_now (vm));
+      vlib_worker_thread_barrier_release (vm);
+    }
+
+  return 0;
+}
+
+VLIB_REGISTER_NODE (nat44_ed_flow_offload_process_node) = {
+  .function = nat44_ed_flow_offload_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "nat44-ed-flow-offload-process",
+};
@@ -46,6 +46,7 @@ format_snat_session (u8 * s, va_list * args)
     va_arg (*args, snat_main_per_thread_data_t *);
   snat_session_t *sess = va_arg (*args, snat_session_t *);
   f64 now = va_arg (*args, f64);
+  nat_ed_session_shared_t *sh;
 
   if (nat44_ed_is_unk_proto (sess->proto))
     {
@@ -90,6 +91,10 @@ format_snat_session (u8 * s, va_list * args)
 	      nat44_session_get_timeout (sm, sess) - (now - sess->last_heard));
   s = format (s, "       total pkts %d, total bytes %lld\n", sess->total_pkts,
 	      sess->total_bytes);
+  sh = nat_ed_session_shared (tsm, sess);
+  if (sh->remote_pkts)
+    s = format (s, "       other workers pkts %u, bytes %llu\n",
+		sh->remote_pkts, sh->remote_bytes);
   if (nat44_ed_is_session_static (sess))
     s = format (s, "       static translation\n");
   else
@@ -316,6 +321,32 @@ format_nat44_ed_tcp_state (u8 *s, va_list *args)
   return s;
 }
 
+u8 *
+format_nat_ed_port_alloc (u8 *s, va_list *args)
+{
+  nat_ed_port_alloc_t *pa = va_arg (*args, nat_ed_port_alloc_t *);
+  snat_main_t *sm = &snat_main;
+  static const char *names[NAT_ED_PORT_N_PROTO] = {
+    [NAT_ED_PORT_PROTO_TCP] = "tcp",
+    [NAT_ED_PORT_PROTO_UDP] = "udp",
+    [NAT_ED_PORT_PROTO_ICMP] = "icmp",
+    [NAT_ED_PORT_PROTO_OTHER] = "other",
+  };
+  int i;
+
+  s = format (s, "ports in use");
+  for (i = 0; i < NAT_ED_PORT_N_PROTO; i++)
+    if (pa->refcnt[i])
+      s = format (s, " %s %u/%u", names[i], pa->n_used[i],
+		  sm->port_per_thread);
+
+  if (sm->port_block_size)
+    s = format (s, ", blocks reserved %u/%u", pa->n_reserved_blocks,
+		sm->port_per_thread / sm->port_block_size);
+
+  return s;
+}
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -96,53 +96,145 @@ format_nat_in2out_ed_trace (u8 * s, va_list * args)
   return s;
 }
 
+/* Try the session's o2i flow with a port of the thread's range */
+static_always_inline int
+nat_ed_alloc_try_port (snat_main_t *sm, u8 proto, u32 thread_index,
+		       snat_session_t *s, u16 port)
+{
+  if (IP_PROTOCOL_ICMP == proto)
+    {
+      s->o2i.match.sport = clib_host_to_net_u16 (port);
+    }
+  s->o2i.match.dport = clib_host_to_net_u16 (port);
+  return nat_ed_ses_o2i_flow_hash_add_del (sm, thread_index, s, 2);
+}
+
+/*
+ * Ports without sessions are tracked per thread, pool address and protocol
+ * in a bitmap, so a free port is found by scanning from a random offset
+ * instead of rolling a dice against the flow hash. Only when all ports are
+ * in use are they shared, endpoint dependent, with sessions to other
+ * destinations. With port blocks configured each subscriber first uses a
+ * block of ports reserved for it.
+ */
 static int
 nat_ed_alloc_addr_and_port_with_snat_address (
   snat_main_t *sm, u8 proto, u32 thread_index, snat_address_t *a,
   u16 port_per_thread, u32 snat_thread_index, snat_session_t *s,
   ip4_address_t *outside_addr, u16 *outside_port)
 {
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, thread_index);
   const u16 port_thread_offset =
     (port_per_thread * snat_thread_index) + ED_USER_PORT_OFFSET;
+  const u8 pi = nat_ed_port_proto_index (proto);
+  nat_ed_port_block_t *blk = 0;
+  nat_ed_port_alloc_t *pa;
+  u32 off, from, first, last, n_skipped = 0;
+  u16 attempts, *refcnt;
 
   /* Backup original match in case of failure */
   const nat_6t_t match = s->o2i.match;
 
   s->o2i.match.daddr = a->addr;
-  /* first try port suggested by caller */
-  u16 port = clib_net_to_host_u16 (*outside_port);
-  u16 port_offset = port - port_thread_offset;
-  if (port < port_thread_offset ||
-      port >= port_thread_offset + port_per_thread)
+
+  pa = nat_ed_port_alloc_get (tsm, a->addr);
+  if (PREDICT_FALSE (!pa))
+    pa = nat_ed_port_alloc_create (sm, thread_index, a->addr);
+  refcnt = pa->refcnt[pi];
+  if (PREDICT_FALSE (!refcnt))
+    refcnt = nat_ed_port_alloc_proto_init (sm, pa, pi);
+
+  if (sm->port_block_size)
     {
-      /* need to pick a different port, suggested port doesn't fit in
-       * this thread's port range */
-      port_offset = snat_random_port (0, port_per_thread - 1);
-      port = port_thread_offset + port_offset;
+      u64 subscriber = nat_ed_port_subscriber (s->in2out.addr, a->addr);
+
+      blk = nat_ed_port_block_get (tsm, subscriber);
+      if (!blk)
+	blk = nat_ed_port_block_reserve (sm, thread_index, pa, subscriber,
+					 s->in2out.fib_index);
     }
-  u16 attempts = ED_PORT_ALLOC_ATTEMPTS;
-  do
+
+  /* first try port suggested by caller, within the block if there is one */
+  off = (u16) (clib_net_to_host_u16 (*outside_port) - port_thread_offset);
+  if (off < port_per_thread && refcnt[off] < CLIB_U16_MAX &&
+      (blk ? nat_ed_port_in_block (sm, blk, off) :
+	     nat_ed_port_usable (sm, pa, blk, off)) &&
+      0 == nat_ed_alloc_try_port (sm, proto, thread_index, s,
+				  port_thread_offset + off))
+    goto done;
+
+  /* then a free port of the subscriber's block */
+  if (blk)
     {
-      if (IP_PROTOCOL_ICMP == proto)
+      first = blk->block_index * sm->port_block_size;
+      last = first + sm->port_block_size;
+      from = first + snat_random_port (0, sm->port_block_size - 1);
+      for (attempts = ED_PORT_ALLOC_ATTEMPTS; attempts > 0; --attempts)
 	{
-	  s->o2i.match.sport = clib_host_to_net_u16 (port);
+	  off = nat_ed_port_find_free (pa->free[pi], first, last, from);
+	  if (off == ~0)
+	    break;
+	  if (0 == nat_ed_alloc_try_port (sm, proto, thread_index, s,
+					  port_thread_offset + off))
+	    goto done;
+	  from = off + 1 < last ? off + 1 : first;
 	}
-      s->o2i.match.dport = clib_host_to_net_u16 (port);
-      if (0 == nat_ed_ses_o2i_flow_hash_add_del (sm, thread_index, s, 2))
+    }
+
+  /* then any free port */
+  from = snat_random_port (0, port_per_thread - 1);
+  for (attempts = ED_PORT_ALLOC_ATTEMPTS; attempts > 0;)
+    {
+      off = nat_ed_port_find_free (pa->free[pi], 0, port_per_thread, from);
+      if (off == ~0)
+	break;
+      if (!nat_ed_port_usable (sm, pa, blk, off))
 	{
-	  *outside_addr = a->addr;
-	  *outside_port = clib_host_to_net_u16 (port);
-	  return 0;
+	  /* skip the block reserved by another subscriber */
+	  from = (off / sm->port_block_size + 1) * sm->port_block_size;
+	  if (from >= port_per_thread)
+	    from = 0;
+	  if (++n_skipped > pa->n_reserved_blocks)
+	    break;
+	  continue;
 	}
-      port_offset = snat_random_port (0, port_per_thread - 1);
-      port = port_thread_offset + port_offset;
+      if (0 == nat_ed_alloc_try_port (sm, proto, thread_index, s,
+				      port_thread_offset + off))
+	goto done;
+      from = off + 1 < port_per_thread ? off + 1 : 0;
       --attempts;
     }
-  while (attempts > 0);
+
+  /* finally share a port with sessions to other destinations */
+  for (attempts = ED_PORT_ALLOC_ATTEMPTS; attempts > 0; --attempts)
+    {
+      off = snat_random_port (0, port_per_thread - 1);
+      if (refcnt[off] == CLIB_U16_MAX ||
+	  !nat_ed_port_usable (sm, pa, blk, off))
+	continue;
+      if (0 == nat_ed_alloc_try_port (sm, proto, thread_index, s,
+				      port_thread_offset + off))
+	goto done;
+    }
 
   /* Revert match */
   s->o2i.match = match;
+  if (blk && !blk->n_sessions)
+    nat_ed_port_block_release (sm, thread_index, blk);
   return 1;
+
+done:
+  nat_ed_port_take (sm, pa, blk, pi, off);
+  s->flags |= SNAT_SESSION_FLAG_PORT_ALLOCATED;
+  if (nat_ed_port_in_block (sm, blk, off))
+    s->flags |= SNAT_SESSION_FLAG_PORT_BLOCK;
+  /* a block just reserved had no port left for this protocol */
+  else if (blk && !blk->n_sessions)
+    nat_ed_port_block_release (sm, thread_index, blk);
+  *outside_addr = a->addr;
+  *outside_port = clib_host_to_net_u16 (port_thread_offset + off);
+  return 0;
 }
 
 static int
@@ -600,9 +692,10 @@ slow_path_ed (vlib_main_t *vm, snat_main_t *sm, vlib_buffer_t *b,
     }
 
   /* log NAT event */
-  nat_ipfix_logging_nat44_ses_create (
-    thread_index, s->in2out.addr.as_u32, s->out2in.addr.as_u32, s->proto,
-    s->in2out.port, s->out2in.port, s->in2out.fib_index);
+  if (!nat44_ed_is_port_block_session (s))
+    nat_ipfix_logging_nat44_ses_create (
+      thread_index, s->in2out.addr.as_u32, s->out2in.addr.as_u32, s->proto,
+      s->in2out.port, s->out2in.port, s->in2out.fib_index);
 
   nat_syslog_nat44_sadd (0, s->in2out.fib_index, &s->in2out.addr,
 			 s->in2out.port, &s->ext_host_nat_addr,
@@ -1153,9 +1246,21 @@ nat44_ed_in2out_fast_path_node_fn_inline (vlib_main_t *vm,
 	  lookup.dport = vnet_buffer (b0)->ip.reass.l4_dst_port;
 	}
 
+      /* without handoff, the NIC may have marked the packet with its
+       * session if the flow is offloaded */
+      if (!is_multi_worker && !is_output_feature &&
+	  PREDICT_FALSE (sm->flow_offload_id_count))
+	{
+	  u32 fo_thread_index;
+	  vnet_buffer2 (b0)->nat.cached_session_index =
+	    nat44_ed_flow_offload_session (sm, b0, ip0, rx_fib_index0,
+					   &fo_thread_index);
+	}
+
       /* there might be a stashed index in vnet_buffer2 from handoff or
        * classify node, see if it can be used */
-      if (is_multi_worker &&
+      if ((is_multi_worker ||
+	   (!is_output_feature && sm->flow_offload_id_count)) &&
 	  !pool_is_free_index (tsm->sessions,
 			       vnet_buffer2 (b0)->nat.cached_session_index))
 	{
@@ -1207,6 +1312,7 @@ nat44_ed_in2out_fast_path_node_fn_inline (vlib_main_t *vm,
 
       // drop if session expired
       u64 sess_timeout_time;
+      nat_ed_session_sync (tsm, s0);
       sess_timeout_time =
 	s0->last_heard + (f64) nat44_session_get_timeout (sm, s0);
       if (now >= sess_timeout_time)
@@ -1282,6 +1388,10 @@ nat44_ed_in2out_fast_path_node_fn_inline (vlib_main_t *vm,
 				     thread_index);
       /* Per-user LRU list maintenance */
       nat44_session_update_lru (sm, s0, thread_index);
+      if (is_multi_worker)
+	nat_ed_session_publish (tsm, s0);
+      if (!is_output_feature && PREDICT_FALSE (sm->flow_offload_enabled))
+	nat44_ed_flow_offload_update (sm, tsm, s0, b0, NAT44_ED_DIR_I2O);
 
     trace0:
       if (PREDICT_FALSE
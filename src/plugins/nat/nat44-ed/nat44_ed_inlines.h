@@ -309,6 +309,305 @@ nat_ed_ses_o2i_flow_hash_add_del (snat_main_t *sm, u32 thread_idx,
   return clib_bihash_add_del_16_8 (&sm->flow_hash, &kv, is_add);
 }
 
+static_always_inline u8
+nat_ed_port_proto_index (ip_protocol_t proto)
+{
+  switch (proto)
+    {
+    case IP_PROTOCOL_TCP:
+      return NAT_ED_PORT_PROTO_TCP;
+    case IP_PROTOCOL_UDP:
+      return NAT_ED_PORT_PROTO_UDP;
+    case IP_PROTOCOL_ICMP:
+      return NAT_ED_PORT_PROTO_ICMP;
+    default:
+      return NAT_ED_PORT_PROTO_OTHER;
+    }
+}
+
+static_always_inline nat_ed_port_alloc_t *
+nat_ed_port_alloc_get (snat_main_per_thread_data_t *tsm, ip4_address_t addr)
+{
+  uword *p = hash_get (tsm->port_alloc_by_addr, addr.as_u32);
+  return p ? pool_elt_at_index (tsm->port_allocs, p[0]) : 0;
+}
+
+static_always_inline u64
+nat_ed_port_subscriber (ip4_address_t in_addr, ip4_address_t out_addr)
+{
+  return (u64) in_addr.as_u32 << 32 | out_addr.as_u32;
+}
+
+static_always_inline nat_ed_port_block_t *
+nat_ed_port_block_get (snat_main_per_thread_data_t *tsm, u64 subscriber)
+{
+  uword *p = hash_get (tsm->port_block_by_subscriber, subscriber);
+  return p ? pool_elt_at_index (tsm->port_blocks, p[0]) : 0;
+}
+
+static_always_inline int
+nat_ed_port_in_block (snat_main_t *sm, nat_ed_port_block_t *blk, u32 off)
+{
+  return blk && off / sm->port_block_size == blk->block_index;
+}
+
+/* Port may be used unless it is in a block reserved by someone else */
+static_always_inline int
+nat_ed_port_usable (snat_main_t *sm, nat_ed_port_alloc_t *pa,
+		    nat_ed_port_block_t *blk, u32 off)
+{
+  return !pa->n_reserved_blocks ||
+	 !clib_bitmap_get (pa->reserved_blocks, off / sm->port_block_size) ||
+	 nat_ed_port_in_block (sm, blk, off);
+}
+
+/* Lowest free port in [from, last), else in [first, from) */
+static_always_inline u32
+nat_ed_port_find_free (uword *free, u32 first, u32 last, u32 from)
+{
+  uword off = clib_bitmap_next_set (free, from);
+
+  if (off < last)
+    return off;
+
+  off = clib_bitmap_next_set (free, first);
+  return off < from ? off : ~0;
+}
+
+static_always_inline void
+nat_ed_port_take (snat_main_t *sm, nat_ed_port_alloc_t *pa,
+		  nat_ed_port_block_t *blk, u8 pi, u32 off)
+{
+  if (pa->refcnt[pi][off]++ == 0)
+    {
+      clib_bitmap_set_no_check (pa->free[pi], off, 0);
+      pa->n_used[pi]++;
+    }
+  if (nat_ed_port_in_block (sm, blk, off))
+    blk->n_sessions++;
+}
+
+static_always_inline void
+nat_ed_session_port_release (snat_main_t *sm, snat_session_t *s,
+			     u32 thread_index)
+{
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, thread_index);
+  nat_ed_port_block_t *blk = 0;
+  nat_ed_port_alloc_t *pa;
+  u8 pi = nat_ed_port_proto_index (s->proto);
+  u32 off;
+
+  s->flags &= ~SNAT_SESSION_FLAG_PORT_ALLOCATED;
+
+  pa = nat_ed_port_alloc_get (tsm, s->out2in.addr);
+  if (PREDICT_FALSE (!pa))
+    return;
+
+  off = (u16) (clib_net_to_host_u16 (s->out2in.port) - ED_USER_PORT_OFFSET -
+	       sm->port_per_thread * tsm->snat_thread_index);
+  /* tables are reset when the workers change */
+  if (PREDICT_FALSE (off >= vec_len (pa->refcnt[pi]) ||
+		     !pa->refcnt[pi][off]))
+    return;
+
+  if (--pa->refcnt[pi][off] == 0)
+    {
+      clib_bitmap_set_no_check (pa->free[pi], off, 1);
+      pa->n_used[pi]--;
+    }
+
+  if (sm->port_block_size)
+    {
+      blk = nat_ed_port_block_get (
+	tsm, nat_ed_port_subscriber (s->in2out.addr, s->out2in.addr));
+      if (nat_ed_port_in_block (sm, blk, off) && blk->n_sessions &&
+	  --blk->n_sessions == 0)
+	nat_ed_port_block_release (sm, thread_index, blk);
+    }
+}
+
+static_always_inline nat_ed_session_shared_t *
+nat_ed_session_shared (snat_main_per_thread_data_t *tsm, snat_session_t *s)
+{
+  return vec_elt_at_index (tsm->sessions_shared, s - tsm->sessions);
+}
+
+/* Let other workers translate out2in packets of the session */
+static_always_inline void
+nat_ed_session_publish (snat_main_per_thread_data_t *tsm, snat_session_t *s)
+{
+  nat_ed_session_shared_t *sh = nat_ed_session_shared (tsm, s);
+
+  if (PREDICT_FALSE (sh->version & 1))
+    clib_atomic_fetch_add (&sh->version, 1);
+}
+
+/* Must precede any change of the session's out2in flow */
+static_always_inline void
+nat_ed_session_unpublish (snat_main_per_thread_data_t *tsm, snat_session_t *s)
+{
+  nat_ed_session_shared_t *sh = nat_ed_session_shared (tsm, s);
+
+  if (!(sh->version & 1))
+    clib_atomic_fetch_add (&sh->version, 1);
+}
+
+/* Fold the packets other workers translated into the session, owner only */
+static_always_inline void
+nat_ed_session_sync (snat_main_per_thread_data_t *tsm, snat_session_t *s)
+{
+  nat_ed_session_shared_t *sh = nat_ed_session_shared (tsm, s);
+
+  if (PREDICT_TRUE (!clib_atomic_load_relax_n (&sh->remote_pkts)))
+    return;
+
+  s->total_pkts += clib_atomic_swap_acq_n (&sh->remote_pkts, 0);
+  s->total_bytes += clib_atomic_swap_acq_n (&sh->remote_bytes, 0);
+  if (sh->remote_last_heard > s->last_heard)
+    s->last_heard = sh->remote_last_heard;
+}
+
+/*
+ * Whether an out2in packet may be translated by this worker although
+ * another one owns its session. Whatever changes the session - TCP state
+ * transitions, expiry - is left to the owner. The session is read without
+ * synchronization, which is only a hint: the translation itself uses a
+ * validated copy, see nat_ed_session_o2i_copy.
+ */
+static_always_inline int
+nat44_ed_o2i_session_shareable (snat_main_t *sm, vlib_buffer_t *b,
+				u32 thread_index, u32 session_index, f64 now)
+{
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, thread_index);
+  nat_ed_session_shared_t *sh;
+  snat_session_t *s;
+  f64 last_heard;
+
+  if (PREDICT_FALSE (session_index >= vec_len (tsm->sessions_shared)))
+    return 0;
+
+  sh = tsm->sessions_shared + session_index;
+  if (clib_atomic_load_relax_n (&sh->version) & 1)
+    return 0;
+
+  s = tsm->sessions + session_index;
+  if (s->flags & SNAT_SESSION_FLAG_TWICE_NAT)
+    return 0;
+
+  switch (s->proto)
+    {
+    case IP_PROTOCOL_UDP:
+      break;
+    case IP_PROTOCOL_TCP:
+      if (!nat44_ed_tcp_is_established (s->tcp_state) ||
+	  (vnet_buffer (b)->ip.reass.icmp_type_or_tcp_flags &
+	   (TCP_FLAG_SYN | TCP_FLAG_FIN | TCP_FLAG_RST)))
+	return 0;
+      break;
+    default:
+      return 0;
+    }
+
+  last_heard = clib_max (s->last_heard, sh->remote_last_heard);
+  return now < last_heard + (f64) nat44_session_get_timeout (sm, s);
+}
+
+/*
+ * Copy the out2in flow of another worker's session. Fails if the session
+ * is not published or if its owner unpublished it during the copy.
+ */
+static_always_inline nat_ed_session_shared_t *
+nat_ed_session_o2i_copy (snat_main_t *sm, u32 thread_index,
+			 u32 session_index, nat_6t_flow_t *f)
+{
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, thread_index);
+  nat_ed_session_shared_t *sh;
+  u32 version;
+
+  if (PREDICT_FALSE (session_index >= vec_len (tsm->sessions_shared)))
+    return 0;
+
+  sh = tsm->sessions_shared + session_index;
+  version = clib_atomic_load_acq_n (&sh->version);
+  if (version & 1)
+    return 0;
+
+  clib_memcpy_fast (f, &tsm->sessions[session_index].o2i, sizeof (*f));
+
+  __atomic_thread_fence (__ATOMIC_ACQUIRE);
+  if (clib_atomic_load_relax_n (&sh->version) != version)
+    return 0;
+
+  return sh;
+}
+
+/* Account a packet translated for another worker's session */
+static_always_inline void
+nat_ed_session_remote_update (nat_ed_session_shared_t *sh, f64 now,
+			      uword bytes)
+{
+  sh->remote_last_heard = now;
+  clib_atomic_fetch_add_relax (&sh->remote_bytes, bytes);
+  clib_atomic_fetch_add_relax (&sh->remote_pkts, 1);
+}
+
+/* Ask for the session flow of the packet to be offloaded once it is big */
+static_always_inline void
+nat44_ed_flow_offload_update (snat_main_t *sm,
+			      snat_main_per_thread_data_t *tsm,
+			      snat_session_t *s, vlib_buffer_t *b, u8 dir)
+{
+  nat_ed_session_shared_t *sh;
+  vnet_hw_interface_t *hi;
+
+  if (PREDICT_TRUE (s->total_pkts < sm->flow_offload_threshold))
+    return;
+
+  sh = nat_ed_session_shared (tsm, s);
+  if (PREDICT_TRUE (sh->flow_offload[dir] != NAT_ED_FLOW_OFFLOAD_NONE))
+    return;
+
+  if (!(s->proto == IP_PROTOCOL_UDP ||
+	(s->proto == IP_PROTOCOL_TCP &&
+	 nat44_ed_tcp_is_established (s->tcp_state))))
+    return;
+
+  hi = vnet_get_sup_hw_interface (vnet_get_main (),
+				  vnet_buffer (b)->sw_if_index[VLIB_RX]);
+  if (!clib_bitmap_get (sm->flow_offload_interfaces, hi->hw_if_index))
+    {
+      sh->flow_offload[dir] = NAT_ED_FLOW_OFFLOAD_NEVER;
+      return;
+    }
+
+  sh->flow_offload[dir] = NAT_ED_FLOW_OFFLOAD_PENDING;
+  nat44_ed_flow_offload_request (tsm, s - tsm->sessions,
+				 NAT_ED_FLOW_OFFLOAD_PENDING, hi->hw_if_index,
+				 dir);
+}
+
+static_always_inline void
+nat44_ed_flow_offload_release (snat_main_per_thread_data_t *tsm,
+			       snat_session_t *s)
+{
+  nat_ed_session_shared_t *sh = nat_ed_session_shared (tsm, s);
+  u8 dir;
+
+  for (dir = 0; dir < NAT44_ED_N_DIR; dir++)
+    {
+      u32 state = sh->flow_offload[dir];
+
+      sh->flow_offload[dir] = NAT_ED_FLOW_OFFLOAD_NONE;
+      if (state != NAT_ED_FLOW_OFFLOAD_NONE &&
+	  state != NAT_ED_FLOW_OFFLOAD_NEVER)
+	nat44_ed_flow_offload_request (tsm, s - tsm->sessions, state, ~0,
+				       dir);
+    }
+}
+
 always_inline void
 nat_ed_session_delete (snat_main_t *sm, snat_session_t *ses, u32 thread_index,
 		       int lru_delete
@@ -317,6 +616,8 @@ nat_ed_session_delete (snat_main_t *sm, snat_session_t *ses, u32 thread_index,
   snat_main_per_thread_data_t *tsm =
     vec_elt_at_index (sm->per_thread_data, thread_index);
 
+  nat_ed_session_unpublish (tsm, ses);
+  nat44_ed_flow_offload_release (tsm, ses);
   if (lru_delete)
     {
       clib_dlist_remove (tsm->lru_pool, ses->lru_index);
@@ -326,6 +627,8 @@ nat_ed_session_delete (snat_main_t *sm, snat_session_t *ses, u32 thread_index,
     nat_elog_warn (sm, "flow hash del failed");
   if (nat_ed_ses_o2i_flow_hash_add_del (sm, thread_index, ses, 0))
     nat_elog_warn (sm, "flow hash del failed");
+  if (ses->flags & SNAT_SESSION_FLAG_PORT_ALLOCATED)
+    nat_ed_session_port_release (sm, ses, thread_index);
   pool_put (tsm->sessions, ses);
   vlib_set_simple_counter (&sm->total_sessions, thread_index, 0,
 			   pool_elts (tsm->sessions));
@@ -346,6 +649,7 @@ nat_lru_free_one_with_head (snat_main_t *sm, int thread_index, f64 now,
       oldest_elt = pool_elt_at_index (tsm->lru_pool, oldest_index);
       s = pool_elt_at_index (tsm->sessions, oldest_elt->value);
 
+      nat_ed_session_sync (tsm, s);
       sess_timeout_time =
 	s->last_heard + (f64) nat44_session_get_timeout (sm, s);
       if (now >= sess_timeout_time)
@@ -354,6 +658,12 @@ nat_lru_free_one_with_head (snat_main_t *sm, int thread_index, f64 now,
 	  nat_ed_session_delete (sm, s, thread_index, 0);
 	  return 1;
 	}
+      else if (s->last_heard > s->last_lru_update + 1)
+	{
+	  /* kept alive by other workers */
+	  clib_dlist_addtail (tsm->lru_pool, head_index, oldest_index);
+	  s->last_lru_update = s->last_heard;
+	}
       else
 	{
 	  clib_dlist_addhead (tsm->lru_pool, head_index, oldest_index);
@@ -385,6 +695,7 @@ nat_lru_free_one (snat_main_t *sm, int thread_index, f64 now)
 static_always_inline snat_session_t *
 nat_ed_session_alloc (snat_main_t *sm, u32 thread_index, f64 now, u8 proto)
 {
+  nat_ed_session_shared_t *sh;
   snat_session_t *s;
   snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
 
@@ -393,6 +704,12 @@ nat_ed_session_alloc (snat_main_t *sm, u32 thread_index, f64 now, u8 proto)
   pool_get (tsm->sessions, s);
   clib_memset (s, 0, sizeof (*s));
 
+  /* the version stays odd from the previous delete */
+  sh = nat_ed_session_shared (tsm, s);
+  sh->remote_pkts = 0;
+  sh->remote_bytes = 0;
+  sh->remote_last_heard = 0;
+
   nat_ed_lru_insert (tsm, s, now, proto);
 
   s->ha_last_refreshed = now;
@@ -549,6 +866,47 @@ nat_6t_t_eq (nat_6t_t *t1, nat_6t_t *t2)
   return t1->as_u64[0] == t2->as_u64[0] && t1->as_u64[1] == t2->as_u64[1];
 }
 
+/*
+ * Session of a packet the NIC marked with an offloaded flow, ~0 if it is
+ * not marked or the mark is stale. The session may belong to another
+ * thread and is only read as a hint, the translating thread checks it
+ * again.
+ */
+static_always_inline u32
+nat44_ed_flow_offload_session (snat_main_t *sm, vlib_buffer_t *b,
+			       ip4_header_t *ip, u32 fib_index,
+			       u32 *thread_index)
+{
+  u32 id = b->flow_id - sm->flow_offload_id_start, session_index;
+  snat_main_per_thread_data_t *tsm;
+  snat_session_t *s;
+  nat_6t_t match;
+
+  if (PREDICT_TRUE (id >= sm->flow_offload_id_count))
+    return ~0;
+
+  *thread_index = id / sm->max_translations_per_thread;
+  session_index = id % sm->max_translations_per_thread;
+  tsm = vec_elt_at_index (sm->per_thread_data, *thread_index);
+  if (session_index >= vec_len (tsm->sessions))
+    return ~0;
+
+  match.as_u64[0] = match.as_u64[1] = 0;
+  match.saddr.as_u32 = ip->src_address.as_u32;
+  match.daddr.as_u32 = ip->dst_address.as_u32;
+  match.sport = vnet_buffer (b)->ip.reass.l4_src_port;
+  match.dport = vnet_buffer (b)->ip.reass.l4_dst_port;
+  match.fib_index = fib_index;
+  match.proto = ip->protocol;
+
+  s = tsm->sessions + session_index;
+  if (!nat_6t_t_eq (&s->i2o.match, &match) &&
+      !nat_6t_t_eq (&s->o2i.match, &match))
+    return ~0;
+
+  return session_index;
+}
+
 static inline uword
 nat_pre_node_fn_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 			vlib_frame_t *frame, u32 def_next)
@@ -708,12 +1066,15 @@ nat44_ed_session_reopen (u32 thread_index, snat_session_t *s)
 			 &s->ext_host_addr, s->ext_host_port, s->proto,
 			 nat44_ed_is_twice_nat_session (s));
 
-  nat_ipfix_logging_nat44_ses_delete (
-    thread_index, s->in2out.addr.as_u32, s->out2in.addr.as_u32, s->proto,
-    s->in2out.port, s->out2in.port, s->in2out.fib_index);
-  nat_ipfix_logging_nat44_ses_create (
-    thread_index, s->in2out.addr.as_u32, s->out2in.addr.as_u32, s->proto,
-    s->in2out.port, s->out2in.port, s->in2out.fib_index);
+  if (!nat44_ed_is_port_block_session (s))
+    {
+      nat_ipfix_logging_nat44_ses_delete (
+	thread_index, s->in2out.addr.as_u32, s->out2in.addr.as_u32, s->proto,
+	s->in2out.port, s->out2in.port, s->in2out.fib_index);
+      nat_ipfix_logging_nat44_ses_create (
+	thread_index, s->in2out.addr.as_u32, s->out2in.addr.as_u32, s->proto,
+	s->in2out.port, s->out2in.port, s->in2out.fib_index);
+    }
 
   nat_syslog_nat44_sadd (0, s->in2out.fib_index, &s->in2out.addr,
 			 s->in2out.port, &s->ext_host_nat_addr,
@@ -734,6 +734,30 @@ nat44_ed_out2in_slowpath_unknown_proto (snat_main_t *sm, vlib_buffer_t *b,
   return s;
 }
 
+/* Translate with a copy of another worker's session, 0 if there was one */
+static_always_inline int
+nat44_ed_out2in_shared_session (vlib_main_t *vm, snat_main_t *sm,
+				vlib_buffer_t *b, ip4_header_t *ip,
+				ip_protocol_t proto,
+				clib_bihash_kv_16_8_t *value, nat_6t_t *lookup,
+				f64 now, nat_translation_error_e *error)
+{
+  nat_ed_session_shared_t *sh;
+  nat_6t_flow_t f;
+
+  sh = nat_ed_session_o2i_copy (sm, ed_value_get_thread_index (value),
+				ed_value_get_session_index (value), &f);
+  if (!sh || !nat_6t_t_eq (&f.match, lookup))
+    return -1;
+
+  *error = nat_6t_flow_buf_translate_o2i (vm, sm, b, ip, &f, proto,
+					  0 /* is_output_feature */);
+  if (NAT_ED_TRNSL_ERR_SUCCESS == *error)
+    nat_ed_session_remote_update (sh, now,
+				  vlib_buffer_length_in_chain (vm, b));
+  return 0;
+}
+
 static inline uword
 nat44_ed_out2in_fast_path_node_fn_inline (vlib_main_t * vm,
 					  vlib_node_runtime_t * node,
@@ -751,6 +775,9 @@ nat44_ed_out2in_fast_path_node_fn_inline (vlib_main_t * vm,
 
   vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
   u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
+  u32 handoff_bi[VLIB_FRAME_SIZE];
+  u16 handoff_ti[VLIB_FRAME_SIZE];
+  u32 n_handoff = 0;
   vlib_get_buffers (vm, from, b, n_left_from);
 
   while (n_left_from > 0)
@@ -838,9 +865,19 @@ nat44_ed_out2in_fast_path_node_fn_inline (vlib_main_t * vm,
 	  lookup.proto = ip0->protocol;
 	}
 
+      /* without handoff, the NIC may have marked the packet with its
+       * session if the flow is offloaded */
+      if (!is_multi_worker && PREDICT_FALSE (sm->flow_offload_id_count))
+	{
+	  u32 fo_thread_index;
+	  vnet_buffer2 (b0)->nat.cached_session_index =
+	    nat44_ed_flow_offload_session (sm, b0, ip0, rx_fib_index0,
+					   &fo_thread_index);
+	}
+
       /* there might be a stashed index in vnet_buffer2 from handoff or
        * classify node, see if it can be used */
-      if (is_multi_worker &&
+      if ((is_multi_worker || sm->flow_offload_id_count) &&
 	  !pool_is_free_index (tsm->sessions,
 			       vnet_buffer2 (b0)->nat.cached_session_index))
 	{
@@ -868,7 +905,32 @@ nat44_ed_out2in_fast_path_node_fn_inline (vlib_main_t * vm,
 	  next[0] = NAT_NEXT_OUT2IN_ED_SLOW_PATH;
 	  goto trace0;
 	}
-      ASSERT (thread_index == ed_value_get_thread_index (&value0));
+      if (PREDICT_FALSE (thread_index !=
+			 ed_value_get_thread_index (&value0)))
+	{
+	  /* the handoff node found another worker's session shareable */
+	  if (nat44_ed_out2in_shared_session (vm, sm, b0, ip0, proto0,
+					      &value0, &lookup, now,
+					      &translation_error))
+	    {
+	      /* the session is being deleted, only its owner may touch it */
+	      handoff_bi[n_handoff] = from[next - nexts];
+	      handoff_ti[n_handoff++] = ed_value_get_thread_index (&value0);
+	      next[0] = NAT_N_NEXT;
+	    }
+	  else if (NAT_ED_TRNSL_ERR_SUCCESS != translation_error)
+	    {
+	      next[0] = NAT_NEXT_DROP;
+	      b0->error = node->errors[NAT_OUT2IN_ED_ERROR_TRNSL_FAILED];
+	    }
+	  else if (IP_PROTOCOL_TCP == proto0)
+	    vlib_increment_simple_counter (&sm->counters.fastpath.out2in.tcp,
+					   thread_index, sw_if_index0, 1);
+	  else
+	    vlib_increment_simple_counter (&sm->counters.fastpath.out2in.udp,
+					   thread_index, sw_if_index0, 1);
+	  goto trace0;
+	}
       s0 =
 	pool_elt_at_index (tsm->sessions,
 			   ed_value_get_session_index (&value0));
@@ -889,6 +951,7 @@ nat44_ed_out2in_fast_path_node_fn_inline (vlib_main_t * vm,
 
       // drop if session expired
       u64 sess_timeout_time;
+      nat_ed_session_sync (tsm, s0);
       sess_timeout_time =
 	s0->last_heard + (f64) nat44_session_get_timeout (sm, s0);
       if (now >= sess_timeout_time)
@@ -992,6 +1055,10 @@ nat44_ed_out2in_fast_path_node_fn_inline (vlib_main_t * vm,
 				     thread_index);
       /* Per-user LRU list maintenance */
       nat44_session_update_lru (sm, s0, thread_index);
+      if (is_multi_worker)
+	nat_ed_session_publish (tsm, s0);
+      if (PREDICT_FALSE (sm->flow_offload_enabled))
+	nat44_ed_flow_offload_update (sm, tsm, s0, b0, NAT44_ED_DIR_O2I);
 
     trace0:
       if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
@@ -1031,6 +1098,27 @@ nat44_ed_out2in_fast_path_node_fn_inline (vlib_main_t * vm,
       next++;
     }
 
+  if (PREDICT_FALSE (n_handoff))
+    {
+      u32 to[VLIB_FRAME_SIZE], n_to = 0, n_enq, i;
+
+      for (i = 0; i < frame->n_vectors; i++)
+	if (nexts[i] != NAT_N_NEXT)
+	  {
+	    to[n_to] = from[i];
+	    nexts[n_to++] = nexts[i];
+	  }
+      vlib_buffer_enqueue_to_next (vm, node, to, (u16 *) nexts, n_to);
+
+      n_enq = vlib_buffer_enqueue_to_thread (
+	vm, node, sm->fq_out2in_index, handoff_bi, handoff_ti, n_handoff, 1);
+      if (n_enq < n_handoff)
+	vlib_node_increment_counter (vm, node->node_index,
+				     NAT_OUT2IN_ED_ERROR_CONGESTION_DROP,
+				     n_handoff - n_enq);
+      return frame->n_vectors;
+    }
+
   vlib_buffer_enqueue_to_next (vm, node, from, (u16 *) nexts,
 			       frame->n_vectors);
   return frame->n_vectors;
@@ -111,6 +111,7 @@ test_ipsec_spd_outbound_perf_command_fn (vlib_main_t *vm,
   u64 t1 = 0;
   u32 k = 0, m;
   u64 burst_counter = 0;
+  int ranges = 0;
 
   while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
     {
@@ -126,6 +127,8 @@ test_ipsec_spd_outbound_perf_command_fn (vlib_main_t *vm,
 	      burst_size = clib_min (burst_size, BURST_MAX_SIZE);
 	    }
 	}
+      else if (unformat (input, "ranges"))
+	ranges = 1;
       else
 	break;
     }
@@ -134,7 +137,8 @@ test_ipsec_spd_outbound_perf_command_fn (vlib_main_t *vm,
   /* creating a new SA */
   rv = ipsec_sa_add_and_lock (sa_id, spi, proto, crypto_alg, &ck, integ_alg,
 			      &ik, sa_flags, clib_host_to_net_u32 (salt),
-			      udp_src, udp_dst, &tun, &sai);
+			      udp_src, udp_dst,
+			      IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE, &tun, &sai);
   if (rv)
     {
       err = clib_error_return (0, "create sa failure");
@@ -182,6 +186,19 @@ test_ipsec_spd_outbound_perf_command_fn (vlib_main_t *vm,
 	clib_host_to_net_u32 (ip4_start + i * 32);
       p_vec[i].raddr.stop.ip4.data_u32 =
 	clib_host_to_net_u32 (ip4_start + i * 32);
+
+      if (ranges)
+	{
+	  /* port ranges, any local address and remote ranges overlapping
+	   * the next policy, so every lookup has several candidates */
+	  p_vec[i].lport.start = 0;
+	  p_vec[i].lport.stop = 65535;
+	  p_vec[i].rport.stop = 1024;
+	  p_vec[i].laddr.start.ip4.data_u32 = 0;
+	  p_vec[i].laddr.stop.ip4.data_u32 = ~0;
+	  p_vec[i].raddr.stop.ip4.data_u32 =
+	    clib_host_to_net_u32 (ip4_start + i * 32 + 63);
+	}
     }
 
   vlib_cli_output (vm, "Add SPD Policy");
@@ -322,6 +339,7 @@ done:
   vlib_cli_output (vm, "Cleaning:");
   /* delete SPD policy */
   is_add = 0;
+  t_add_0 = clib_cpu_time_now ();
   for (i = 0; i < flows; i++)
     {
       rv = ipsec_add_del_policy (vm, &p_vec[i], is_add, &stat_index);
@@ -331,7 +349,10 @@ done:
 	  err = clib_error_return (0, "delete SPD Policy failure");
 	}
     }
+  t_add_1 = clib_cpu_time_now ();
   vlib_cli_output (vm, "\tDelete all SPD Policy");
+  vlib_cli_output (vm, "Average cycle CPU to delete 1 flow: \t%32lu cycles",
+		   (t_add_1 - t_add_0) / flows);
 
   /* delete SPD */
   rv = ipsec_add_del_spd (vm, spd_id, is_add);
@@ -363,10 +384,268 @@ done:
 
 VLIB_CLI_COMMAND (test_ipsec_spd_perf_command, static) = {
   .path = "test ipsec_spd_outbound_perf",
-  .short_help = "test ipsec_spd_outbound_perf flows <n_flows>",
+  .short_help = "test ipsec_spd_outbound_perf flows <n_flows> [burst <n>] "
+		"[ranges]",
   .function = test_ipsec_spd_outbound_perf_command_fn,
 };
 
+static ipsec_policy_t *
+test_ipsec_spd_ranges_first (ipsec_spd_t *spd, u32 ra)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_policy_t *p;
+  u32 *i;
+
+  vec_foreach (i, spd->policies[IPSEC_SPD_POLICY_IP4_OUTBOUND])
+    {
+      p = pool_elt_at_index (im->policies, *i);
+      if (ra >= clib_net_to_host_u32 (p->raddr.start.ip4.as_u32) &&
+	  ra <= clib_net_to_host_u32 (p->raddr.stop.ip4.as_u32))
+	return p;
+    }
+  return 0;
+}
+
+static clib_error_t *
+test_ipsec_spd_ranges_lookup (ipsec_spd_t *spd, u32 ra)
+{
+  ipsec_policy_t *p = ipsec_output_policy_match (spd, IP_PROTOCOL_UDP, 1, ra,
+						 1, 1, 0);
+
+  if (p != test_ipsec_spd_ranges_first (spd, ra))
+    return clib_error_return (0, "lookup of %U is not the first SPD match",
+			      format_ip4_address, &(ip4_address_t){
+				.as_u32 = clib_host_to_net_u32 (ra) });
+  return 0;
+}
+
+/* compare the range index of the SPD with the policy vector */
+static clib_error_t *
+test_ipsec_spd_ranges_check (ipsec_spd_t *spd, u32 *seed)
+{
+  ipsec_spd_range_index_t *ri =
+    &spd->ip4_ranges[IPSEC_SPD_POLICY_IP4_OUTBOUND];
+  u32 *policies = spd->policies[IPSEC_SPD_POLICY_IP4_OUTBOUND];
+  ipsec_main_t *im = &ipsec_main;
+  clib_error_t *err = 0;
+  u32 *expected = 0;
+  ipsec_policy_t *p;
+  u32 i, k, start, stop, last;
+
+  if (vec_len (policies) == 0)
+    {
+      if (vec_len (ri->starts) > 1 ||
+	  (vec_len (ri->starts) && vec_len (ri->policies[0])))
+	return clib_error_return (0, "%u intervals left in an empty SPD",
+				  vec_len (ri->starts));
+      return 0;
+    }
+
+  if (vec_len (ri->starts) == 0 || ri->starts[0] != 0 ||
+      vec_len (ri->starts) != vec_len (ri->policies))
+    return clib_error_return (0, "range index does not cover 0.0.0.0");
+
+  /* every policy boundary is an interval boundary */
+  vec_foreach_index (i, policies)
+    {
+      p = pool_elt_at_index (im->policies, policies[i]);
+      start = clib_net_to_host_u32 (p->raddr.start.ip4.as_u32);
+      stop = clib_net_to_host_u32 (p->raddr.stop.ip4.as_u32);
+      if (ri->starts[ipsec_spd_range_find (ri, start)] != start ||
+	  (stop != ~0 &&
+	   ri->starts[ipsec_spd_range_find (ri, stop + 1)] != stop + 1))
+	return clib_error_return (0, "policy %u boundaries are not indexed",
+				  policies[i]);
+    }
+
+  vec_foreach_index (k, ri->starts)
+    {
+      if (k && ri->starts[k] <= ri->starts[k - 1])
+	{
+	  err = clib_error_return (0, "interval %u is out of order", k);
+	  goto done;
+	}
+
+      /* the covering policies, in SPD order */
+      vec_reset_length (expected);
+      vec_foreach_index (i, policies)
+	{
+	  p = pool_elt_at_index (im->policies, policies[i]);
+	  start = clib_net_to_host_u32 (p->raddr.start.ip4.as_u32);
+	  stop = clib_net_to_host_u32 (p->raddr.stop.ip4.as_u32);
+	  if (ri->starts[k] >= start && ri->starts[k] <= stop)
+	    vec_add1 (expected, policies[i]);
+	}
+
+      if (vec_len (expected) != vec_len (ri->policies[k]) ||
+	  (vec_len (expected) &&
+	   memcmp (expected, ri->policies[k],
+		   vec_len (expected) * sizeof (expected[0]))))
+	{
+	  err = clib_error_return (0, "interval %u does not hold the SPD "
+				   "order", k);
+	  goto done;
+	}
+
+      if (k && vec_len (ri->policies[k]) == vec_len (ri->policies[k - 1]) &&
+	  (vec_len (expected) == 0 ||
+	   !memcmp (ri->policies[k], ri->policies[k - 1],
+		    vec_len (expected) * sizeof (expected[0]))))
+	{
+	  err = clib_error_return (0, "interval %u is not merged", k);
+	  goto done;
+	}
+
+      /* both ends of the interval and an address inside it */
+      last = k + 1 < vec_len (ri->starts) ? ri->starts[k + 1] - 1 : ~0;
+      if ((err = test_ipsec_spd_ranges_lookup (spd, ri->starts[k])) ||
+	  (err = test_ipsec_spd_ranges_lookup (spd, last)) ||
+	  (err = test_ipsec_spd_ranges_lookup (
+	     spd, ri->starts[k] + random_u32 (seed) %
+				    ((u64) last - ri->starts[k] + 1))))
+	goto done;
+    }
+
+done:
+  vec_free (expected);
+  return err;
+}
+
+static clib_error_t *
+test_ipsec_spd_ranges_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				  vlib_cli_command_t *cmd)
+{
+  ipsec_main_t *im = &ipsec_main;
+  clib_error_t *err = 0;
+  ipsec_policy_t *p_vec = 0, *p;
+  ipsec_spd_t *spd;
+  u32 *order = 0;
+  u32 stat_index, spd_id = 1, n_policies = 200, start, stop;
+  u32 seed = random_default_seed ();
+  u32 i, j, tmp;
+  uword *pp;
+  int rv;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "policies %u", &n_policies))
+	;
+      else if (unformat (input, "seed %u", &seed))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (im->fp_spd_ipv4_out_is_enabled)
+    return clib_error_return (0, "the range index is not used with the "
+			      "IPv4 outbound fast path");
+
+  vlib_cli_output (vm, "%u policies, seed %u", n_policies, seed);
+
+  rv = ipsec_add_del_spd (vm, spd_id, 1);
+  if (rv)
+    return clib_error_return (0, "create spd failure");
+
+  pp = hash_get (im->spd_index_by_spd_id, spd_id);
+  spd = pool_elt_at_index (im->spds, pp[0]);
+
+  /* nested and overlapping remote ranges around 10.0.0.0, with few
+   * priorities so ties are common, and some open ended or catch-all */
+  vec_validate (p_vec, n_policies - 1);
+  vec_foreach_index (i, p_vec)
+    {
+      p = p_vec + i;
+      start = 0x0a000000 + random_u32 (&seed) % 4096;
+      switch (random_u32 (&seed) % 4)
+	{
+	case 0:
+	  stop = start;
+	  break;
+	case 1:
+	  stop = start + random_u32 (&seed) % 64;
+	  break;
+	case 2:
+	  stop = start + random_u32 (&seed) % 1024;
+	  break;
+	default:
+	  stop = ~0;
+	  break;
+	}
+      if (i % 16 == 0)
+	{
+	  start = 0;
+	  stop = ~0;
+	}
+
+      p->type = IPSEC_SPD_POLICY_IP4_OUTBOUND;
+      p->priority = random_u32 (&seed) % 8;
+      p->policy = IPSEC_POLICY_ACTION_BYPASS;
+      p->id = spd_id;
+      p->protocol = IPSEC_POLICY_PROTOCOL_ANY;
+      p->lport.stop = 65535;
+      p->rport.stop = 65535;
+      p->laddr.stop.ip4.as_u32 = ~0;
+      p->raddr.start.ip4.as_u32 = clib_host_to_net_u32 (start);
+      p->raddr.stop.ip4.as_u32 = clib_host_to_net_u32 (stop);
+      vec_add1 (order, i);
+    }
+
+  vec_foreach_index (i, p_vec)
+    {
+      rv = ipsec_add_del_policy (vm, &p_vec[i], 1, &stat_index);
+      if (rv)
+	{
+	  vec_set_len (order, i);
+	  err = clib_error_return (0, "add SPD Policy failure");
+	  goto done;
+	}
+      if ((err = test_ipsec_spd_ranges_check (spd, &seed)))
+	goto done;
+    }
+
+  vlib_cli_output (vm, "%u intervals",
+		   vec_len (spd->ip4_ranges[IPSEC_SPD_POLICY_IP4_OUTBOUND]
+			      .starts));
+
+  /* delete in random order, every delete may merge boundaries */
+  for (i = vec_len (order); i > 1; i--)
+    {
+      j = random_u32 (&seed) % i;
+      tmp = order[i - 1];
+      order[i - 1] = order[j];
+      order[j] = tmp;
+    }
+
+  while (vec_len (order))
+    {
+      i = vec_pop (order);
+      rv = ipsec_add_del_policy (vm, &p_vec[i], 0, &stat_index);
+      if (rv)
+	{
+	  err = clib_error_return (0, "delete SPD Policy failure");
+	  goto done;
+	}
+      if ((err = test_ipsec_spd_ranges_check (spd, &seed)))
+	goto done;
+    }
+
+done:
+  vec_foreach_index (j, order)
+    ipsec_add_del_policy (vm, &p_vec[order[j]], 0, &stat_index);
+  ipsec_add_del_spd (vm, spd_id, 0);
+  vec_free (order);
+  vec_free (p_vec);
+
+  return err;
+}
+
+VLIB_CLI_COMMAND (test_ipsec_spd_ranges_command, static) = {
+  .path = "test ipsec_spd_ranges",
+  .short_help = "test ipsec_spd_ranges [policies <n>] [seed <n>]",
+  .function = test_ipsec_spd_ranges_command_fn,
+};
+
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (test_ipsec_command, static) =
 {
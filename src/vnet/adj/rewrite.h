@@ -224,6 +224,70 @@ _vnet_rewrite_two_headers (const vnet_rewrite_header_t * h0,
 			     (p0), (p1),				\
 			     (most_likely_size))
 
+/*
+ * A rewrite string preloaded into registers, for applying the same rewrite
+ * to a run of packets. Strings of 8 to 32 bytes are then written with two
+ * possibly overlapping stores of 8 or 16 bytes, others with a memcpy.
+ */
+typedef struct vnet_rewrite_vec_t_
+{
+#if defined(CLIB_HAVE_VEC128)
+  /* first and last 16 bytes of a 17 to 32 byte string */
+  u8x16 head;
+  u8x16 tail;
+#endif
+  /* first and last 8 bytes of an 8 to 16 byte string */
+  u64 head8;
+  u64 tail8;
+  const vnet_rewrite_header_t *rw;
+  u16 data_bytes;
+} vnet_rewrite_vec_t;
+
+always_inline void
+vnet_rewrite_vec_load (vnet_rewrite_vec_t *v, const vnet_rewrite_header_t *h)
+{
+  u16 n = h->data_bytes;
+
+  /* 0xfefe => poisoned adjacency => crash */
+  ASSERT (n != 0xfefe);
+  *v = (vnet_rewrite_vec_t){ .rw = h, .data_bytes = n };
+
+  if (n >= 8 && n <= 16)
+    {
+      v->head8 = clib_mem_unaligned (h->data, u64);
+      v->tail8 = clib_mem_unaligned (h->data + n - 8, u64);
+    }
+#if defined(CLIB_HAVE_VEC128)
+  else if (n > 16 && n <= 32)
+    {
+      v->head = u8x16_load_unaligned ((u8 *) h->data);
+      v->tail = u8x16_load_unaligned ((u8 *) h->data + n - 16);
+    }
+#endif
+}
+
+always_inline void
+vnet_rewrite_vec_store (const vnet_rewrite_vec_t *v, void *packet0)
+{
+  u8 *p = packet0;
+  u16 n = v->data_bytes;
+
+  if (PREDICT_TRUE (n >= 8 && n <= 16))
+    {
+      clib_mem_unaligned (p - n, u64) = v->head8;
+      clib_mem_unaligned (p - 8, u64) = v->tail8;
+    }
+#if defined(CLIB_HAVE_VEC128)
+  else if (n > 16 && n <= 32)
+    {
+      u8x16_store_unaligned (v->head, p - n);
+      u8x16_store_unaligned (v->tail, p - 16);
+    }
+#endif
+  else
+    clib_memcpy_fast (p - n, v->rw->data, n);
+}
+
 always_inline void
 vnet_ip_mcast_fixup_header (u32 dst_mcast_mask,
 			    u32 dst_mcast_offset, u32 * addr, u8 * packet0)
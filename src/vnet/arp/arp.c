@@ -202,7 +202,7 @@ arp_learn (u32 sw_if_index,
   };
   /* *INDENT-ON* */
 
-  ip_neighbor_learn_dp (&l);
+  ip_neighbor_learn_dp_batch (&l);
 
   return (ARP_ERROR_L3_SRC_ADDRESS_LEARNED);
 }
@@ -670,6 +670,8 @@ arp_reply (vlib_main_t * vm, vlib_node_runtime_t * node, vlib_frame_t * frame)
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
 
+  ip_neighbor_learn_dp_flush ();
+
   vlib_error_count (vm, node->node_index, ARP_ERROR_REPLIES_SENT,
 		    n_replies_sent);
 
@@ -70,27 +70,20 @@ vnet_is_packet_traced_inline (vlib_buffer_t * b,
    * Look for a hit in a less-specific table.
    * Performance hint: for this use-case, don't go there.
    */
-  while (1)
-    {
-      /* Most likely, we're done right now */
-      if (PREDICT_TRUE (t->next_table_index == ~0))
-	return 0;
-      t = pool_elt_at_index (vcm->tables, t->next_table_index);
-
-      /* Compute hash for this table */
-      hash = vnet_classify_hash_packet (t, vlib_buffer_get_current (b));
+  if (PREDICT_TRUE (t->next_table_index == ~0))
+    return 0;
 
-      /* See if there's a matching entry */
-      e = vnet_classify_find_entry (t, vlib_buffer_get_current (b), hash,
-				    0 /* time = 0, disables hit-counter */ );
-      if (e)
-	{
-	  /* Manual hit accounting */
-	  e->hits++;
-	  return 1;
-	}
+  e = vnet_classify_find_entry_in_chain (t->next_table_index,
+					 vlib_buffer_get_current (b),
+					 0 /* time = 0, disables hit-counter */,
+					 &t);
+  if (e)
+    {
+      /* Manual hit accounting */
+      e->hits++;
+      return 1;
     }
-  /* NOTREACHED */
+  return 0;
 }
 
 /*
@@ -660,6 +660,13 @@ vnet_classify_find_entry (const vnet_classify_table_t *t, u8 *h, u32 hash,
   return vnet_classify_find_entry_inline (t, h, hash, now);
 }
 
+vnet_classify_entry_t *
+vnet_classify_find_entry_in_chain (u32 table_index, const u8 *h, f64 now,
+				   vnet_classify_table_t **tp)
+{
+  return vnet_classify_find_entry_in_chain_inline (table_index, h, now, tp);
+}
+
 u8 *
 format_classify_entry (u8 *s, va_list *args)
 {
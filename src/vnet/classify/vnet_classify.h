@@ -581,6 +581,63 @@ vnet_classify_find_entry_inline (const vnet_classify_table_t *t, const u8 *h,
   return 0;
 }
 
+/*
+ * Number of tables of a chain hashed and prefetched together
+ */
+#define VNET_CLASSIFY_CHAIN_BATCH 4
+
+/*
+ * Find the first entry matching the packet in the chain of tables starting
+ * at table_index. The packet is hashed for a batch of tables, whose buckets
+ * and then entries are prefetched before any of them is searched, so that
+ * the cache misses of the tables of a batch overlap instead of following
+ * one another. Returns the entry and its table in *tp, or 0 and the last
+ * table of the chain in *tp.
+ */
+static inline vnet_classify_entry_t *
+vnet_classify_find_entry_in_chain_inline (u32 table_index, const u8 *h,
+					  f64 now, vnet_classify_table_t **tp)
+{
+  vnet_classify_main_t *vcm = &vnet_classify_main;
+  vnet_classify_table_t *tables[VNET_CLASSIFY_CHAIN_BATCH];
+  u32 hashes[VNET_CLASSIFY_CHAIN_BATCH];
+  vnet_classify_table_t *t = 0;
+  vnet_classify_entry_t *e;
+  int i, n;
+
+  while (table_index != ~0)
+    {
+      for (n = 0; n < VNET_CLASSIFY_CHAIN_BATCH && table_index != ~0; n++)
+	{
+	  t = pool_elt_at_index (vcm->tables, table_index);
+	  tables[n] = t;
+	  hashes[n] = vnet_classify_hash_packet_inline (t, h);
+	  vnet_classify_prefetch_bucket (t, hashes[n]);
+	  table_index = t->next_table_index;
+	}
+
+      for (i = 0; i < n; i++)
+	vnet_classify_prefetch_entry (tables[i], hashes[i]);
+
+      for (i = 0; i < n; i++)
+	{
+	  e = vnet_classify_find_entry_inline (tables[i], h, hashes[i], now);
+	  if (e)
+	    {
+	      *tp = tables[i];
+	      return e;
+	    }
+	}
+    }
+
+  *tp = t;
+  return 0;
+}
+
+vnet_classify_entry_t *
+vnet_classify_find_entry_in_chain (u32 table_index, const u8 *h, f64 now,
+				   vnet_classify_table_t **tp);
+
 vnet_classify_table_t *vnet_classify_new_table (vnet_classify_main_t *cm,
 						const u8 *mask, u32 nbuckets,
 						u32 memory_size,
@@ -22,6 +22,7 @@
 #include <vnet/fib/fib_urpf_list.h>
 #include <vnet/bier/bier_fwd.h>
 #include <vnet/fib/mpls_fib.h>
+#include <vnet/fib/ip4_fib_cache.h>
 #include <vnet/ip/ip4_inlines.h>
 #include <vnet/ip/ip6_inlines.h>
 
@@ -279,6 +280,7 @@ load_balance_set_bucket_i (load_balance_t *lb,
                            const dpo_id_t *next)
 {
     dpo_stack(DPO_LOAD_BALANCE, lb->lb_proto, &buckets[bucket], next);
+    ip4_fib_cache_invalidate();
 }
 
 void
@@ -863,6 +865,11 @@ load_balance_multipath_update (const dpo_id_t *dpo,
         }
     }
 
+    /*
+     * the number of buckets may have changed after the last bucket write
+     */
+    ip4_fib_cache_invalidate();
+
     vec_foreach (nh, nhs)
     {
         dpo_reset(&nh->path_dpo);
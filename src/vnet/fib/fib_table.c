@@ -20,6 +20,7 @@
 #include <vnet/fib/fib_entry_cover.h>
 #include <vnet/fib/fib_internal.h>
 #include <vnet/fib/ip4_fib.h>
+#include <vnet/fib/ip4_fib_cache.h>
 #include <vnet/fib/ip6_fib.h>
 #include <vnet/fib/mpls_fib.h>
 
@@ -259,10 +260,12 @@ fib_table_fwding_dpo_update (u32 fib_index,
     switch (prefix->fp_proto)
     {
     case FIB_PROTOCOL_IP4:
-	return (ip4_fib_table_fwding_dpo_update(ip4_fib_get(fib_index),
-						&prefix->fp_addr.ip4,
-						prefix->fp_len,
-						dpo));
+	ip4_fib_table_fwding_dpo_update(ip4_fib_get(fib_index),
+                                        &prefix->fp_addr.ip4,
+                                        prefix->fp_len,
+                                        dpo);
+        ip4_fib_cache_invalidate();
+        return;
     case FIB_PROTOCOL_IP6:
 	return (ip6_fib_table_fwding_dpo_update(fib_index,
 						&prefix->fp_addr.ip6,
@@ -286,12 +289,14 @@ fib_table_fwding_dpo_remove (u32 fib_index,
     switch (prefix->fp_proto)
     {
     case FIB_PROTOCOL_IP4:
-	return (ip4_fib_table_fwding_dpo_remove(ip4_fib_get(fib_index),
-						&prefix->fp_addr.ip4,
-						prefix->fp_len,
-						dpo,
-                                                fib_table_get_less_specific(fib_index,
-                                                                            prefix)));
+	ip4_fib_table_fwding_dpo_remove(ip4_fib_get(fib_index),
+                                        &prefix->fp_addr.ip4,
+                                        prefix->fp_len,
+                                        dpo,
+                                        fib_table_get_less_specific(fib_index,
+                                                                    prefix));
+        ip4_fib_cache_invalidate();
+        return;
     case FIB_PROTOCOL_IP6:
 	return (ip6_fib_table_fwding_dpo_remove(fib_index,
 						&prefix->fp_addr.ip6,
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2024 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/fib/ip4_fib_cache.h>
+
+ip4_fib_cache_main_t ip4_fib_cache_main = {
+    .fcm_epoch = 1,
+};
+
+/**
+ * Number of entries requested in the startup config, 0 if none.
+ */
+static u32 ip4_fib_cache_config_size;
+
+static void
+ip4_fib_cache_free_entries (void)
+{
+    ip4_fib_cache_main_t *fcm = &ip4_fib_cache_main;
+    ip4_fib_cache_per_thread_t *fcpt;
+
+    vec_foreach (fcpt, fcm->fcm_per_thread)
+    {
+        vec_free (fcpt->fcpt_entries);
+    }
+    vec_free (fcm->fcm_per_thread);
+}
+
+/**
+ * @brief Enable (or resize) the cache. Runs with the workers stopped.
+ */
+clib_error_t *
+ip4_fib_cache_enable (u32 n_entries)
+{
+    ip4_fib_cache_main_t *fcm = &ip4_fib_cache_main;
+    ip4_fib_cache_per_thread_t *fcpt;
+    u32 log2_size;
+
+    if (0 == n_entries)
+        return (clib_error_return (0, "cache size must be non-zero"));
+
+    log2_size = max_log2 (n_entries);
+
+    if (log2_size > 24)
+        return (clib_error_return (0, "cache size %u too large", n_entries));
+
+    ip4_fib_cache_free_entries ();
+
+    vec_validate_aligned (fcm->fcm_per_thread, vlib_get_n_threads () - 1,
+                          CLIB_CACHE_LINE_BYTES);
+    vec_foreach (fcpt, fcm->fcm_per_thread)
+    {
+        vec_validate_aligned (fcpt->fcpt_entries, (1 << log2_size) - 1,
+                              CLIB_CACHE_LINE_BYTES);
+    }
+
+    fcm->fcm_log2_size = log2_size;
+    fcm->fcm_mask = (1 << log2_size) - 1;
+    fcm->fcm_enabled = 1;
+
+    /* the new entries are zeroed, i.e. never filled; start afresh anyway */
+    ip4_fib_cache_invalidate ();
+
+    return (NULL);
+}
+
+void
+ip4_fib_cache_disable (void)
+{
+    ip4_fib_cache_main_t *fcm = &ip4_fib_cache_main;
+
+    fcm->fcm_enabled = 0;
+    ip4_fib_cache_free_entries ();
+}
+
+u8 *
+format_ip4_fib_cache (u8 * s, va_list * args)
+{
+    ip4_fib_cache_main_t *fcm = &ip4_fib_cache_main;
+    ip4_fib_cache_per_thread_t *fcpt;
+    u64 hits = 0, misses = 0;
+
+    if (!fcm->fcm_enabled)
+        return (format (s, "ip4 fib cache: disabled"));
+
+    s = format (s, "ip4 fib cache: %u entries per thread, epoch %u",
+                1 << fcm->fcm_log2_size, fcm->fcm_epoch);
+
+    vec_foreach (fcpt, fcm->fcm_per_thread)
+    {
+        s = format (s, "\n  thread %u: hits %llu misses %llu",
+                    fcpt - fcm->fcm_per_thread,
+                    fcpt->fcpt_hits, fcpt->fcpt_misses);
+        hits += fcpt->fcpt_hits;
+        misses += fcpt->fcpt_misses;
+    }
+    s = format (s, "\n  total: hits %llu misses %llu", hits, misses);
+
+    if (hits + misses)
+        s = format (s, " hit-rate %.2f%%",
+                    100.0 * (f64) hits / (f64) (hits + misses));
+
+    return (s);
+}
+
+static clib_error_t *
+ip4_fib_cache_set_cmd (vlib_main_t * vm,
+                       unformat_input_t * input,
+                       vlib_cli_command_t * cmd)
+{
+    u32 n_entries = 1 << IP4_FIB_CACHE_DEFAULT_LOG2_SIZE;
+    int disable = 0;
+
+    while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+        if (unformat (input, "size %u", &n_entries))
+            ;
+        else if (unformat (input, "disable"))
+            disable = 1;
+        else
+            return (clib_error_return (0, "unknown input '%U'",
+                                       format_unformat_error, input));
+    }
+
+    if (disable)
+    {
+        ip4_fib_cache_disable ();
+        return (NULL);
+    }
+
+    return (ip4_fib_cache_enable (n_entries));
+}
+
+/*?
+ * This command enables, resizes or disables the per-thread IPv4 FIB
+ * forwarding cache consulted by ip4-lookup before the mtrie.
+ *
+ * @cliexpar
+ * @cliexcmd{set ip fib cache size 65536}
+ * @cliexcmd{set ip fib cache disable}
+ ?*/
+VLIB_CLI_COMMAND (ip4_fib_cache_set_command, static) = {
+    .path = "set ip fib cache",
+    .short_help = "set ip fib cache [size <n-entries>] [disable]",
+    .function = ip4_fib_cache_set_cmd,
+};
+
+static clib_error_t *
+ip4_fib_cache_show_cmd (vlib_main_t * vm,
+                        unformat_input_t * input,
+                        vlib_cli_command_t * cmd)
+{
+    ip4_fib_cache_main_t *fcm = &ip4_fib_cache_main;
+    ip4_fib_cache_per_thread_t *fcpt;
+
+    if (unformat (input, "clear"))
+    {
+        vec_foreach (fcpt, fcm->fcm_per_thread)
+        {
+            fcpt->fcpt_hits = fcpt->fcpt_misses = 0;
+        }
+        return (NULL);
+    }
+
+    vlib_cli_output (vm, "%U", format_ip4_fib_cache);
+
+    return (NULL);
+}
+
+/*?
+ * This command displays the per-thread hit and miss counters of the IPv4
+ * FIB forwarding cache. With 'clear' the counters are reset.
+ *
+ * @cliexpar
+ * @cliexstart{show ip fib cache}
+ * ip4 fib cache: 65536 entries per thread, epoch 1234
+ *   thread 0: hits 0 misses 0
+ *   thread 1: hits 91723410 misses 81204
+ *   total: hits 91723410 misses 81204 hit-rate 99.91%
+ * @cliexend
+ ?*/
+VLIB_CLI_COMMAND (ip4_fib_cache_show_command, static) = {
+    .path = "show ip fib cache",
+    .short_help = "show ip fib cache [clear]",
+    .function = ip4_fib_cache_show_cmd,
+};
+
+static clib_error_t *
+ip4_fib_cache_config (vlib_main_t * vm, unformat_input_t * input)
+{
+    while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+        if (unformat (input, "fib-cache-size %u", &ip4_fib_cache_config_size))
+            ;
+        else
+            return (clib_error_return (0, "unknown input '%U'",
+                                       format_unformat_error, input));
+    }
+
+    return (NULL);
+}
+
+VLIB_CONFIG_FUNCTION (ip4_fib_cache_config, "ip4");
+
+static clib_error_t *
+ip4_fib_cache_main_loop_enter (vlib_main_t * vm)
+{
+    /* the number of threads is only known now */
+    if (ip4_fib_cache_config_size)
+        return (ip4_fib_cache_enable (ip4_fib_cache_config_size));
+
+    return (NULL);
+}
+
+VLIB_MAIN_LOOP_ENTER_FUNCTION (ip4_fib_cache_main_loop_enter);
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2024 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @brief The IPv4 FIB forwarding cache
+ *
+ * An optional, per-thread, direct mapped, exact match cache in front of
+ * the mtrie. It maps {fib_index, destination} to the load-balance the
+ * mtrie would return and, when that load-balance has a single bucket, to
+ * the forwarding DPO itself.
+ *
+ * Entries are not invalidated one by one. Every change to the IPv4
+ * forwarding tables or to a load-balance's buckets bumps a global epoch and
+ * entries tagged with an older epoch are treated as misses. Workers read
+ * the epoch before doing the lookup that fills an entry, so an entry can
+ * never outlive the forwarding state it was built from.
+ */
+
+#ifndef __IP4_FIB_CACHE_H__
+#define __IP4_FIB_CACHE_H__
+
+#include <vnet/ip/ip.h>
+#include <vnet/dpo/dpo.h>
+
+typedef struct ip4_fib_cache_entry_t_
+{
+    ip4_address_t fce_dst;
+    u32 fce_fib_index;
+    /**
+     * The epoch the entry was filled in. Zero is never a valid epoch.
+     */
+    u32 fce_epoch;
+    /**
+     * The load-balance the mtrie returned.
+     */
+    index_t fce_lbi;
+    /**
+     * The load-balance's only bucket, invalid if it has more than one.
+     */
+    dpo_id_t fce_dpo;
+} ip4_fib_cache_entry_t;
+
+typedef struct ip4_fib_cache_per_thread_t_
+{
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+    ip4_fib_cache_entry_t *fcpt_entries;
+    u64 fcpt_hits;
+    u64 fcpt_misses;
+} ip4_fib_cache_per_thread_t;
+
+typedef struct ip4_fib_cache_main_t_
+{
+    /**
+     * Current epoch; bumped on every forwarding change
+     */
+    volatile u32 fcm_epoch;
+    u8 fcm_enabled;
+    u8 fcm_log2_size;
+    u32 fcm_mask;
+    ip4_fib_cache_per_thread_t *fcm_per_thread;
+} ip4_fib_cache_main_t;
+
+extern ip4_fib_cache_main_t ip4_fib_cache_main;
+
+#define IP4_FIB_CACHE_DEFAULT_LOG2_SIZE 16
+
+extern clib_error_t *ip4_fib_cache_enable (u32 n_entries);
+extern void ip4_fib_cache_disable (void);
+
+extern u8 *format_ip4_fib_cache (u8 * s, va_list * args);
+
+static_always_inline int
+ip4_fib_cache_is_enabled (void)
+{
+    return (ip4_fib_cache_main.fcm_enabled);
+}
+
+/**
+ * @brief Invalidate all cached entries on all threads
+ *
+ * Called after, never before, the forwarding state is changed.
+ */
+static_always_inline void
+ip4_fib_cache_invalidate (void)
+{
+    ip4_fib_cache_main_t *fcm = &ip4_fib_cache_main;
+    u32 epoch = fcm->fcm_epoch + 1;
+
+    /* zero is the epoch of never filled entries */
+    if (PREDICT_FALSE (0 == epoch))
+        epoch = 1;
+
+    clib_atomic_store_rel_n (&fcm->fcm_epoch, epoch);
+}
+
+static_always_inline u32
+ip4_fib_cache_epoch (void)
+{
+    return (clib_atomic_load_acq_n (&ip4_fib_cache_main.fcm_epoch));
+}
+
+static_always_inline ip4_fib_cache_entry_t *
+ip4_fib_cache_get_entry (ip4_fib_cache_per_thread_t *fcpt,
+                         u32 fib_index,
+                         const ip4_address_t *dst)
+{
+    u64 hash;
+
+    hash = ((u64) fib_index << 32 | dst->as_u32) * 0x9e3779b97f4a7c15ULL;
+    hash >>= 32;
+
+    return (&fcpt->fcpt_entries[hash & ip4_fib_cache_main.fcm_mask]);
+}
+
+static_always_inline int
+ip4_fib_cache_entry_match (const ip4_fib_cache_entry_t *fce,
+                           u32 fib_index,
+                           const ip4_address_t *dst,
+                           u32 epoch)
+{
+    return ((fce->fce_dst.as_u32 == dst->as_u32) &
+            (fce->fce_fib_index == fib_index) &
+            (fce->fce_epoch == epoch));
+}
+
+#endif
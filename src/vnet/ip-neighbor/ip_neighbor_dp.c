@@ -20,6 +20,77 @@
 #include <vnet/ip-neighbor/ip_neighbor_dp.h>
 #include <vnet/ip-neighbor/ip_neighbor.h>
 
+/**
+ * Learns are sent to the main thread in batches of at most this many
+ */
+#define IP_NEIGHBOR_DP_BATCH_SIZE 64
+
+/**
+ * Size of the filter of repeated learns within a batch
+ */
+#define IP_NEIGHBOR_DP_N_RECENT 256
+
+typedef struct ip_neighbor_dp_recent_t_
+{
+  ip_neighbor_learn_t ipndr_learn;
+  /** the batch the learn was added to */
+  u32 ipndr_batch;
+} ip_neighbor_dp_recent_t;
+
+typedef struct ip_neighbor_dp_per_thread_t_
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /** learns waiting to be sent to the main thread */
+  ip_neighbor_learn_t *ipndpt_learns;
+
+  /** the number of batches sent; the current batch's number */
+  u32 ipndpt_batch;
+
+  /** the last learn batched, per hash bucket */
+  ip_neighbor_dp_recent_t ipndpt_recent[IP_NEIGHBOR_DP_N_RECENT];
+} ip_neighbor_dp_per_thread_t;
+
+static ip_neighbor_dp_per_thread_t *ip_neighbor_dp_per_thread;
+
+/**
+ * Runs on the main thread, with the workers stopped, once per batch.
+ * The batch is terminated by an entry with an invalid interface.
+ */
+static void
+ip_neighbor_learn_batch (const ip_neighbor_learn_t * l)
+{
+  for (; l->sw_if_index != ~0; l++)
+    ip_neighbor_learn (l);
+}
+
+static int
+ip_neighbor_dp_is_repeat (ip_neighbor_dp_per_thread_t * ipndpt,
+			  const ip_neighbor_learn_t * l)
+{
+  ip_neighbor_dp_recent_t *ipndr;
+  u32 hash;
+
+  if (AF_IP4 == ip_addr_version (&l->ip))
+    hash = ip_addr_v4 (&l->ip).as_u32;
+  else
+    hash = ip_addr_v6 (&l->ip).as_u32[3];
+  hash = ((hash ^ l->sw_if_index) * 0x9e3779b1) >> 24;
+
+  ipndr = &ipndpt->ipndpt_recent[hash % IP_NEIGHBOR_DP_N_RECENT];
+
+  if (ipndr->ipndr_batch == ipndpt->ipndpt_batch &&
+      ipndr->ipndr_learn.sw_if_index == l->sw_if_index &&
+      0 == mac_address_cmp (&ipndr->ipndr_learn.mac, &l->mac) &&
+      0 == ip_address_cmp (&ipndr->ipndr_learn.ip, &l->ip))
+    return (1);
+
+  ipndr->ipndr_learn = *l;
+  ipndr->ipndr_batch = ipndpt->ipndpt_batch;
+
+  return (0);
+}
+
 /**
  * APIs invoked by neighbor implementation (i.s. ARP and ND) that can be
  * called from the DP when the protocol has resolved a neighbor
@@ -30,6 +101,78 @@ ip_neighbor_learn_dp (const ip_neighbor_learn_t * l)
   vl_api_rpc_call_main_thread (ip_neighbor_learn, (u8 *) l, sizeof (*l));
 }
 
+void
+ip_neighbor_learn_dp_batch (const ip_neighbor_learn_t * l)
+{
+  ip_neighbor_dp_per_thread_t *ipndpt;
+  vlib_main_t *vm = vlib_get_main ();
+
+  if (PREDICT_FALSE (vm->thread_index >= vec_len (ip_neighbor_dp_per_thread)))
+    {
+      /* before the main loop has started */
+      vl_api_rpc_call_main_thread (ip_neighbor_learn, (u8 *) l, sizeof (*l));
+      return;
+    }
+
+  ipndpt = &ip_neighbor_dp_per_thread[vm->thread_index];
+
+  /* ARP and ND storms repeat the same bindings; send each once a batch */
+  if (ip_neighbor_dp_is_repeat (ipndpt, l))
+    return;
+
+  vec_add1 (ipndpt->ipndpt_learns, *l);
+
+  if (vec_len (ipndpt->ipndpt_learns) >= IP_NEIGHBOR_DP_BATCH_SIZE)
+    ip_neighbor_learn_dp_flush ();
+}
+
+void
+ip_neighbor_learn_dp_flush (void)
+{
+  ip_neighbor_dp_per_thread_t *ipndpt;
+  ip_neighbor_learn_t *end;
+  u32 thread_index;
+
+  thread_index = vlib_get_thread_index ();
+
+  if (thread_index >= vec_len (ip_neighbor_dp_per_thread))
+    return;
+
+  ipndpt = &ip_neighbor_dp_per_thread[thread_index];
+
+  if (0 == vec_len (ipndpt->ipndpt_learns))
+    return;
+
+  vec_add2 (ipndpt->ipndpt_learns, end, 1);
+  end->sw_if_index = ~0;
+
+  vl_api_rpc_call_main_thread (ip_neighbor_learn_batch,
+			       (u8 *) ipndpt->ipndpt_learns,
+			       vec_len (ipndpt->ipndpt_learns) *
+			       sizeof (ip_neighbor_learn_t));
+
+  vec_reset_length (ipndpt->ipndpt_learns);
+  ipndpt->ipndpt_batch++;
+}
+
+static clib_error_t *
+ip_neighbor_dp_main_loop_enter (vlib_main_t * vm)
+{
+  /* the number of threads is only known now */
+  ip_neighbor_dp_per_thread_t *ipndpt;
+
+  vec_validate_aligned (ip_neighbor_dp_per_thread, vlib_get_n_threads () - 1,
+			CLIB_CACHE_LINE_BYTES);
+
+  /* no learn belongs to the first batch yet */
+  vec_foreach (ipndpt, ip_neighbor_dp_per_thread)
+    ipndpt->ipndpt_batch = 1;
+
+  return (NULL);
+}
+
+VLIB_MAIN_LOOP_ENTER_FUNCTION (ip_neighbor_dp_main_loop_enter);
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
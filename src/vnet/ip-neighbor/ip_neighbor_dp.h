@@ -27,6 +27,19 @@
 
 extern void ip_neighbor_learn_dp (const ip_neighbor_learn_t * l);
 
+/**
+ * As ip_neighbor_learn_dp, but learns are batched per thread; the node
+ * that learns must flush the batch to the main thread before it returns.
+ *
+ * Learns are the only neighbor events the DP passes to the main thread.
+ * A learn of an already known binding is how a neighbor is refreshed, so
+ * refreshes travel in the same batches. Probes need no batching: the glean
+ * nodes send them from the worker itself, rate limited per thread, and
+ * aging probes are sent by the main thread's own process.
+ */
+extern void ip_neighbor_learn_dp_batch (const ip_neighbor_learn_t * l);
+extern void ip_neighbor_learn_dp_flush (void);
+
 #endif /* __INCLUDE_IP_NEIGHBOR_H__ */
 
 /*
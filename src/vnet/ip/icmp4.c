@@ -556,6 +556,24 @@ ip4_icmp_register_type (vlib_main_t * vm, icmp4_type_t type, u32 node_index)
     clib_warning ("WARNING: changed next_by_type[%d]", (int) type);
 }
 
+void
+ip4_icmp_unregister_type (vlib_main_t *vm, icmp4_type_t type)
+{
+  icmp4_main_t *im = &icmp4_main;
+
+  ASSERT ((int) type < ARRAY_LEN (im->ip4_input_next_index_by_type));
+  im->ip4_input_next_index_by_type[type] = ICMP_INPUT_NEXT_ERROR;
+}
+
+int
+ip4_icmp_type_is_registered (icmp4_type_t type)
+{
+  icmp4_main_t *im = &icmp4_main;
+
+  ASSERT ((int) type < ARRAY_LEN (im->ip4_input_next_index_by_type));
+  return (im->ip4_input_next_index_by_type[type] != ICMP_INPUT_NEXT_ERROR);
+}
+
 static clib_error_t *
 icmp4_init (vlib_main_t * vm)
 {
@@ -23,6 +23,8 @@ typedef struct
 format_function_t format_icmp4_input_trace;
 void ip4_icmp_register_type (vlib_main_t * vm, icmp4_type_t type,
 			     u32 node_index);
+void ip4_icmp_unregister_type (vlib_main_t *vm, icmp4_type_t type);
+int ip4_icmp_type_is_registered (icmp4_type_t type);
 
 static_always_inline void
 icmp4_error_set_vnet_buffer (vlib_buffer_t * b, u8 type, u8 code, u32 data)
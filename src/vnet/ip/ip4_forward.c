@@ -40,6 +40,7 @@
 #include <vnet/vnet.h>
 #include <vnet/ip/ip.h>
 #include <vnet/ip/ip_frag.h>
+#include <vnet/ip/ip4_pmtu_cache.h>
 #include <vnet/ethernet/ethernet.h>	/* for ethernet_header_t */
 #include <vnet/ethernet/arp_packet.h>	/* for ethernet_arp_header_t */
 #include <vnet/ppp/ppp.h>
@@ -98,6 +99,9 @@
 VLIB_NODE_FN (ip4_lookup_node) (vlib_main_t * vm, vlib_node_runtime_t * node,
 				vlib_frame_t * frame)
 {
+  if (PREDICT_FALSE (ip4_fib_cache_is_enabled ()))
+    return ip4_lookup_cached_inline (vm, node, frame);
+
   return ip4_lookup_inline (vm, node, frame);
 }
 
@@ -2017,10 +2021,13 @@ typedef enum
 #endif
 
 always_inline void
-ip4_mtu_check (vlib_buffer_t * b, u16 packet_len,
-	       u16 adj_packet_bytes, bool df, u16 * next,
-	       u8 is_midchain, u32 * error)
+ip4_mtu_check (vlib_main_t *vm, vlib_buffer_t *b, const ip4_header_t *ip,
+	       u16 packet_len, u16 adj_packet_bytes, bool df, u16 *next,
+	       u8 is_midchain, u32 *error)
 {
+  /* a learnt path MTU further along the path may be lower */
+  adj_packet_bytes = ip4_pmtu_cache_mtu (vm, ip, adj_packet_bytes);
+
   if (packet_len > adj_packet_bytes)
     {
       *error = IP4_ERROR_MTU_EXCEEDED;
@@ -2111,6 +2118,106 @@ ip4_ttl_and_checksum_check (vlib_buffer_t * b, ip4_header_t * ip, u16 * next,
 	  (vnet_buffer (b)->oflags & VNET_BUFFER_OFFLOAD_F_OUTER_IP_CKSUM));
 }
 
+/* Shortest run of packets sharing an adjacency worth the run path.
+ * ip6-rewrite has no run path: it still enqueues speculatively to the
+ * cached next frame packet by packet, runs need the nexts array form this
+ * node uses and would come with converting that node first. */
+#define IP4_REWRITE_MIN_RUN 4
+
+static_always_inline u32
+ip4_rewrite_n_same_adj (vlib_buffer_t **b, u32 n_left)
+{
+  u32 adj_index = vnet_buffer (b[0])->ip.adj_index[VLIB_TX];
+  u32 n = 1;
+
+  while (n < n_left && vnet_buffer (b[n])->ip.adj_index[VLIB_TX] == adj_index)
+    n++;
+
+  return n;
+}
+
+/* Rewrite a run of packets that share one adjacency. The adjacency is read
+ * once, its rewrite string is kept in vector registers and the adjacency
+ * counter is bumped once for the whole run. */
+static_always_inline void
+ip4_rewrite_adj_run (vlib_main_t *vm, vlib_node_runtime_t *error_node,
+		     vlib_buffer_t **b, u16 *next, u32 n_left,
+		     int do_counters)
+{
+  ip_lookup_main_t *lm = &ip4_main.lookup_main;
+  u32 adj_index = vnet_buffer (b[0])->ip.adj_index[VLIB_TX];
+  const ip_adjacency_t *adj = adj_get (adj_index);
+  const vnet_rewrite_header_t *rw = &adj->rewrite_header;
+  u32 n_packets = 0, n_bytes = 0;
+  vnet_rewrite_vec_t rwv;
+
+  vnet_rewrite_vec_load (&rwv, rw);
+
+  while (n_left)
+    {
+      ip4_header_t *ip0;
+      u32 error0 = IP4_ERROR_NONE;
+      u16 ip0_len;
+
+      if (n_left > 2)
+	{
+	  u8 *p = vlib_buffer_get_current (b[2]);
+	  clib_prefetch_store (p - CLIB_CACHE_LINE_BYTES);
+	  clib_prefetch_load (p);
+	}
+
+      ip0 = vlib_buffer_get_current (b[0]);
+      ip4_ttl_and_checksum_check (b[0], ip0, next, &error0);
+      vnet_buffer (b[0])->ip.save_rewrite_length = rwv.data_bytes;
+
+      ip0_len = clib_net_to_host_u16 (ip0->length);
+      if (b[0]->flags & VNET_BUFFER_F_GSO)
+	ip0_len = gso_mtu_sz (b[0]);
+
+      ip4_mtu_check (vm, b[0], ip0, ip0_len, rw->max_l3_packet_bytes,
+		     ip0->flags_and_fragment_offset &
+		       clib_host_to_net_u16 (IP4_HEADER_FLAG_DONT_FRAGMENT),
+		     next, 0 /* is_midchain */, &error0);
+
+      if (PREDICT_TRUE (error0 == IP4_ERROR_NONE))
+	{
+	  u32 next_index = rw->next_index;
+
+	  vlib_buffer_advance (b[0], -(word) rwv.data_bytes);
+	  vnet_buffer (b[0])->sw_if_index[VLIB_TX] = rw->sw_if_index;
+
+	  if (PREDICT_FALSE (rw->flags & VNET_REWRITE_HAS_FEATURES))
+	    vnet_feature_arc_start_w_cfg_index (lm->output_feature_arc_index,
+						rw->sw_if_index, &next_index,
+						b[0], adj->ia_cfg_index);
+	  next[0] = next_index;
+
+	  vnet_rewrite_vec_store (&rwv, ip0);
+
+	  if (do_counters)
+	    {
+	      n_packets++;
+	      n_bytes += vlib_buffer_length_in_chain (vm, b[0]) +
+			 rwv.data_bytes;
+	    }
+	}
+      else
+	{
+	  b[0]->error = error_node->errors[error0];
+	  if (error0 == IP4_ERROR_MTU_EXCEEDED)
+	    ip4_ttl_inc (b[0], ip0);
+	}
+
+      next += 1;
+      b += 1;
+      n_left -= 1;
+    }
+
+  if (do_counters && n_packets)
+    vlib_increment_combined_counter (&adjacency_counters, vm->thread_index,
+				     adj_index, n_packets, n_bytes);
+}
+
 always_inline uword
 ip4_rewrite_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 		    vlib_frame_t *frame, int do_counters, int is_midchain,
@@ -2158,6 +2265,21 @@ ip4_rewrite_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       adj_index0 = vnet_buffer (b[0])->ip.adj_index[VLIB_TX];
       adj_index1 = vnet_buffer (b[1])->ip.adj_index[VLIB_TX];
 
+      if (!is_midchain && !is_mcast && adj_index0 == adj_index1)
+	{
+	  u32 n_run = ip4_rewrite_n_same_adj (b, n_left_from);
+
+	  if (n_run >= IP4_REWRITE_MIN_RUN)
+	    {
+	      ip4_rewrite_adj_run (vm, error_node, b, next, n_run,
+				   do_counters);
+	      next += n_run;
+	      b += n_run;
+	      n_left_from -= n_run;
+	      continue;
+	    }
+	}
+
       /*
        * pre-fetch the per-adjacency counters
        */
@@ -2204,12 +2326,12 @@ ip4_rewrite_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       if (b[1]->flags & VNET_BUFFER_F_GSO)
 	ip1_len = gso_mtu_sz (b[1]);
 
-      ip4_mtu_check (b[0], ip0_len,
+      ip4_mtu_check (vm, b[0], ip0, ip0_len,
 		     adj0[0].rewrite_header.max_l3_packet_bytes,
 		     ip0->flags_and_fragment_offset &
 		     clib_host_to_net_u16 (IP4_HEADER_FLAG_DONT_FRAGMENT),
 		     next + 0, is_midchain, &error0);
-      ip4_mtu_check (b[1], ip1_len,
+      ip4_mtu_check (vm, b[1], ip1, ip1_len,
 		     adj1[0].rewrite_header.max_l3_packet_bytes,
 		     ip1->flags_and_fragment_offset &
 		     clib_host_to_net_u16 (IP4_HEADER_FLAG_DONT_FRAGMENT),
@@ -2388,7 +2510,7 @@ ip4_rewrite_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       if (b[0]->flags & VNET_BUFFER_F_GSO)
 	ip0_len = gso_mtu_sz (b[0]);
 
-      ip4_mtu_check (b[0], ip0_len,
+      ip4_mtu_check (vm, b[0], ip0, ip0_len,
 		     adj0[0].rewrite_header.max_l3_packet_bytes,
 		     ip0->flags_and_fragment_offset &
 		     clib_host_to_net_u16 (IP4_HEADER_FLAG_DONT_FRAGMENT),
@@ -2494,7 +2616,7 @@ ip4_rewrite_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       if (b[0]->flags & VNET_BUFFER_F_GSO)
 	ip0_len = gso_mtu_sz (b[0]);
 
-      ip4_mtu_check (b[0], ip0_len,
+      ip4_mtu_check (vm, b[0], ip0, ip0_len,
 		     adj0[0].rewrite_header.max_l3_packet_bytes,
 		     ip0->flags_and_fragment_offset &
 		     clib_host_to_net_u16 (IP4_HEADER_FLAG_DONT_FRAGMENT),
@@ -42,6 +42,7 @@
 
 #include <vppinfra/cache.h>
 #include <vnet/fib/ip4_fib.h>
+#include <vnet/fib/ip4_fib_cache.h>
 #include <vnet/dpo/load_balance_map.h>
 #include <vnet/ip/ip4_inlines.h>
 
@@ -371,6 +372,123 @@ ip4_lookup_inline (vlib_main_t * vm,
   return frame->n_vectors;
 }
 
+/**
+ * @brief ip4-lookup through the per-thread forwarding cache.
+ *
+ * Packets hitting an entry skip the mtrie walk and, for single bucket
+ * load-balances, the load-balance fetch too. See ip4_fib_cache.h.
+ */
+always_inline uword
+ip4_lookup_cached_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
+			  vlib_frame_t *frame)
+{
+  ip4_main_t *im = &ip4_main;
+  ip4_fib_cache_per_thread_t *fcpt;
+  vlib_combined_counter_main_t *cm = &load_balance_main.lbm_to_counters;
+  u32 n_left, *from, epoch, n_hits = 0;
+  u32 thread_index = vm->thread_index;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
+  ip4_fib_cache_entry_t *entries[VLIB_FRAME_SIZE], **fce;
+  u16 nexts[VLIB_FRAME_SIZE], *next;
+
+  fcpt = vec_elt_at_index (ip4_fib_cache_main.fcm_per_thread, thread_index);
+
+  /* read the epoch before doing any lookup whose result is cached */
+  epoch = ip4_fib_cache_epoch ();
+
+  from = vlib_frame_vector_args (frame);
+  n_left = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left);
+
+  /* find, and prefetch, each packet's cache entry */
+  for (u32 i = 0; i < n_left; i++)
+    {
+      ip4_header_t *ip0;
+
+      if (i + 8 < n_left)
+	vlib_prefetch_buffer_header (bufs[i + 8], LOAD);
+      if (i + 4 < n_left)
+	vlib_prefetch_buffer_data (bufs[i + 4], LOAD);
+
+      ip0 = vlib_buffer_get_current (bufs[i]);
+      ip_lookup_set_buffer_fib_index (im->fib_index_by_sw_if_index, bufs[i]);
+      entries[i] = ip4_fib_cache_get_entry (
+	fcpt, vnet_buffer (bufs[i])->ip.fib_index, &ip0->dst_address);
+      clib_prefetch_store (entries[i]);
+    }
+
+  b = bufs;
+  next = nexts;
+  fce = entries;
+  while (n_left > 0)
+    {
+      ip4_header_t *ip0;
+      const load_balance_t *lb0;
+      const dpo_id_t *dpo0;
+      u32 lbi0, fib_index0, hash_c0;
+
+      ip0 = vlib_buffer_get_current (b[0]);
+      fib_index0 = vnet_buffer (b[0])->ip.fib_index;
+      vnet_buffer (b[0])->ip.flow_hash = 0;
+
+      if (PREDICT_TRUE (ip4_fib_cache_entry_match (
+	    fce[0], fib_index0, &ip0->dst_address, epoch)))
+	{
+	  lbi0 = fce[0]->fce_lbi;
+	  n_hits++;
+	}
+      else
+	{
+	  lbi0 = ip4_fib_forwarding_lookup (fib_index0, &ip0->dst_address);
+	  ASSERT (lbi0);
+	  lb0 = load_balance_get (lbi0);
+
+	  fce[0]->fce_dst = ip0->dst_address;
+	  fce[0]->fce_fib_index = fib_index0;
+	  fce[0]->fce_epoch = epoch;
+	  fce[0]->fce_lbi = lbi0;
+	  if (1 == lb0->lb_n_buckets)
+	    fce[0]->fce_dpo = *load_balance_get_bucket_i (lb0, 0);
+	  else
+	    fce[0]->fce_dpo = (dpo_id_t) DPO_INVALID;
+	}
+
+      if (PREDICT_TRUE (dpo_id_is_valid (&fce[0]->fce_dpo)))
+	dpo0 = &fce[0]->fce_dpo;
+      else
+	{
+	  /* Use flow hash to compute multipath adjacency. */
+	  lb0 = load_balance_get (lbi0);
+	  ASSERT (is_pow2 (lb0->lb_n_buckets));
+	  hash_c0 = vnet_buffer (b[0])->ip.flow_hash =
+	    ip4_compute_flow_hash (ip0, lb0->lb_hash_config);
+	  dpo0 = load_balance_get_fwd_bucket (
+	    lb0, (hash_c0 & (lb0->lb_n_buckets_minus_1)));
+	}
+
+      next[0] = dpo0->dpoi_next_node;
+      vnet_buffer (b[0])->ip.adj_index[VLIB_TX] = dpo0->dpoi_index;
+
+      vlib_increment_combined_counter (cm, thread_index, lbi0, 1,
+				       vlib_buffer_length_in_chain (vm, b[0]));
+
+      b += 1;
+      next += 1;
+      fce += 1;
+      n_left -= 1;
+    }
+
+  fcpt->fcpt_hits += n_hits;
+  fcpt->fcpt_misses += frame->n_vectors - n_hits;
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+
+  if (node->flags & VLIB_NODE_FLAG_TRACE)
+    ip4_forward_next_trace (vm, node, frame, VLIB_TX);
+
+  return frame->n_vectors;
+}
+
 #endif /* __included_ip4_forward_h__ */
 
 /*
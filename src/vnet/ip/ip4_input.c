@@ -223,18 +223,26 @@ ip4_input_inline (vlib_main_t * vm,
 	  next[3] = ip4_input_set_next (sw_if_index[3], b[3], 1);
 	}
 
+#if !defined(CLIB_HAVE_VEC256)
       ip[0] = vlib_buffer_get_current (b[0]);
       ip[1] = vlib_buffer_get_current (b[1]);
       ip[2] = vlib_buffer_get_current (b[2]);
       ip[3] = vlib_buffer_get_current (b[3]);
 
       ip4_input_check_x4 (vm, error_node, b, ip, next, verify_checksum);
+#endif
 
       /* next */
       b += 4;
       next += 4;
       n_left_from -= 4;
     }
+
+#if defined(CLIB_HAVE_VEC256)
+  /* headers of the packets handled above are validated 8 at a time */
+  ip4_input_check_frame (vm, error_node, bufs, nexts, b - bufs,
+			 verify_checksum);
+#endif
 #elif (CLIB_N_PREFETCHES >= 4)
   while (n_left_from >= 2)
     {
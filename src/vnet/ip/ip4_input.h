@@ -326,6 +326,98 @@ ip4_input_check_x1 (vlib_main_t * vm,
     }
 }
 
+#if defined(CLIB_HAVE_VEC256)
+/* Validate 8 headers at once. Version/IHL, TTL, fragment offset, length
+ * and checksum are checked with vector compares; only packets flagged in the
+ * resulting per-lane mask take the scalar path to pick error and next. */
+always_inline void
+ip4_input_check_x8 (vlib_main_t *vm, vlib_node_runtime_t *error_node,
+		    vlib_buffer_t **p, u16 *next, int verify_checksum)
+{
+  ip4_header_t *ip[8];
+  u32 cur_len[8];
+  u32x8 w0, w1, w2, ip_len, bad;
+
+  for (int i = 0; i < 8; i++)
+    {
+      ip[i] = vlib_buffer_get_current (p[i]);
+      cur_len[i] = vlib_buffer_length_in_chain (vm, p[i]);
+    }
+
+  /* ver/ihl, tos, length */
+  w0 = u32x8_gather (ip[0], ip[1], ip[2], ip[3], ip[4], ip[5], ip[6], ip[7]);
+  /* fragment id, flags and fragment offset */
+  w1 = u32x8_gather (&ip[0]->fragment_id, &ip[1]->fragment_id,
+		     &ip[2]->fragment_id, &ip[3]->fragment_id,
+		     &ip[4]->fragment_id, &ip[5]->fragment_id,
+		     &ip[6]->fragment_id, &ip[7]->fragment_id);
+  /* ttl, protocol, checksum */
+  w2 = u32x8_gather (&ip[0]->ttl, &ip[1]->ttl, &ip[2]->ttl, &ip[3]->ttl,
+		     &ip[4]->ttl, &ip[5]->ttl, &ip[6]->ttl, &ip[7]->ttl);
+
+  ip_len = (w0 >> 24) | ((w0 >> 8) & u32x8_splat (0xff00));
+
+  bad = (u32x8) ((w0 & u32x8_splat (0xff)) != u32x8_splat (0x45));
+  bad |= (u32x8) ((w2 & u32x8_splat (0xff)) == u32x8_splat (0));
+  bad |= (u32x8) ((w1 & u32x8_splat (0xff1f0000)) ==
+		  u32x8_splat (0x01000000));
+  bad |= (u32x8) (ip_len < u32x8_splat (sizeof (ip4_header_t)));
+  bad |= (u32x8) (ip_len > u32x8_load_unaligned (cur_len));
+
+  if (verify_checksum)
+    bad |= (u32x8) (clib_ip_csum_hdr20_x8 ((u8 *) ip[0], (u8 *) ip[1],
+					   (u8 *) ip[2], (u8 *) ip[3],
+					   (u8 *) ip[4], (u8 *) ip[5],
+					   (u8 *) ip[6], (u8 *) ip[7]) !=
+		    u32x8_splat (0));
+
+  if (PREDICT_TRUE (u32x8_is_all_zero (bad)))
+    return;
+
+  for (int i = 0; i < 8; i++)
+    if (bad[i])
+      {
+	u32 next0 = next[i];
+	ip4_input_check_x1 (vm, error_node, p[i], ip[i], &next0,
+			    verify_checksum);
+	next[i] = next0;
+      }
+}
+#endif
+
+/* Validate a run of packets whose next nodes are already known, n_left must
+ * be a multiple of 4. */
+always_inline void
+ip4_input_check_frame (vlib_main_t *vm, vlib_node_runtime_t *error_node,
+		       vlib_buffer_t **b, u16 *next, u32 n_left,
+		       int verify_checksum)
+{
+  ip4_header_t *ip[4];
+
+#if defined(CLIB_HAVE_VEC256)
+  while (n_left >= 8)
+    {
+      ip4_input_check_x8 (vm, error_node, b, next, verify_checksum);
+      b += 8;
+      next += 8;
+      n_left -= 8;
+    }
+#endif
+
+  while (n_left >= 4)
+    {
+      ip[0] = vlib_buffer_get_current (b[0]);
+      ip[1] = vlib_buffer_get_current (b[1]);
+      ip[2] = vlib_buffer_get_current (b[2]);
+      ip[3] = vlib_buffer_get_current (b[3]);
+
+      ip4_input_check_x4 (vm, error_node, b, ip, next, verify_checksum);
+      b += 4;
+      next += 4;
+      n_left -= 4;
+    }
+}
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2024 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/ip/ip4_pmtu_cache.h>
+#include <vnet/ip/icmp4.h>
+#include <vnet/fib/ip4_fib.h>
+#include <vnet/dpo/load_balance.h>
+#include <vnet/dpo/receive_dpo.h>
+
+ip4_pmtu_cache_main_t ip4_pmtu_cache_main;
+
+extern vlib_node_registration_t ip4_icmp_dest_unreach_node;
+
+static void
+ip4_pmtu_cache_free_entries (void)
+{
+  ip4_pmtu_cache_main_t *ipcm = &ip4_pmtu_cache_main;
+  ip4_pmtu_cache_per_thread_t *ipcpt;
+
+  vec_foreach (ipcpt, ipcm->ipcm_per_thread)
+    vec_free (ipcpt->ipcpt_entries);
+  vec_free (ipcm->ipcm_per_thread);
+}
+
+/**
+ * @brief Enable (or resize) the cache. Runs with the workers stopped.
+ */
+clib_error_t *
+ip4_pmtu_cache_enable (vlib_main_t *vm, u32 n_entries, u16 timeout)
+{
+  ip4_pmtu_cache_main_t *ipcm = &ip4_pmtu_cache_main;
+  ip4_pmtu_cache_per_thread_t *ipcpt;
+  u32 log2_size;
+
+  if (0 == n_entries)
+    return clib_error_return (0, "cache size must be non-zero");
+  if (0 == timeout)
+    return clib_error_return (0, "timeout must be non-zero");
+
+  log2_size = max_log2 (n_entries);
+  if (log2_size > 20)
+    return clib_error_return (0, "cache size %u too large", n_entries);
+
+  /*
+   * destination unreachable messages are punted unless something claims
+   * them; only claim them while enabled and when nothing else has. The
+   * learning node passes them on to the punt node afterwards.
+   */
+  if (!ipcm->ipcm_registered)
+    {
+      if (ip4_icmp_type_is_registered (ICMP4_destination_unreachable))
+	return clib_error_return (
+	  0, "ICMP destination unreachable is already handled elsewhere");
+      ip4_icmp_register_type (vm, ICMP4_destination_unreachable,
+			      ip4_icmp_dest_unreach_node.index);
+      ipcm->ipcm_registered = 1;
+    }
+
+  ip4_pmtu_cache_free_entries ();
+
+  vec_validate_aligned (ipcm->ipcm_per_thread, vlib_get_n_threads () - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (ipcpt, ipcm->ipcm_per_thread)
+    vec_validate_aligned (ipcpt->ipcpt_entries, (1 << log2_size) - 1,
+			  CLIB_CACHE_LINE_BYTES);
+
+  ipcm->ipcm_mask = (1 << log2_size) - 1;
+  ipcm->ipcm_timeout = timeout;
+  ipcm->ipcm_enabled = 1;
+
+  return (NULL);
+}
+
+void
+ip4_pmtu_cache_disable (vlib_main_t *vm)
+{
+  ip4_pmtu_cache_main_t *ipcm = &ip4_pmtu_cache_main;
+
+  ipcm->ipcm_enabled = 0;
+  ip4_pmtu_cache_free_entries ();
+
+  if (ipcm->ipcm_registered)
+    {
+      ip4_icmp_unregister_type (vm, ICMP4_destination_unreachable);
+      ipcm->ipcm_registered = 0;
+    }
+}
+
+/**
+ * @brief Record the path MTU to a destination in every thread's table.
+ *
+ * An entry is only replaced by a lower MTU, by another destination or once
+ * it has expired. MTUs below IP4_PMTU_CACHE_MIN_MTU are raised to it.
+ */
+void
+ip4_pmtu_cache_learn (vlib_main_t *vm, const ip4_address_t *dst, u16 pmtu)
+{
+  ip4_pmtu_cache_main_t *ipcm = &ip4_pmtu_cache_main;
+  ip4_pmtu_cache_per_thread_t *ipcpt;
+  ip4_pmtu_cache_entry_t ipce, *e;
+
+  if (!ipcm->ipcm_enabled)
+    return;
+
+  pmtu = clib_max (pmtu, IP4_PMTU_CACHE_MIN_MTU);
+
+  ipcpt = vec_elt_at_index (ipcm->ipcm_per_thread, vm->thread_index);
+  e = ip4_pmtu_cache_get_entry (ipcpt, dst);
+
+  if (ip4_pmtu_cache_entry_read (e, &ipce) &&
+      ip4_pmtu_cache_entry_valid (vm, &ipce, dst) && ipce.ipce_pmtu <= pmtu)
+    return;
+
+  clib_memset (&ipce, 0, sizeof (ipce));
+  ipce.ipce_dst = *dst;
+  ipce.ipce_pmtu = pmtu;
+  ipce.ipce_learnt = ip4_pmtu_cache_now (vm);
+
+  /* readers discard the entry while the word is clear or has changed */
+  vec_foreach (ipcpt, ipcm->ipcm_per_thread)
+    {
+      e = ip4_pmtu_cache_get_entry (ipcpt, dst);
+      clib_atomic_store_rel_n (&e->as_u64, 0);
+      clib_atomic_store_rel_n (&e->ipce_learnt, ipce.ipce_learnt);
+      clib_atomic_store_rel_n (&e->as_u64, ipce.as_u64);
+    }
+}
+
+/**
+ * @brief Whether a frag-needed message quotes a packet this host sent and
+ * could not have fitted in the reported MTU; anything else is forged or
+ * stale and must not lower the path MTU.
+ */
+static_always_inline int
+ip4_pmtu_cache_inner_is_ours (vlib_buffer_t *b, const ip4_header_t *inner,
+			      u16 pmtu)
+{
+  const load_balance_t *lb;
+  const dpo_id_t *dpo;
+  u32 fib_index;
+
+  if (!(inner->flags_and_fragment_offset &
+	clib_host_to_net_u16 (IP4_HEADER_FLAG_DONT_FRAGMENT)))
+    return (0);
+  if (clib_net_to_host_u16 (inner->length) <= pmtu)
+    return (0);
+
+  fib_index = vec_elt (ip4_main.fib_index_by_sw_if_index,
+		       vnet_buffer (b)->sw_if_index[VLIB_RX]);
+  lb = load_balance_get (
+    ip4_fib_forwarding_lookup (fib_index, &inner->src_address));
+  dpo = load_balance_get_bucket_i (lb, 0);
+
+  return (DPO_RECEIVE == dpo->dpoi_type);
+}
+
+u8 *
+format_ip4_pmtu_cache (u8 *s, va_list *args)
+{
+  ip4_pmtu_cache_main_t *ipcm = &ip4_pmtu_cache_main;
+  vlib_main_t *vm = va_arg (*args, vlib_main_t *);
+  int verbose = va_arg (*args, int);
+  ip4_pmtu_cache_per_thread_t *ipcpt;
+  ip4_pmtu_cache_entry_t *ipce;
+  u32 n_valid = 0;
+
+  if (!ipcm->ipcm_enabled)
+    return format (s, "ip4 path-mtu cache: disabled");
+
+  s = format (s, "ip4 path-mtu cache: %u entries per thread, timeout %us",
+	      ipcm->ipcm_mask + 1, ipcm->ipcm_timeout);
+
+  vec_foreach (ipcpt, ipcm->ipcm_per_thread)
+    s = format (s, "\n  thread %u: hits %llu", ipcpt - ipcm->ipcm_per_thread,
+		ipcpt->ipcpt_hits);
+
+  /* all tables hold the same entries */
+  ipcpt = vec_elt_at_index (ipcm->ipcm_per_thread, 0);
+  vec_foreach (ipce, ipcpt->ipcpt_entries)
+    {
+      if (!ip4_pmtu_cache_entry_valid (vm, ipce, &ipce->ipce_dst))
+	continue;
+      n_valid++;
+      if (verbose)
+	s = format (s, "\n  %U mtu %u age %us", format_ip4_address,
+		    &ipce->ipce_dst, ipce->ipce_pmtu,
+		    ip4_pmtu_cache_now (vm) - ipce->ipce_learnt);
+    }
+  s = format (s, "\n  %u valid entries", n_valid);
+
+  return (s);
+}
+
+typedef struct ip4_icmp_dest_unreach_trace_t_
+{
+  ip4_address_t dst;
+  u16 pmtu;
+  u8 code;
+} ip4_icmp_dest_unreach_trace_t;
+
+static u8 *
+format_ip4_icmp_dest_unreach_trace (u8 *s, va_list *args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  ip4_icmp_dest_unreach_trace_t *t =
+    va_arg (*args, ip4_icmp_dest_unreach_trace_t *);
+
+  s = format (s, "code %u dst %U path-mtu %u", t->code, format_ip4_address,
+	      &t->dst, t->pmtu);
+
+  return s;
+}
+
+typedef enum
+{
+  IP4_ICMP_DEST_UNREACH_NEXT_PUNT,
+  IP4_ICMP_DEST_UNREACH_N_NEXT,
+} ip4_icmp_dest_unreach_next_t;
+
+VLIB_NODE_FN (ip4_icmp_dest_unreach_node)
+(vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)
+{
+  u32 n_left, *from;
+
+  from = vlib_frame_vector_args (frame);
+  n_left = frame->n_vectors;
+
+  while (n_left > 0)
+    {
+      ip4_header_t *ip0, *inner0;
+      icmp46_header_t *icmp0;
+      vlib_buffer_t *b0;
+      u16 pmtu0 = 0;
+
+      b0 = vlib_get_buffer (vm, from[0]);
+      ip0 = vlib_buffer_get_current (b0);
+      icmp0 = ip4_next_header (ip0);
+      inner0 = (ip4_header_t *) ((u8 *) (icmp0 + 1) + sizeof (u32));
+
+      /* the next-hop MTU is the low half of the 4 byte data field */
+      if (icmp0->code ==
+	    ICMP4_destination_unreachable_fragmentation_needed_and_dont_fragment_set &&
+	  b0->current_length >=
+	    (u8 *) (inner0 + 1) - (u8 *) vlib_buffer_get_current (b0))
+	{
+	  pmtu0 = clib_net_to_host_u32 (*(u32 *) (icmp0 + 1));
+	  if (ip4_pmtu_cache_inner_is_ours (b0, inner0, pmtu0))
+	    ip4_pmtu_cache_learn (vm, &inner0->dst_address, pmtu0);
+	}
+
+      if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
+	{
+	  ip4_icmp_dest_unreach_trace_t *t;
+
+	  t = vlib_add_trace (vm, node, b0, sizeof (*t));
+	  t->code = icmp0->code;
+	  t->pmtu = pmtu0;
+	  t->dst.as_u32 = pmtu0 ? inner0->dst_address.as_u32 : 0;
+	}
+
+      from += 1;
+      n_left -= 1;
+    }
+
+  vlib_buffer_enqueue_to_single_next (vm, node, vlib_frame_vector_args (frame),
+				      IP4_ICMP_DEST_UNREACH_NEXT_PUNT,
+				      frame->n_vectors);
+
+  return frame->n_vectors;
+}
+
+VLIB_REGISTER_NODE (ip4_icmp_dest_unreach_node) = {
+  .name = "ip4-icmp-dest-unreach",
+  .vector_size = sizeof (u32),
+  .format_trace = format_ip4_icmp_dest_unreach_trace,
+  .n_next_nodes = IP4_ICMP_DEST_UNREACH_N_NEXT,
+  .next_nodes = {
+    [IP4_ICMP_DEST_UNREACH_NEXT_PUNT] = "ip4-punt",
+  },
+};
+
+static clib_error_t *
+ip4_pmtu_cache_set_cmd (vlib_main_t *vm, unformat_input_t *input,
+			vlib_cli_command_t *cmd)
+{
+  u32 n_entries = IP4_PMTU_CACHE_DEFAULT_SIZE;
+  u32 timeout = IP4_PMTU_CACHE_DEFAULT_TIMEOUT;
+  int disable = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "size %u", &n_entries))
+	;
+      else if (unformat (input, "timeout %u", &timeout))
+	;
+      else if (unformat (input, "disable"))
+	disable = 1;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  if (disable)
+    {
+      ip4_pmtu_cache_disable (vm);
+      return (NULL);
+    }
+
+  if (timeout > 0xffff)
+    return clib_error_return (0, "timeout %u too large", timeout);
+
+  return (ip4_pmtu_cache_enable (vm, n_entries, timeout));
+}
+
+/*?
+ * Enables, resizes or disables the cache of IPv4 path MTUs learnt from
+ * ICMP fragmentation needed messages. While enabled, ip4-rewrite
+ * fragments packets to a cached destination to its path MTU.
+ *
+ * @cliexpar
+ * @cliexcmd{set ip path-mtu cache size 4096 timeout 600}
+ * @cliexcmd{set ip path-mtu cache disable}
+ ?*/
+VLIB_CLI_COMMAND (ip4_pmtu_cache_set_command, static) = {
+  .path = "set ip path-mtu cache",
+  .short_help =
+    "set ip path-mtu cache [size <n-entries>] [timeout <secs>] [disable]",
+  .function = ip4_pmtu_cache_set_cmd,
+};
+
+static clib_error_t *
+ip4_pmtu_cache_show_cmd (vlib_main_t *vm, unformat_input_t *input,
+			 vlib_cli_command_t *cmd)
+{
+  int verbose = 0;
+
+  if (unformat (input, "verbose"))
+    verbose = 1;
+
+  vlib_cli_output (vm, "%U", format_ip4_pmtu_cache, vm, verbose);
+
+  return (NULL);
+}
+
+VLIB_CLI_COMMAND (ip4_pmtu_cache_show_command, static) = {
+  .path = "show ip path-mtu cache",
+  .short_help = "show ip path-mtu cache [verbose]",
+  .function = ip4_pmtu_cache_show_cmd,
+};
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2024 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @brief The learnt IPv4 path MTU cache
+ *
+ * Path MTUs learnt from ICMP 'fragmentation needed' messages sent to this
+ * host, i.e. in response to packets it originated, such as the outer
+ * header of tunnelled traffic. ip4-rewrite fragments, or rejects with DF
+ * set, packets to a cached destination larger than its path MTU, rather
+ * than let them be dropped further along the path.
+ *
+ * Each thread has its own direct mapped table; the thread that learns a
+ * path MTU writes it to all tables, so the data plane reads its own table
+ * without locks. A writer clears the destination and MTU word before it
+ * updates the timestamp, and readers discard an entry whose word changed
+ * while they read it. Entries expire after a timeout, so a path MTU only
+ * ever increases again by aging out.
+ *
+ * Only messages quoting a packet this host sent, from one of its own
+ * addresses with DF set and larger than the reported MTU, are learnt, and
+ * the MTU is never lowered below IP4_PMTU_CACHE_MIN_MTU.
+ */
+
+#ifndef __IP4_PMTU_CACHE_H__
+#define __IP4_PMTU_CACHE_H__
+
+#include <vnet/ip/ip.h>
+
+typedef struct ip4_pmtu_cache_entry_t_
+{
+  union
+  {
+    struct
+    {
+      ip4_address_t ipce_dst;
+      /** The learnt path MTU; zero if the entry is not in use */
+      u16 ipce_pmtu;
+      u16 __ipce_pad;
+    };
+    u64 as_u64;
+  };
+  /** When the entry was learnt, in seconds */
+  u32 ipce_learnt;
+} ip4_pmtu_cache_entry_t;
+
+STATIC_ASSERT_SIZEOF (ip4_pmtu_cache_entry_t, 2 * sizeof (u64));
+
+typedef struct ip4_pmtu_cache_per_thread_t_
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  ip4_pmtu_cache_entry_t *ipcpt_entries;
+  u64 ipcpt_hits;
+} ip4_pmtu_cache_per_thread_t;
+
+typedef struct ip4_pmtu_cache_main_t_
+{
+  u8 ipcm_enabled;
+  u8 ipcm_registered;
+  /** Seconds an entry stays valid */
+  u16 ipcm_timeout;
+  u32 ipcm_mask;
+  ip4_pmtu_cache_per_thread_t *ipcm_per_thread;
+} ip4_pmtu_cache_main_t;
+
+extern ip4_pmtu_cache_main_t ip4_pmtu_cache_main;
+
+#define IP4_PMTU_CACHE_DEFAULT_SIZE 4096
+/* RFC 1191: 10 minutes */
+#define IP4_PMTU_CACHE_DEFAULT_TIMEOUT 600
+/*
+ * RFC 791 only guarantees 68 octets, but no real path is that small; the
+ * floor stops forged messages from making us fragment to tiny packets.
+ * Same as the Linux min_pmtu default.
+ */
+#define IP4_PMTU_CACHE_MIN_MTU 552
+
+extern clib_error_t *ip4_pmtu_cache_enable (vlib_main_t *vm, u32 n_entries,
+					    u16 timeout);
+extern void ip4_pmtu_cache_disable (vlib_main_t *vm);
+extern void ip4_pmtu_cache_learn (vlib_main_t *vm, const ip4_address_t *dst,
+				  u16 pmtu);
+
+extern u8 *format_ip4_pmtu_cache (u8 *s, va_list *args);
+
+static_always_inline u32
+ip4_pmtu_cache_now (vlib_main_t *vm)
+{
+  return ((u32) vlib_time_now (vm));
+}
+
+static_always_inline ip4_pmtu_cache_entry_t *
+ip4_pmtu_cache_get_entry (ip4_pmtu_cache_per_thread_t *ipcpt,
+			  const ip4_address_t *dst)
+{
+  u32 hash = (dst->as_u32 * 0x9e3779b1) >> 8;
+
+  return (&ipcpt->ipcpt_entries[hash & ip4_pmtu_cache_main.ipcm_mask]);
+}
+
+static_always_inline int
+ip4_pmtu_cache_entry_valid (vlib_main_t *vm,
+			    const ip4_pmtu_cache_entry_t *ipce,
+			    const ip4_address_t *dst)
+{
+  return (ipce->ipce_dst.as_u32 == dst->as_u32 && ipce->ipce_pmtu &&
+	  ip4_pmtu_cache_now (vm) - ipce->ipce_learnt <
+	    ip4_pmtu_cache_main.ipcm_timeout);
+}
+
+/**
+ * @brief Take a consistent copy of an entry; returns 0 if a writer was
+ * updating it.
+ */
+static_always_inline int
+ip4_pmtu_cache_entry_read (const ip4_pmtu_cache_entry_t *e,
+			   ip4_pmtu_cache_entry_t *ipce)
+{
+  ipce->as_u64 = clib_atomic_load_acq_n (&e->as_u64);
+  ipce->ipce_learnt = clib_atomic_load_acq_n (&e->ipce_learnt);
+
+  return (ipce->as_u64 == clib_atomic_load_relax_n (&e->as_u64));
+}
+
+/**
+ * @brief The MTU to apply to a packet, the lower of the egress MTU and the
+ * learnt path MTU of its destination.
+ */
+static_always_inline u16
+ip4_pmtu_cache_mtu (vlib_main_t *vm, const ip4_header_t *ip, u16 mtu)
+{
+  ip4_pmtu_cache_main_t *ipcm = &ip4_pmtu_cache_main;
+  ip4_pmtu_cache_per_thread_t *ipcpt;
+  ip4_pmtu_cache_entry_t ipce, *e;
+
+  if (PREDICT_TRUE (!ipcm->ipcm_enabled))
+    return (mtu);
+
+  ipcpt = vec_elt_at_index (ipcm->ipcm_per_thread, vm->thread_index);
+  e = ip4_pmtu_cache_get_entry (ipcpt, &ip->dst_address);
+  ipce.as_u64 = clib_atomic_load_relax_n (&e->as_u64);
+
+  if (PREDICT_TRUE (ipce.ipce_dst.as_u32 != ip->dst_address.as_u32 ||
+		    ipce.ipce_pmtu >= mtu))
+    return (mtu);
+
+  if (!ip4_pmtu_cache_entry_read (e, &ipce) ||
+      !ip4_pmtu_cache_entry_valid (vm, &ipce, &ip->dst_address) ||
+      ipce.ipce_pmtu >= mtu)
+    return (mtu);
+
+  ipcpt->ipcpt_hits++;
+
+  return (ipce.ipce_pmtu);
+}
+
+#endif
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
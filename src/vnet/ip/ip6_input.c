@@ -61,6 +61,30 @@ format_ip6_input_trace (u8 * s, va_list * va)
   return s;
 }
 
+static_always_inline u32
+ip6_input_set_next (vlib_buffer_t *b, ip6_header_t *ip)
+{
+  ip_lookup_main_t *lm = &ip6_main.lookup_main;
+  u32 sw_if_index = vnet_buffer (b)->sw_if_index[VLIB_RX];
+  u32 next;
+  u8 arc;
+
+  if (PREDICT_FALSE (ip6_address_is_multicast (&ip->dst_address)))
+    {
+      arc = lm->mcast_feature_arc_index;
+      next = IP6_INPUT_NEXT_LOOKUP_MULTICAST;
+    }
+  else
+    {
+      arc = lm->ucast_feature_arc_index;
+      next = IP6_INPUT_NEXT_LOOKUP;
+    }
+
+  vnet_buffer (b)->ip.adj_index[VLIB_RX] = ~0;
+  vnet_feature_arc_start (arc, sw_if_index, &next, b);
+  return next;
+}
+
 /* Validate IP v6 packets and pass them either to forwarding code
    or drop exception packets. */
 VLIB_NODE_FN (ip6_input_node) (vlib_main_t * vm, vlib_node_runtime_t * node,
@@ -94,6 +118,49 @@ VLIB_NODE_FN (ip6_input_node) (vlib_main_t * vm, vlib_node_runtime_t * node,
 
       vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
 
+#if defined(CLIB_HAVE_VEC128)
+      while (n_left_from >= 8 && n_left_to_next >= 4)
+	{
+	  vlib_buffer_t *p[4];
+	  ip6_header_t *ip[4];
+	  u32 next[4], *bi = from;
+
+	  /* Prefetch next iteration. */
+	  {
+	    vlib_buffer_t *pf[4];
+
+	    vlib_get_buffers (vm, from + 4, pf, 4);
+	    for (int i = 0; i < 4; i++)
+	      {
+		vlib_prefetch_buffer_header (pf[i], LOAD);
+		CLIB_PREFETCH (pf[i]->data, sizeof (ip[0][0]), LOAD);
+	      }
+	  }
+
+	  vlib_get_buffers (vm, from, p, 4);
+	  clib_memcpy_fast (to_next, from, 4 * sizeof (from[0]));
+	  from += 4;
+	  to_next += 4;
+	  n_left_from -= 4;
+	  n_left_to_next -= 4;
+
+	  for (int i = 0; i < 4; i++)
+	    {
+	      ip[i] = vlib_buffer_get_current (p[i]);
+	      next[i] = ip6_input_set_next (p[i], ip[i]);
+	      vlib_increment_simple_counter (
+		cm, thread_index, vnet_buffer (p[i])->sw_if_index[VLIB_RX], 1);
+	    }
+
+	  ip6_input_check_x4 (vm, error_node, p, ip, next);
+
+	  vlib_validate_buffer_enqueue_x4 (vm, node, next_index, to_next,
+					   n_left_to_next, bi[0], bi[1], bi[2],
+					   bi[3], next[0], next[1], next[2],
+					   next[3]);
+	}
+#endif
+
       while (n_left_from >= 4 && n_left_to_next >= 2)
 	{
 	  vlib_buffer_t *p0, *p1;
@@ -157,6 +157,36 @@ ip6_input_check_x1 (vlib_main_t * vm,
     }
 }
 
+#if defined(CLIB_HAVE_VEC128)
+/* Validate 4 headers at once with vector compares, packets flagged in the
+ * resulting per-lane mask take the scalar path to pick the next node. */
+always_inline void
+ip6_input_check_x4 (vlib_main_t *vm, vlib_node_runtime_t *error_node,
+		    vlib_buffer_t **p, ip6_header_t **ip, u32 *next)
+{
+  u32x4 w0, w1, cur_len, bad;
+
+  /* version, traffic class and flow label */
+  w0 = u32x4_gather (ip[0], ip[1], ip[2], ip[3]);
+  /* payload length, protocol and hop limit */
+  w1 = u32x4_gather (&ip[0]->payload_length, &ip[1]->payload_length,
+		     &ip[2]->payload_length, &ip[3]->payload_length);
+  cur_len = (u32x4){ p[0]->current_length, p[1]->current_length,
+		     p[2]->current_length, p[3]->current_length };
+
+  bad = (u32x4) ((w0 & u32x4_splat (0xf0)) != u32x4_splat (0x60));
+  bad |= (u32x4) ((w1 >> 24) == u32x4_splat (0));
+  bad |= (u32x4) (cur_len < u32x4_splat (sizeof (ip6_header_t)));
+
+  if (PREDICT_TRUE (u32x4_is_all_zero (bad)))
+    return;
+
+  for (int i = 0; i < 4; i++)
+    if (bad[i])
+      ip6_input_check_x1 (vm, error_node, p[i], ip[i], next + i);
+}
+#endif
+
 #endif
 
 /*
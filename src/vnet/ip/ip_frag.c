@@ -231,6 +231,262 @@ ip4_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
   return IP_FRAG_ERROR_NONE;
 }
 
+/*
+ * Upper bound on the number of buffers in a packet that is fragmented
+ * without copying; longer chains take the copying path.
+ */
+#define IP4_FRAG_ZC_MAX_SEGMENTS 32
+
+static_always_inline void
+frag_buffer_link (vlib_buffer_t *tail, u32 bi)
+{
+  tail->next_buffer = bi;
+  tail->flags |= VLIB_BUFFER_NEXT_PRESENT;
+}
+
+/*
+ * Zero-copy variant of ip4_frag_do_fragment.
+ *
+ * The original buffer becomes the first fragment and every other fragment
+ * is a freshly allocated buffer holding only the copied headers, chained to
+ * the buffers of the original packet that carry its payload. Payload is
+ * copied only where a buffer straddles a fragment boundary, and then only
+ * the smaller side of the split when the buffer in front has room for it.
+ *
+ * Only chained packets gain much: a buffer cannot point into another
+ * buffer's data, so for a packet held in a single buffer just the first
+ * fragment stays in place and the payload of every other fragment is still
+ * copied, as ip4_frag_do_fragment would.
+ *
+ * When the packet is split in place its first buffer is the first fragment
+ * returned and must not be freed by the caller. Packets that are shared
+ * (cloned), carry pending checksum offloads or are chained too deeply fall
+ * back to the copying path, after which the caller frees the original as it
+ * would after ip4_frag_do_fragment. On error the packet is left untouched.
+ */
+ip_frag_error_t
+ip4_frag_do_fragment_zc (vlib_main_t *vm, u32 from_bi, u16 mtu,
+			 u16 l2unfragmentablesize, u32 **buffer)
+{
+  u32 segs[IP4_FRAG_ZC_MAX_SEGMENTS], n_segs, n_frags, *bis, bi, i, s;
+  vlib_buffer_t *from_b, *b, *sb, *fb, *tail;
+  ip4_header_t *ip4, *to_ip4;
+  u16 len, max, rem, ip_frag_id, ip_frag_offset, head_bytes, fo;
+  u16 so, sl, need, take;
+  u8 *org_from_packet, more, sb_linked;
+
+  from_b = vlib_get_buffer (vm, from_bi);
+  org_from_packet = vlib_buffer_get_current (from_b);
+  ip4 = vlib_buffer_get_current (from_b) + l2unfragmentablesize;
+
+  rem = clib_net_to_host_u16 (ip4->length) - sizeof (ip4_header_t);
+  head_bytes = sizeof (ip4_header_t) + l2unfragmentablesize;
+
+  if (rem >
+      (vlib_buffer_length_in_chain (vm, from_b) - sizeof (ip4_header_t)))
+    return IP_FRAG_ERROR_MALFORMED;
+
+  if (mtu < sizeof (ip4_header_t))
+    return IP_FRAG_ERROR_CANT_FRAGMENT_HEADER;
+
+  if (ip4->flags_and_fragment_offset &
+      clib_host_to_net_u16 (IP4_HEADER_FLAG_DONT_FRAGMENT))
+    return IP_FRAG_ERROR_DONT_FRAGMENT_SET;
+
+  /* collect the segments, checking the packet can be split in place */
+  n_segs = 0;
+  bi = from_bi;
+  b = from_b;
+  if (rem && mtu >= head_bytes + 8 && from_b->current_length >= head_bytes &&
+      !(from_b->flags & VNET_BUFFER_F_OFFLOAD))
+    while (n_segs < ARRAY_LEN (segs) && b->ref_count == 1 &&
+	   (n_segs == 0 || b->current_length))
+      {
+	segs[n_segs++] = bi;
+	if (!(b->flags & VLIB_BUFFER_NEXT_PRESENT))
+	  {
+	    bi = ~0;
+	    break;
+	  }
+	bi = b->next_buffer;
+	b = vlib_get_buffer (vm, bi);
+      }
+
+  if (n_segs == 0 || bi != ~0)
+    return ip4_frag_do_fragment (vm, from_bi, mtu, l2unfragmentablesize,
+				 buffer);
+
+  max = (clib_min (mtu, vlib_buffer_get_default_data_size (vm)) - head_bytes) &
+	~0x7;
+  n_frags = (rem + max - 1) / max;
+
+  vec_add2 (*buffer, bis, n_frags);
+  bis[0] = from_bi;
+  if (n_frags > 1)
+    {
+      u32 n_alloc = vlib_buffer_alloc (vm, bis + 1, n_frags - 1);
+
+      if (n_alloc != n_frags - 1)
+	{
+	  vlib_buffer_free (vm, bis + 1, n_alloc);
+	  vec_dec_len (*buffer, n_frags);
+	  return IP_FRAG_ERROR_MEMORY;
+	}
+    }
+
+  if (ip4_is_fragment (ip4))
+    {
+      ip_frag_id = ip4->fragment_id;
+      ip_frag_offset = ip4_get_fragment_offset (ip4);
+      more =
+	!(!(ip4->flags_and_fragment_offset &
+	    clib_host_to_net_u16 (IP4_HEADER_FLAG_MORE_FRAGMENTS)));
+    }
+  else
+    {
+      ip_frag_id = (++running_fragment_id);
+      ip_frag_offset = 0;
+      more = 0;
+    }
+
+  /* headers are copied before the first fragment's is rewritten */
+  for (i = 1; i < n_frags; i++)
+    {
+      fb = vlib_get_buffer (vm, bis[i]);
+      vlib_buffer_copy_trace_flag (vm, from_b, bis[i]);
+      frag_set_sw_if_index (fb, from_b);
+
+      clib_memcpy_fast (vlib_buffer_get_current (fb), org_from_packet,
+			head_bytes);
+      fb->current_length = head_bytes;
+      vnet_buffer (fb)->l3_hdr_offset = fb->current_data;
+      fb->flags |= VNET_BUFFER_F_L3_HDR_OFFSET_VALID | VNET_BUFFER_F_IS_IP4;
+
+      if (from_b->flags & VNET_BUFFER_F_L4_HDR_OFFSET_VALID)
+	{
+	  vnet_buffer (fb)->l4_hdr_offset =
+	    (vnet_buffer (fb)->l3_hdr_offset +
+	     (vnet_buffer (from_b)->l4_hdr_offset -
+	      vnet_buffer (from_b)->l3_hdr_offset));
+	  fb->flags |= VNET_BUFFER_F_L4_HDR_OFFSET_VALID;
+	}
+    }
+
+  /*
+   * Walk the segments. sb is the current one, [so, so + sl) the bytes in it
+   * not yet assigned to a fragment; sb_linked says whether sb is already
+   * part of an earlier fragment, in which case those bytes must be copied.
+   */
+  s = 0;
+  sb = from_b;
+  so = head_bytes;
+  sl = from_b->current_length - head_bytes;
+  sb_linked = 1;
+  fo = 0;
+
+  for (i = 0; i < n_frags; i++)
+    {
+      len = (rem > max ? max : rem);
+      need = len;
+      fb = tail = vlib_get_buffer (vm, bis[i]);
+      fb->total_length_not_including_first_buffer = 0;
+
+      if (i == 0)
+	{
+	  /* the first fragment's payload starts in place */
+	  take = clib_min (sl, need);
+	  fb->current_length = head_bytes + take;
+	  so += take;
+	  sl -= take;
+	  need -= take;
+	}
+      else if (sl && sb_linked)
+	{
+	  take = clib_min (sl, need);
+	  clib_memcpy_fast (vlib_buffer_get_current (fb) + fb->current_length,
+			    vlib_buffer_get_current (sb) + so, take);
+	  fb->current_length += take;
+	  so += take;
+	  sl -= take;
+	  need -= take;
+	}
+
+      while (need)
+	{
+	  if (0 == sl)
+	    {
+	      ASSERT (s + 1 < n_segs);
+	      sb = vlib_get_buffer (vm, segs[++s]);
+	      so = 0;
+	      sl = sb->current_length;
+	      sb_linked = 0;
+	    }
+
+	  if (sl <= need)
+	    {
+	      /* the whole segment belongs to this fragment */
+	      frag_buffer_link (tail, segs[s]);
+	      tail = sb;
+	      fb->total_length_not_including_first_buffer += sl;
+	      need -= sl;
+	      sl = 0;
+	    }
+	  else if (i + 1 < n_frags && need <= sl - need &&
+		   vlib_buffer_space_left_at_end (vm, tail) >= need)
+	    {
+	      /*
+	       * copy the smaller head of the segment onto the end of this
+	       * fragment and leave the segment to the next one
+	       */
+	      clib_memcpy_fast (vlib_buffer_get_current (tail) +
+				  tail->current_length,
+				vlib_buffer_get_current (sb), need);
+	      tail->current_length += need;
+	      if (tail != fb)
+		fb->total_length_not_including_first_buffer += need;
+	      vlib_buffer_advance (sb, need);
+	      sl -= need;
+	      need = 0;
+	    }
+	  else
+	    {
+	      /* link the segment, its remainder is copied to what follows */
+	      frag_buffer_link (tail, segs[s]);
+	      tail = sb;
+	      sb->current_length = need;
+	      fb->total_length_not_including_first_buffer += need;
+	      so = need;
+	      sl -= need;
+	      need = 0;
+	      sb_linked = 1;
+	    }
+	}
+
+      tail->flags &= ~VLIB_BUFFER_NEXT_PRESENT;
+      fb->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
+
+      to_ip4 = vlib_buffer_get_current (fb) + l2unfragmentablesize;
+      to_ip4->fragment_id = ip_frag_id;
+      to_ip4->flags_and_fragment_offset =
+	clib_host_to_net_u16 ((fo >> 3) + ip_frag_offset);
+      to_ip4->flags_and_fragment_offset |=
+	clib_host_to_net_u16 (((len != rem) || more) << 13);
+      to_ip4->length = clib_host_to_net_u16 (len + sizeof (ip4_header_t));
+      to_ip4->checksum = ip4_header_checksum (to_ip4);
+
+      vnet_buffer_offload_flags_clear (fb, VNET_BUFFER_OFFLOAD_F_IP_CKSUM);
+
+      rem -= len;
+      fo += len;
+    }
+
+  /* segments past the end of the IP packet are not part of any fragment */
+  if (s + 1 < n_segs)
+    vlib_buffer_free_no_next (vm, segs + s + 1, n_segs - s - 1);
+
+  return IP_FRAG_ERROR_NONE;
+}
+
 void
 ip_frag_set_vnet_buffer (vlib_buffer_t * b, u16 mtu, u8 next_index, u8 flags)
 {
@@ -261,7 +517,7 @@ frag_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  u32 pi0, *frag_from, frag_left;
 	  vlib_buffer_t *p0;
 	  ip_frag_error_t error0;
-	  int next0;
+	  int next0, traced0;
 
 	  /*
 	   * Note: The packet is not enqueued now. It is instead put
@@ -273,19 +529,28 @@ frag_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
 	  p0 = vlib_get_buffer (vm, pi0);
 	  u16 mtu = vnet_buffer (p0)->ip_frag.mtu;
+	  u16 pkt_size = 0;
+
+	  /* the ip4 fragmenter may reuse the buffer's metadata */
+	  next0 = vnet_buffer (p0)->ip_frag.next_index;
+	  traced0 = p0->flags & VLIB_BUFFER_IS_TRACED;
+
+	  if (PREDICT_FALSE (traced0))
+	    pkt_size = vlib_buffer_length_in_chain (vm, p0);
+
 	  if (is_ip6)
 	    error0 = ip6_frag_do_fragment (vm, pi0, mtu, 0, &buffer);
 	  else
-	    error0 = ip4_frag_do_fragment (vm, pi0, mtu, 0, &buffer);
+	    error0 = ip4_frag_do_fragment_zc (vm, pi0, mtu, 0, &buffer);
 
-	  if (PREDICT_FALSE (p0->flags & VLIB_BUFFER_IS_TRACED))
+	  if (PREDICT_FALSE (traced0))
 	    {
 	      ip_frag_trace_t *tr =
 		vlib_add_trace (vm, node, p0, sizeof (*tr));
 	      tr->mtu = mtu;
-	      tr->pkt_size = vlib_buffer_length_in_chain (vm, p0);
+	      tr->pkt_size = pkt_size;
 	      tr->n_fragments = vec_len (buffer);
-	      tr->next = vnet_buffer (p0)->ip_frag.next_index;
+	      tr->next = next0;
 	    }
 
 	  if (!is_ip6 && error0 == IP_FRAG_ERROR_DONT_FRAGMENT_SET)
@@ -295,19 +560,16 @@ frag_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 					   vnet_buffer (p0)->ip_frag.mtu);
 	      next0 = IP_FRAG_NEXT_ICMP_ERROR;
 	    }
-	  else
-	    {
-	      next0 = (error0 == IP_FRAG_ERROR_NONE ?
-		       vnet_buffer (p0)->ip_frag.next_index :
-		       IP_FRAG_NEXT_DROP);
-	    }
+	  else if (error0 != IP_FRAG_ERROR_NONE)
+	    next0 = IP_FRAG_NEXT_DROP;
 
 	  if (error0 == IP_FRAG_ERROR_NONE)
 	    {
-	      /* Free original buffer chain */
 	      frag_sent += vec_len (buffer);
 	      small_packets += (vec_len (buffer) == 1);
-	      vlib_buffer_free_one (vm, pi0);	/* Free original packet */
+	      /* unless the ip4 fragments were built in place from it */
+	      if (is_ip6 || !vec_len (buffer) || buffer[0] != pi0)
+		vlib_buffer_free_one (vm, pi0);	/* Free original packet */
 	    }
 	  else
 	    {
@@ -67,6 +67,14 @@ extern ip_frag_error_t ip4_frag_do_fragment (vlib_main_t * vm,
 					     u32 from_bi,
 					     u16 mtu,
 					     u16 encapsize, u32 ** buffer);
+/*
+ * As ip4_frag_do_fragment but the fragments reuse the original packet's
+ * buffers where it can. The original must then not be freed: it is freed
+ * on success only when it is not the first fragment returned.
+ */
+extern ip_frag_error_t ip4_frag_do_fragment_zc (vlib_main_t *vm, u32 from_bi,
+						u16 mtu, u16 encapsize,
+						u32 **buffer);
 extern ip_frag_error_t ip6_frag_do_fragment (vlib_main_t * vm,
 					     u32 from_bi,
 					     u16 mtu,
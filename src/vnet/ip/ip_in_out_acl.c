@@ -111,6 +111,75 @@ static char *ip_outacl_error_strings[] = {
 #undef _
 };
 
+/* The data the table matches on */
+static_always_inline u8 *
+ip_in_out_acl_match_data (vnet_classify_table_t *t, vlib_buffer_t *b,
+			  const int is_output)
+{
+  u8 *h;
+
+  if (t->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
+    h = (u8 *) vlib_buffer_get_current (b) + t->current_data_offset;
+  else
+    h = b->data;
+
+  /* advance the match pointer so the matching happens on IP header */
+  if (is_output)
+    h += vnet_buffer (b)->l2.l2_len;
+
+  return h;
+}
+
+/*
+ * Search the tables chained after *tp a batch at a time, as
+ * vnet_classify_find_entry_in_chain_inline () does, but with the data
+ * offset of each table. Returns the entry and its table in *tp, or 0 and
+ * the last table of the chain in *tp.
+ */
+static_always_inline vnet_classify_entry_t *
+ip_in_out_acl_find_entry_in_chain (vnet_classify_table_t *tables,
+				   vnet_classify_table_t **tp,
+				   vlib_buffer_t *b, f64 now,
+				   const int is_output)
+{
+  vnet_classify_table_t *ts[VNET_CLASSIFY_CHAIN_BATCH];
+  u8 *hs[VNET_CLASSIFY_CHAIN_BATCH];
+  u32 hashes[VNET_CLASSIFY_CHAIN_BATCH];
+  vnet_classify_table_t *t = *tp;
+  u32 table_index = t->next_table_index;
+  vnet_classify_entry_t *e;
+  int i, n;
+
+  while (table_index != ~0)
+    {
+      for (n = 0; n < VNET_CLASSIFY_CHAIN_BATCH && table_index != ~0; n++)
+	{
+	  t = pool_elt_at_index (tables, table_index);
+	  ts[n] = t;
+	  hs[n] = ip_in_out_acl_match_data (t, b, is_output);
+	  hashes[n] = vnet_classify_hash_packet_inline (t, hs[n]);
+	  vnet_classify_prefetch_bucket (t, hashes[n]);
+	  table_index = t->next_table_index;
+	}
+
+      for (i = 0; i < n; i++)
+	vnet_classify_prefetch_entry (ts[i], hashes[i]);
+
+      for (i = 0; i < n; i++)
+	{
+	  e = vnet_classify_find_entry_inline (ts[i], hs[i], hashes[i], now);
+	  if (e)
+	    {
+	      *tp = ts[i];
+	      return e;
+	    }
+	}
+    }
+
+  *tp = t;
+  return 0;
+}
+
 static_always_inline void
 ip_in_out_acl_inline_trace (
   vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame,
@@ -294,6 +363,13 @@ ip_in_out_acl_inline_trace (
 	{
 	  e[0] =
 	    vnet_classify_find_entry_inline (t[0], (u8 *) h[0], hash[0], now);
+	  if (!e[0] && t[0]->next_table_index != ~0)
+	    {
+	      e[0] = ip_in_out_acl_find_entry_in_chain (tables, &t[0], b[0], now,
+							 is_output);
+	      table_index[0] = t[0] - tables;
+	      chain_hits += (e[0] != 0);
+	    }
 	  if (e[0])
 	    {
 	      vnet_buffer (b[0])->l2_classify.opaque_index
@@ -325,76 +401,15 @@ ip_in_out_acl_inline_trace (
 	    }
 	  else
 	    {
-	      while (1)
-		{
-		  table_index[0] = t[0]->next_table_index;
-		  if (PREDICT_TRUE (table_index[0] != ~0))
-		    t[0] = pool_elt_at_index (tables, table_index[0]);
-		  else
-		    {
-		      _next[0] = (t[0]->miss_next_index < n_next_nodes) ?
-			t[0]->miss_next_index : _next[0];
+	      _next[0] = (t[0]->miss_next_index < n_next_nodes) ?
+			   t[0]->miss_next_index :
+			   _next[0];
+	      table_index[0] = ~0;
 
-		      misses++;
-
-		      b[0]->error = (_next[0] == ACL_NEXT_INDEX_DENY) ?
-				      error_miss :
-				      error_none;
-		      break;
-		    }
+	      misses++;
 
-		  if (t[0]->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
-		    h[0] =
-		      (void *) vlib_buffer_get_current (b[0]) +
-		      t[0]->current_data_offset;
-		  else
-		    h[0] = b[0]->data;
-
-		  /* advance the match pointer so the matching happens on IP header */
-		  if (is_output)
-		    h[0] += vnet_buffer (b[0])->l2.l2_len;
-
-		  hash[0] =
-		    vnet_classify_hash_packet_inline (t[0], (u8 *) h[0]);
-		  e[0] =
-		    vnet_classify_find_entry_inline (t[0], (u8 *) h[0],
-						     hash[0], now);
-		  if (e[0])
-		    {
-		      vnet_buffer (b[0])->l2_classify.opaque_index
-			= e[0]->opaque_index;
-		      vlib_buffer_advance (b[0], e[0]->advance);
-		      _next[0] = (e[0]->next_index < n_next_nodes) ?
-			e[0]->next_index : _next[0];
-		      hits++;
-		      chain_hits++;
-
-		      b[0]->error = (_next[0] == ACL_NEXT_INDEX_DENY) ?
-				      error_deny :
-				      error_none;
-
-		      if (!is_output)
-			{
-			  if (e[0]->action ==
-			      CLASSIFY_ACTION_SET_IP4_FIB_INDEX
-			      || e[0]->action ==
-			      CLASSIFY_ACTION_SET_IP6_FIB_INDEX)
-			    vnet_buffer (b[0])->sw_if_index[VLIB_TX] =
-			      e[0]->metadata;
-			  else if (e[0]->action ==
-				   CLASSIFY_ACTION_SET_METADATA)
-			    {
-			      vnet_buffer (b[0])->ip.adj_index[VLIB_TX] =
-				e[0]->metadata;
-			      /* For source check in case we skip the lookup
-			       * node */
-			      ip_lookup_set_buffer_fib_index (
-				fib_index_by_sw_if_index, b[0]);
-			    }
-			}
-		      break;
-		    }
-		}
+	      b[0]->error =
+		(_next[0] == ACL_NEXT_INDEX_DENY) ? error_miss : error_none;
 	    }
 	}
 
@@ -402,6 +417,13 @@ ip_in_out_acl_inline_trace (
 	{
 	  e[1] =
 	    vnet_classify_find_entry_inline (t[1], (u8 *) h[1], hash[1], now);
+	  if (!e[1] && t[1]->next_table_index != ~0)
+	    {
+	      e[1] = ip_in_out_acl_find_entry_in_chain (tables, &t[1], b[1], now,
+							 is_output);
+	      table_index[1] = t[1] - tables;
+	      chain_hits += (e[1] != 0);
+	    }
 	  if (e[1])
 	    {
 	      vnet_buffer (b[1])->l2_classify.opaque_index
@@ -433,76 +455,15 @@ ip_in_out_acl_inline_trace (
 	    }
 	  else
 	    {
-	      while (1)
-		{
-		  table_index[1] = t[1]->next_table_index;
-		  if (PREDICT_TRUE (table_index[1] != ~0))
-		    t[1] = pool_elt_at_index (tables, table_index[1]);
-		  else
-		    {
-		      _next[1] = (t[1]->miss_next_index < n_next_nodes) ?
-			t[1]->miss_next_index : _next[1];
-
-		      misses++;
+	      _next[1] = (t[1]->miss_next_index < n_next_nodes) ?
+			   t[1]->miss_next_index :
+			   _next[1];
+	      table_index[1] = ~0;
 
-		      b[1]->error = (_next[1] == ACL_NEXT_INDEX_DENY) ?
-				      error_miss :
-				      error_none;
-		      break;
-		    }
+	      misses++;
 
-		  if (t[1]->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
-		    h[1] =
-		      (void *) vlib_buffer_get_current (b[1]) +
-		      t[1]->current_data_offset;
-		  else
-		    h[1] = b[1]->data;
-
-		  /* advance the match pointer so the matching happens on IP header */
-		  if (is_output)
-		    h[1] += vnet_buffer (b[1])->l2.l2_len;
-
-		  hash[1] =
-		    vnet_classify_hash_packet_inline (t[1], (u8 *) h[1]);
-		  e[1] =
-		    vnet_classify_find_entry_inline (t[1], (u8 *) h[1],
-						     hash[1], now);
-		  if (e[1])
-		    {
-		      vnet_buffer (b[1])->l2_classify.opaque_index
-			= e[1]->opaque_index;
-		      vlib_buffer_advance (b[1], e[1]->advance);
-		      _next[1] = (e[1]->next_index < n_next_nodes) ?
-			e[1]->next_index : _next[1];
-		      hits++;
-		      chain_hits++;
-
-		      b[1]->error = (_next[1] == ACL_NEXT_INDEX_DENY) ?
-				      error_deny :
-				      error_none;
-
-		      if (!is_output)
-			{
-			  if (e[1]->action ==
-			      CLASSIFY_ACTION_SET_IP4_FIB_INDEX
-			      || e[1]->action ==
-			      CLASSIFY_ACTION_SET_IP6_FIB_INDEX)
-			    vnet_buffer (b[1])->sw_if_index[VLIB_TX] =
-			      e[1]->metadata;
-			  else if (e[1]->action ==
-				   CLASSIFY_ACTION_SET_METADATA)
-			    {
-			      vnet_buffer (b[1])->ip.adj_index[VLIB_TX] =
-				e[1]->metadata;
-			      /* For source check in case we skip the lookup
-			       * node */
-			      ip_lookup_set_buffer_fib_index (
-				fib_index_by_sw_if_index, b[1]);
-			    }
-			}
-		      break;
-		    }
-		}
+	      b[1]->error =
+		(_next[1] == ACL_NEXT_INDEX_DENY) ? error_miss : error_none;
 	    }
 	}
 
@@ -607,6 +568,13 @@ ip_in_out_acl_inline_trace (
 	    h0 += vnet_buffer (b[0])->l2.l2_len;
 
 	  e0 = vnet_classify_find_entry_inline (t0, (u8 *) h0, hash0, now);
+	  if (!e0 && t0->next_table_index != ~0)
+	    {
+	      e0 = ip_in_out_acl_find_entry_in_chain (tables, &t0, b[0], now,
+						      is_output);
+	      table_index0 = t0 - tables;
+	      chain_hits += (e0 != 0);
+	    }
 	  if (e0)
 	    {
 	      vnet_buffer (b[0])->l2_classify.opaque_index = e0->opaque_index;
@@ -636,72 +604,15 @@ ip_in_out_acl_inline_trace (
 	    }
 	  else
 	    {
-	      while (1)
-		{
-		  table_index0 = t0->next_table_index;
-		  if (PREDICT_TRUE (table_index0 != ~0))
-		    t0 = pool_elt_at_index (tables, table_index0);
-		  else
-		    {
-		      next0 = (t0->miss_next_index < n_next_nodes) ?
-			t0->miss_next_index : next0;
-
-		      misses++;
+	      next0 = (t0->miss_next_index < n_next_nodes) ?
+			t0->miss_next_index :
+			next0;
+	      table_index0 = ~0;
 
-		      b[0]->error = (next0 == ACL_NEXT_INDEX_DENY) ?
-				      error_miss :
-				      error_none;
-		      break;
-		    }
+	      misses++;
 
-		  if (t0->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
-		    h0 =
-		      (void *) vlib_buffer_get_current (b[0]) +
-		      t0->current_data_offset;
-		  else
-		    h0 = b[0]->data;
-
-		  /* advance the match pointer so the matching happens on IP header */
-		  if (is_output)
-		    h0 += vnet_buffer (b[0])->l2.l2_len;
-
-		  hash0 = vnet_classify_hash_packet_inline (t0, (u8 *) h0);
-		  e0 = vnet_classify_find_entry_inline
-		    (t0, (u8 *) h0, hash0, now);
-		  if (e0)
-		    {
-		      vnet_buffer (b[0])->l2_classify.opaque_index
-			= e0->opaque_index;
-		      vlib_buffer_advance (b[0], e0->advance);
-		      next0 = (e0->next_index < n_next_nodes) ?
-			e0->next_index : next0;
-		      hits++;
-
-		      b[0]->error = (next0 == ACL_NEXT_INDEX_DENY) ?
-				      error_deny :
-				      error_none;
-
-		      if (!is_output)
-			{
-			  if (e0->action ==
-			      CLASSIFY_ACTION_SET_IP4_FIB_INDEX
-			      || e0->action ==
-			      CLASSIFY_ACTION_SET_IP6_FIB_INDEX)
-			    vnet_buffer (b[0])->sw_if_index[VLIB_TX] =
-			      e0->metadata;
-			  else if (e0->action == CLASSIFY_ACTION_SET_METADATA)
-			    {
-			      vnet_buffer (b[0])->ip.adj_index[VLIB_TX] =
-				e0->metadata;
-			      /* For source check in case we skip the lookup
-			       * node */
-			      ip_lookup_set_buffer_fib_index (
-				fib_index_by_sw_if_index, b[0]);
-			    }
-			}
-		      break;
-		    }
-		}
+	      b[0]->error =
+		(next0 == ACL_NEXT_INDEX_DENY) ? error_miss : error_none;
 	    }
 	}
 
@@ -94,7 +94,7 @@ ip_pmtu_dpo_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	      ip6_frag_do_fragment (vm, pi0, ipm0->ipm_pmtu, 0, &buffer);
 	  else
 	    error0 =
-	      ip4_frag_do_fragment (vm, pi0, ipm0->ipm_pmtu, 0, &buffer);
+	      ip4_frag_do_fragment_zc (vm, pi0, ipm0->ipm_pmtu, 0, &buffer);
 
 	  if (AF_IP4 == af && error0 == IP_FRAG_ERROR_DONT_FRAGMENT_SET)
 	    {
@@ -112,8 +112,9 @@ ip_pmtu_dpo_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 
 	  if (error0 == IP_FRAG_ERROR_NONE)
 	    {
-	      /* Free original buffer chain */
-	      vlib_buffer_free_one (vm, pi0); /* Free original packet */
+	      /* unless the ip4 fragments were built in place from it */
+	      if (AF_IP6 == af || !vec_len (buffer) || buffer[0] != pi0)
+		vlib_buffer_free_one (vm, pi0); /* Free original packet */
 	    }
 	  else
 	    {
@@ -161,7 +161,7 @@ icmp6_neighbor_solicitation_or_advertisement (vlib_main_t * vm,
 	      };
               /* *INDENT-ON* */
 	      memcpy (&learn.mac, o0->ethernet_address, sizeof (learn.mac));
-	      ip_neighbor_learn_dp (&learn);
+	      ip_neighbor_learn_dp_batch (&learn);
 	    }
 
 	  if (is_solicitation && error0 == ICMP6_ERROR_NONE)
@@ -266,6 +266,8 @@ icmp6_neighbor_solicitation_or_advertisement (vlib_main_t * vm,
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
 
+  ip_neighbor_learn_dp_flush ();
+
   /* Account for advertisements sent. */
   vlib_error_count (vm, error_node->node_index,
 		    ICMP6_ERROR_NEIGHBOR_ADVERTISEMENTS_TX,
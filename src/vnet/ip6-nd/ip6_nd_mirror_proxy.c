@@ -215,7 +215,7 @@ ip6_nd_proxy_multicast (vlib_main_t *vm, vlib_node_runtime_t *node,
 						} };
 		  clib_memcpy (&learn.mac, icmp6_nd_ell_addr->ethernet_address,
 			       sizeof (learn.mac));
-		  ip_neighbor_learn_dp (&learn);
+		  ip_neighbor_learn_dp_batch (&learn);
 
 		  *next0 = ICMP6_NEIGHBOR_SOLICITATION_NEXT_REPLY;
 		  icmp6_send_neighbor_advertisement (
@@ -242,7 +242,7 @@ ip6_nd_proxy_multicast (vlib_main_t *vm, vlib_node_runtime_t *node,
 						} };
 		  clib_memcpy (&learn.mac, icmp6_nd_ell_addr->ethernet_address,
 			       sizeof (learn.mac));
-		  ip_neighbor_learn_dp (&learn);
+		  ip_neighbor_learn_dp_batch (&learn);
 
 		  *next0 = ICMP6_NEIGHBOR_SOLICITATION_NEXT_DROP;
 		}
@@ -352,6 +352,8 @@ ip6_nd_proxy_node_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
 
+  ip_neighbor_learn_dp_flush ();
+
   return frame->n_vectors;
 }
 
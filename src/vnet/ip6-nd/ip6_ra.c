@@ -315,7 +315,7 @@ icmp6_router_solicitation (vlib_main_t * vm,
 	      };
               /* *INDENT-ON* */
 	      memcpy (&learn.mac, o0->ethernet_address, sizeof (learn.mac));
-	      ip_neighbor_learn_dp (&learn);
+	      ip_neighbor_learn_dp_batch (&learn);
 	    }
 
 	  /* default is to drop */
@@ -626,6 +626,8 @@ icmp6_router_solicitation (vlib_main_t * vm,
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
 
+  ip_neighbor_learn_dp_flush ();
+
   /* Account for router advertisements sent. */
   vlib_error_count (vm, error_node->node_index,
 		    ICMP6_ERROR_ROUTER_ADVERTISEMENTS_TX,
@@ -129,6 +129,7 @@ ah_decrypt_inline (vlib_main_t * vm,
   n_left = from_frame->n_vectors;
   ipsec_sa_t *sa0 = 0;
   u32 current_sa_index = ~0, current_sa_bytes = 0, current_sa_pkts = 0;
+  int rv;
 
   clib_memset (pkt_data, 0, VLIB_FRAME_SIZE * sizeof (pkt_data[0]));
   vlib_get_buffers (vm, from, b, n_left);
@@ -201,12 +202,15 @@ ah_decrypt_inline (vlib_main_t * vm,
       pd->seq = clib_host_to_net_u32 (ah0->seq_no);
 
       /* anti-replay check */
-      if (ipsec_sa_anti_replay_and_sn_advance (sa0, pd->seq, ~0, false,
-					       &pd->seq_hi))
+      rv = ipsec_sa_anti_replay_and_sn_advance (sa0, pd->seq, ~0, false,
+						&pd->seq_hi);
+      if (rv)
 	{
-	  ah_decrypt_set_next_index (b[0], node, vm->thread_index,
-				     AH_DECRYPT_ERROR_REPLAY, 0, next,
-				     AH_DECRYPT_NEXT_DROP, current_sa_index);
+	  ah_decrypt_set_next_index (
+	    b[0], node, vm->thread_index,
+	    rv == IPSEC_SA_ANTI_REPLAY_LATE ? AH_DECRYPT_ERROR_LATE :
+					      AH_DECRYPT_ERROR_REPLAY,
+	    0, next, AH_DECRYPT_NEXT_DROP, current_sa_index);
 	  goto next;
 	}
 
@@ -306,12 +310,15 @@ ah_decrypt_inline (vlib_main_t * vm,
       if (PREDICT_TRUE (sa0->integ_alg != IPSEC_INTEG_ALG_NONE))
 	{
 	  /* redo the anti-reply check. see esp_decrypt for details */
-	  if (ipsec_sa_anti_replay_and_sn_advance (sa0, pd->seq, pd->seq_hi,
-						   true, NULL))
+	  rv = ipsec_sa_anti_replay_and_sn_advance (sa0, pd->seq, pd->seq_hi,
+						    true, NULL);
+	  if (rv)
 	    {
-	      ah_decrypt_set_next_index (b[0], node, vm->thread_index,
-					 AH_DECRYPT_ERROR_REPLAY, 0, next,
-					 AH_DECRYPT_NEXT_DROP, pd->sa_index);
+	      ah_decrypt_set_next_index (
+		b[0], node, vm->thread_index,
+		rv == IPSEC_SA_ANTI_REPLAY_LATE ? AH_DECRYPT_ERROR_LATE :
+						  AH_DECRYPT_ERROR_REPLAY,
+		0, next, AH_DECRYPT_NEXT_DROP, pd->sa_index);
 	      goto trace;
 	    }
 	  n_lost = ipsec_sa_anti_replay_advance (sa0, thread_index, pd->seq,
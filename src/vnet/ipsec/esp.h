@@ -115,6 +115,51 @@ esp_seq_advance (ipsec_sa_t * sa)
   return 0;
 }
 
+/*
+ * MULTI_WORKER SAs are used by all threads at once, each thread reserves
+ * blocks of sequence numbers with an atomic add on the ESN so the SA is
+ * only written once per block. blocks interleave on the wire, the peer
+ * needs an anti-replay window of a few blocks per worker.
+ */
+#define ESP_SEQ_BLOCK_SIZE 8
+
+/*
+ * called when a thread starts on the SA, the numbers left in the block
+ * since the thread last used it are likely already behind the window of
+ * the peer, give them up
+ */
+always_inline void
+esp_seq_block_refresh (ipsec_sa_t *sa, u32 thread_index)
+{
+  ipsec_sa_seq_block_t *sb = vec_elt_at_index (sa->seq_blocks, thread_index);
+
+  if (clib_atomic_load_relax_n (&sa->seq64) - sb->next >
+      2 * ESP_SEQ_BLOCK_SIZE)
+    sb->next = sb->end;
+}
+
+always_inline int
+esp_seq_advance_mw (ipsec_sa_t *sa, u32 thread_index, u64 *seq)
+{
+  ipsec_sa_seq_block_t *sb = vec_elt_at_index (sa->seq_blocks, thread_index);
+
+  if (PREDICT_FALSE (sb->next == sb->end))
+    {
+      sb->next =
+	clib_atomic_fetch_add_relax (&sa->seq64, ESP_SEQ_BLOCK_SIZE) + 1;
+      sb->end = sb->next + ESP_SEQ_BLOCK_SIZE;
+    }
+
+  *seq = sb->next++;
+
+  /* a 64 bit ESN does not cycle */
+  if (PREDICT_FALSE (ipsec_sa_is_set_USE_ANTI_REPLAY (sa) &&
+		     !ipsec_sa_is_set_USE_ESN (sa) && *seq > ESP_SEQ_MAX))
+    return 1;
+
+  return 0;
+}
+
 always_inline u16
 esp_aad_fill (u8 *data, const esp_header_t *esp, const ipsec_sa_t *sa,
 	      u32 seq_hi)
@@ -175,6 +220,8 @@ esp_decrypt_err_to_sa_err (u32 err)
       return IPSEC_SA_ERROR_CRYPTO_ENGINE_ERROR;
     case ESP_DECRYPT_ERROR_REPLAY:
       return IPSEC_SA_ERROR_REPLAY;
+    case ESP_DECRYPT_ERROR_LATE:
+      return IPSEC_SA_ERROR_LATE;
     case ESP_DECRYPT_ERROR_RUNT:
       return IPSEC_SA_ERROR_RUNT;
     case ESP_DECRYPT_ERROR_NO_BUFFERS:
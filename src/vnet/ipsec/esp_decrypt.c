@@ -733,6 +733,7 @@ esp_decrypt_post_crypto (vlib_main_t *vm, vlib_node_runtime_t *node,
   const u8 tun_flags = IPSEC_SA_FLAG_IS_TUNNEL | IPSEC_SA_FLAG_IS_TUNNEL_V6;
   u8 pad_length = 0, next_header = 0;
   u16 icv_sz;
+  int rv;
 
   /*
    * redo the anti-reply check
@@ -755,19 +756,32 @@ esp_decrypt_post_crypto (vlib_main_t *vm, vlib_node_runtime_t *node,
    * sequence number in the window) which is non-trivial, it can generate
    * a sequence s, s+1, s+2, s+3, ... s+n and nothing will prevent any
    * implementation, sequential or batching, from decrypting these.
+   *
+   * Workers sharing a MULTI_WORKER SA take turns to check and advance.
    */
-  if (ipsec_sa_anti_replay_and_sn_advance (sa0, pd->seq, pd->seq_hi, true,
-					   NULL))
+  if (PREDICT_FALSE (ipsec_sa_is_set_MULTI_WORKER (sa0)))
+    clib_spinlock_lock (&sa0->replay_lock);
+
+  rv = ipsec_sa_anti_replay_and_sn_advance (sa0, pd->seq, pd->seq_hi, true,
+					    NULL);
+  if (rv)
     {
+      if (PREDICT_FALSE (ipsec_sa_is_set_MULTI_WORKER (sa0)))
+	clib_spinlock_unlock (&sa0->replay_lock);
       esp_decrypt_set_next_index (b, node, vm->thread_index,
-				  ESP_DECRYPT_ERROR_REPLAY, 0, next,
-				  ESP_DECRYPT_NEXT_DROP, pd->sa_index);
+				  rv == IPSEC_SA_ANTI_REPLAY_LATE ?
+				    ESP_DECRYPT_ERROR_LATE :
+				    ESP_DECRYPT_ERROR_REPLAY,
+				  0, next, ESP_DECRYPT_NEXT_DROP, pd->sa_index);
       return;
     }
 
   u64 n_lost =
     ipsec_sa_anti_replay_advance (sa0, vm->thread_index, pd->seq, pd->seq_hi);
 
+  if (PREDICT_FALSE (ipsec_sa_is_set_MULTI_WORKER (sa0)))
+    clib_spinlock_unlock (&sa0->replay_lock);
+
   vlib_prefetch_simple_counter (&ipsec_sa_err_counters[IPSEC_SA_ERROR_LOST],
 				vm->thread_index, pd->sa_index);
 
@@ -1039,6 +1053,7 @@ esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
   vnet_crypto_async_op_id_t async_op = ~0;
   vnet_crypto_async_frame_t *async_frames[VNET_CRYPTO_ASYNC_OP_N_IDS];
   esp_decrypt_error_t err;
+  int rv;
 
   vlib_get_buffers (vm, from, b, n_left);
   if (!is_async)
@@ -1109,7 +1124,8 @@ esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 				    ipsec_sa_assign_thread (thread_index));
 	}
 
-      if (PREDICT_FALSE (thread_index != sa0->thread_index))
+      if (PREDICT_FALSE (thread_index != sa0->thread_index &&
+			 !ipsec_sa_is_set_MULTI_WORKER (sa0)))
 	{
 	  vnet_buffer (b[0])->ipsec.thread_index = sa0->thread_index;
 	  err = ESP_DECRYPT_ERROR_HANDOFF;
@@ -1149,10 +1165,12 @@ esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       pd->current_length = b[0]->current_length;
 
       /* anti-reply check */
-      if (ipsec_sa_anti_replay_and_sn_advance (sa0, pd->seq, ~0, false,
-					       &pd->seq_hi))
+      rv = ipsec_sa_anti_replay_and_sn_advance (sa0, pd->seq, ~0, false,
+						&pd->seq_hi);
+      if (rv)
 	{
-	  err = ESP_DECRYPT_ERROR_REPLAY;
+	  err = rv == IPSEC_SA_ANTI_REPLAY_LATE ? ESP_DECRYPT_ERROR_LATE :
+						  ESP_DECRYPT_ERROR_REPLAY;
 	  esp_decrypt_set_next_index (b[0], node, thread_index, err, n_noop,
 				      noop_nexts, ESP_DECRYPT_NEXT_DROP,
 				      current_sa_index);
@@ -26,6 +26,7 @@
 #include <vnet/ipsec/ipsec.api_enum.h>
 #include <vnet/ipsec/esp.h>
 #include <vnet/tunnel/tunnel_dp.h>
+#include <vnet/gso/gso.h>
 
 #define foreach_esp_encrypt_next                                              \
   _ (DROP4, "ip4-drop")                                                       \
@@ -225,12 +226,18 @@ esp_get_ip6_hdr_len (ip6_header_t * ip6, ip6_ext_header_t ** ext_hdr)
  * message. You can refer to NIST SP800-38a and NIST SP800-38d for more
  * details. */
 static_always_inline void *
-esp_generate_iv (ipsec_sa_t *sa, void *payload, int iv_sz)
+esp_generate_iv (ipsec_sa_t *sa, u32 thread_index, void *payload, int iv_sz)
 {
   ASSERT (iv_sz >= sizeof (u64));
+  clib_pcg64i_random_t *prng = &sa->iv_prng;
   u64 *iv = (u64 *) (payload - iv_sz);
+
+  /* threads sharing the SA each have their own generator */
+  if (PREDICT_FALSE (ipsec_sa_is_set_MULTI_WORKER (sa)))
+    prng = &vec_elt (sa->seq_blocks, thread_index).iv_prng;
+
   clib_memset_u8 (iv, 0, iv_sz);
-  *iv = clib_pcg64i_random_r (&sa->iv_prng);
+  *iv = clib_pcg64i_random_r (prng);
   return iv;
 }
 
@@ -334,7 +341,7 @@ esp_encrypt_chain_crypto (vlib_main_t * vm, ipsec_per_thread_data_t * ptd,
 
 static_always_inline u32
 esp_encrypt_chain_integ (vlib_main_t * vm, ipsec_per_thread_data_t * ptd,
-			 ipsec_sa_t * sa0, vlib_buffer_t * b,
+			 ipsec_sa_t * sa0, u32 seq_hi, vlib_buffer_t * b,
 			 vlib_buffer_t * lb, u8 icv_sz, u8 * start,
 			 u32 start_len, u8 * digest, u16 * n_ch)
 {
@@ -356,7 +363,7 @@ esp_encrypt_chain_integ (vlib_main_t * vm, ipsec_per_thread_data_t * ptd,
 	  total_len += ch->len = cb->current_length - icv_sz;
 	  if (ipsec_sa_is_set_USE_ESN (sa0))
 	    {
-	      u32 seq_hi = clib_net_to_host_u32 (sa0->seq_hi);
+	      seq_hi = clib_net_to_host_u32 (seq_hi);
 	      clib_memcpy_fast (digest, &seq_hi, sizeof (seq_hi));
 	      ch->len += sizeof (seq_hi);
 	      total_len += sizeof (seq_hi);
@@ -398,7 +405,7 @@ esp_prepare_sync_op (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
       u16 crypto_len = payload_len - icv_sz;
 
       /* generate the IV in front of the payload */
-      void *pkt_iv = esp_generate_iv (sa0, payload, iv_sz);
+      void *pkt_iv = esp_generate_iv (sa0, vm->thread_index, payload, iv_sz);
 
       op->key_index = sa0->crypto_key_index;
       op->user_data = bi;
@@ -472,7 +479,7 @@ esp_prepare_sync_op (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
 	  op->chunk_index = vec_len (ptd->chunks);
 	  op->digest = vlib_buffer_get_tail (lb) - icv_sz;
 
-	  esp_encrypt_chain_integ (vm, ptd, sa0, b[0], lb, icv_sz,
+	  esp_encrypt_chain_integ (vm, ptd, sa0, seq_hi, b[0], lb, icv_sz,
 				   payload - iv_sz - sizeof (esp_header_t),
 				   payload_len + iv_sz +
 				   sizeof (esp_header_t), op->digest,
@@ -490,8 +497,9 @@ esp_prepare_sync_op (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
 static_always_inline void
 esp_prepare_async_frame (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
 			 vnet_crypto_async_frame_t *async_frame,
-			 ipsec_sa_t *sa, vlib_buffer_t *b, esp_header_t *esp,
-			 u8 *payload, u32 payload_len, u8 iv_sz, u8 icv_sz,
+			 ipsec_sa_t *sa, u32 seq_hi, vlib_buffer_t *b,
+			 esp_header_t *esp, u8 *payload, u32 payload_len,
+			 u8 iv_sz, u8 icv_sz,
 			 u32 bi, u16 next, u32 hdr_len, u16 async_next,
 			 vlib_buffer_t *lb)
 {
@@ -510,7 +518,7 @@ esp_prepare_async_frame (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
   tag = payload + crypto_total_len;
 
   /* generate the IV in front of the payload */
-  void *pkt_iv = esp_generate_iv (sa, payload, iv_sz);
+  void *pkt_iv = esp_generate_iv (sa, vm->thread_index, payload, iv_sz);
 
   if (ipsec_sa_is_set_IS_CTR (sa))
     {
@@ -521,7 +529,7 @@ esp_prepare_async_frame (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
 	{
 	  /* constuct aad in a scratch space in front of the nonce */
 	  aad = (u8 *) nonce - sizeof (esp_aead_t);
-	  esp_aad_fill (aad, esp, sa, sa->seq_hi);
+	  esp_aad_fill (aad, esp, sa, seq_hi);
 	}
       else
 	{
@@ -560,13 +568,13 @@ esp_prepare_async_frame (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
       if (b != lb)
 	{
 	  integ_total_len = esp_encrypt_chain_integ (
-	    vm, ptd, sa, b, lb, icv_sz,
+	    vm, ptd, sa, seq_hi, b, lb, icv_sz,
 	    payload - iv_sz - sizeof (esp_header_t),
 	    payload_len + iv_sz + sizeof (esp_header_t), tag, 0);
 	}
       else if (ipsec_sa_is_set_USE_ESN (sa))
 	{
-	  u32 seq_hi = clib_net_to_host_u32 (sa->seq_hi);
+	  seq_hi = clib_net_to_host_u32 (seq_hi);
 	  clib_memcpy_fast (tag, &seq_hi, sizeof (seq_hi));
 	  integ_total_len += sizeof (seq_hi);
 	}
@@ -579,16 +587,14 @@ esp_prepare_async_frame (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
 				  async_next, iv, tag, aad, flag);
 }
 
-always_inline uword
-esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
-		    vlib_frame_t *frame, vnet_link_t lt, int is_tun,
-		    u16 async_next_node)
+always_inline void
+esp_encrypt_buffers (vlib_main_t *vm, vlib_node_runtime_t *node, u32 *from,
+		     vlib_buffer_t **bufs, u32 n_left, vnet_link_t lt,
+		     int is_tun, u16 async_next_node)
 {
   ipsec_main_t *im = &ipsec_main;
   ipsec_per_thread_data_t *ptd = vec_elt_at_index (im->ptd, vm->thread_index);
-  u32 *from = vlib_frame_vector_args (frame);
-  u32 n_left = frame->n_vectors;
-  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  vlib_buffer_t **b = bufs;
   u32 thread_index = vm->thread_index;
   u16 buffer_data_size = vlib_buffer_get_default_data_size (vm);
   u32 current_sa_index = ~0, current_sa_packets = 0;
@@ -616,8 +622,7 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
   u32 sync_bi[VLIB_FRAME_SIZE];
   u32 noop_bi[VLIB_FRAME_SIZE];
   esp_encrypt_error_t err;
-
-  vlib_get_buffers (vm, from, b, n_left);
+  u64 seq;
 
   vec_reset_length (ptd->crypto_ops);
   vec_reset_length (ptd->integ_ops);
@@ -637,6 +642,7 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       u32 hdr_len;
 
       err = ESP_ENCRYPT_ERROR_RX_PKTS;
+      seq = 0;
 
       if (n_left > 2)
 	{
@@ -701,6 +707,9 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  icv_sz = sa0->integ_icv_size;
 	  iv_sz = sa0->crypto_iv_size;
 	  is_async = im->async_mode | ipsec_sa_is_set_IS_ASYNC (sa0);
+
+	  if (ipsec_sa_is_set_MULTI_WORKER (sa0))
+	    esp_seq_block_refresh (sa0, thread_index);
 	}
 
       if (PREDICT_FALSE ((u16) ~0 == sa0->thread_index))
@@ -712,7 +721,8 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 				    ipsec_sa_assign_thread (thread_index));
 	}
 
-      if (PREDICT_FALSE (thread_index != sa0->thread_index))
+      if (PREDICT_FALSE (thread_index != sa0->thread_index &&
+			 !ipsec_sa_is_set_MULTI_WORKER (sa0)))
 	{
 	  vnet_buffer (b[0])->ipsec.thread_index = sa0->thread_index;
 	  err = ESP_ENCRYPT_ERROR_HANDOFF;
@@ -739,12 +749,28 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	    lb = vlib_get_buffer (vm, lb->next_buffer);
 	}
 
-      if (PREDICT_FALSE (esp_seq_advance (sa0)))
+      if (ipsec_sa_is_set_MULTI_WORKER (sa0))
 	{
-	  err = ESP_ENCRYPT_ERROR_SEQ_CYCLED;
-	  esp_encrypt_set_next_index (b[0], node, thread_index, err, n_noop,
-				      noop_nexts, drop_next, current_sa_index);
-	  goto trace;
+	  if (PREDICT_FALSE (esp_seq_advance_mw (sa0, thread_index, &seq)))
+	    {
+	      err = ESP_ENCRYPT_ERROR_SEQ_CYCLED;
+	      esp_encrypt_set_next_index (b[0], node, thread_index, err,
+					  n_noop, noop_nexts, drop_next,
+					  current_sa_index);
+	      goto trace;
+	    }
+	}
+      else
+	{
+	  if (PREDICT_FALSE (esp_seq_advance (sa0)))
+	    {
+	      err = ESP_ENCRYPT_ERROR_SEQ_CYCLED;
+	      esp_encrypt_set_next_index (b[0], node, thread_index, err,
+					  n_noop, noop_nexts, drop_next,
+					  current_sa_index);
+	      goto trace;
+	    }
+	  seq = sa0->seq64;
 	}
 
       /* space for IV */
@@ -986,7 +1012,7 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	}
 
       esp->spi = spi;
-      esp->seq = clib_net_to_host_u32 (sa0->seq);
+      esp->seq = clib_net_to_host_u32 ((u32) seq);
 
       if (is_async)
 	{
@@ -1013,13 +1039,13 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	      vec_add1 (ptd->async_frames, async_frames[async_op]);
 	    }
 
-	  esp_prepare_async_frame (vm, ptd, async_frames[async_op], sa0, b[0],
-				   esp, payload, payload_len, iv_sz, icv_sz,
-				   from[b - bufs], sync_next[0], hdr_len,
-				   async_next_node, lb);
+	  esp_prepare_async_frame (vm, ptd, async_frames[async_op], sa0,
+				   seq >> 32, b[0], esp, payload, payload_len,
+				   iv_sz, icv_sz, from[b - bufs], sync_next[0],
+				   hdr_len, async_next_node, lb);
 	}
       else
-	esp_prepare_sync_op (vm, ptd, crypto_ops, integ_ops, sa0, sa0->seq_hi,
+	esp_prepare_sync_op (vm, ptd, crypto_ops, integ_ops, sa0, seq >> 32,
 			     payload, payload_len, iv_sz, icv_sz, n_sync, b,
 			     lb, hdr_len, esp);
 
@@ -1039,8 +1065,18 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	    {
 	      tr->sa_index = sa_index0;
 	      tr->spi = sa0->spi;
-	      tr->seq = sa0->seq;
-	      tr->sa_seq_hi = sa0->seq_hi;
+	      /* the SA counter of a multi-worker SA runs ahead of the
+	       * packet, trace the number this packet was given */
+	      if (ipsec_sa_is_set_MULTI_WORKER (sa0))
+		{
+		  tr->seq = (u32) seq;
+		  tr->sa_seq_hi = seq >> 32;
+		}
+	      else
+		{
+		  tr->seq = sa0->seq;
+		  tr->sa_seq_hi = sa0->seq_hi;
+		}
 	      tr->udp_encap = ipsec_sa_is_set_UDP_ENCAP (sa0);
 	      tr->crypto_alg = sa0->crypto_alg;
 	      tr->integ_alg = sa0->integ_alg;
@@ -1106,6 +1142,124 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
     }
   if (n_noop)
     vlib_buffer_enqueue_to_next (vm, node, noop_bi, noop_nexts, n_noop);
+}
+
+/*
+ * each ESP packet needs its own header, sequence number and ICV, so a GSO
+ * super-segment cannot be encrypted as a whole. it is segmented here
+ * rather than by the gso feature so that its segments, which share the
+ * SA, are encrypted back to back in the same batch. super-segments the
+ * segmenter does not handle (tunnelled inner headers) are passed through
+ * untouched, as they were before.
+ */
+static_always_inline u32 *
+esp_encrypt_gso_segment (vlib_main_t *vm, vlib_node_runtime_t *node,
+			 u32 *from, vlib_buffer_t **b, u32 n_left,
+			 vnet_link_t lt, int is_tun, u16 drop_next)
+{
+  ipsec_per_thread_data_t *ptd =
+    vec_elt_at_index (ipsec_main.ptd, vm->thread_index);
+  vnet_interface_per_thread_data_t *iptd = vec_elt_at_index (
+    vnet_get_main ()->interface_main.per_thread_data, vm->thread_index);
+  int is_ip6 = VNET_LINK_IP6 == lt;
+  u32 drop_bi[VLIB_FRAME_SIZE], n_drop = 0;
+  u32 *segs = ptd->gso_buffers;
+
+  vec_reset_length (segs);
+
+  for (; n_left > 0; n_left--, from++, b++)
+    {
+      generic_header_offset_t gho = {};
+      u32 n_segs;
+
+      if (PREDICT_TRUE (!(b[0]->flags & VNET_BUFFER_F_GSO)))
+	{
+	  vec_add1 (segs, from[0]);
+	  continue;
+	}
+
+      vnet_generic_header_offset_parser (b[0], &gho, 0, !is_ip6, is_ip6);
+
+      if (PREDICT_FALSE (gho.gho_flags & GHO_F_TUNNEL))
+	{
+	  vec_add1 (segs, from[0]);
+	  continue;
+	}
+
+      if (PREDICT_FALSE (
+	    !gso_segment_buffer_inline (vm, iptd, b[0], &gho, 0, is_ip6)))
+	{
+	  b[0]->error = node->errors[ESP_ENCRYPT_ERROR_NO_BUFFERS];
+	  drop_bi[n_drop++] = from[0];
+	  continue;
+	}
+
+      n_segs = vec_len (iptd->split_buffers);
+      for (u32 i = 0; i < n_segs; i++)
+	{
+	  vlib_buffer_t *sb = vlib_get_buffer (vm, iptd->split_buffers[i]);
+
+	  vnet_buffer_offload_flags_clear (sb, 0x7F);
+
+	  /* transport mode re-uses the L2 rewrite in front of the IP header */
+	  if (!is_tun)
+	    clib_memcpy_fast (vlib_buffer_get_current (sb) -
+				vnet_buffer (b[0])->ip.save_rewrite_length,
+			      vlib_buffer_get_current (b[0]) -
+				vnet_buffer (b[0])->ip.save_rewrite_length,
+			      vnet_buffer (b[0])->ip.save_rewrite_length);
+	}
+
+      vec_add (segs, iptd->split_buffers, n_segs);
+      vec_set_len (iptd->split_buffers, 0);
+      vlib_buffer_free_one (vm, from[0]);
+    }
+
+  if (n_drop)
+    vlib_buffer_enqueue_to_single_next (vm, node, drop_bi, drop_next, n_drop);
+
+  ptd->gso_buffers = segs;
+  return segs;
+}
+
+always_inline uword
+esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
+		    vlib_frame_t *frame, vnet_link_t lt, int is_tun,
+		    u16 async_next_node)
+{
+  u32 *from = vlib_frame_vector_args (frame);
+  u32 n_left = frame->n_vectors;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE];
+  u32 flags = 0;
+
+  vlib_get_buffers (vm, from, bufs, n_left);
+
+  if (VNET_LINK_MPLS != lt)
+    for (u32 i = 0; i < n_left; i++)
+      flags |= bufs[i]->flags;
+
+  if (PREDICT_FALSE (flags & VNET_BUFFER_F_GSO))
+    {
+      u16 drop_next = (VNET_LINK_IP6 == lt ? ESP_ENCRYPT_NEXT_DROP6 :
+					       ESP_ENCRYPT_NEXT_DROP4);
+      from = esp_encrypt_gso_segment (vm, node, from, bufs, n_left, lt,
+				      is_tun, drop_next);
+      n_left = vec_len (from);
+    }
+
+  /* the segments of GSO packets may not fit in one batch */
+  while (n_left)
+    {
+      u32 n = clib_min (n_left, VLIB_FRAME_SIZE);
+
+      if (PREDICT_FALSE (flags & VNET_BUFFER_F_GSO))
+	vlib_get_buffers (vm, from, bufs, n);
+
+      esp_encrypt_buffers (vm, node, from, bufs, n, lt, is_tun,
+			   async_next_node);
+      from += n;
+      n_left -= n;
+    }
 
   vlib_node_increment_counter (vm, node->node_index, ESP_ENCRYPT_ERROR_RX_PKTS,
 			       frame->n_vectors);
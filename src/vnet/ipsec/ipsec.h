@@ -136,6 +136,8 @@ typedef struct
   vnet_crypto_op_t *chained_integ_ops;
   vnet_crypto_op_chunk_t *chunks;
   vnet_crypto_async_frame_t **async_frames;
+  /* GSO packets segmented before encryption */
+  u32 *gso_buffers;
 } ipsec_per_thread_data_t;
 
 typedef struct
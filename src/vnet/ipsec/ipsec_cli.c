@@ -93,7 +93,7 @@ ipsec_sa_add_del_command_fn (vlib_main_t * vm,
   clib_error_t *error;
   ipsec_key_t ck = { 0 };
   ipsec_key_t ik = { 0 };
-  u32 id, spi, salt, sai;
+  u32 id, spi, salt, sai, anti_replay_window_size;
   int i = 0;
   u16 udp_src, udp_dst;
   int is_add, rv;
@@ -108,6 +108,7 @@ ipsec_sa_add_del_command_fn (vlib_main_t * vm,
   integ_alg = IPSEC_INTEG_ALG_NONE;
   crypto_alg = IPSEC_CRYPTO_ALG_NONE;
   udp_src = udp_dst = IPSEC_UDP_PORT_NONE;
+  anti_replay_window_size = IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE;
 
   if (!unformat_user (input, unformat_line_input, line_input))
     return 0;
@@ -157,8 +158,13 @@ ipsec_sa_add_del_command_fn (vlib_main_t * vm,
 	flags |= IPSEC_SA_FLAG_IS_INBOUND;
       else if (unformat (line_input, "use-anti-replay"))
 	flags |= IPSEC_SA_FLAG_USE_ANTI_REPLAY;
+      else if (unformat (line_input, "anti-replay-window-size %u",
+			 &anti_replay_window_size))
+	;
       else if (unformat (line_input, "use-esn"))
 	flags |= IPSEC_SA_FLAG_USE_ESN;
+      else if (unformat (line_input, "multi-worker"))
+	flags |= IPSEC_SA_FLAG_MULTI_WORKER;
       else if (unformat (line_input, "udp-encap"))
 	flags |= IPSEC_SA_FLAG_UDP_ENCAP;
       else if (unformat (line_input, "async"))
@@ -186,7 +192,8 @@ ipsec_sa_add_del_command_fn (vlib_main_t * vm,
 	}
       rv = ipsec_sa_add_and_lock (id, spi, proto, crypto_alg, &ck, integ_alg,
 				  &ik, flags, clib_host_to_net_u32 (salt),
-				  udp_src, udp_dst, &tun, &sai);
+				  udp_src, udp_dst, anti_replay_window_size,
+				  &tun, &sai);
     }
   else
     {
@@ -183,9 +183,12 @@ ipsec_input_policy_match (ipsec_spd_t *spd, u32 sa, u32 da,
 {
   ipsec_main_t *im = &ipsec_main;
   ipsec_policy_t *p;
-  u32 *i;
+  u32 *i, *candidates;
+
+  /* only the policies whose remote range covers the source address */
+  candidates = ipsec_spd_range_lookup (&spd->ip4_ranges[policy_type], sa);
 
-  vec_foreach (i, spd->policies[policy_type])
+  vec_foreach (i, candidates)
   {
     p = pool_elt_at_index (im->policies, *i);
 
@@ -195,12 +198,6 @@ ipsec_input_policy_match (ipsec_spd_t *spd, u32 sa, u32 da,
     if (da > clib_net_to_host_u32 (p->laddr.stop.ip4.as_u32))
       continue;
 
-    if (sa < clib_net_to_host_u32 (p->raddr.start.ip4.as_u32))
-      continue;
-
-    if (sa > clib_net_to_host_u32 (p->raddr.stop.ip4.as_u32))
-      continue;
-
     if (im->input_flow_cache_flag)
       {
 	/* Add an Entry in Flow cache */
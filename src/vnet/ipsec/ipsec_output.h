@@ -171,7 +171,7 @@ ipsec_output_policy_match_n (ipsec_spd_t *spd,
   ipsec4_spd_5tuple_t *ip4_5tuple = ip4_5tuples;
   u32 policy_ids[n], *policy_id = policy_ids;
   ipsec_fp_5tuple_t tuples[n];
-  u32 *i;
+  u32 *i, *candidates;
   u32 counter = 0;
 
   if (!spd)
@@ -192,26 +192,28 @@ ipsec_output_policy_match_n (ipsec_spd_t *spd,
       if (*pp != 0)
 	goto next;
 
-      vec_foreach (i, spd->policies[IPSEC_SPD_POLICY_IP4_OUTBOUND])
+      /* only the policies whose remote range covers the remote address */
+      candidates = ipsec_spd_range_lookup (
+	&spd->ip4_ranges[IPSEC_SPD_POLICY_IP4_OUTBOUND],
+	ip4_5tuple->ip4_addr[1].as_u32);
+
+      if (n_left > 1)
+	clib_prefetch_load (ipsec_spd_range_lookup (
+	  &spd->ip4_ranges[IPSEC_SPD_POLICY_IP4_OUTBOUND],
+	  ip4_5tuple[1].ip4_addr[1].as_u32));
+
+      vec_foreach (i, candidates)
 	{
 	  p = pool_elt_at_index (im->policies, *i);
 	  if (PREDICT_FALSE (p->protocol &&
 			     (p->protocol != ip4_5tuple->proto)))
 	    continue;
 
-	  if (ip4_5tuple->ip4_addr[0].as_u32 <
-	      clib_net_to_host_u32 (p->raddr.start.ip4.as_u32))
-	    continue;
-
-	  if (ip4_5tuple->ip4_addr[1].as_u32 >
-	      clib_net_to_host_u32 (p->raddr.stop.ip4.as_u32))
-	    continue;
-
 	  if (ip4_5tuple->ip4_addr[0].as_u32 <
 	      clib_net_to_host_u32 (p->laddr.start.ip4.as_u32))
 	    continue;
 
-	  if (ip4_5tuple->ip4_addr[1].as_u32 >
+	  if (ip4_5tuple->ip4_addr[0].as_u32 >
 	      clib_net_to_host_u32 (p->laddr.stop.ip4.as_u32))
 	    continue;
 
@@ -326,7 +328,7 @@ ipsec_output_policy_match (ipsec_spd_t *spd, u8 pr, u32 la, u32 ra, u16 lp,
   ipsec_fp_5tuple_t tuples[1];
   u32 fp_policy_ids[1];
 
-  u32 *i;
+  u32 *i, *candidates;
 
   if (!spd)
     return 0;
@@ -348,19 +350,17 @@ ipsec_output_policy_match (ipsec_spd_t *spd, u8 pr, u32 la, u32 ra, u16 lp,
       goto add_flow_cache;
     }
 
-  vec_foreach (i, spd->policies[IPSEC_SPD_POLICY_IP4_OUTBOUND])
+  /* only the policies whose remote range covers the remote address */
+  candidates = ipsec_spd_range_lookup (
+    &spd->ip4_ranges[IPSEC_SPD_POLICY_IP4_OUTBOUND], ra);
+
+  vec_foreach (i, candidates)
     {
       p = pool_elt_at_index (im->policies, *i);
       if (PREDICT_FALSE ((p->protocol != IPSEC_POLICY_PROTOCOL_ANY) &&
 			 (p->protocol != pr)))
 	continue;
 
-      if (ra < clib_net_to_host_u32 (p->raddr.start.ip4.as_u32))
-	continue;
-
-      if (ra > clib_net_to_host_u32 (p->raddr.stop.ip4.as_u32))
-	continue;
-
       if (la < clib_net_to_host_u32 (p->laddr.start.ip4.as_u32))
 	continue;
 
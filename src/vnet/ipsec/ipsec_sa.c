@@ -322,7 +322,8 @@ ipsec_sa_add_and_lock (u32 id, u32 spi, ipsec_protocol_t proto,
 		       ipsec_crypto_alg_t crypto_alg, const ipsec_key_t *ck,
 		       ipsec_integ_alg_t integ_alg, const ipsec_key_t *ik,
 		       ipsec_sa_flags_t flags, u32 salt, u16 src_port,
-		       u16 dst_port, const tunnel_t *tun, u32 *sa_out_index)
+		       u16 dst_port, u32 anti_replay_window_size,
+		       const tunnel_t *tun, u32 *sa_out_index)
 {
   vlib_main_t *vm = vlib_get_main ();
   ipsec_main_t *im = &ipsec_main;
@@ -337,6 +338,15 @@ ipsec_sa_add_and_lock (u32 id, u32 spi, ipsec_protocol_t proto,
   if (p)
     return VNET_API_ERROR_ENTRY_ALREADY_EXISTS;
 
+  if (anti_replay_window_size > IPSEC_SA_ANTI_REPLAY_WINDOW_MAX_SIZE ||
+      (anti_replay_window_size > IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE &&
+       !is_pow2 (anti_replay_window_size)))
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  /* only ESP shares an SA between workers */
+  if ((flags & IPSEC_SA_FLAG_MULTI_WORKER) && proto != IPSEC_PROTOCOL_ESP)
+    return VNET_API_ERROR_UNSUPPORTED;
+
   if (getrandom (rand, sizeof (rand), 0) != sizeof (rand))
     return VNET_API_ERROR_INIT_FAILED;
 
@@ -481,6 +491,30 @@ ipsec_sa_add_and_lock (u32 id, u32 spi, ipsec_protocol_t proto,
 				 !ipsec_sa_is_set_IS_TUNNEL_V6 (sa));
     }
 
+  /* windows larger than the default are a ring bitmap */
+  if (ipsec_sa_is_set_USE_ANTI_REPLAY (sa) &&
+      anti_replay_window_size > IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE)
+    {
+      ipsec_sa_set_ANTI_REPLAY_HUGE (sa);
+      clib_bitmap_alloc (sa->replay_window_huge, anti_replay_window_size);
+    }
+
+  if (ipsec_sa_is_set_MULTI_WORKER (sa))
+    {
+      ipsec_sa_seq_block_t *sb;
+
+      clib_spinlock_init (&sa->replay_lock);
+      vec_validate_aligned (sa->seq_blocks, vlib_get_n_threads () - 1,
+			    CLIB_CACHE_LINE_BYTES);
+      vec_foreach (sb, sa->seq_blocks)
+	{
+	  /* the SA generator is seeded, draw the threads' seeds from it */
+	  clib_pcg64i_srandom_r (&sb->iv_prng,
+				 clib_pcg64i_random_r (&sa->iv_prng),
+				 clib_pcg64i_random_r (&sa->iv_prng));
+	}
+    }
+
   hash_set (im->sa_index_by_sa_id, sa->id, sa_index);
 
   if (sa_out_index)
@@ -518,6 +552,13 @@ ipsec_sa_del (ipsec_sa_t * sa)
   vnet_crypto_key_del (vm, sa->crypto_sync_key_index);
   if (sa->integ_alg != IPSEC_INTEG_ALG_NONE)
     vnet_crypto_key_del (vm, sa->integ_sync_key_index);
+  if (ipsec_sa_is_set_ANTI_REPLAY_HUGE (sa))
+    clib_bitmap_free (sa->replay_window_huge);
+  if (ipsec_sa_is_set_MULTI_WORKER (sa))
+    {
+      clib_spinlock_free (&sa->replay_lock);
+      vec_free (sa->seq_blocks);
+    }
   pool_put (ipsec_sa_pool, sa);
 }
 
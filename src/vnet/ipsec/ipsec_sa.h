@@ -112,7 +112,9 @@ typedef struct ipsec_key_t_
   _ (128, IS_AEAD, "aead")                                                    \
   _ (256, IS_CTR, "ctr")                                                      \
   _ (512, IS_ASYNC, "async")                                                  \
-  _ (1024, NO_ALGO_NO_DROP, "no-algo-no-drop")
+  _ (1024, NO_ALGO_NO_DROP, "no-algo-no-drop")                               \
+  _ (2048, ANTI_REPLAY_HUGE, "anti-replay-huge")                             \
+  _ (4096, MULTI_WORKER, "multi-worker")
 
 typedef enum ipsec_sad_flags_t_
 {
@@ -142,7 +144,8 @@ STATIC_ASSERT (sizeof (ipsec_sa_flags_t) == 2, "IPSEC SA flags != 2 byte");
   _ (12, SEQ_CYCLED, seq_cycled, "sequence number cycled (dropped)")          \
   _ (13, CRYPTO_QUEUE_FULL, crypto_queue_full, "crypto queue full (dropped)") \
   _ (14, NO_ENCRYPTION, no_encryption, "no Encrypting SA (dropped)")          \
-  _ (15, DROP_FRAGMENTS, drop_fragments, "IP fragments drop")
+  _ (15, DROP_FRAGMENTS, drop_fragments, "IP fragments drop")                \
+  _ (16, LATE, late, "SA late packet (before the anti-replay window)")
 
 typedef enum
 {
@@ -152,21 +155,47 @@ typedef enum
     IPSEC_SA_N_ERRORS,
 } __clib_packed ipsec_sa_err_t;
 
+/*
+ * per thread state of a MULTI_WORKER SA: the sequence numbers reserved by
+ * the thread, [next, end) of the 64 bit ESN, and its IV generator
+ */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  u64 next;
+  u64 end;
+  clib_pcg64i_random_t iv_prng;
+} ipsec_sa_seq_block_t;
+
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
 
   clib_pcg64i_random_t iv_prng;
 
-  u64 replay_window;
+  union
+  {
+    u64 replay_window;
+    /* ring of anti-replay window bits, indexed by sequence number modulo
+     * the window size, if ANTI_REPLAY_HUGE */
+    clib_bitmap_t *replay_window_huge;
+  };
   dpo_id_t dpo;
 
   vnet_crypto_key_index_t crypto_key_index;
   vnet_crypto_key_index_t integ_key_index;
 
+  union
+  {
+    struct
+    {
+      u32 seq;
+      u32 seq_hi;
+    };
+    /* the ESN, reserved atomically by MULTI_WORKER SAs */
+    u64 seq64;
+  };
   u32 spi;
-  u32 seq;
-  u32 seq_hi;
 
   u16 crypto_enc_op_id;
   u16 crypto_dec_op_id;
@@ -194,6 +223,9 @@ typedef struct
   tunnel_encap_decap_flags_t tunnel_flags;
   u8 __pad[2];
 
+  /* serialises the anti-replay window updates of MULTI_WORKER SAs */
+  clib_spinlock_t replay_lock;
+
   /* data accessed by dataplane code should be above this comment */
     CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
 
@@ -223,6 +255,9 @@ typedef struct
 
   ipsec_key_t integ_key;
   ipsec_key_t crypto_key;
+
+  /* per thread blocks of sequence numbers of MULTI_WORKER SAs */
+  ipsec_sa_seq_block_t *seq_blocks;
 } ipsec_sa_t;
 
 STATIC_ASSERT (VNET_CRYPTO_N_OP_IDS < (1 << 16), "crypto ops overflow");
@@ -230,6 +265,9 @@ STATIC_ASSERT (ESP_MAX_ICV_SIZE < (1 << 6), "integer icv overflow");
 STATIC_ASSERT (ESP_MAX_IV_SIZE < (1 << 5), "esp iv overflow");
 STATIC_ASSERT (ESP_MAX_BLOCK_SIZE < (1 << 5), "esp alignment overflow");
 STATIC_ASSERT_OFFSET_OF (ipsec_sa_t, cacheline1, CLIB_CACHE_LINE_BYTES);
+STATIC_ASSERT (STRUCT_OFFSET_OF (ipsec_sa_t, seq_hi) ==
+		 STRUCT_OFFSET_OF (ipsec_sa_t, seq) + sizeof (u32),
+	       "seq64 is not the ESN");
 STATIC_ASSERT_OFFSET_OF (ipsec_sa_t, cacheline2, 2 * CLIB_CACHE_LINE_BYTES);
 
 /**
@@ -282,7 +320,8 @@ ipsec_sa_add_and_lock (u32 id, u32 spi, ipsec_protocol_t proto,
 		       ipsec_crypto_alg_t crypto_alg, const ipsec_key_t *ck,
 		       ipsec_integ_alg_t integ_alg, const ipsec_key_t *ik,
 		       ipsec_sa_flags_t flags, u32 salt, u16 src_port,
-		       u16 dst_port, const tunnel_t *tun, u32 *sa_out_index);
+		       u16 dst_port, u32 anti_replay_window_size,
+		       const tunnel_t *tun, u32 *sa_out_index);
 extern int ipsec_sa_bind (u32 id, u32 worker, bool bind);
 extern index_t ipsec_sa_find_and_lock (u32 id);
 extern int ipsec_sa_unlock_id (u32 id);
@@ -316,23 +355,52 @@ extern uword unformat_ipsec_key (unformat_input_t * input, va_list * args);
  */
 
 #define IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE (64)
-#define IPSEC_SA_ANTI_REPLAY_WINDOW_MAX_INDEX (IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE-1)
+#define IPSEC_SA_ANTI_REPLAY_WINDOW_MAX_SIZE (1 << 15)
 
 /*
  * sequence number less than the lower bound are outside of the window
  * From RFC4303 Appendix A:
  *  Bl = Tl - W + 1
  */
-#define IPSEC_SA_ANTI_REPLAY_WINDOW_LOWER_BOUND(_tl) (_tl - IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE + 1)
+#define IPSEC_SA_ANTI_REPLAY_WINDOW_LOWER_BOUND(_tl, _ws) (_tl - (_ws) + 1)
+
+/*
+ * Anti replay check verdicts, anything but OK drops the packet.
+ * LATE packets are older than the window, REPLAY ones are in the window
+ * but were already received.
+ */
+#define IPSEC_SA_ANTI_REPLAY_OK	    0
+#define IPSEC_SA_ANTI_REPLAY_REPLAY 1
+#define IPSEC_SA_ANTI_REPLAY_LATE   2
+
+always_inline u32
+ipsec_sa_anti_replay_window_size (const ipsec_sa_t *sa)
+{
+  if (PREDICT_FALSE (ipsec_sa_is_set_ANTI_REPLAY_HUGE (sa)))
+    return clib_bitmap_bytes (sa->replay_window_huge) * BITS (u8);
+  return IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE;
+}
 
 always_inline int
 ipsec_sa_anti_replay_check (const ipsec_sa_t *sa, u32 seq)
 {
-  if (ipsec_sa_is_set_USE_ANTI_REPLAY (sa) &&
-      sa->replay_window & (1ULL << (sa->seq - seq)))
-    return 1;
+  u32 ws;
+
+  if (!ipsec_sa_is_set_USE_ANTI_REPLAY (sa))
+    return IPSEC_SA_ANTI_REPLAY_OK;
+
+  if (PREDICT_FALSE (ipsec_sa_is_set_ANTI_REPLAY_HUGE (sa)))
+    {
+      ws = ipsec_sa_anti_replay_window_size (sa);
+      if (clib_bitmap_get_no_check (sa->replay_window_huge, seq & (ws - 1)))
+	return IPSEC_SA_ANTI_REPLAY_REPLAY;
+      return IPSEC_SA_ANTI_REPLAY_OK;
+    }
+
+  if (sa->replay_window & (1ULL << (sa->seq - seq)))
+    return IPSEC_SA_ANTI_REPLAY_REPLAY;
   else
-    return 0;
+    return IPSEC_SA_ANTI_REPLAY_OK;
 }
 
 /*
@@ -354,6 +422,8 @@ ipsec_sa_anti_replay_and_sn_advance (const ipsec_sa_t *sa, u32 seq,
 				     u32 hi_seq_used, bool post_decrypt,
 				     u32 *hi_seq_req)
 {
+  u32 ws = ipsec_sa_anti_replay_window_size (sa);
+
   ASSERT ((post_decrypt == false) == (hi_seq_req != 0));
 
   if (!ipsec_sa_is_set_USE_ESN (sa))
@@ -363,19 +433,15 @@ ipsec_sa_anti_replay_and_sn_advance (const ipsec_sa_t *sa, u32 seq,
 	*hi_seq_req = 0;
 
       if (!ipsec_sa_is_set_USE_ANTI_REPLAY (sa))
-	return 0;
+	return IPSEC_SA_ANTI_REPLAY_OK;
 
       if (PREDICT_TRUE (seq > sa->seq))
-	return 0;
-
-      u32 diff = sa->seq - seq;
+	return IPSEC_SA_ANTI_REPLAY_OK;
 
-      if (IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE > diff)
-	return ((sa->replay_window & (1ULL << diff)) ? 1 : 0);
+      if (ws > sa->seq - seq)
+	return (ipsec_sa_anti_replay_check (sa, seq));
       else
-	return 1;
-
-      return 0;
+	return IPSEC_SA_ANTI_REPLAY_LATE;
     }
 
   if (!ipsec_sa_is_set_USE_ANTI_REPLAY (sa))
@@ -415,14 +481,14 @@ ipsec_sa_anti_replay_and_sn_advance (const ipsec_sa_t *sa, u32 seq,
        */
       return 0;
     }
-  if (PREDICT_TRUE (sa->seq >= (IPSEC_SA_ANTI_REPLAY_WINDOW_MAX_INDEX)))
+  if (PREDICT_TRUE (sa->seq >= ws - 1))
     {
       /*
        * the last sequence number VPP recieved is more than one
        * window size greater than zero.
        * Case A from RFC4303 Appendix A.
        */
-      if (seq < IPSEC_SA_ANTI_REPLAY_WINDOW_LOWER_BOUND (sa->seq))
+      if (seq < IPSEC_SA_ANTI_REPLAY_WINDOW_LOWER_BOUND (sa->seq, ws))
 	{
 	  /*
 	   * the received sequence number is lower than the lower bound
@@ -437,7 +503,7 @@ ipsec_sa_anti_replay_and_sn_advance (const ipsec_sa_t *sa, u32 seq,
 		 * packet is the same as the last-sequnence number of the SA.
 		 * that means this packet did not cause a wrap.
 		 * this packet is thus out of window and should be dropped */
-		return 1;
+		return IPSEC_SA_ANTI_REPLAY_LATE;
 	      else
 		/* The packet decrypted with a different high sequence number
 		 * to the SA, that means it is the wrap packet and should be
@@ -486,7 +552,7 @@ ipsec_sa_anti_replay_and_sn_advance (const ipsec_sa_t *sa, u32 seq,
        * RHS will be a larger number.
        * Case B from RFC4303 Appendix A.
        */
-      if (seq < IPSEC_SA_ANTI_REPLAY_WINDOW_LOWER_BOUND (sa->seq))
+      if (seq < IPSEC_SA_ANTI_REPLAY_WINDOW_LOWER_BOUND (sa->seq, ws))
 	{
 	  /*
 	   * the sequence number is less than the lower bound.
@@ -537,11 +603,80 @@ ipsec_sa_anti_replay_and_sn_advance (const ipsec_sa_t *sa, u32 seq,
   return 0;
 }
 
+/*
+ * clear n bits of the huge window ring from bit first on, without wrapping,
+ * a word at a time. returns the number of bits that were set.
+ */
+always_inline u32
+ipsec_sa_anti_replay_window_clear_huge (clib_bitmap_t *bm, u32 first, u32 n)
+{
+  u32 i = first / BITS (uword), off = first % BITS (uword);
+  u32 len, seen = 0;
+  uword mask;
+
+  while (n)
+    {
+      len = clib_min (n, BITS (uword) - off);
+      mask = len == BITS (uword) ? ~(uword) 0 : pow2_mask (len) << off;
+      seen += count_set_bits (bm[i] & mask);
+      bm[i] &= ~mask;
+      n -= len;
+      off = 0;
+      i++;
+    }
+
+  return seen;
+}
+
 always_inline u32
-ipsec_sa_anti_replay_window_shift (ipsec_sa_t *sa, u32 inc)
+ipsec_sa_anti_replay_window_shift_huge (ipsec_sa_t *sa, u32 inc, u32 seq)
+{
+  clib_bitmap_t *bm = sa->replay_window_huge;
+  u32 ws = ipsec_sa_anti_replay_window_size (sa);
+  u32 n_lost = 0, first, seen;
+
+  if (inc < ws)
+    {
+      /*
+       * the slots of the sequence numbers we move on to still hold the
+       * ones falling off the end of the window, those not seen are lost
+       */
+      first = (sa->seq + 1) & (ws - 1);
+      if (first + inc > ws)
+	seen = ipsec_sa_anti_replay_window_clear_huge (bm, first, ws - first) +
+	       ipsec_sa_anti_replay_window_clear_huge (bm, 0,
+						       first + inc - ws);
+      else
+	seen = ipsec_sa_anti_replay_window_clear_huge (bm, first, inc);
+
+      if (sa->seq > ws)
+	n_lost = inc - seen;
+    }
+  else
+    {
+      /* holes in the replay window are lost packets */
+      n_lost = ws - clib_bitmap_count_set_bits (bm);
+
+      /* any sequence numbers that now fall outside the window
+       * are forever lost */
+      n_lost += inc - ws;
+
+      clib_bitmap_zero (bm);
+    }
+
+  clib_bitmap_set_no_check (bm, seq & (ws - 1), 1);
+
+  return (n_lost);
+}
+
+always_inline u32
+ipsec_sa_anti_replay_window_shift (ipsec_sa_t *sa, u32 inc, u32 seq)
 {
   u32 n_lost = 0;
 
+  if (PREDICT_FALSE (ipsec_sa_is_set_ANTI_REPLAY_HUGE (sa)))
+    return ipsec_sa_anti_replay_window_shift_huge (sa, inc, seq);
+
   if (inc < IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE)
     {
       if (sa->seq > IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE)
@@ -579,6 +714,43 @@ ipsec_sa_anti_replay_window_shift (ipsec_sa_t *sa, u32 inc)
   return (n_lost);
 }
 
+/* mark an in window sequence number as received */
+always_inline void
+ipsec_sa_anti_replay_window_set (ipsec_sa_t *sa, u32 seq)
+{
+  u32 ws;
+
+  if (PREDICT_FALSE (ipsec_sa_is_set_ANTI_REPLAY_HUGE (sa)))
+    {
+      ws = ipsec_sa_anti_replay_window_size (sa);
+      clib_bitmap_set_no_check (sa->replay_window_huge, seq & (ws - 1), 1);
+    }
+  else
+    sa->replay_window |= (1ULL << (sa->seq - seq));
+}
+
+/*
+ * the last 64 bits of the window, most recent sequence number in the lowest
+ * bit, as reported for the default window size
+ */
+always_inline u64
+ipsec_sa_anti_replay_get_64b_window (const ipsec_sa_t *sa)
+{
+  u64 w = 0;
+  u32 ws, i;
+
+  if (!ipsec_sa_is_set_ANTI_REPLAY_HUGE (sa))
+    return sa->replay_window;
+
+  ws = ipsec_sa_anti_replay_window_size (sa);
+  for (i = 0; i < BITS (u64); i++)
+    if (clib_bitmap_get_no_check (sa->replay_window_huge,
+				  (sa->seq - i) & (ws - 1)))
+      w |= 1ULL << i;
+
+  return w;
+}
+
 /*
  * Anti replay window advance
  *  inputs need to be in host byte order.
@@ -602,25 +774,21 @@ ipsec_sa_anti_replay_advance (ipsec_sa_t *sa, u32 thread_index, u32 seq,
       if (wrap == 0 && seq > sa->seq)
 	{
 	  pos = seq - sa->seq;
-	  n_lost = ipsec_sa_anti_replay_window_shift (sa, pos);
+	  n_lost = ipsec_sa_anti_replay_window_shift (sa, pos, seq);
 	  sa->seq = seq;
 	}
       else if (wrap > 0)
 	{
 	  pos = ~seq + sa->seq + 1;
-	  n_lost = ipsec_sa_anti_replay_window_shift (sa, pos);
+	  n_lost = ipsec_sa_anti_replay_window_shift (sa, pos, seq);
 	  sa->seq = seq;
 	  sa->seq_hi = hi_seq;
 	}
-      else if (wrap < 0)
-	{
-	  pos = ~seq + sa->seq + 1;
-	  sa->replay_window |= (1ULL << pos);
-	}
       else
 	{
-	  pos = sa->seq - seq;
-	  sa->replay_window |= (1ULL << pos);
+	  /* wrap < 0 or an older sequence number with the same hi,
+	   * sa->seq - seq modulo 2^32 is its place in the window */
+	  ipsec_sa_anti_replay_window_set (sa, seq);
 	}
     }
   else
@@ -628,13 +796,12 @@ ipsec_sa_anti_replay_advance (ipsec_sa_t *sa, u32 thread_index, u32 seq,
       if (seq > sa->seq)
 	{
 	  pos = seq - sa->seq;
-	  n_lost = ipsec_sa_anti_replay_window_shift (sa, pos);
+	  n_lost = ipsec_sa_anti_replay_window_shift (sa, pos, seq);
 	  sa->seq = seq;
 	}
       else
 	{
-	  pos = sa->seq - seq;
-	  sa->replay_window |= (1ULL << pos);
+	  ipsec_sa_anti_replay_window_set (sa, seq);
 	}
     }
 
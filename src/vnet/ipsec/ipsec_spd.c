@@ -16,6 +16,116 @@
 #include <vnet/ipsec/ipsec.h>
 #include <vnet/ipsec/ipsec_io.h>
 
+/* make sure an interval starts at addr */
+static void
+ipsec_spd_range_split (ipsec_spd_range_index_t *ri, u32 addr)
+{
+  u32 i = ipsec_spd_range_find (ri, addr);
+  u32 *policies;
+
+  if (ri->starts[i] == addr)
+    return;
+
+  policies = vec_dup (ri->policies[i]);
+  vec_insert_elts (ri->starts, &addr, 1, i + 1);
+  vec_insert_elts (ri->policies, &policies, 1, i + 1);
+}
+
+/* merge the interval i with the previous one if they hold the same list */
+static void
+ipsec_spd_range_merge (ipsec_spd_range_index_t *ri, u32 i)
+{
+  u32 *a, *b;
+
+  if (i == 0 || i >= vec_len (ri->starts))
+    return;
+
+  a = ri->policies[i - 1];
+  b = ri->policies[i];
+
+  if (vec_len (a) != vec_len (b) ||
+      (vec_len (a) && memcmp (a, b, vec_len (a) * sizeof (a[0]))))
+    return;
+
+  vec_free (ri->policies[i]);
+  vec_delete (ri->starts, 1, i);
+  vec_delete (ri->policies, 1, i);
+}
+
+void
+ipsec_spd_range_add (ipsec_spd_range_index_t *ri, u32 policy_index)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_policy_t *p, *vp = pool_elt_at_index (im->policies, policy_index);
+  u32 start = clib_net_to_host_u32 (vp->raddr.start.ip4.as_u32);
+  u32 stop = clib_net_to_host_u32 (vp->raddr.stop.ip4.as_u32);
+  u32 i, j, end;
+
+  if (vec_len (ri->starts) == 0)
+    {
+      vec_add1 (ri->starts, 0);
+      vec_add1 (ri->policies, 0);
+    }
+
+  ipsec_spd_range_split (ri, start);
+  if (stop != ~0)
+    ipsec_spd_range_split (ri, stop + 1);
+
+  i = ipsec_spd_range_find (ri, start);
+  end = stop == ~0 ? vec_len (ri->starts) : ipsec_spd_range_find (ri, stop + 1);
+
+  for (; i < end; i++)
+    {
+      /* same position rule as the SPD policy vector */
+      vec_foreach_index (j, ri->policies[i])
+	{
+	  p = pool_elt_at_index (im->policies, ri->policies[i][j]);
+	  if (p->priority <= vp->priority)
+	    break;
+	}
+      vec_insert_elts (ri->policies[i], &policy_index, 1, j);
+    }
+}
+
+void
+ipsec_spd_range_del (ipsec_spd_range_index_t *ri, u32 policy_index)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_policy_t *vp = pool_elt_at_index (im->policies, policy_index);
+  u32 start = clib_net_to_host_u32 (vp->raddr.start.ip4.as_u32);
+  u32 stop = clib_net_to_host_u32 (vp->raddr.stop.ip4.as_u32);
+  u32 i, j, first, end;
+
+  if (vec_len (ri->starts) == 0)
+    return;
+
+  first = i = ipsec_spd_range_find (ri, start);
+  end = stop == ~0 ? vec_len (ri->starts) : ipsec_spd_range_find (ri, stop + 1);
+
+  for (; i < end; i++)
+    vec_foreach_index (j, ri->policies[i])
+      if (ri->policies[i][j] == policy_index)
+	{
+	  vec_delete (ri->policies[i], 1, j);
+	  break;
+	}
+
+  /* drop the boundaries this policy created if nothing else needs them */
+  ipsec_spd_range_merge (ri, end);
+  ipsec_spd_range_merge (ri, first);
+}
+
+void
+ipsec_spd_range_free (ipsec_spd_range_index_t *ri)
+{
+  u32 **policies;
+
+  vec_foreach (policies, ri->policies)
+    vec_free (policies[0]);
+  vec_free (ri->policies);
+  vec_free (ri->starts);
+}
+
 int
 ipsec_add_del_spd (vlib_main_t * vm, u32 spd_id, int is_add)
 {
@@ -49,6 +159,9 @@ ipsec_add_del_spd (vlib_main_t * vm, u32 spd_id, int is_add)
       foreach_ipsec_spd_policy_type
 #undef _
 
+	for (int t = 0; t < IPSEC_SPD_POLICY_N_TYPES; t++)
+	  ipsec_spd_range_free (&spd->ip4_ranges[t]);
+
 	fp_spd = &spd->fp_spd;
 
       if (im->fp_spd_ipv4_out_is_enabled)
@@ -67,6 +67,29 @@ typedef struct
   u32 ip4_in_lookup_hash_idx;  /* fp ip4 lookup hash in index in the pool */
 } ipsec_spd_fp_t;
 
+/**
+ * @brief Policies of an IPv4 SPD type indexed by remote address
+ *
+ * The remote address space is cut into disjoint intervals at the start and
+ * at the end + 1 of the remote range of each policy. Every interval lists
+ * the policies whose remote range covers it, in the same order as the SPD
+ * policy vector, so the first match in the list is the first match in the
+ * SPD. Intervals with identical lists are merged when policies are removed.
+ *
+ * A policy is copied into every interval its range covers, so n nested or
+ * widely overlapping ranges create up to 2n intervals holding O(n) policies
+ * each: memory and add/delete cost grow as O(n^2) in that case, while
+ * disjoint ranges stay linear. At the 50k policies this is sized for, deeply
+ * nested SPDs are better served by the SPD fast path.
+ */
+typedef struct
+{
+  /** sorted start addresses, in host byte order, of the intervals */
+  u32 *starts;
+  /** per interval, the policy indices covering it */
+  u32 **policies;
+} ipsec_spd_range_index_t;
+
 /**
  * @brief A Security Policy Database
  */
@@ -76,9 +99,50 @@ typedef struct
   u32 id;
   /** vectors for each of the policy types */
   u32 *policies[IPSEC_SPD_POLICY_N_TYPES];
+  /** remote address index of the range based IPv4 policy types */
+  ipsec_spd_range_index_t ip4_ranges[IPSEC_SPD_POLICY_N_TYPES];
   ipsec_spd_fp_t fp_spd;
 } ipsec_spd_t;
 
+static_always_inline int
+ipsec_spd_type_is_range_indexed (ipsec_spd_policy_type_t type)
+{
+  return (type == IPSEC_SPD_POLICY_IP4_OUTBOUND ||
+	  type == IPSEC_SPD_POLICY_IP4_INBOUND_BYPASS ||
+	  type == IPSEC_SPD_POLICY_IP4_INBOUND_DISCARD);
+}
+
+/* index of the interval holding addr */
+static_always_inline u32
+ipsec_spd_range_find (const ipsec_spd_range_index_t *ri, u32 addr)
+{
+  u32 lo = 0, hi = vec_len (ri->starts) - 1, mid;
+
+  while (lo < hi)
+    {
+      mid = (lo + hi + 1) / 2;
+      if (ri->starts[mid] <= addr)
+	lo = mid;
+      else
+	hi = mid - 1;
+    }
+
+  return lo;
+}
+
+/**
+ * @brief Candidate policies, in SPD order, for a remote address in host
+ * byte order. The caller still has to match the rest of the selector.
+ */
+static_always_inline u32 *
+ipsec_spd_range_lookup (const ipsec_spd_range_index_t *ri, u32 addr)
+{
+  if (PREDICT_FALSE (vec_len (ri->starts) == 0))
+    return 0;
+
+  return ri->policies[ipsec_spd_range_find (ri, addr)];
+}
+
 /**
  * @brief Add/Delete a SPD
  */
@@ -90,6 +154,12 @@ extern int ipsec_add_del_spd (vlib_main_t * vm, u32 spd_id, int is_add);
 extern int ipsec_set_interface_spd (vlib_main_t * vm,
 				    u32 sw_if_index, u32 spd_id, int is_add);
 
+extern void ipsec_spd_range_add (ipsec_spd_range_index_t *ri,
+				 u32 policy_index);
+extern void ipsec_spd_range_del (ipsec_spd_range_index_t *ri,
+				 u32 policy_index);
+extern void ipsec_spd_range_free (ipsec_spd_range_index_t *ri);
+
 extern u8 *format_ipsec_spd (u8 * s, va_list * args);
 
 extern u8 *format_ipsec_out_spd_flow_cache (u8 *s, va_list *args);
@@ -215,6 +215,9 @@ ipsec_add_del_policy (vlib_main_t * vm,
 
       vec_insert_elts (spd->policies[policy->type], &policy_index, 1, i);
 
+      if (ipsec_spd_type_is_range_indexed (policy->type))
+	ipsec_spd_range_add (&spd->ip4_ranges[policy->type], policy_index);
+
       *stat_index = policy_index;
     }
   else
@@ -251,6 +254,9 @@ ipsec_add_del_policy (vlib_main_t * vm,
 				spd->policies[policy->type][ii]);
 	if (ipsec_policy_is_equal (vp, policy))
 	  {
+	    if (ipsec_spd_type_is_range_indexed (policy->type))
+	      ipsec_spd_range_del (&spd->ip4_ranges[policy->type],
+				   vp - im->policies);
 	    vec_delete (spd->policies[policy->type], 1, ii);
 	    ipsec_sa_unlock (vp->sa_index);
 	    pool_put (im->policies, vp);
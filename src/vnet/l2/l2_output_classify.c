@@ -352,6 +352,12 @@ VLIB_NODE_FN (l2_output_classify_node) (vlib_main_t * vm,
 	      t0 = pool_elt_at_index (vcm->tables, table_index0);
 
 	      e0 = vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
+	      if (!e0 && t0->next_table_index != ~0)
+		{
+		  e0 = vnet_classify_find_entry_in_chain_inline (
+		    t0->next_table_index, (u8 *) h0, now, &t0);
+		  chain_hits += (e0 != 0);
+		}
 	      if (e0)
 		{
 		  vnet_buffer (b0)->l2_classify.opaque_index
@@ -363,34 +369,9 @@ VLIB_NODE_FN (l2_output_classify_node) (vlib_main_t * vm,
 		}
 	      else
 		{
-		  while (1)
-		    {
-		      if (t0->next_table_index != ~0)
-			t0 = pool_elt_at_index (vcm->tables,
-						t0->next_table_index);
-		      else
-			{
-			  next0 = (t0->miss_next_index < n_next_nodes) ?
-			    t0->miss_next_index : next0;
-			  misses++;
-			  break;
-			}
-
-		      hash0 = vnet_classify_hash_packet (t0, (u8 *) h0);
-		      e0 =
-			vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
-		      if (e0)
-			{
-			  vnet_buffer (b0)->l2_classify.opaque_index
-			    = e0->opaque_index;
-			  vlib_buffer_advance (b0, e0->advance);
-			  next0 = (e0->next_index < n_next_nodes) ?
-			    e0->next_index : next0;
-			  hits++;
-			  chain_hits++;
-			  break;
-			}
-		    }
+		  next0 = (t0->miss_next_index < n_next_nodes) ?
+		    t0->miss_next_index : next0;
+		  misses++;
 		}
 	    }
 
@@ -679,6 +679,66 @@ VLIB_CLI_COMMAND (pg_capture_cmd, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+pg_flow_offload_cmd_fn (vlib_main_t *vm, unformat_input_t *input,
+			vlib_cli_command_t *cmd)
+{
+  pg_main_t *pg = &pg_main;
+  clib_error_t *error = 0;
+  vnet_main_t *vnm = vnet_get_main ();
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_hw_interface_t *hi = 0;
+  pg_interface_t *pi;
+  u32 hw_if_index;
+  u32 is_disable = 0;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U", unformat_vnet_hw_interface, vnm,
+		    &hw_if_index))
+	hi = vnet_get_hw_interface (vnm, hw_if_index);
+      else if (unformat (line_input, "disable"))
+	is_disable = 1;
+      else
+	{
+	  error = clib_error_create ("unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (!hi)
+    {
+      error = clib_error_return (0, "Please specify interface name");
+      goto done;
+    }
+
+  if (hi->dev_class_index != pg_dev_class.index)
+    {
+      error =
+	clib_error_return (0, "Please specify packet-generator interface");
+      goto done;
+    }
+
+  /* flows added before stay until they are deleted */
+  pi = pool_elt_at_index (pg->interfaces, hi->dev_instance);
+  pi->flow_offload_enabled = !is_disable;
+
+done:
+  unformat_free (line_input);
+
+  return error;
+}
+
+VLIB_CLI_COMMAND (pg_flow_offload_cmd, static) = {
+  .path = "packet-generator flow-offload",
+  .short_help = "packet-generator flow-offload <interface name> [disable]",
+  .function = pg_flow_offload_cmd_fn,
+};
+
 static clib_error_t *
 create_pg_if_cmd_fn (vlib_main_t * vm,
 		     unformat_input_t * input, vlib_cli_command_t * cmd)
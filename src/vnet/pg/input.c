@@ -50,6 +50,7 @@
 #include <vnet/vnet.h>
 #include <vnet/ethernet/ethernet.h>
 #include <vnet/feature/feature.h>
+#include <vnet/flow/flow.h>
 #include <vnet/ip/ip4_packet.h>
 #include <vnet/ip/ip6_packet.h>
 #include <vnet/udp/udp_packet.h>
@@ -1621,6 +1622,61 @@ fill_buffer_offload_flags (vlib_main_t *vm, u32 *buffers, u32 n_buffers,
     }
 }
 
+static_always_inline int
+pg_flow_match (vnet_flow_ip4_n_tuple_t *t, ip4_header_t *ip4)
+{
+  udp_header_t *udp = ip4_next_header (ip4);
+
+  if ((ip4->src_address.as_u32 ^ t->src_addr.addr.as_u32) &
+	t->src_addr.mask.as_u32 ||
+      (ip4->dst_address.as_u32 ^ t->dst_addr.addr.as_u32) &
+	t->dst_addr.mask.as_u32 ||
+      (ip4->protocol ^ t->protocol.prot) & t->protocol.mask)
+    return 0;
+  if (ip4->protocol != IP_PROTOCOL_TCP && ip4->protocol != IP_PROTOCOL_UDP)
+    return !t->src_port.mask && !t->dst_port.mask;
+  return !((clib_net_to_host_u16 (udp->src_port) ^ t->src_port.port) &
+	   t->src_port.mask) &&
+	 !((clib_net_to_host_u16 (udp->dst_port) ^ t->dst_port.port) &
+	   t->dst_port.mask);
+}
+
+/* Mark the packets of the flows added to the interface, like a NIC would */
+static_always_inline void
+pg_mark_flows (vlib_main_t *vm, pg_interface_t *pi, u32 *buffers,
+	       u32 n_buffers)
+{
+  for (int i = 0; i < n_buffers; i++)
+    {
+      vlib_buffer_t *b0 = vlib_get_buffer (vm, buffers[i]);
+      ip4_header_t *ip4 = vlib_buffer_get_current (b0);
+      u32 *fi;
+
+      b0->flow_id = 0;
+      if (pi->mode == PG_MODE_ETHERNET)
+	{
+	  ethernet_header_t *eh = vlib_buffer_get_current (b0);
+
+	  if (eh->type != clib_host_to_net_u16 (ETHERNET_TYPE_IP4))
+	    continue;
+	  ip4 = (ip4_header_t *) (eh + 1);
+	}
+      else if (pi->mode != PG_MODE_IP4)
+	continue;
+
+      vec_foreach (fi, pi->flows)
+	{
+	  vnet_flow_t *flow = vnet_get_flow (*fi);
+
+	  if (pg_flow_match (&flow->ip4_n_tuple, ip4))
+	    {
+	      b0->flow_id = flow->mark_flow_id;
+	      break;
+	    }
+	}
+    }
+}
+
 static uword
 pg_generate_packets (vlib_node_runtime_t * node,
 		     pg_main_t * pg,
@@ -1728,6 +1784,9 @@ pg_generate_packets (vlib_node_runtime_t * node,
 				     pi->gso_size);
 	}
 
+      if (PREDICT_FALSE (vec_len (pi->flows)))
+	pg_mark_flows (vm, pi, to_next, n_this_frame);
+
       n_trace = vlib_get_trace_count (vm, node);
       if (PREDICT_FALSE (n_trace > 0))
 	{
@@ -326,6 +326,10 @@ typedef struct
   pg_interface_mode_t mode;
 
   mac_address_t *allowed_mcast_macs;
+
+  /* Emulated flow offload, the packets of these flows are marked */
+  u8 flow_offload_enabled;
+  u32 *flows;
 } pg_interface_t;
 
 /* Per VLIB node data. */
@@ -43,6 +43,7 @@
 #include <vnet/ip/ip.h>
 #include <vnet/mpls/mpls.h>
 #include <vnet/devices/devices.h>
+#include <vnet/flow/flow.h>
 
 /* Mark stream active or inactive. */
 void
@@ -171,6 +172,36 @@ pg_add_del_mac_address (vnet_hw_interface_t * hi,
   return (NULL);
 }
 
+static int
+pg_flow_ops (vnet_main_t *vnm, vnet_flow_dev_op_t op, u32 dev_instance,
+	     u32 flow_index, uword *private_data)
+{
+  pg_main_t *pg = &pg_main;
+  pg_interface_t *pi = pool_elt_at_index (pg->interfaces, dev_instance);
+  vnet_flow_t *flow = vnet_get_flow (flow_index);
+  u32 pos;
+
+  switch (op)
+    {
+    case VNET_FLOW_DEV_OP_ADD_FLOW:
+      if (!pi->flow_offload_enabled ||
+	  flow->type != VNET_FLOW_TYPE_IP4_N_TUPLE ||
+	  flow->actions != VNET_FLOW_ACTION_MARK)
+	return VNET_FLOW_ERROR_NOT_SUPPORTED;
+      vec_add1 (pi->flows, flow_index);
+      return 0;
+    case VNET_FLOW_DEV_OP_DEL_FLOW:
+      /* also once disabled, flows added before are still marked */
+      pos = vec_search (pi->flows, flow_index);
+      if (~0 == pos)
+	return VNET_FLOW_ERROR_NO_SUCH_ENTRY;
+      vec_del1 (pi->flows, pos);
+      return 0;
+    default:
+      return VNET_FLOW_ERROR_NOT_SUPPORTED;
+    }
+}
+
 /* *INDENT-OFF* */
 VNET_DEVICE_CLASS (pg_dev_class) = {
   .name = "pg",
@@ -179,6 +210,7 @@ VNET_DEVICE_CLASS (pg_dev_class) = {
   .format_tx_trace = format_pg_output_trace,
   .admin_up_down_function = pg_interface_admin_up_down,
   .mac_addr_add_del_function = pg_add_del_mac_address,
+  .flow_ops_function = pg_flow_ops,
 };
 /* *INDENT-ON* */
 
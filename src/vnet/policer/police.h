@@ -66,6 +66,21 @@ typedef enum
 // The lock field should be used for a spin-lock on the struct. Alternatively,
 // a thread index field is provided so that policed packets may be handed
 // off to a single worker thread.
+//
+// A distributed policer is neither locked per packet nor handed off. Each
+// thread polices from its own pair of buckets (policer_local_t) and only
+// takes the lock to borrow up to a quantum of tokens from the shared buckets
+// when its own run short. Tokens on loan still count against the limits, so
+// the shared buckets are only refilled up to the limits less what the
+// threads hold, and shared plus borrowed tokens never exceed one burst.
+// Tokens left in the buckets of an idle thread are not available to the
+// others, so a policer distributed over N threads may under-admit by at
+// most N quanta.
+//
+// vnet_police_packet () is the single bucket algorithm and must not be used
+// on a distributed policer; the data-plane users (input and output feature,
+// classify and punt policers) all go through vnet_policer_police (), which
+// picks the distributed path.
 
 #define POLICER_TICKS_PER_PERIOD_SHIFT 17
 #define POLICER_TICKS_PER_PERIOD       (1 << POLICER_TICKS_PER_PERIOD_SHIFT)
@@ -78,7 +93,8 @@ typedef struct
   u32 scale;			// power-of-2 shift amount for lower rates
   qos_action_type_en action[3];
   ip_dscp_t mark_dscp[3];
-  u8 pad[2];
+  u8 distributed;		// police from per-thread buckets
+  u8 lock;			// protects the shared buckets when distributed
 
   // Fields are marked as 2R if they are only used for a 2-rate policer,
   // and MOD if they are modified as part of the update operation.
@@ -106,6 +122,8 @@ vnet_police_packet (policer_t *policer, u32 packet_length,
   u64 current_tokens, extended_tokens;
   policer_result_e result;
 
+  ASSERT (!policer->distributed);
+
   // Scale packet length to support a wide range of speeds
   packet_length = packet_length << policer->scale;
 
@@ -214,6 +232,138 @@ vnet_police_packet (policer_t *policer, u32 packet_length,
   return result;
 }
 
+// Per-thread buckets of a distributed policer, one cache-line per thread.
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  u32 current_bucket;	 // tokens borrowed from the shared current bucket
+  u32 extended_bucket;	 // tokens borrowed from the shared extended bucket
+  u32 quantum;		 // max tokens borrowed at once, unscaled; 0 = 1 period
+  u64 last_borrow_time;	 // period of the last borrow
+} policer_local_t;
+
+// Move tokens from the shared buckets to the thread's buckets.
+static_always_inline void
+vnet_police_borrow (policer_t *policer, policer_local_t *locals,
+		    policer_local_t *local, u64 want, u64 time)
+{
+  u64 n_periods = 0;
+  u64 current_tokens, extended_tokens, take;
+  u64 current_loaned = 0, extended_loaned = 0;
+  u32 extended_tokens_per_period;
+  policer_local_t *l;
+
+  extended_tokens_per_period = policer->single_rate ?
+				 policer->cir_tokens_per_period :
+				 policer->pir_tokens_per_period;
+
+  while (clib_atomic_test_and_set (&policer->lock))
+    CLIB_PAUSE ();
+
+  // The threads' clocks are not exactly in step, never go backwards
+  if (time > policer->last_update_time)
+    {
+      n_periods = time - policer->last_update_time;
+      policer->last_update_time = time;
+    }
+
+  // Loans only grow under the lock, so a stale read of another thread's
+  // bucket over-counts and errs on the side of admitting less
+  vec_foreach (l, locals)
+    {
+      current_loaned += clib_atomic_load_relax_n (&l->current_bucket);
+      extended_loaned += clib_atomic_load_relax_n (&l->extended_bucket);
+    }
+
+  current_tokens =
+    policer->current_bucket + n_periods * policer->cir_tokens_per_period;
+  if (current_tokens + current_loaned > policer->current_limit)
+    current_tokens = policer->current_limit > current_loaned ?
+		       policer->current_limit - current_loaned :
+		       0;
+  extended_tokens =
+    policer->extended_bucket + n_periods * extended_tokens_per_period;
+  if (extended_tokens + extended_loaned > policer->extended_limit)
+    extended_tokens = policer->extended_limit > extended_loaned ?
+			policer->extended_limit - extended_loaned :
+			0;
+
+  // Top each of the thread's buckets up to want, as far as possible
+  take = want > local->current_bucket ? want - local->current_bucket : 0;
+  take = clib_min (current_tokens, take);
+  policer->current_bucket = current_tokens - take;
+  local->current_bucket += take;
+
+  take = want > local->extended_bucket ? want - local->extended_bucket : 0;
+  take = clib_min (extended_tokens, take);
+  policer->extended_bucket = extended_tokens - take;
+  local->extended_bucket += take;
+
+  clib_atomic_release (&policer->lock);
+
+  local->last_borrow_time = time;
+}
+
+// Same colouring as vnet_police_packet () but from the thread's buckets.
+// A thread borrows at most once per period, so a policer running over its
+// rate costs one lock per thread and period rather than one per packet.
+static inline policer_result_e
+vnet_police_packet_distributed (policer_t *policer, policer_local_t *locals,
+				policer_local_t *local, u32 packet_length,
+				policer_result_e packet_color, u64 time)
+{
+  u64 quantum;
+
+  packet_length = packet_length << policer->scale;
+
+  if (PREDICT_FALSE ((local->current_bucket < packet_length ||
+		      local->extended_bucket < packet_length) &&
+		     local->last_borrow_time != time))
+    {
+      quantum = local->quantum ? (u64) local->quantum << policer->scale :
+				 policer->cir_tokens_per_period;
+      // No more than a full bucket, which also keeps the sum within 32 bits
+      vnet_police_borrow (
+	policer, locals, local,
+	clib_min (quantum + packet_length,
+		  clib_max (policer->current_limit, policer->extended_limit)),
+	time);
+    }
+
+  if (policer->single_rate)
+    {
+      if ((!policer->color_aware || (packet_color == POLICE_CONFORM)) &&
+	  (local->current_bucket >= packet_length))
+	{
+	  local->current_bucket -= packet_length;
+	  local->extended_bucket -=
+	    clib_min (local->extended_bucket, packet_length);
+	  return POLICE_CONFORM;
+	}
+      if ((!policer->color_aware || (packet_color != POLICE_VIOLATE)) &&
+	  (local->extended_bucket >= packet_length))
+	{
+	  local->extended_bucket -= packet_length;
+	  return POLICE_EXCEED;
+	}
+      return POLICE_VIOLATE;
+    }
+
+  // Two-rate policer
+  if ((policer->color_aware && (packet_color == POLICE_VIOLATE)) ||
+      (local->extended_bucket < packet_length))
+    return POLICE_VIOLATE;
+
+  local->extended_bucket -= packet_length;
+
+  if ((policer->color_aware && (packet_color == POLICE_EXCEED)) ||
+      (local->current_bucket < packet_length))
+    return POLICE_EXCEED;
+
+  local->current_bucket -= packet_length;
+  return POLICE_CONFORM;
+}
+
 #endif // __POLICE_H__
 
 /*
@@ -72,6 +72,20 @@ vnet_policer_police (vlib_main_t *vm, vlib_buffer_t *b, u32 policer_index,
 
   pol = &pm->policers[policer_index];
 
+  if (pol->distributed)
+    {
+      /* Policed on this thread, never handed off */
+      policer_local_t *locals, *local;
+
+      locals = pm->locals_by_policer[policer_index];
+      local = vec_elt_at_index (locals, vm->thread_index);
+      len = vlib_buffer_length_in_chain (vm, b);
+      col = vnet_police_packet_distributed (pol, locals, local, len,
+					    packet_color,
+					    time_in_policer_periods);
+      goto done;
+    }
+
   if (handoff)
     {
       if (PREDICT_FALSE (pol->thread_index == ~0))
@@ -90,6 +104,8 @@ vnet_policer_police (vlib_main_t *vm, vlib_buffer_t *b, u32 policer_index,
 
   len = vlib_buffer_length_in_chain (vm, b);
   col = vnet_police_packet (pol, len, packet_color, time_in_policer_periods);
+
+done:
   act = pol->action[col];
   vlib_increment_combined_counter (&policer_counters[col], vm->thread_index,
 				   policer_index, 1, len);
@@ -123,7 +139,7 @@ policer_handoff (vlib_main_t *vm, vlib_node_runtime_t *node,
   u32 n_enq, n_left_from, *from;
   vnet_policer_main_t *pm;
   policer_t *policer;
-  u32 this_thread, policer_thread;
+  u32 this_thread, policer_thread = ~0;
   bool single_policer_node = (policer_index != ~0);
 
   pm = &vnet_policer_main;
@@ -49,6 +49,24 @@ vlib_combined_counter_main_t policer_counters[] = {
   },
 };
 
+/* Drop the tokens the threads of a distributed policer have borrowed */
+static void
+policer_locals_reset (u32 policer_index)
+{
+  vnet_policer_main_t *pm = &vnet_policer_main;
+  policer_local_t *local;
+
+  if (policer_index >= vec_len (pm->locals_by_policer))
+    return;
+
+  vec_foreach (local, pm->locals_by_policer[policer_index])
+    {
+      local->current_bucket = 0;
+      local->extended_bucket = 0;
+      local->last_borrow_time = 0;
+    }
+}
+
 int
 policer_add (vlib_main_t *vm, const u8 *name, const qos_pol_cfg_params_st *cfg,
 	     u32 *policer_index)
@@ -118,6 +136,9 @@ policer_del (vlib_main_t *vm, u32 policer_index)
       hash_unset_mem (pm->policer_config_by_name, policer->name);
     }
 
+  if (policer_index < vec_len (pm->locals_by_policer))
+    vec_free (pm->locals_by_policer[policer_index]);
+
   /* free policer */
   hash_unset_mem (pm->policer_index_by_name, policer->name);
   vec_free (policer->name);
@@ -134,6 +155,7 @@ policer_update (vlib_main_t *vm, u32 policer_index,
   policer_t test_policer;
   policer_t *policer;
   qos_pol_cfg_params_st *cp;
+  u8 distributed;
   uword *p;
   u8 *name;
   int rv;
@@ -164,12 +186,15 @@ policer_update (vlib_main_t *vm, u32 policer_index,
     }
 
   name = policer->name;
+  distributed = policer->distributed;
 
   clib_memcpy (cp, cfg, sizeof (*cp));
   clib_memcpy (policer, &test_policer, sizeof (*policer));
 
   policer->name = name;
   policer->thread_index = ~0;
+  policer->distributed = distributed;
+  policer_locals_reset (policer_index);
 
   for (i = 0; i < NUM_POLICE_RESULTS; i++)
     vlib_zero_combined_counter (&policer_counters[i], policer_index);
@@ -190,6 +215,7 @@ policer_reset (vlib_main_t *vm, u32 policer_index)
 
   policer->current_bucket = policer->current_limit;
   policer->extended_bucket = policer->extended_limit;
+  policer_locals_reset (policer_index);
 
   return 0;
 }
@@ -213,6 +239,7 @@ policer_bind_worker (u32 policer_index, u32 worker, bool bind)
 	}
 
       policer->thread_index = vlib_get_worker_thread_index (worker);
+      policer->distributed = 0;
     }
   else
     {
@@ -221,6 +248,35 @@ policer_bind_worker (u32 policer_index, u32 worker, bool bind)
   return 0;
 }
 
+int
+policer_distribute (u32 policer_index, u32 quantum, bool distribute)
+{
+  vnet_policer_main_t *pm = &vnet_policer_main;
+  policer_local_t *local;
+  policer_t *policer;
+
+  if (pool_is_free_index (pm->policers, policer_index))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  policer = &pm->policers[policer_index];
+
+  if (distribute)
+    {
+      vec_validate (pm->locals_by_policer, policer_index);
+      vec_validate_aligned (pm->locals_by_policer[policer_index],
+			    vlib_get_n_threads () - 1, CLIB_CACHE_LINE_BYTES);
+      policer_locals_reset (policer_index);
+      vec_foreach (local, pm->locals_by_policer[policer_index])
+	local->quantum = quantum;
+
+      policer->thread_index = ~0;
+    }
+
+  policer->distributed = distribute;
+
+  return 0;
+}
+
 int
 policer_input (u32 policer_index, u32 sw_if_index, vlib_dir_t dir, bool apply)
 {
@@ -275,6 +331,17 @@ format_policer_instance (u8 * s, va_list * va)
 	      i->current_limit,
 	      i->current_bucket, i->extended_limit, i->extended_bucket);
   s = format (s, "last update %llu\n", i->last_update_time);
+  if (i->distributed)
+    {
+      policer_local_t *local;
+
+      local = vec_elt_at_index (pm->locals_by_policer[policer_index], 0);
+      s = format (s, "distributed, quantum %u bytes\n", local->quantum);
+      vec_foreach (local, pm->locals_by_policer[policer_index])
+	s = format (s, "  thread %u: cur bkt %u, ext bkt %u\n",
+		    local - pm->locals_by_policer[policer_index],
+		    local->current_bucket, local->extended_bucket);
+    }
   s = format (s, "conform %llu packets, %llu bytes\n",
 	      counts[POLICE_CONFORM].packets, counts[POLICE_CONFORM].bytes);
   s = format (s, "exceed %llu packets, %llu bytes\n",
@@ -758,6 +825,63 @@ done:
   return error;
 }
 
+static clib_error_t *
+policer_distribute_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			       vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  clib_error_t *error = NULL;
+  vnet_policer_main_t *pm = &vnet_policer_main;
+  u8 distribute = 1;
+  u8 *name = 0;
+  u32 quantum = 0;
+  u32 policer_index = ~0;
+  uword *p;
+  int rv;
+
+  /* Get a line of input. */
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "name %s", &name))
+	;
+      else if (unformat (line_input, "index %u", &policer_index))
+	;
+      else if (unformat (line_input, "quantum %u", &quantum))
+	;
+      else if (unformat (line_input, "disable"))
+	distribute = 0;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (~0 == policer_index && 0 != name)
+    {
+      p = hash_get_mem (pm->policer_index_by_name, name);
+      if (p != NULL)
+	policer_index = p[0];
+    }
+
+  rv = VNET_API_ERROR_NO_SUCH_ENTRY;
+  if (~0 != policer_index)
+    rv = policer_distribute (policer_index, quantum, distribute);
+
+  if (rv)
+    error = clib_error_return (0, "failed: `%d'", rv);
+
+done:
+  unformat_free (line_input);
+  vec_free (name);
+
+  return error;
+}
+
 static clib_error_t *
 policer_input_command_fn (vlib_main_t *vm, unformat_input_t *input,
 			  vlib_cli_command_t *cmd)
@@ -917,6 +1041,13 @@ VLIB_CLI_COMMAND (policer_bind_command, static) = {
   .function = policer_bind_command_fn,
 };
 
+VLIB_CLI_COMMAND (policer_distribute_command, static) = {
+  .path = "policer distribute",
+  .short_help = "policer distribute [name <name> | index <index>] "
+		"[quantum <bytes>] [disable]",
+  .function = policer_distribute_command_fn,
+};
+
 VLIB_CLI_COMMAND (policer_input_command, static) = {
   .path = "policer input",
   .short_help =
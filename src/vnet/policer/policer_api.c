@@ -221,6 +221,22 @@ vl_api_policer_bind_v2_t_handler (vl_api_policer_bind_v2_t *mp)
   REPLY_MACRO (VL_API_POLICER_BIND_V2_REPLY);
 }
 
+static void
+vl_api_policer_distribute_t_handler (vl_api_policer_distribute_t *mp)
+{
+  vl_api_policer_distribute_reply_t *rmp;
+  u32 policer_index;
+  u32 quantum;
+  int rv;
+
+  policer_index = ntohl (mp->policer_index);
+  quantum = ntohl (mp->quantum);
+
+  rv = policer_distribute (policer_index, quantum, mp->enable);
+
+  REPLY_MACRO (VL_API_POLICER_DISTRIBUTE_REPLY);
+}
+
 static void
 vl_api_policer_input_t_handler (vl_api_policer_input_t *mp)
 {
@@ -706,7 +706,31 @@ clib_bitmap_next_set (uword * ai, uword i)
       if (t)
 	return log2_first_set (t) + i0 * BITS (ai[0]);
 
-      for (i0++; i0 < vec_len (ai); i0++)
+      i0++;
+#if uword_bits == 64
+#if defined(CLIB_HAVE_VEC256)
+      while (i0 + 7 < vec_len (ai))
+	{
+	  u64x4 v;
+	  v = u64x4_load_unaligned (ai + i0) |
+	      u64x4_load_unaligned (ai + i0 + 4);
+	  if (!u64x4_is_all_zero (v))
+	    break;
+	  i0 += 8;
+	}
+#elif defined(CLIB_HAVE_VEC128) && defined(CLIB_HAVE_VEC128_UNALIGNED_LOAD_STORE)
+      while (i0 + 3 < vec_len (ai))
+	{
+	  u64x2 v;
+	  v = u64x2_load_unaligned (ai + i0) |
+	      u64x2_load_unaligned (ai + i0 + 2);
+	  if (!u64x2_is_all_zero (v))
+	    break;
+	  i0 += 4;
+	}
+#endif
+#endif
+      for (; i0 < vec_len (ai); i0++)
 	{
 	  t = ai[i0];
 	  if (t)
@@ -0,0 +1,278 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright(c) 2024 Cisco Systems, Inc.
+ */
+
+#ifndef __clib_chacha20_h__
+#define __clib_chacha20_h__
+
+#include <vppinfra/clib.h>
+#include <vppinfra/vector.h>
+#include <vppinfra/cache.h>
+#include <vppinfra/string.h>
+#include <vppinfra/crypto/poly1305.h>
+
+/*
+ * implementation of DJB's chacha20 and of the chacha20-poly1305 AEAD
+ * construction from RFC 8439.
+ *
+ * keystream is generated for CLIB_CHACHA20_N_LANES consecutive blocks at
+ * once, the state word i of all blocks sits in vector x[i], one block per
+ * lane, so each quarter round operation works on all blocks. generating a
+ * batch costs the same instructions as a single block, a packet needs
+ * one batch per 64 x CLIB_CHACHA20_N_LANES bytes.
+ */
+
+#if defined(CLIB_HAVE_VEC512)
+#define CLIB_CHACHA20_N_LANES 16
+typedef u32x16 clib_chacha20_vec_t;
+#elif defined(CLIB_HAVE_VEC256)
+#define CLIB_CHACHA20_N_LANES 8
+typedef u32x8 clib_chacha20_vec_t;
+#else
+#define CLIB_CHACHA20_N_LANES 4
+typedef u32x4 clib_chacha20_vec_t;
+#endif
+
+#define CLIB_CHACHA20_KEY_SIZE	 32
+#define CLIB_CHACHA20_NONCE_SIZE 12
+#define CLIB_CHACHA20_BLOCK_SIZE 64
+#define CLIB_CHACHA20_BATCH_SIZE                                              \
+  (CLIB_CHACHA20_BLOCK_SIZE * CLIB_CHACHA20_N_LANES)
+
+typedef struct
+{
+  /* key in host byte order words */
+  u32 k[8];
+} clib_chacha20_key_t;
+
+typedef struct
+{
+  /* word i of the keystream block in lane j is in w[i][j] */
+  u32 w[16][CLIB_CHACHA20_N_LANES] __clib_aligned (sizeof (clib_chacha20_vec_t));
+} clib_chacha20_batch_t;
+
+static_always_inline void
+clib_chacha20_key_init (clib_chacha20_key_t *key, const u8 *data)
+{
+  u32u *d = (u32u *) data;
+
+  for (int i = 0; i < 8; i++)
+    key->k[i] = clib_little_to_host_u32 (d[i]);
+}
+
+#define _clib_chacha20_rotl(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define _clib_chacha20_qr(a, b, c, d)                                         \
+  do                                                                          \
+    {                                                                         \
+      x[a] += x[b];                                                           \
+      x[d] = _clib_chacha20_rotl (x[d] ^ x[a], 16);                           \
+      x[c] += x[d];                                                           \
+      x[b] = _clib_chacha20_rotl (x[b] ^ x[c], 12);                           \
+      x[a] += x[b];                                                           \
+      x[d] = _clib_chacha20_rotl (x[d] ^ x[a], 8);                            \
+      x[c] += x[d];                                                           \
+      x[b] = _clib_chacha20_rotl (x[b] ^ x[c], 7);                            \
+    }                                                                         \
+  while (0)
+
+/* keystream of blocks ctr to ctr + CLIB_CHACHA20_N_LANES - 1 */
+static_always_inline void
+clib_chacha20_batch (const clib_chacha20_key_t *key, const u32 nonce[3],
+		     u32 ctr, clib_chacha20_batch_t *b)
+{
+  const u32 sigma[4] = { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574 };
+  clib_chacha20_vec_t x[16], s[16];
+  clib_chacha20_vec_t z = {};
+  int i;
+
+  for (i = 0; i < 4; i++)
+    s[i] = z + sigma[i];
+  for (i = 0; i < 8; i++)
+    s[4 + i] = z + key->k[i];
+  for (i = 0; i < CLIB_CHACHA20_N_LANES; i++)
+    s[12][i] = ctr + i;
+  for (i = 0; i < 3; i++)
+    s[13 + i] = z + nonce[i];
+
+  for (i = 0; i < 16; i++)
+    x[i] = s[i];
+
+  for (i = 0; i < 10; i++)
+    {
+      /* column round */
+      _clib_chacha20_qr (0, 4, 8, 12);
+      _clib_chacha20_qr (1, 5, 9, 13);
+      _clib_chacha20_qr (2, 6, 10, 14);
+      _clib_chacha20_qr (3, 7, 11, 15);
+      /* diagonal round */
+      _clib_chacha20_qr (0, 5, 10, 15);
+      _clib_chacha20_qr (1, 6, 11, 12);
+      _clib_chacha20_qr (2, 7, 8, 13);
+      _clib_chacha20_qr (3, 4, 9, 14);
+    }
+
+  for (i = 0; i < 16; i++)
+    *(clib_chacha20_vec_t *) b->w[i] = x[i] + s[i];
+}
+
+#undef _clib_chacha20_qr
+#undef _clib_chacha20_rotl
+
+/* xor up to one block of data with the keystream block of a lane */
+static_always_inline void
+clib_chacha20_batch_xor (const clib_chacha20_batch_t *b, int lane, u8 *dst,
+			 const u8 *src, u32 n_bytes)
+{
+  u32 ks[16];
+  int i;
+
+  for (i = 0; i < 16; i++)
+    ks[i] = clib_host_to_little_u32 (b->w[i][lane]);
+
+  if (PREDICT_TRUE (n_bytes == CLIB_CHACHA20_BLOCK_SIZE))
+    {
+      for (i = 0; i < 16; i++)
+	((u32u *) dst)[i] = ((u32u *) src)[i] ^ ks[i];
+      return;
+    }
+
+  for (i = 0; i < n_bytes; i++)
+    dst[i] = src[i] ^ ((u8 *) ks)[i];
+}
+
+/* xor data with the keystream starting at block ctr */
+static_always_inline void
+clib_chacha20_xor (const clib_chacha20_key_t *key, const u32 nonce[3],
+		   u32 ctr, u8 *dst, const u8 *src, uword n_bytes)
+{
+  clib_chacha20_batch_t b;
+
+  while (n_bytes)
+    {
+      clib_chacha20_batch (key, nonce, ctr, &b);
+
+      for (int i = 0; i < CLIB_CHACHA20_N_LANES && n_bytes; i++)
+	{
+	  u32 n = clib_min (n_bytes, CLIB_CHACHA20_BLOCK_SIZE);
+	  clib_chacha20_batch_xor (&b, i, dst, src, n);
+	  dst += n;
+	  src += n;
+	  n_bytes -= n;
+	}
+
+      ctr += CLIB_CHACHA20_N_LANES;
+    }
+}
+
+typedef enum
+{
+  CLIB_CHACHA20_POLY1305_OP_ENCRYPT,
+  CLIB_CHACHA20_POLY1305_OP_DECRYPT,
+} clib_chacha20_poly1305_op_t;
+
+/*
+ * authenticate len bytes followed by zero padding to the next 16 byte
+ * boundary. aad and ciphertext are both padded, so the context never holds
+ * partial data here and full blocks go straight to the accumulator.
+ */
+static_always_inline void
+_clib_chacha20_poly1305_update_padded (clib_poly1305_ctx *ctx, const u8 *msg,
+				       uword len)
+{
+  uword n_tail = len & 15;
+
+  ASSERT (ctx->n_partial_bytes == 0);
+  _clib_poly1305_add_blocks (ctx, msg, len - n_tail, 1);
+
+  if (n_tail)
+    {
+      u8 last[16] = {};
+      clib_memcpy_fast (last, msg + len - n_tail, n_tail);
+      _clib_poly1305_add_blocks (ctx, last, sizeof (last), 1);
+    }
+}
+
+/*
+ * chacha20-poly1305 AEAD, returns 0 if the tag of a decrypted message does
+ * not match. the first batch of keystream provides the poly1305 key from
+ * block 0 and the cipher blocks from 1 on, each batch is authenticated
+ * right after (encrypt) or before (decrypt) it is ciphered.
+ */
+static_always_inline int
+clib_chacha20_poly1305 (const clib_chacha20_key_t *key, const u8 *iv,
+			const u8 *aad, u32 aad_len, const u8 *src, u8 *dst,
+			u32 n_bytes, u8 *tag, u32 tag_len,
+			clib_chacha20_poly1305_op_t op)
+{
+  const int is_enc = op == CLIB_CHACHA20_POLY1305_OP_ENCRYPT;
+  u32 nonce[3], ctr = 0, n_left = n_bytes;
+  clib_chacha20_batch_t b;
+  clib_poly1305_ctx pctx;
+  u8 poly_key[32], t[16];
+  u64 lens[2];
+  int lane = 1;
+
+  for (int i = 0; i < 3; i++)
+    nonce[i] = clib_little_to_host_u32 (((u32u *) iv)[i]);
+
+  clib_chacha20_batch (key, nonce, ctr, &b);
+  for (int i = 0; i < 8; i++)
+    ((u32u *) poly_key)[i] = clib_host_to_little_u32 (b.w[i][0]);
+
+  clib_poly1305_init (&pctx, poly_key);
+  _clib_chacha20_poly1305_update_padded (&pctx, aad, aad_len);
+
+  while (n_left)
+    {
+      u32 n = clib_min (n_left, (CLIB_CHACHA20_N_LANES - lane) *
+				  CLIB_CHACHA20_BLOCK_SIZE);
+
+      if (!is_enc)
+	_clib_chacha20_poly1305_update_padded (&pctx, src, n);
+
+      for (u32 done = 0; done < n; done += CLIB_CHACHA20_BLOCK_SIZE, lane++)
+	clib_chacha20_batch_xor (&b, lane, dst + done, src + done,
+				 clib_min (n - done, CLIB_CHACHA20_BLOCK_SIZE));
+
+      if (is_enc)
+	_clib_chacha20_poly1305_update_padded (&pctx, dst, n);
+
+      src += n;
+      dst += n;
+      n_left -= n;
+
+      if (n_left)
+	{
+	  ctr += CLIB_CHACHA20_N_LANES;
+	  clib_chacha20_batch (key, nonce, ctr, &b);
+	  lane = 0;
+	}
+    }
+
+  lens[0] = clib_host_to_little_u64 (aad_len);
+  lens[1] = clib_host_to_little_u64 (n_bytes);
+  clib_poly1305_update (&pctx, (u8 *) lens, sizeof (lens));
+  clib_poly1305_final (&pctx, t);
+
+  clib_memset_u8 (poly_key, 0, sizeof (poly_key));
+
+  /* poly1305 tags are 16 bytes, callers may only ask for a truncated one */
+  ASSERT (tag_len <= sizeof (t));
+  tag_len = clib_min (tag_len, sizeof (t));
+
+  if (is_enc)
+    {
+      clib_memcpy_fast (tag, t, tag_len);
+      return 1;
+    }
+
+  /* constant time tag compare */
+  u8 diff = 0;
+  for (u32 i = 0; i < tag_len; i++)
+    diff |= tag[i] ^ t[i];
+
+  return diff == 0;
+}
+
+#endif /* __clib_chacha20_h__ */
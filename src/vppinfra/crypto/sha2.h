@@ -413,13 +413,21 @@ clib_sha512_block (clib_sha2_ctx_t *ctx, const u8 *msg, uword n_blocks)
     }
 }
 
+/* block_size is passed separately so it folds to a constant when the hash
+ * type is known at compile time, copies into the pending buffer are then
+ * bounded by it */
 static_always_inline void
-clib_sha2_update (clib_sha2_ctx_t *ctx, const u8 *msg, uword n_bytes)
+_clib_sha2_update (clib_sha2_ctx_t *ctx, const uword block_size, const u8 *msg,
+		   uword n_bytes)
 {
   uword n_blocks;
+
+  /* pending data never fills a whole block */
+  CLIB_ASSUME (ctx->n_pending < block_size);
+
   if (ctx->n_pending)
     {
-      uword n_left = ctx->block_size - ctx->n_pending;
+      uword n_left = block_size - ctx->n_pending;
       if (n_bytes < n_left)
 	{
 	  clib_memcpy_fast (ctx->pending.as_u8 + ctx->n_pending, msg, n_bytes);
@@ -429,31 +437,31 @@ clib_sha2_update (clib_sha2_ctx_t *ctx, const u8 *msg, uword n_bytes)
       else
 	{
 	  clib_memcpy_fast (ctx->pending.as_u8 + ctx->n_pending, msg, n_left);
-	  if (ctx->block_size == SHA512_BLOCK_SIZE)
+	  if (block_size == SHA512_BLOCK_SIZE)
 	    clib_sha512_block (ctx, ctx->pending.as_u8, 1);
 	  else
 	    clib_sha256_block (ctx, ctx->pending.as_u8, 1);
 	  ctx->n_pending = 0;
-	  ctx->total_bytes += ctx->block_size;
+	  ctx->total_bytes += block_size;
 	  n_bytes -= n_left;
 	  msg += n_left;
 	}
     }
 
-  if ((n_blocks = n_bytes / ctx->block_size))
+  if ((n_blocks = n_bytes / block_size))
     {
-      if (ctx->block_size == SHA512_BLOCK_SIZE)
+      if (block_size == SHA512_BLOCK_SIZE)
 	clib_sha512_block (ctx, msg, n_blocks);
       else
 	clib_sha256_block (ctx, msg, n_blocks);
-      n_bytes -= n_blocks * ctx->block_size;
-      msg += n_blocks * ctx->block_size;
-      ctx->total_bytes += n_blocks * ctx->block_size;
+      n_bytes -= n_blocks * block_size;
+      msg += n_blocks * block_size;
+      ctx->total_bytes += n_blocks * block_size;
     }
 
   if (n_bytes)
     {
-      clib_memset_u8 (ctx->pending.as_u8, 0, ctx->block_size);
+      clib_memset_u8 (ctx->pending.as_u8, 0, block_size);
       clib_memcpy_fast (ctx->pending.as_u8, msg, n_bytes);
       ctx->n_pending = n_bytes;
     }
@@ -461,6 +469,12 @@ clib_sha2_update (clib_sha2_ctx_t *ctx, const u8 *msg, uword n_bytes)
     ctx->n_pending = 0;
 }
 
+static_always_inline void
+clib_sha2_update (clib_sha2_ctx_t *ctx, const u8 *msg, uword n_bytes)
+{
+  _clib_sha2_update (ctx, ctx->block_size, msg, n_bytes);
+}
+
 static_always_inline void
 clib_sha2_final (clib_sha2_ctx_t *ctx, u8 *digest)
 {
@@ -521,13 +535,28 @@ clib_sha2 (clib_sha2_type_t type, const u8 *msg, uword len, u8 *digest)
 #define clib_sha512_224(...) clib_sha2 (CLIB_SHA2_512_224, __VA_ARGS__)
 #define clib_sha512_256(...) clib_sha2 (CLIB_SHA2_512_256, __VA_ARGS__)
 
+typedef struct
+{
+  /* hash state after the ipad and opad block, key is not needed anymore */
+  u64 ipad_h[8];
+  u64 opad_h[8];
+} clib_sha2_hmac_key_data_t;
+
 static_always_inline void
-clib_hmac_sha2 (clib_sha2_type_t type, const u8 *key, uword key_len,
-		const u8 *msg, uword len, u8 *digest)
+_clib_sha2_block (clib_sha2_ctx_t *ctx, const u8 *msg, uword n_blocks)
+{
+  if (ctx->block_size == SHA512_BLOCK_SIZE)
+    clib_sha512_block (ctx, msg, n_blocks);
+  else
+    clib_sha256_block (ctx, msg, n_blocks);
+}
+
+static_always_inline void
+clib_sha2_hmac_key_data (clib_sha2_type_t type, const u8 *key, uword key_len,
+			 clib_sha2_hmac_key_data_t *kd)
 {
   clib_sha2_ctx_t _ctx, *ctx = &_ctx;
   uword key_data[SHA2_MAX_BLOCK_SIZE / sizeof (uword)];
-  u8 i_digest[SHA2_MAX_DIGEST_SIZE];
   int i, n_words;
 
   clib_sha2_init (ctx, type);
@@ -553,31 +582,74 @@ clib_hmac_sha2 (clib_sha2_type_t type, const u8 *key, uword key_len,
   /* ipad */
   for (i = 0; i < n_words; i++)
     ctx->pending.as_uword[i] = key_data[i] ^ (uword) 0x3636363636363636;
-  if (ctx->block_size == SHA512_BLOCK_SIZE)
-    clib_sha512_block (ctx, ctx->pending.as_u8, 1);
-  else
-    clib_sha256_block (ctx, ctx->pending.as_u8, 1);
-  ctx->total_bytes += ctx->block_size;
-
-  /* message */
-  clib_sha2_update (ctx, msg, len);
-  clib_sha2_final (ctx, i_digest);
+  _clib_sha2_block (ctx, ctx->pending.as_u8, 1);
+  clib_memcpy_fast (kd->ipad_h, ctx->h64, sizeof (kd->ipad_h));
 
   /* opad */
   clib_sha2_init (ctx, type);
   for (i = 0; i < n_words; i++)
     ctx->pending.as_uword[i] = key_data[i] ^ (uword) 0x5c5c5c5c5c5c5c5c;
-  if (ctx->block_size == SHA512_BLOCK_SIZE)
-    clib_sha512_block (ctx, ctx->pending.as_u8, 1);
-  else
-    clib_sha256_block (ctx, ctx->pending.as_u8, 1);
-  ctx->total_bytes += ctx->block_size;
+  _clib_sha2_block (ctx, ctx->pending.as_u8, 1);
+  clib_memcpy_fast (kd->opad_h, ctx->h64, sizeof (kd->opad_h));
+
+  clib_memset_u8 (key_data, 0, sizeof (key_data));
+}
+
+/* type is passed explicitly so callers handling a single hash type get
+ * the block and digest sizes as compile time constants */
+static_always_inline void
+clib_sha2_hmac_init (clib_sha2_ctx_t *ctx, clib_sha2_type_t type,
+		     const clib_sha2_hmac_key_data_t *kd)
+{
+  clib_sha2_init (ctx, type);
+  clib_memcpy_fast (ctx->h64, kd->ipad_h, sizeof (ctx->h64));
+  ctx->total_bytes = ctx->block_size;
+}
+
+static_always_inline uword
+clib_sha2_block_size (clib_sha2_type_t type)
+{
+  if (type == CLIB_SHA2_224 || type == CLIB_SHA2_256)
+    return SHA256_BLOCK_SIZE;
+  return SHA512_BLOCK_SIZE;
+}
+
+static_always_inline void
+clib_sha2_hmac_update (clib_sha2_ctx_t *ctx, clib_sha2_type_t type,
+		       const u8 *msg, uword len)
+{
+  _clib_sha2_update (ctx, clib_sha2_block_size (type), msg, len);
+}
 
-  /* digest */
-  clib_sha2_update (ctx, i_digest, ctx->digest_size);
+static_always_inline void
+clib_sha2_hmac_final (clib_sha2_ctx_t *ctx, clib_sha2_type_t type,
+		      const clib_sha2_hmac_key_data_t *kd, u8 *digest)
+{
+  u8 i_digest[SHA2_MAX_DIGEST_SIZE];
+
+  clib_sha2_final (ctx, i_digest);
+
+  clib_sha2_init (ctx, type);
+  clib_memcpy_fast (ctx->h64, kd->opad_h, sizeof (ctx->h64));
+  ctx->total_bytes = ctx->block_size;
+  _clib_sha2_update (ctx, clib_sha2_block_size (type), i_digest,
+		     ctx->digest_size);
   clib_sha2_final (ctx, digest);
 }
 
+static_always_inline void
+clib_hmac_sha2 (clib_sha2_type_t type, const u8 *key, uword key_len,
+		const u8 *msg, uword len, u8 *digest)
+{
+  clib_sha2_hmac_key_data_t kd;
+  clib_sha2_ctx_t ctx;
+
+  clib_sha2_hmac_key_data (type, key, key_len, &kd);
+  clib_sha2_hmac_init (&ctx, type, &kd);
+  clib_sha2_hmac_update (&ctx, type, msg, len);
+  clib_sha2_hmac_final (&ctx, type, &kd, digest);
+}
+
 #define clib_hmac_sha224(...) clib_hmac_sha2 (CLIB_SHA2_224, __VA_ARGS__)
 #define clib_hmac_sha256(...) clib_hmac_sha2 (CLIB_SHA2_256, __VA_ARGS__)
 #define clib_hmac_sha384(...) clib_hmac_sha2 (CLIB_SHA2_384, __VA_ARGS__)
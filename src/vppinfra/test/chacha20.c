@@ -0,0 +1,128 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright(c) 2024 Cisco Systems, Inc.
+ */
+
+#include <vppinfra/format.h>
+#include <vppinfra/test/test.h>
+#include <vppinfra/crypto/chacha20.h>
+
+/* RFC 8439 2.8.2 */
+
+static const u8 tc1_key[32] = {
+  0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b,
+  0x8c, 0x8d, 0x8e, 0x8f, 0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97,
+  0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f
+};
+
+static const u8 tc1_iv[12] = {
+  0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47
+};
+
+static const u8 tc1_aad[12] = {
+  0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7
+};
+
+static const u8 tc1_pt[114] = {
+  0x4c, 0x61, 0x64, 0x69, 0x65, 0x73, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x47,
+  0x65, 0x6e, 0x74, 0x6c, 0x65, 0x6d, 0x65, 0x6e, 0x20, 0x6f, 0x66, 0x20,
+  0x74, 0x68, 0x65, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x20, 0x6f, 0x66,
+  0x20, 0x27, 0x39, 0x39, 0x3a, 0x20, 0x49, 0x66, 0x20, 0x49, 0x20, 0x63,
+  0x6f, 0x75, 0x6c, 0x64, 0x20, 0x6f, 0x66, 0x66, 0x65, 0x72, 0x20, 0x79,
+  0x6f, 0x75, 0x20, 0x6f, 0x6e, 0x6c, 0x79, 0x20, 0x6f, 0x6e, 0x65, 0x20,
+  0x74, 0x69, 0x70, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x74, 0x68, 0x65, 0x20,
+  0x66, 0x75, 0x74, 0x75, 0x72, 0x65, 0x2c, 0x20, 0x73, 0x75, 0x6e, 0x73,
+  0x63, 0x72, 0x65, 0x65, 0x6e, 0x20, 0x77, 0x6f, 0x75, 0x6c, 0x64, 0x20,
+  0x62, 0x65, 0x20, 0x69, 0x74, 0x2e
+};
+
+static const u8 tc1_ct[114] = {
+  0xd3, 0x1a, 0x8d, 0x34, 0x64, 0x8e, 0x60, 0xdb, 0x7b, 0x86, 0xaf, 0xbc,
+  0x53, 0xef, 0x7e, 0xc2, 0xa4, 0xad, 0xed, 0x51, 0x29, 0x6e, 0x08, 0xfe,
+  0xa9, 0xe2, 0xb5, 0xa7, 0x36, 0xee, 0x62, 0xd6, 0x3d, 0xbe, 0xa4, 0x5e,
+  0x8c, 0xa9, 0x67, 0x12, 0x82, 0xfa, 0xfb, 0x69, 0xda, 0x92, 0x72, 0x8b,
+  0x1a, 0x71, 0xde, 0x0a, 0x9e, 0x06, 0x0b, 0x29, 0x05, 0xd6, 0xa5, 0xb6,
+  0x7e, 0xcd, 0x3b, 0x36, 0x92, 0xdd, 0xbd, 0x7f, 0x2d, 0x77, 0x8b, 0x8c,
+  0x98, 0x03, 0xae, 0xe3, 0x28, 0x09, 0x1b, 0x58, 0xfa, 0xb3, 0x24, 0xe4,
+  0xfa, 0xd6, 0x75, 0x94, 0x55, 0x85, 0x80, 0x8b, 0x48, 0x31, 0xd7, 0xbc,
+  0x3f, 0xf4, 0xde, 0xf0, 0x8e, 0x4b, 0x7a, 0x9d, 0xe5, 0x76, 0xd2, 0x65,
+  0x86, 0xce, 0xc6, 0x4b, 0x61, 0x16
+};
+
+static const u8 tc1_tag[16] = {
+  0x1a, 0xe1, 0x0b, 0x59, 0x4f, 0x09, 0xe2, 0x6a, 0x7e, 0x90, 0x2e, 0xcb,
+  0xd0, 0x60, 0x06, 0x91
+};
+
+static clib_error_t *
+test_clib_chacha20_poly1305 (clib_error_t *err)
+{
+  clib_chacha20_key_t k;
+  u8 ct[sizeof (tc1_pt)], pt[sizeof (tc1_pt)], tag[16];
+
+  clib_chacha20_key_init (&k, tc1_key);
+
+  clib_chacha20_poly1305 (&k, tc1_iv, tc1_aad, sizeof (tc1_aad), tc1_pt, ct,
+			  sizeof (tc1_pt), tag, sizeof (tag),
+			  CLIB_CHACHA20_POLY1305_OP_ENCRYPT);
+
+  if (memcmp (ct, tc1_ct, sizeof (ct)) != 0)
+    err = clib_error_return (err,
+			     "\nencrypt ciphertext mismatch"
+			     "\nexp: %U"
+			     "\ncalc: %U\n",
+			     format_hexdump, tc1_ct, sizeof (tc1_ct),
+			     format_hexdump, ct, sizeof (ct));
+
+  if (memcmp (tag, tc1_tag, sizeof (tag)) != 0)
+    err = clib_error_return (err,
+			     "\nencrypt tag mismatch"
+			     "\nexp: %U"
+			     "\ncalc: %U\n",
+			     format_hexdump, tc1_tag, sizeof (tc1_tag),
+			     format_hexdump, tag, sizeof (tag));
+
+  if (!clib_chacha20_poly1305 (&k, tc1_iv, tc1_aad, sizeof (tc1_aad), tc1_ct,
+			       pt, sizeof (tc1_ct), (u8 *) tc1_tag,
+			       sizeof (tc1_tag),
+			       CLIB_CHACHA20_POLY1305_OP_DECRYPT))
+    err = clib_error_return (err, "decrypt tag check failed");
+
+  if (memcmp (pt, tc1_pt, sizeof (pt)) != 0)
+    err = clib_error_return (err, "decrypt plaintext mismatch");
+
+  tag[0] ^= 1;
+  if (clib_chacha20_poly1305 (&k, tc1_iv, tc1_aad, sizeof (tc1_aad), tc1_ct,
+			      pt, sizeof (tc1_ct), tag, sizeof (tag),
+			      CLIB_CHACHA20_POLY1305_OP_DECRYPT))
+    err = clib_error_return (err, "decrypt accepted bad tag");
+
+  return err;
+}
+
+void __test_perf_fn
+perftest_byte (test_perf_t *tp)
+{
+  u32 n = tp->n_ops;
+  clib_chacha20_key_t k;
+
+  u8 *src = test_mem_alloc_and_fill_inc_u8 (n, 0, 0);
+  u8 *dst = test_mem_alloc (n);
+  u8 *key = test_mem_alloc_and_fill_inc_u8 (32, 0, 0);
+  u8 *iv = test_mem_alloc_and_fill_inc_u8 (12, 0, 0);
+  u8 *tag = test_mem_alloc (16);
+
+  clib_chacha20_key_init (&k, key);
+
+  test_perf_event_enable (tp);
+  clib_chacha20_poly1305 (&k, iv, 0, 0, src, dst, n, tag, 16,
+			  CLIB_CHACHA20_POLY1305_OP_ENCRYPT);
+  test_perf_event_disable (tp);
+}
+
+REGISTER_TEST (clib_chacha20_poly1305) = {
+  .name = "clib_chacha20_poly1305",
+  .fn = test_clib_chacha20_poly1305,
+  .perf_tests = PERF_TESTS ({ .name = "encrypt (per byte)",
+			      .n_ops = 16384,
+			      .fn = perftest_byte }),
+};
@@ -113,6 +113,51 @@ done:
   return err;
 }
 
+static clib_error_t *
+test_clib_ip_csum_hdr20 (clib_error_t *err)
+{
+  u8 *buf = test_mem_alloc_and_splat (20, 8, (void *) &test1);
+  u16 csum = clib_ip_csum (test1, 20);
+  u16 expected[8];
+
+  /* headers 0, 2, 4 and 6 carry valid checksums, others get corrupted */
+  for (int i = 0; i < 8; i++)
+    {
+      u8 *h = buf + i * 20;
+      if (i & 1)
+	h[15] += i;
+      else
+	clib_memcpy_fast (h + 10, &csum, sizeof (csum));
+      expected[i] = clib_ip_csum (h, 20);
+    }
+
+#if defined(CLIB_HAVE_VEC128)
+  u32x4 r4 = clib_ip_csum_hdr20_x4 (buf, buf + 20, buf + 40, buf + 60);
+  for (int i = 0; i < 4; i++)
+    if (r4[i] != expected[i])
+      return clib_error_return (err,
+				"x4 lane %u: expected 0x%04x, "
+				"calculated 0x%04x",
+				i, expected[i], r4[i]);
+#endif
+
+#if defined(CLIB_HAVE_VEC256)
+  u32x8 r8 = clib_ip_csum_hdr20_x8 (buf, buf + 20, buf + 40, buf + 60,
+				    buf + 80, buf + 100, buf + 120, buf + 140);
+  for (int i = 0; i < 8; i++)
+    if (r8[i] != expected[i])
+      return clib_error_return (err,
+				"x8 lane %u: expected 0x%04x, "
+				"calculated 0x%04x",
+				i, expected[i], r8[i]);
+#endif
+
+  if (expected[0] != 0 || expected[1] == 0)
+    return clib_error_return (err, "unexpected reference checksums");
+
+  return err;
+}
+
 void __test_perf_fn
 perftest_ip4_hdr (test_perf_t *tp)
 {
@@ -152,6 +197,35 @@ perftest_byte (test_perf_t *tp)
   test_perf_event_disable (tp);
 }
 
+#if defined(CLIB_HAVE_VEC256)
+void __test_perf_fn
+perftest_ip4_hdr_x8 (test_perf_t *tp)
+{
+  u32 n = tp->n_ops;
+  u8 *data = test_mem_alloc_and_splat (20, n, (void *) &test1);
+  u32x8 *res = test_mem_alloc (n / 8 * sizeof (u32x8));
+
+  test_perf_event_enable (tp);
+  for (int i = 0; i < n; i += 8)
+    {
+      u8 *d = data + i * 20;
+      res[i / 8] = clib_ip_csum_hdr20_x8 (d, d + 20, d + 40, d + 60, d + 80,
+					  d + 100, d + 120, d + 140);
+    }
+  test_perf_event_disable (tp);
+}
+#endif
+
+REGISTER_TEST (clib_ip_csum_hdr20) = {
+  .name = "clib_ip_csum_hdr20",
+  .fn = test_clib_ip_csum_hdr20,
+#if defined(CLIB_HAVE_VEC256)
+  .perf_tests = PERF_TESTS ({ .name = "8 headers in parallel (per header)",
+			      .n_ops = 1024,
+			      .fn = perftest_ip4_hdr_x8 }),
+#endif
+};
+
 REGISTER_TEST (clib_ip_csum) = {
   .name = "clib_ip_csum",
   .fn = test_clib_ip_csum,
@@ -0,0 +1,142 @@
+import socket
+import unittest
+from ipaddress import ip_address
+
+from scapy.layers.l2 import Ether
+from scapy.layers.inet import IP, UDP
+from scapy.packet import Raw
+
+from asfframework import VppTestCase, VppTestRunner
+from template_ipsec import IPSecIPv4Fwd
+
+
+class IPSec4SpdRangesUnitTest(VppTestCase):
+    """IPSec/IPv4 outbound: SPD remote range index unit test"""
+
+    def test_ipsec_spd_ranges(self):
+        """SPD range index against the policy vector"""
+        # random nested, overlapping, open ended and catch-all remote
+        # ranges with tied priorities; the index is checked against the
+        # SPD order after every add and every delete
+        self.logger.info(self.vapi.cli("test ipsec_spd_ranges policies 200 seed 1"))
+        self.logger.info(self.vapi.cli("test ipsec_spd_ranges policies 500"))
+
+
+class IPSec4SpdRangesOutbound(IPSecIPv4Fwd):
+    """IPSec/IPv4 outbound: overlapping remote range policies"""
+
+    def send_to_hosts(self, forwarded):
+        # 3 packets to each remote host of pg1, only the hosts in
+        # forwarded may come out, the others hit a discard or no policy
+        pkts = []
+        for host in self.pg1.remote_hosts:
+            pkts += [
+                (
+                    Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+                    / IP(src=self.pg0.remote_ip4, dst=host.ip4)
+                    / UDP(sport=1234, dport=5678)
+                    / Raw(b"\xa5" * 64)
+                )
+            ] * 3
+
+        if not forwarded:
+            self.send_and_assert_no_replies(self.pg0, pkts)
+            return
+
+        rx = self.send_and_expect(self.pg0, pkts, self.pg1, n_rx=3 * len(forwarded))
+        expected = [self.pg1.remote_hosts[h].ip4 for h in forwarded]
+        for p in rx:
+            self.assertIn(p[IP].dst, expected)
+        for ip in expected:
+            self.assertEqual(3, len([p for p in rx if p[IP].dst == ip]))
+
+    def add_policy(self, priority, policy_type, first, last=None):
+        hosts = self.pg1.remote_hosts
+        last = first if last is None else last
+        return self.spd_add_rem_policy(
+            1,
+            self.pg0,
+            self.pg1,
+            socket.IPPROTO_UDP,
+            is_out=1,
+            priority=priority,
+            policy_type=policy_type,
+            ip_range=True,
+            remote_ip_start=ip_address(hosts[first].ip4),
+            remote_ip_stop=ip_address(hosts[last].ip4),
+        )
+
+    def remove_policy(self, policy):
+        policy.remove_vpp_config()
+        self.spd_policies.remove(policy)
+
+    def test_ipsec_spd_outbound_ranges(self):
+        # Policies whose remote ranges nest and overlap, on top of a
+        # catch-all. The first match must follow the SPD order, highest
+        # priority first and, for equal priorities, the last one added.
+        # Deleting policies merges their boundaries back and the
+        # addresses they covered fall back to the next policy.
+        self.create_interfaces(2)
+        self.pg1.generate_remote_hosts(8)
+        self.pg1.configure_ipv4_neighbors()
+        self.spd_create_and_intf_add(1, [self.pg1])
+
+        policy_all = self.spd_add_rem_policy(
+            1,
+            self.pg0,
+            self.pg1,
+            socket.IPPROTO_UDP,
+            is_out=1,
+            priority=1,
+            policy_type="bypass",
+            all_ips=True,
+        )
+        policy_d24 = self.add_policy(10, "discard", 2, 4)
+        policy_b3 = self.add_policy(20, "bypass", 3)
+        policy_d46 = self.add_policy(15, "discard", 4, 6)
+
+        # h3 is bypassed out of the h2-h4 discard, h4 takes the higher
+        # priority h4-h6 discard
+        self.send_to_hosts([0, 1, 3, 7])
+        self.verify_policy_match(9, policy_all)
+        self.verify_policy_match(3, policy_d24)
+        self.verify_policy_match(3, policy_b3)
+        self.verify_policy_match(9, policy_d46)
+
+        # same priority as the h4-h6 discard but added later, so first
+        policy_b5 = self.add_policy(15, "bypass", 5)
+        self.send_to_hosts([0, 1, 3, 5, 7])
+        self.verify_policy_match(18, policy_all)
+        self.verify_policy_match(6, policy_d24)
+        self.verify_policy_match(6, policy_b3)
+        self.verify_policy_match(15, policy_d46)
+        self.verify_policy_match(3, policy_b5)
+
+        # h4 falls back to the h2-h4 discard and h6 to the catch-all
+        self.remove_policy(policy_d46)
+        self.send_to_hosts([0, 1, 3, 5, 6, 7])
+        self.verify_policy_match(30, policy_all)
+        self.verify_policy_match(12, policy_d24)
+        self.verify_policy_match(9, policy_b3)
+        self.verify_policy_match(6, policy_b5)
+
+        # only the catch-all and the h5 bypass are left
+        self.remove_policy(policy_d24)
+        self.remove_policy(policy_b3)
+        self.send_to_hosts([0, 1, 2, 3, 4, 5, 6, 7])
+        self.verify_policy_match(51, policy_all)
+        self.verify_policy_match(9, policy_b5)
+
+        # no policy matches anymore
+        self.remove_policy(policy_b5)
+        self.remove_policy(policy_all)
+        self.send_to_hosts([])
+
+        # a new policy only covers its own range
+        policy_b3 = self.add_policy(20, "bypass", 3)
+        self.send_to_hosts([3])
+        self.verify_policy_match(3, policy_b3)
+
+
+if __name__ == "__main__":
+    unittest.main(testRunner=VppTestRunner)
@@ -367,13 +367,17 @@ class TestClassifier(VppTestCase):
                 "didn't arrive" % (dst_if.name, i.name),
             )
 
-    def create_classify_table(self, key, mask, data_offset=0, next_table_index=None):
+    def create_classify_table(
+        self, key, mask, data_offset=0, next_table_index=None, miss_next_index=0
+    ):
         """Create Classify Table
 
         :param str key: key for classify table (ex, ACL name).
         :param str mask: mask value for interested traffic.
         :param int data_offset:
         :param str next_table_index
+        :param int miss_next_index: next node of packets missing the table,
+            ~0 to continue with the next feature.
         """
         mask_match, mask_match_len = self._resolve_mask_match(mask)
         r = self.vapi.classify_add_del_table(
@@ -381,7 +385,7 @@ class TestClassifier(VppTestCase):
             mask=mask_match,
             mask_len=mask_match_len,
             match_n_vectors=(len(mask) - 1) // 32 + 1,
-            miss_next_index=0,
+            miss_next_index=miss_next_index,
             current_data_flag=1,
             current_data_offset=data_offset,
             next_table_index=next_table_index,
@@ -390,7 +394,13 @@ class TestClassifier(VppTestCase):
         self.acl_tbl_idx[key] = r.new_table_index
 
     def create_classify_session(
-        self, table_index, match, pbr_option=0, vrfid=0, is_add=1
+        self,
+        table_index,
+        match,
+        pbr_option=0,
+        vrfid=0,
+        is_add=1,
+        hit_next_index=0xFFFFFFFF,
     ):
         """Create Classify Session
 
@@ -400,6 +410,8 @@ class TestClassifier(VppTestCase):
         :param int vrfid: VRF id.
         :param int is_add: option to configure classify session.
             - create(1) or delete(0)
+        :param int hit_next_index: next node of packets hitting the session,
+            ~0 to continue with the next feature.
         """
         mask_match, mask_match_len = self._resolve_mask_match(match)
         r = self.vapi.classify_add_del_session(
@@ -407,6 +419,7 @@ class TestClassifier(VppTestCase):
             table_index=table_index,
             match=mask_match,
             match_len=mask_match_len,
+            hit_next_index=hit_next_index,
             opaque_index=0,
             action=pbr_option,
             metadata=vrfid,
@@ -71,6 +71,7 @@ class IPsecIPv4Params:
         )
         self.dscp = 0
         self.async_mode = False
+        self.anti_replay_window_size = None
 
 
 class IPsecIPv6Params:
@@ -119,6 +120,7 @@ class IPsecIPv6Params:
         )
         self.dscp = 0
         self.async_mode = False
+        self.anti_replay_window_size = None
 
 
 def mk_scapy_crypt_key(p):
@@ -341,6 +343,18 @@ class IpsecTra4(object):
 
         return count
 
+    def get_late_counts(self, p):
+        late_node_name = "/err/%s/late" % self.tra4_decrypt_node_name[0]
+        count = self.statistics.get_err_counter(late_node_name)
+
+        if p.async_mode:
+            late_post_node_name = (
+                "/err/%s/late" % self.tra4_decrypt_node_name[p.async_mode]
+            )
+            count += self.statistics.get_err_counter(late_post_node_name)
+
+        return count
+
     def get_hash_failed_counts(self, p):
         if ESP == self.encryption_type and p.crypt_algo == "AES-GCM":
             hash_failed_node_name = (
@@ -630,6 +644,7 @@ class IpsecTra4(object):
 
         seq_cycle_node_name = "/err/%s/seq_cycled" % self.tra4_encrypt_node_name
         replay_count = self.get_replay_counts(p)
+        late_count = self.get_late_counts(p)
         hash_failed_count = self.get_hash_failed_counts(p)
         seq_cycle_count = self.statistics.get_err_counter(seq_cycle_node_name)
         hash_err = "integ_error"
@@ -790,10 +805,12 @@ class IpsecTra4(object):
                 self.assertEqual(err, hash_failed_count)
 
         else:
-            replay_count += 17
+            # older than the window is late, not a replay
+            late_count += 17
+            self.assertEqual(self.get_late_counts(p), late_count)
+            err = p.tra_sa_in.get_err("late")
+            self.assertEqual(err, late_count)
             self.assertEqual(self.get_replay_counts(p), replay_count)
-            err = p.tra_sa_in.get_err("replay")
-            self.assertEqual(err, replay_count)
 
         # valid packet moves the window over to 258
         pkt = Ether(
@@ -4,6 +4,7 @@
 
 import unittest
 import random
+import re
 
 from scapy.packet import Raw
 from scapy.layers.l2 import Ether
@@ -1620,6 +1621,76 @@ class TestACLplugin(VppTestCase):
 
         self.logger.info("ACLP_TEST_FINISH_0315")
 
+    def test_0400_bitmap_classifier_bench(self):
+        """bitmap classifier agrees with the linear matching"""
+        self.logger.info("ACLP_TEST_START_0400")
+
+        for seed in (1, 2, 3):
+            reply = self.vapi.cli(
+                "test acl-plugin bitmap-classifier bench "
+                "rules 2000 packets 20000 seed %d" % seed
+            )
+            self.logger.info(reply)
+            self.assertIn("mismatches: 0", reply)
+
+        self.logger.info("ACLP_TEST_FINISH_0400")
+
+    def set_lookup_contexts_classifier(self, classifier):
+        reply = self.vapi.cli("show acl-plugin lookup-context")
+        for lc_index in re.findall(r"^index (\d+):", reply, re.M):
+            self.vapi.cli(
+                "set acl-plugin lookup-context %s classifier %s"
+                % (lc_index, classifier)
+            )
+        # the bitmap classifiers are built in the background
+        for i in range(50):
+            reply = self.vapi.cli("show acl-plugin lookup-context")
+            if "building" not in reply:
+                break
+            self.sleep(0.1)
+        self.assertNotIn("building", reply)
+        if classifier == "bitmap":
+            self.assertIn("bitmap classifier:", reply)
+
+    def test_0401_bitmap_classifier_traffic(self):
+        """bitmap and hash matching permit and deny the same packets"""
+        self.logger.info("ACLP_TEST_START_0401")
+
+        tcp = self.proto[self.IP][self.TCP]
+        udp = self.proto[self.IP][self.UDP]
+
+        # permit a tcp port range, deny the rest
+        rules = []
+        rules.append(self.create_rule(self.IPV4, self.PERMIT, self.PORTS_RANGE, tcp))
+        rules.append(self.create_rule(self.IPV6, self.PERMIT, self.PORTS_RANGE, tcp))
+        rules.append(self.create_rule(self.IPV4, self.DENY, self.PORTS_ALL, 0))
+        rules.append(self.create_rule(self.IPV6, self.DENY, self.PORTS_ALL, 0))
+        self.apply_rules(rules, "permit ip4/ip6 tcp range")
+
+        for classifier in ("default", "bitmap"):
+            self.set_lookup_contexts_classifier(classifier)
+            self.reset_packet_infos()
+            self.run_verify_test(self.IP, self.IPRANDOM, tcp)
+            self.run_verify_negat_test(self.IP, self.IPRANDOM, udp)
+
+        # deny a single tcp port, permit the rest
+        port = random.randint(16384, 65535)
+        rules = []
+        rules.append(self.create_rule(self.IPV4, self.DENY, port, tcp))
+        rules.append(self.create_rule(self.IPV6, self.DENY, port, tcp))
+        rules.append(self.create_rule(self.IPV4, self.PERMIT, self.PORTS_ALL, 0))
+        rules.append(self.create_rule(self.IPV6, self.PERMIT, self.PORTS_ALL, 0))
+        self.apply_rules(rules, "deny ip4/ip6 tcp %d" % port)
+
+        for classifier in ("default", "bitmap"):
+            self.set_lookup_contexts_classifier(classifier)
+            self.run_verify_negat_test(self.IP, self.IPRANDOM, tcp, port)
+            self.reset_packet_infos()
+            self.run_verify_test(self.IP, self.IPRANDOM, udp, port)
+
+        self.set_lookup_contexts_classifier("default")
+
+        self.logger.info("ACLP_TEST_FINISH_0401")
 
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
@@ -236,6 +236,26 @@ class ACLPluginConnTestCase(VppTestCase):
             p2 = None
         self.assert_equal(p2, None, "packet on supposedly deleted conn")
 
+    def run_burst_conn_test(self, af, acl_side):
+        """A burst of packets on a new conn creates one session"""
+        conn1 = Conn(self, self.pg0, self.pg1, af, UDP, 44001, 4444)
+        conn1.apply_acls(0, acl_side)
+        node = "acl-plugin-in-%s-fa" % ("ip6" if af == AF_INET6 else "ip4")
+        counter = "/err/%s/new sessions added" % node
+        n_sessions = self.statistics.get_err_counter(counter)
+        # all the packets are in one frame, only the first one has no session
+        self.pg0.add_stream([conn1.pkt(0)] * 65)
+        self.pg1.enable_capture()
+        self.pg_start()
+        self.pg1.get_capture(65)
+        self.assert_equal(
+            self.statistics.get_err_counter(counter) - n_sessions,
+            1,
+            "sessions added",
+        )
+        # the return packets should pass
+        conn1.send_through(1)
+
     def run_tcp_transient_setup_conn_test(self, af, acl_side):
         conn1 = Conn(self, self.pg0, self.pg1, af, TCP, 53001, 5151)
         conn1.apply_acls(0, acl_side)
@@ -335,6 +355,10 @@ class ACLPluginConnTestCase(VppTestCase):
         """IPv4: Idle conn behind active conn, reflect on egress"""
         self.run_active_conn_test(AF_INET, 1)
 
+    def test_0015_burst_conn_test(self):
+        """IPv4: one session for a burst on a new conn"""
+        self.run_burst_conn_test(AF_INET, 0)
+
     def test_1001_basic_conn_test(self):
         """IPv6: Basic conn timeout test reflect on ingress"""
         self.run_basic_conn_test(AF_INET6, 0)
@@ -359,6 +383,10 @@ class ACLPluginConnTestCase(VppTestCase):
         """IPv6: Idle conn behind active conn, reflect on egress"""
         self.run_active_conn_test(AF_INET6, 1)
 
+    def test_1015_burst_conn_test(self):
+        """IPv6: one session for a burst on a new conn"""
+        self.run_burst_conn_test(AF_INET6, 0)
+
     def test_2000_prepare_for_tcp_test(self):
         """Prepare for TCP session tests"""
         # ensure the session hangs on if it gets treated as UDP
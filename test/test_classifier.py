@@ -835,6 +835,83 @@ class TestClassifierComplex(TestClassifier):
         self.pg2.assert_nothing_captured(remark="packets forwarded")
         self.pg3.assert_nothing_captured(remark="packets forwarded")
 
+    def test_iacl_chain(self):
+        """Input ACL table chain test
+
+        Test scenario for a chain of tables longer than the batch of
+        tables searched at once:
+            - Create a chain of 5 tables with different masks, the first
+              four drop on a miss, the last one permits.
+            - A session in the first table permits dport 2000, one in the
+              last table drops sport 3000, the tables between do not
+              match the stream.
+            - Send one stream mixing the flows and verify that the first
+              table to hit decides and that a miss of the whole chain
+              takes the miss_next of the last table.
+        """
+
+        tables = [
+            (self.build_ip_mask(dst_port="ffff"), self.build_ip_match(dst_port=2000)),
+            (
+                self.build_ip_mask(src_ip="ffffffff"),
+                self.build_ip_match(src_ip="10.255.0.1"),
+            ),
+            (
+                self.build_ip_mask(dst_ip="ffffffff"),
+                self.build_ip_match(dst_ip="10.255.0.2"),
+            ),
+            (
+                self.build_ip_mask(proto="ff"),
+                self.build_ip_match(proto=socket.IPPROTO_TCP),
+            ),
+            (self.build_ip_mask(src_port="ffff"), self.build_ip_match(src_port=3000)),
+        ]
+
+        next_table_index = None
+        for i, (mask, match) in reversed(list(enumerate(tables))):
+            key = "chain_%d_in" % i
+            last = i == len(tables) - 1
+            self.create_classify_table(
+                key,
+                mask,
+                next_table_index=next_table_index,
+                miss_next_index=0xFFFFFFFF if last else 0,
+            )
+            next_table_index = self.acl_tbl_idx.get(key)
+            self.create_classify_session(
+                next_table_index, match, hit_next_index=0 if last else 0xFFFFFFFF
+            )
+
+        self.input_acl_set_interface(self.pg0, self.acl_tbl_idx.get("chain_0_in"))
+        self.acl_active_table = "chain_0_in"
+
+        # (sport, dport) -> forwarded
+        flows = {
+            (1000, 2000): True,  # hit in the first table
+            (3000, 2000): True,  # hits in first and last, the first wins
+            (3000, 2001): False,  # hit in the last table
+            (3001, 2001): True,  # miss of the whole chain
+        }
+        pkts = [
+            (
+                Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+                / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+                / UDP(sport=sport, dport=dport)
+                / Raw(b"\x00" * 64)
+            )
+            for i in range(5)
+            for sport, dport in flows
+        ]
+        # odd count, so the single packet loop walks the chain too
+        pkts.append(pkts[2].copy())
+        n_fwd = sum(flows[(p[UDP].sport, p[UDP].dport)] for p in pkts)
+
+        rx = self.send_and_expect(self.pg0, pkts, self.pg1, n_rx=n_fwd)
+        for p in rx:
+            self.assertTrue(flows[(p[UDP].sport, p[UDP].dport)])
+        self.pg2.assert_nothing_captured(remark="packets forwarded")
+        self.pg3.assert_nothing_captured(remark="packets forwarded")
+
 
 class TestClassifierPBR(TestClassifier):
     """Classifier PBR Test Case"""
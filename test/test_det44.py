@@ -12,6 +12,7 @@ from scapy.layers.inet import IP, TCP, UDP, ICMP
 from scapy.layers.inet import IPerror, UDPerror
 from scapy.layers.l2 import Ether
 from util import ppp
+from vpp_ip_route import VppIpRoute, VppRoutePath
 
 
 class TestDET44(VppTestCase):
@@ -485,6 +486,107 @@ class TestDET44(VppTestCase):
         dms = self.vapi.det44_map_dump()
         self.assertEqual(dms[0].ses_num, 0)
 
+    def test_session_table(self):
+        """Deterministic NAT session lookup and accounting"""
+        in_net = "10.8.0.0"
+        out_net = "10.0.1.0"
+        users = ["10.8.0.1", "10.8.255.254"]
+        ext_hosts = [self.pg1.remote_ip4, "10.1.1.1"]
+
+        # a /16 of inside addresses: only the session memory of the
+        # addresses which get sessions is ever backed
+        self.vapi.det44_add_del_map(
+            is_add=1,
+            in_addr=in_net,
+            in_plen=16,
+            out_addr=socket.inet_aton(out_net),
+            out_plen=24,
+        )
+        VppIpRoute(
+            self, in_net, 16, [VppRoutePath(self.pg0.remote_ip4, 0xFFFFFFFF)]
+        ).add_vpp_config()
+        VppIpRoute(
+            self, "10.1.1.1", 32, [VppRoutePath(self.pg1.remote_ip4, 0xFFFFFFFF)]
+        ).add_vpp_config()
+        self.vapi.det44_interface_add_del_feature(
+            sw_if_index=self.pg0.sw_if_index, is_add=1, is_inside=1
+        )
+        self.vapi.det44_interface_add_del_feature(
+            sw_if_index=self.pg1.sw_if_index, is_add=1, is_inside=0
+        )
+
+        def in2out(user, sport, ext_host):
+            p = (
+                Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+                / IP(src=user, dst=ext_host)
+                / UDP(sport=sport, dport=53)
+            )
+            rx = self.send_and_expect(self.pg0, p, self.pg1)[0]
+            fwd = self.vapi.det44_forward(in_addr=user)
+            self.assertEqual(rx[IP].src, str(fwd.out_addr))
+            self.assertGreaterEqual(rx[UDP].sport, fwd.out_port_lo)
+            self.assertLessEqual(rx[UDP].sport, fwd.out_port_hi)
+            return rx[IP].src, rx[UDP].sport
+
+        def out2in(out_addr, out_port, ext_host, user, sport):
+            p = (
+                Ether(src=self.pg1.remote_mac, dst=self.pg1.local_mac)
+                / IP(src=ext_host, dst=out_addr)
+                / UDP(sport=53, dport=out_port)
+            )
+            rx = self.send_and_expect(self.pg1, p, self.pg0)[0]
+            self.assertEqual(rx[IP].dst, user)
+            self.assertEqual(rx[UDP].dport, sport)
+
+        def user_ses_num(user):
+            return len(self.vapi.det44_session_dump(user_addr=user))
+
+        # the same inside port to two external hosts are two sessions
+        outs = {}
+        for user in users:
+            for sport in [1000, 1001]:
+                for ext_host in ext_hosts:
+                    outs[user, sport, ext_host] = in2out(user, sport, ext_host)
+        self.assertEqual(len(set(outs.values())), len(outs))
+        self.assertEqual(self.vapi.det44_map_dump()[0].ses_num, len(outs))
+        for user in users:
+            self.assertEqual(user_ses_num(user), 4)
+        self.assertEqual(user_ses_num("10.8.1.1"), 0)
+
+        # existing sessions are found both ways
+        for (user, sport, ext_host), out in outs.items():
+            self.assertEqual(in2out(user, sport, ext_host), out)
+            out2in(out[0], out[1], ext_host, user, sport)
+        self.assertEqual(self.vapi.det44_map_dump()[0].ses_num, len(outs))
+
+        # packets to an outside port without a session are dropped
+        out = outs[users[0], 1000, ext_hosts[0]]
+        p = (
+            Ether(src=self.pg1.remote_mac, dst=self.pg1.local_mac)
+            / IP(src=ext_hosts[1], dst=out[0])
+            / UDP(sport=53, dport=out[1])
+        )
+        self.send_and_assert_no_replies(self.pg1, p)
+
+        # a closed session is no longer found, its slot is reused
+        self.vapi.det44_close_session_in(users[0], 1000, ext_hosts[0], 53)
+        self.assertEqual(user_ses_num(users[0]), 3)
+        self.assertEqual(user_ses_num(users[1]), 4)
+        p[IP].src = ext_hosts[0]
+        self.send_and_assert_no_replies(self.pg1, p)
+        in2out(users[0], 1002, ext_hosts[0])
+        self.assertEqual(user_ses_num(users[0]), 4)
+        self.assertEqual(self.vapi.det44_map_dump()[0].ses_num, len(outs))
+
+        self.vapi.det44_close_session_out(
+            socket.inet_aton(outs[users[1], 1001, ext_hosts[1]][0]),
+            outs[users[1], 1001, ext_hosts[1]][1],
+            ext_hosts[1],
+            53,
+        )
+        self.assertEqual(user_ses_num(users[1]), 3)
+        self.assertIn("10.8.255.254", self.vapi.cli("show det44 sessions"))
+
     def test_tcp_session_close_detection_in(self):
         """DET44 TCP session close from inside network"""
         self.vapi.det44_add_del_map(
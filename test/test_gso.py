@@ -26,15 +26,22 @@ from vpp_ip import DpoProto
 from vpp_ip_route import VppIpRoute, VppRoutePath, FibPathProto
 from vpp_ipip_tun_interface import VppIpIpTunInterface
 from vpp_vxlan_tunnel import VppVxlanTunnel
-from socket import AF_INET, AF_INET6, inet_pton
+from socket import AF_INET, AF_INET6, IPPROTO_RAW, inet_pton
 from util import reassemble4
 
-from vpp_ipsec import VppIpsecSA, VppIpsecTunProtect
+from vpp_ipsec import (
+    VppIpsecSA,
+    VppIpsecTunProtect,
+    VppIpsecSpd,
+    VppIpsecSpdEntry,
+    VppIpsecSpdItfBinding,
+)
 from template_ipsec import (
     IPsecIPv4Params,
     IPsecIPv6Params,
     mk_scapy_crypt_key,
     config_tun_params,
+    config_tra_params,
 )
 
 """ Test_gso is a subclass of VPPTestCase classes.
@@ -1092,6 +1099,221 @@ class TestGSO(VppTestCase):
 
         self.vapi.feature_gso_enable_disable(self.pg0.sw_if_index, enable_disable=0)
 
+    def verify_esp_segments(self, rxs, spi, decrypt, n_segs=45):
+        """All segments decrypt and carry consecutive sequence numbers"""
+        self.assertEqual(len(rxs), n_segs)
+        seqs = [rx[ESP].seq for rx in rxs]
+        self.assertEqual(seqs, list(range(seqs[0], seqs[0] + n_segs)))
+        size = 0
+        for rx in rxs:
+            self.assertEqual(rx[ESP].spi, spi)
+            inner = decrypt(rx)
+            self.assertEqual(inner[TCP].seq, size)
+            size += len(inner[TCP].payload)
+        self.assertEqual(size, 65200)
+        return seqs[-1]
+
+    def test_gso_ipsec_inline(self):
+        """GSO IPSEC test, segmented by ESP encrypt"""
+        #
+        # Send jumbo frame with gso enabled only on input interface and
+        # an IPIP tunnel protected by IPSec without the gso feature on it.
+        # The super-segment reaches esp4-encrypt-tun whole.
+        #
+        self.ipip4.add_vpp_config()
+        self.ipip4.admin_up()
+        self.ipip4.set_unnumbered(self.pg0.sw_if_index)
+
+        ip4_via_tunnel = VppIpRoute(
+            self,
+            "172.16.10.0",
+            24,
+            [
+                VppRoutePath(
+                    "0.0.0.0",
+                    self.ipip4.sw_if_index,
+                    proto=FibPathProto.FIB_PATH_NH_PROTO_IP4,
+                )
+            ],
+        )
+        ip4_via_tunnel.add_vpp_config()
+        ip6_via_tunnel = VppIpRoute(
+            self,
+            "fd01:10::",
+            64,
+            [
+                VppRoutePath(
+                    "::",
+                    self.ipip4.sw_if_index,
+                    proto=FibPathProto.FIB_PATH_NH_PROTO_IP6,
+                )
+            ],
+        )
+        ip6_via_tunnel.add_vpp_config()
+
+        p = IPsecIPv4Params()
+        config_tun_params(p, ESP, self.ipip4)
+        sa_in = VppIpsecSA(
+            self,
+            p.scapy_tun_sa_id,
+            p.scapy_tun_spi,
+            p.auth_algo_vpp_id,
+            p.auth_key,
+            p.crypt_algo_vpp_id,
+            p.crypt_key,
+            VppEnum.vl_api_ipsec_proto_t.IPSEC_API_PROTO_ESP,
+        )
+        sa_in.add_vpp_config()
+        sa_out = VppIpsecSA(
+            self,
+            p.vpp_tun_sa_id,
+            p.vpp_tun_spi,
+            p.auth_algo_vpp_id,
+            p.auth_key,
+            p.crypt_algo_vpp_id,
+            p.crypt_key,
+            VppEnum.vl_api_ipsec_proto_t.IPSEC_API_PROTO_ESP,
+        )
+        sa_out.add_vpp_config()
+        protect = VppIpsecTunProtect(self, self.ipip4, sa_out, [sa_in])
+        protect.add_vpp_config()
+
+        def decrypt(rx):
+            self.assertEqual(rx[Ether].src, self.pg0.local_mac)
+            self.assertEqual(rx[Ether].dst, self.pg0.remote_mac)
+            self.assertEqual(rx[IP].src, self.pg0.local_ip4)
+            self.assertEqual(rx[IP].dst, self.pg0.remote_ip4)
+            return p.vpp_tun_sa.decrypt(rx[IP])
+
+        ipsec44 = (
+            Ether(src=self.pg2.remote_mac, dst="02:fe:60:1e:a2:79")
+            / IP(src=self.pg2.remote_ip4, dst="172.16.10.3", flags="DF")
+            / TCP(sport=1234, dport=1234)
+            / Raw(b"\xa5" * 65200)
+        )
+        rxs = self.send_and_expect(self.pg2, [ipsec44], self.pg0, 45)
+        last = self.verify_esp_segments(rxs, p.vpp_tun_spi, decrypt)
+
+        # the next super-segment carries on from the last sequence number
+        ipsec46 = (
+            Ether(src=self.pg2.remote_mac, dst="02:fe:60:1e:a2:79")
+            / IPv6(src=self.pg2.remote_ip6, dst="fd01:10::3")
+            / TCP(sport=1234, dport=1234)
+            / Raw(b"\xa5" * 65200)
+        )
+        rxs = self.send_and_expect(self.pg2, [ipsec46], self.pg0, 45)
+        self.assertEqual(rxs[0][ESP].seq, last + 1)
+        self.verify_esp_segments(rxs, p.vpp_tun_spi, decrypt)
+
+        protect.remove_vpp_config()
+        sa_in.remove_vpp_config()
+        sa_out.remove_vpp_config()
+        ip4_via_tunnel.remove_vpp_config()
+        ip6_via_tunnel.remove_vpp_config()
+        self.ipip4.remove_vpp_config()
+
+    def test_gso_ipsec_transport(self):
+        """GSO IPSEC transport mode test, segmented by ESP encrypt"""
+        #
+        # Send jumbo frame with gso enabled only on input interface and
+        # protect the forwarded traffic in transport mode on pg1, which
+        # does not have the gso feature. The super-segment reaches
+        # esp4/6-encrypt whole, after the L2 rewrite.
+        #
+        e = VppEnum.vl_api_ipsec_spd_action_t
+        p4 = IPsecIPv4Params()
+        p6 = IPsecIPv6Params()
+        spd = VppIpsecSpd(self, 1)
+        objs = [spd, VppIpsecSpdItfBinding(self, spd, self.pg1)]
+
+        for p, any_start, any_stop in [
+            (p4, "0.0.0.0", "255.255.255.255"),
+            (p6, "::", "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"),
+        ]:
+            config_tra_params(p, ESP)
+            objs.append(
+                VppIpsecSA(
+                    self,
+                    p.vpp_tra_sa_id,
+                    p.vpp_tra_spi,
+                    p.auth_algo_vpp_id,
+                    p.auth_key,
+                    p.crypt_algo_vpp_id,
+                    p.crypt_key,
+                    VppEnum.vl_api_ipsec_proto_t.IPSEC_API_PROTO_ESP,
+                )
+            )
+            # everything else, neighbour discovery included, goes in clear
+            for is_outbound in [0, 1]:
+                objs.append(
+                    VppIpsecSpdEntry(
+                        self,
+                        spd,
+                        0,
+                        any_start,
+                        any_stop,
+                        any_start,
+                        any_stop,
+                        IPPROTO_RAW,
+                        priority=10,
+                        policy=e.IPSEC_API_SPD_ACTION_BYPASS,
+                        is_outbound=is_outbound,
+                    )
+                )
+            src = self.pg2.remote_addr[p.addr_type]
+            dst = self.pg1.remote_addr[p.addr_type]
+            objs.append(
+                VppIpsecSpdEntry(
+                    self,
+                    spd,
+                    p.vpp_tra_sa_id,
+                    src,
+                    src,
+                    dst,
+                    dst,
+                    IPPROTO_RAW,
+                    priority=100,
+                    policy=e.IPSEC_API_SPD_ACTION_PROTECT,
+                )
+            )
+        for o in objs:
+            o.add_vpp_config()
+
+        def decrypt4(rx):
+            self.assertEqual(rx[Ether].src, self.pg1.local_mac)
+            self.assertEqual(rx[Ether].dst, self.pg1.remote_mac)
+            self.assertEqual(rx[IP].src, self.pg2.remote_ip4)
+            self.assertEqual(rx[IP].dst, self.pg1.remote_ip4)
+            return p4.vpp_tra_sa.decrypt(rx[IP])
+
+        def decrypt6(rx):
+            self.assertEqual(rx[Ether].src, self.pg1.local_mac)
+            self.assertEqual(rx[Ether].dst, self.pg1.remote_mac)
+            self.assertEqual(rx[IPv6].src, self.pg2.remote_ip6)
+            self.assertEqual(rx[IPv6].dst, self.pg1.remote_ip6)
+            return p6.vpp_tra_sa.decrypt(rx[IPv6])
+
+        ipsec4 = (
+            Ether(src=self.pg2.remote_mac, dst=self.pg2.local_mac)
+            / IP(src=self.pg2.remote_ip4, dst=self.pg1.remote_ip4, flags="DF")
+            / TCP(sport=1234, dport=1234)
+            / Raw(b"\xa5" * 65200)
+        )
+        rxs = self.send_and_expect(self.pg2, [ipsec4], self.pg1, 45)
+        self.verify_esp_segments(rxs, p4.vpp_tra_spi, decrypt4)
+
+        ipsec6 = (
+            Ether(src=self.pg2.remote_mac, dst=self.pg2.local_mac)
+            / IPv6(src=self.pg2.remote_ip6, dst=self.pg1.remote_ip6)
+            / TCP(sport=1234, dport=1234)
+            / Raw(b"\xa5" * 65200)
+        )
+        rxs = self.send_and_expect(self.pg2, [ipsec6], self.pg1, 45)
+        self.verify_esp_segments(rxs, p6.vpp_tra_spi, decrypt6)
+
+        for o in reversed(objs):
+            o.remove_vpp_config()
+
 
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+
+import unittest
+
+from framework import VppTestCase, VppTestRunner
+
+from scapy.layers.inet import IP, UDP
+from scapy.layers.l2 import Ether
+from scapy.packet import Raw
+from vpp_papi import VppEnum
+from vpp_qos import VppQosRecord
+
+NUM_PKTS = 67
+N_TC = 4
+
+
+class HQoSTestCase(VppTestCase):
+    """Hierarchical QoS Scheduler Test Case Base"""
+
+    def setUp(self):
+        super(HQoSTestCase, self).setUp()
+
+        self.create_pg_interfaces(range(3))
+
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+    def tearDown(self):
+        for i in self.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+        super(HQoSTestCase, self).tearDown()
+
+    def hqos_pipe(
+        self,
+        port_rate,
+        pipe_rate,
+        burst=0,
+        queue_size=0,
+        weights=[1, 1, 1, 1],
+        itf=None,
+        worker_index=0xFFFFFFFF,
+    ):
+        """Schedule the output of an interface, pg1 by default, in one pipe"""
+        itf = itf or self.pg1
+        self.vapi.hqos_port_add_del(
+            sw_if_index=itf.sw_if_index,
+            rate=port_rate,
+            queue_size=queue_size,
+            worker_index=worker_index,
+        )
+        sp = self.vapi.hqos_subport_add(sw_if_index=itf.sw_if_index, rate=0)
+        profile = self.vapi.hqos_pipe_profile_add(
+            rate=pipe_rate, burst=burst, weights=weights
+        )
+        pipe = self.vapi.hqos_pipe_add(
+            subport_index=sp.subport_index,
+            profile_index=profile.profile_index,
+            sw_if_index=itf.sw_if_index,
+        )
+        return profile.profile_index, pipe.pipe_index
+
+    def hqos_unconfig(self, profile_index, itf=None):
+        itf = itf or self.pg1
+        self.vapi.hqos_port_add_del(sw_if_index=itf.sw_if_index, is_add=False)
+        self.vapi.hqos_pipe_profile_del(profile_index=profile_index)
+
+    def hqos_tc_map(self, tos, tc, queue):
+        self.vapi.hqos_tc_map_set(
+            sw_if_index=self.pg1.sw_if_index, qos_bits=tos, tc=tc, queue=queue
+        )
+
+    def hqos_stats(self, name, pipe_index):
+        c = self.statistics.get_counter(name)
+        packets = [0] * N_TC
+        for t in c:
+            for tc in range(N_TC):
+                packets[tc] += t[pipe_index * N_TC + tc]["packets"]
+        return packets
+
+    def create_stream(self, size=100, tos=0, itf=None, count=NUM_PKTS):
+        itf = itf or self.pg1
+        p = (
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / IP(src=self.pg0.remote_ip4, dst=itf.remote_ip4, tos=tos)
+            / UDP(sport=1234, dport=1234)
+            / Raw(b"\xa5" * size)
+        )
+        return p * count
+
+    def record_qos(self):
+        """Record the input TOS so it selects the class and queue"""
+        qr = VppQosRecord(
+            self, self.pg0, VppEnum.vl_api_qos_source_t.QOS_API_SOURCE_IP
+        )
+        qr.add_vpp_config()
+        return qr
+
+    def interleave(self, *streams):
+        return [p for ps in zip(*streams) for p in ps]
+
+
+class TestHQoS(HQoSTestCase):
+    """Hierarchical QoS Scheduler Test Case"""
+
+    def test_hqos_unshaped(self):
+        """Unshaped pipe passes all traffic"""
+        profile_index, pipe_index = self.hqos_pipe(0, 0)
+
+        self.send_and_expect(self.pg0, self.create_stream(), self.pg1)
+
+        # without recorded QoS bits the lowest priority class is used
+        tx = self.hqos_stats("/hqos/tx", pipe_index)
+        self.assertEqual(tx, [0, 0, 0, NUM_PKTS])
+        self.assertEqual(sum(self.hqos_stats("/hqos/drop", pipe_index)), 0)
+
+        self.logger.info(self.vapi.cli("show hqos verbose"))
+        self.hqos_unconfig(profile_index)
+
+        # the interface is no longer scheduled
+        self.send_and_expect(self.pg0, self.create_stream(), self.pg1)
+        self.assertEqual(self.vapi.cli("show hqos"), "")
+
+    def test_hqos_shaped(self):
+        """Shaped pipe drops the excess"""
+        profile_index, pipe_index = self.hqos_pipe(0, 80000, burst=1500, queue_size=16)
+
+        rx = self.send_and_expect_some(self.pg0, self.create_stream(), self.pg1)
+
+        drop = sum(self.hqos_stats("/hqos/drop", pipe_index))
+        tx = sum(self.hqos_stats("/hqos/tx", pipe_index))
+        self.assertGreater(drop, 0)
+        self.assertGreaterEqual(tx, len(rx))
+        self.assertLessEqual(tx + drop, NUM_PKTS)
+
+        self.logger.info(self.vapi.cli("show hqos verbose"))
+        self.hqos_unconfig(profile_index)
+
+    def test_hqos_strict_priority(self):
+        """Higher priority classes are served first"""
+        # shaped so the whole stream is backlogged before it is sent
+        profile_index, pipe_index = self.hqos_pipe(0, 8000000, burst=1500)
+        qr = self.record_qos()
+        self.hqos_tc_map(0x20, 0, 0)
+        self.hqos_tc_map(0x40, 1, 0)
+
+        n = 20
+        pkts = self.interleave(
+            self.create_stream(tos=0, count=n),
+            self.create_stream(tos=0x40, count=n),
+            self.create_stream(tos=0x20, count=n),
+        )
+        rx = self.send_and_expect(self.pg0, pkts, self.pg1)
+
+        # tc0, then tc1, then the default tc3
+        self.assertEqual([p[IP].tos for p in rx], [0x20] * n + [0x40] * n + [0] * n)
+        tx = self.hqos_stats("/hqos/tx", pipe_index)
+        self.assertEqual(tx, [n, n, 0, n])
+
+        qr.remove_vpp_config()
+        self.hqos_unconfig(profile_index)
+
+    def test_hqos_wrr(self):
+        """Queues of a class share it by weight"""
+        profile_index, pipe_index = self.hqos_pipe(
+            0, 8000000, burst=1500, weights=[3, 1, 1, 1]
+        )
+        qr = self.record_qos()
+        self.hqos_tc_map(0x20, N_TC - 1, 1)
+
+        n = 40
+        pkts = self.interleave(
+            self.create_stream(size=1000, tos=0, count=n),
+            self.create_stream(size=1000, tos=0x20, count=n),
+        )
+        rx = self.send_and_expect(self.pg0, pkts, self.pg1)
+
+        # while both are backlogged queue 0 gets three times the bytes
+        first = [p[IP].tos for p in rx[:n]]
+        self.assertTrue(27 <= first.count(0) <= 32, first)
+        self.assertEqual(sum(self.hqos_stats("/hqos/drop", pipe_index)), 0)
+
+        qr.remove_vpp_config()
+        self.hqos_unconfig(profile_index)
+
+
+class TestHQoSWorkers(HQoSTestCase):
+    """Hierarchical QoS Scheduler Multi-worker Test Case"""
+
+    vpp_worker_count = 2
+
+    def test_hqos_handoff(self):
+        """Packets are handed off to the port's worker"""
+        # both ports on the second worker, which serves them in turn
+        profile1, pipe1 = self.hqos_pipe(0, 0, worker_index=1)
+        profile2, pipe2 = self.hqos_pipe(0, 0, itf=self.pg2, worker_index=1)
+        self.logger.info(self.vapi.cli("show hqos verbose"))
+
+        for worker in [0, 1]:
+            self.send_and_expect(
+                self.pg0, self.create_stream(), self.pg1, worker=worker
+            )
+            self.send_and_expect(
+                self.pg0, self.create_stream(itf=self.pg2), self.pg2, worker=worker
+            )
+
+        # whichever worker received them, all were scheduled
+        self.assertEqual(self.hqos_stats("/hqos/tx", pipe1)[N_TC - 1], 2 * NUM_PKTS)
+        self.assertEqual(self.hqos_stats("/hqos/tx", pipe2)[N_TC - 1], 2 * NUM_PKTS)
+        self.logger.info(self.vapi.cli("show errors"))
+
+        self.hqos_unconfig(profile1)
+        self.hqos_unconfig(profile2, itf=self.pg2)
+
+
+if __name__ == "__main__":
+    unittest.main(testRunner=VppTestRunner)
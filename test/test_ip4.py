@@ -2542,6 +2542,82 @@ class TestIPLPM(VppTestCase):
         rx = self.send_and_expect(self.pg0, p_24 * NUM_PKTS, self.pg1)
 
 
+class TestIPFibCache(VppTestCase):
+    """IPv4 FIB forwarding cache"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestIPFibCache, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestIPFibCache, cls).tearDownClass()
+
+    def setUp(self):
+        super(TestIPFibCache, self).setUp()
+
+        self.create_pg_interfaces(range(3))
+
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+        self.vapi.cli("set ip fib cache size 1024")
+
+    def tearDown(self):
+        self.vapi.cli("set ip fib cache disable")
+        super(TestIPFibCache, self).tearDown()
+        for i in self.pg_interfaces:
+            i.admin_down()
+            i.unconfig_ip4()
+
+    def test_ip_fib_cache(self):
+        """IP FIB cache follows route changes"""
+
+        p = (
+            Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+            / IP(src="1.1.1.1", dst="10.1.2.1")
+            / UDP(sport=1234, dport=1234)
+            / Raw(b"\xa5" * 100)
+        )
+
+        s_8 = VppIpRoute(
+            self,
+            "10.0.0.0",
+            8,
+            [VppRoutePath(self.pg1.remote_ip4, self.pg1.sw_if_index)],
+        )
+        s_8.add_vpp_config()
+
+        # the first packet fills the cache, the rest hit it
+        self.send_and_expect(self.pg0, p * NUM_PKTS, self.pg1)
+        self.assertIn(
+            "hits %d misses 1" % (NUM_PKTS - 1), self.vapi.cli("show ip fib cache")
+        )
+
+        # a more specific route must be used straight away
+        s_24 = VppIpRoute(
+            self,
+            "10.1.2.0",
+            24,
+            [VppRoutePath(self.pg2.remote_ip4, self.pg2.sw_if_index)],
+        )
+        s_24.add_vpp_config()
+        self.send_and_expect(self.pg0, p * NUM_PKTS, self.pg2)
+
+        # and so must a path change
+        s_24.modify([VppRoutePath(self.pg1.remote_ip4, self.pg1.sw_if_index)])
+        self.send_and_expect(self.pg0, p * NUM_PKTS, self.pg1)
+
+        # as must the removal
+        s_24.remove_vpp_config()
+        s_8.remove_vpp_config()
+        self.send_and_assert_no_replies(self.pg0, p * NUM_PKTS)
+
+        self.logger.info(self.vapi.cli("show ip fib cache"))
+
+
 @tag_fixme_vpp_workers
 class TestIPv4Frag(VppTestCase):
     """IPv4 fragmentation"""
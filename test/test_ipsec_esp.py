@@ -287,6 +287,7 @@ class ConfigIpsecESP(TemplateIpsec):
             self.vpp_esp_protocol,
             flags=flags,
             salt=salt,
+            anti_replay_window_size=params.anti_replay_window_size,
         )
         params.tra_sa_out = VppIpsecSA(
             self,
@@ -299,6 +300,7 @@ class ConfigIpsecESP(TemplateIpsec):
             self.vpp_esp_protocol,
             flags=flags,
             salt=salt,
+            anti_replay_window_size=params.anti_replay_window_size,
         )
         objs.append(params.tra_sa_in)
         objs.append(params.tra_sa_out)
@@ -605,6 +607,208 @@ class TestIpsecEsp2(TemplateIpsecEsp, IpsecTcpTests):
     pass
 
 
+class TemplateIpsecEspWindow(TemplateIpsecEsp, IpsecTra4):
+    """Ipsec ESP - anti-replay window template"""
+
+    window_size = 1024
+    multi_worker = False
+
+    def setup_params(self):
+        super(TemplateIpsecEspWindow, self).setup_params()
+        saf = VppEnum.vl_api_ipsec_sad_flags_t
+        for p in self.params.values():
+            p.anti_replay_window_size = self.window_size
+            if self.multi_worker:
+                p.flags |= saf.IPSEC_API_SAD_FLAG_MULTI_WORKER
+
+    def gen_pkts(self, p, seqs):
+        return [
+            (
+                Ether(src=self.tra_if.remote_mac, dst=self.tra_if.local_mac)
+                / p.scapy_tra_sa.encrypt(
+                    IP(src=self.tra_if.remote_ip4, dst=self.tra_if.local_ip4) / ICMP(),
+                    seq_num=seq,
+                )
+            )
+            for seq in seqs
+        ]
+
+    def verify_counts(self, p, replay_count, late_count):
+        self.assertEqual(self.get_replay_counts(p), replay_count)
+        self.assertEqual(p.tra_sa_in.get_err("replay"), replay_count)
+        self.assertEqual(self.get_late_counts(p), late_count)
+        self.assertEqual(p.tra_sa_in.get_err("late"), late_count)
+
+
+class TestIpsecEspHugeWindow(TemplateIpsecEspWindow):
+    """Ipsec ESP - anti-replay window larger than 64"""
+
+    def test_tra_anti_replay_huge(self):
+        """ipsec v4 transport anti-replay with a huge window"""
+        p = self.params[socket.AF_INET]
+        ws = self.window_size
+        replay_count = self.get_replay_counts(p)
+        late_count = self.get_late_counts(p)
+
+        # the window is a bitmap rather than the default u64
+        sa = [
+            line
+            for line in self.vapi.cli("show ipsec sa").splitlines()
+            if " sa %d " % p.scapy_tra_sa_id in line
+        ]
+        self.assertEqual(len(sa), 1)
+        self.assertIn("anti-replay-huge", sa[0])
+
+        self.send_and_expect(self.tra_if, self.gen_pkts(p, range(1, 34)), self.tra_if)
+
+        # replayed packets are dropped
+        self.send_and_assert_no_replies(
+            self.tra_if, self.gen_pkts(p, range(1, 34)), timeout=0.2
+        )
+        replay_count += 33
+        self.verify_counts(p, replay_count, late_count)
+
+        # jump forward, yet not a full window, i.e. still in Case B
+        self.send_and_expect(self.tra_if, self.gen_pkts(p, [ws - 24]), self.tra_if)
+
+        # far more than 64 behind, but in the window and not seen
+        self.send_and_expect(self.tra_if, self.gen_pkts(p, [100]), self.tra_if)
+        self.send_and_assert_no_replies(
+            self.tra_if, self.gen_pkts(p, [100, 20, ws - 24]), timeout=0.2
+        )
+        replay_count += 3
+        self.verify_counts(p, replay_count, late_count)
+
+        # slide the window by more than its size into Case A
+        top = 3 * ws - 72
+        self.send_and_expect(self.tra_if, self.gen_pkts(p, [top]), self.tra_if)
+
+        # the slide cleared the bits of 100 and 20, their aliases are new
+        self.send_and_expect(
+            self.tra_if, self.gen_pkts(p, [100 + 2 * ws, 20 + 2 * ws]), self.tra_if
+        )
+
+        # behind the window is late, in the window but seen is a replay
+        self.send_and_assert_no_replies(
+            self.tra_if, self.gen_pkts(p, [ws - 24, 100, top - ws]), timeout=0.2
+        )
+        late_count += 3
+        self.send_and_assert_no_replies(
+            self.tra_if, self.gen_pkts(p, [top, 100 + 2 * ws]), timeout=0.2
+        )
+        replay_count += 2
+        self.verify_counts(p, replay_count, late_count)
+
+        # the oldest sequence number the window still holds
+        self.send_and_expect(self.tra_if, self.gen_pkts(p, [top - ws + 1]), self.tra_if)
+
+        # slide by less than the window, the older half goes out of it
+        top += ws // 2
+        self.send_and_expect(self.tra_if, self.gen_pkts(p, [top]), self.tra_if)
+        self.send_and_expect(
+            self.tra_if, self.gen_pkts(p, [top - ws + 1, top - 1]), self.tra_if
+        )
+        self.send_and_assert_no_replies(
+            self.tra_if, self.gen_pkts(p, [100 + 2 * ws, top - ws]), timeout=0.2
+        )
+        late_count += 2
+        self.send_and_assert_no_replies(
+            self.tra_if, self.gen_pkts(p, [top - 1, top - ws + 1]), timeout=0.2
+        )
+        replay_count += 2
+        self.verify_counts(p, replay_count, late_count)
+
+        self.logger.info(self.vapi.ppcli("show ipsec sa"))
+
+
+class TestIpsecEspMultiWorker(TemplateIpsecEspWindow):
+    """Ipsec ESP - SA shared by all workers"""
+
+    vpp_worker_count = 2
+    window_size = 256
+    multi_worker = True
+    # ESP_SEQ_BLOCK_SIZE, the sequence numbers a worker reserves at once
+    seq_block_size = 8
+
+    def send_and_assert_dropped(self, pkts, worker):
+        self.pg_send(self.tra_if, pkts, worker=worker)
+        self.tra_if.assert_nothing_captured(timeout=0.2)
+
+    def test_tra_multi_worker(self):
+        """ipsec v4 transport multi-worker SA"""
+        p = self.params[socket.AF_INET]
+        replay_count = self.get_replay_counts(p)
+        late_count = self.get_late_counts(p)
+        n = NUM_PKTS
+
+        sa = [
+            line
+            for line in self.vapi.cli("show ipsec sa").splitlines()
+            if " sa %d " % p.vpp_tra_sa_id in line
+        ]
+        self.assertEqual(len(sa), 1)
+        self.assertIn("multi-worker", sa[0])
+
+        # the workers take turns, each encrypts its own packets
+        seqs = []
+        for i, worker in enumerate([0, 1, 0, 1]):
+            pkts = self.gen_pkts(p, range(i * n + 1, (i + 1) * n + 1))
+            rxs = self.send_and_expect(self.tra_if, pkts, self.tra_if, worker=worker)
+            burst = [rx[ESP].seq for rx in rxs]
+            self.assertEqual(burst, sorted(burst))
+            if seqs:
+                # the worker gave up the rest of its old block, no more
+                self.assertGreater(burst[0], seqs[-1])
+                self.assertLessEqual(burst[0] - seqs[-1], 2 * self.seq_block_size)
+            seqs += burst
+            for rx in rxs:
+                p.vpp_tra_sa.decrypt(rx[IP])
+
+        # no number is sent twice and, as they are in order on the wire,
+        # the peer's window accepts every one
+        self.assertEqual(len(set(seqs)), len(seqs))
+
+        # nothing was handed off to the thread that first used the SA
+        for worker in [0, 1]:
+            self.assertEqual(p.tra_sa_in.get_stats(worker)["packets"], 2 * n)
+            self.assertEqual(p.tra_sa_out.get_stats(worker)["packets"], 2 * n)
+
+        # both workers check and advance the one inbound window
+        ws = self.window_size
+        base = 4 * n
+        self.send_and_expect(
+            self.tra_if,
+            self.gen_pkts(p, range(base + 1, base + 41, 2)),
+            self.tra_if,
+            worker=0,
+        )
+        self.send_and_expect(
+            self.tra_if,
+            self.gen_pkts(p, range(base + 2, base + 41, 2)),
+            self.tra_if,
+            worker=1,
+        )
+        self.send_and_assert_dropped(self.gen_pkts(p, range(base + 1, base + 41)), 1)
+        replay_count += 40
+        self.verify_counts(p, replay_count, late_count)
+
+        # a slide by one worker is seen by the other
+        top = base + 40 + ws
+        self.send_and_expect(
+            self.tra_if, self.gen_pkts(p, [top]), self.tra_if, worker=0
+        )
+        self.send_and_expect(
+            self.tra_if, self.gen_pkts(p, [top - ws + 1]), self.tra_if, worker=1
+        )
+        self.send_and_assert_dropped(self.gen_pkts(p, [top - ws, base + 1]), 1)
+        late_count += 2
+        self.send_and_assert_dropped(self.gen_pkts(p, [top, top - ws + 1]), 0)
+        replay_count += 2
+        self.verify_counts(p, replay_count, late_count)
+
+        self.logger.info(self.vapi.ppcli("show ipsec sa"))
+
+
 class TestIpsecEspAsync(TemplateIpsecEsp):
     """Ipsec ESP - Aysnc tests"""
 
@@ -823,6 +1027,94 @@ class TestIpsecEspAsync(TemplateIpsecEsp):
         self.p_async.sa.remove_vpp_config()
 
 
+class TestIpsecEspAsyncSteal(TemplateIpsecEsp):
+    """Ipsec ESP - Async work stealing tests"""
+
+    vpp_worker_count = 2
+    extra_vpp_statseg_config = "update-interval 0.05"
+
+    def sw_scheduler_stats(self):
+        # wait for the collector to refresh the per thread counters
+        self.sleep(0.2)
+        return {
+            name: self.statistics.get_counter("/crypto_sw_scheduler/" + name)[0]
+            for name in [
+                "frames",
+                "frames-stolen",
+                "steals",
+                "encrypt-depth",
+                "decrypt-depth",
+            ]
+        }
+
+    def send_both_ways(self, p, worker, count=NUM_PKTS):
+        rxs = self.send_and_expect(
+            self.pg1,
+            self.gen_pkts(
+                self.pg1, self.pg1.remote_ip4, p.remote_tun_if_host, count=count
+            ),
+            self.tun_if,
+            worker=worker,
+        )
+        for rx in rxs:
+            p.vpp_tun_sa.decrypt(rx[IP])
+        self.send_and_expect(
+            self.tun_if,
+            self.gen_encrypt_pkts(
+                p,
+                p.scapy_tun_sa,
+                self.tun_if,
+                p.remote_tun_if_host,
+                self.pg1.remote_ip4,
+                count=count,
+            ),
+            self.pg1,
+            worker=worker,
+        )
+
+    def test_steal(self):
+        """Workers without crypto have their frames stolen"""
+        p = self.params[socket.AF_INET]
+        self.vapi.ipsec_set_async_mode(async_enable=True)
+        self.vapi.crypto_sw_scheduler_set_worker(worker_index=0, crypto_enable=False)
+        before = self.sw_scheduler_stats()
+
+        # the first worker enqueues, only the other threads process
+        self.send_both_ways(p, worker=0)
+        after = self.sw_scheduler_stats()
+        self.logger.info(self.vapi.cli("show sw_scheduler workers"))
+
+        diff = {
+            name: [a - b for a, b in zip(after[name], before[name])]
+            for name in after
+        }
+        # thread 1 is the first worker
+        self.assertEqual(diff["frames"][1], 0)
+        self.assertGreater(sum(diff["frames"]), 0)
+        self.assertEqual(sum(diff["frames-stolen"]), sum(diff["frames"]))
+        self.assertGreater(sum(diff["steals"]), 0)
+        self.assertLessEqual(sum(diff["steals"]), sum(diff["frames-stolen"]))
+        # all was returned, nothing is left behind in the queues
+        self.assertEqual(after["encrypt-depth"][1], 0)
+        self.assertEqual(after["decrypt-depth"][1], 0)
+
+        # with its crypto back the worker processes its own frames, the
+        # others may still steal what it has not got to yet
+        self.vapi.crypto_sw_scheduler_set_worker(worker_index=0, crypto_enable=True)
+        self.send_both_ways(p, worker=0)
+        again = self.sw_scheduler_stats()
+        diff = {
+            name: [a - b for a, b in zip(again[name], after[name])]
+            for name in again
+        }
+        self.assertEqual(diff["frames-stolen"][1], 0)
+        self.assertEqual(
+            sum(diff["frames"]), diff["frames"][1] + sum(diff["frames-stolen"])
+        )
+
+        self.vapi.ipsec_set_async_mode(async_enable=False)
+
+
 class TestIpsecEspHandoff(
     TemplateIpsecEsp, IpsecTun6HandoffTests, IpsecTun4HandoffTests
 ):
@@ -16,6 +16,7 @@ from vpp_ip import INVALID_INDEX
 
  TestLB class defines Load Balancer test cases for:
   - IP4 to GRE4 encap on per-port vip case
+  - IP4 to GRE4 encap with sticky flows overflowing a full bucket
   - IP4 to GRE6 encap on per-port vip case
   - IP6 to GRE4 encap on per-port vip case
   - IP6 to GRE6 encap on per-port vip case
@@ -547,3 +548,48 @@ class TestLB(VppTestCase):
                 " type clusterip target_port 3307 del"
             )
             self.vapi.cli("test lb flowtable flush")
+
+    def getStickyAS(self, flows):
+        # one packet per flow, returns the AS each flow is sent to
+        pkts = [
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / self.getIPv4Flow(id)
+            / Raw(b"\xa5" * 64)
+            for id in flows
+        ]
+        rx = self.send_and_expect(self.pg0, pkts, self.pg1)
+        return {p[UDP].sport - 10000: p[IP].dst for p in rx}
+
+    def checkStickyOverflow(self, flows):
+        added = []
+        try:
+            self.vapi.cli("lb vip 90.0.0.0/8 encap gre4")
+            for asid in self.ass:
+                self.vapi.cli("lb as 90.0.0.0/8 10.0.0.%u" % (asid))
+                added.append(asid)
+            sticky = self.getStickyAS(flows)
+
+            # more ASes change the new flow table
+            for asid in range(len(self.ass), 2 * len(self.ass)):
+                self.vapi.cli("lb as 90.0.0.0/8 10.0.0.%u" % (asid))
+                added.append(asid)
+            self.assertEqual(sticky, self.getStickyAS(flows))
+        finally:
+            for asid in added:
+                self.vapi.cli("lb as 90.0.0.0/8 10.0.0.%u del" % (asid))
+            self.vapi.cli("lb vip 90.0.0.0/8 encap gre4 del")
+            self.vapi.cli("test lb flowtable flush")
+
+    def test_lb_ip4_gre4_sticky_overflow(self):
+        """Load Balancer IP4 GRE4 sticky flows overflowing a bucket"""
+        # With 2 sticky buckets of 4 entries, these 8 flows all hash to
+        # the same bucket (crc32c), so 4 of them only get an entry by
+        # overflowing into the other one. They must all keep their AS
+        # once the new flow table changes. Consecutive flows split 4/4
+        # and check the flows stored in the bucket they hash to.
+        try:
+            self.vapi.cli("lb conf buckets 2")
+            self.checkStickyOverflow(range(0, 8 * 33, 33))
+            self.checkStickyOverflow(range(8))
+        finally:
+            self.vapi.cli("lb conf buckets 1024")
@@ -14,6 +14,8 @@ from scapy.layers.inet import ICMP
 from framework import VppTestCase, VppTestRunner
 from vpp_ip import DpoProto
 from vpp_ip_route import VppIpRoute, VppRoutePath, FibPathProto
+from vpp_ip_route import VppIpMRoute, VppMRoutePath
+from vpp_papi import VppEnum
 from socket import AF_INET, AF_INET6, inet_pton
 from util import reassemble4
 
@@ -31,7 +33,7 @@ class TestMTU(VppTestCase):
     @classmethod
     def setUpClass(cls):
         super(TestMTU, cls).setUpClass()
-        cls.create_pg_interfaces(range(2))
+        cls.create_pg_interfaces(range(3))
         cls.interfaces = list(cls.pg_interfaces)
 
     @classmethod
@@ -155,6 +157,148 @@ class TestMTU(VppTestCase):
         # Reset MTU
         self.vapi.sw_interface_set_mtu(self.pg1.sw_if_index, [current_mtu, 0, 0, 0])
 
+    def test_ip4_path_mtu_cache(self):
+        """IP4 learnt path MTU cache"""
+
+        self.vapi.cli("set ip path-mtu cache size 1024")
+
+        p_ether = Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+        p_ip4 = IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+        p_payload = UDP(sport=1234, dport=1234) / self.payload(1500 - 20 - 8)
+
+        def too_big(mtu, src=self.pg1.local_ip4, flags="DF"):
+            return (
+                Ether(src=self.pg1.remote_mac, dst=self.pg1.local_mac)
+                / IP(src=self.pg1.remote_ip4, dst=self.pg1.local_ip4)
+                / ICMP(
+                    type="dest-unreach", code="fragmentation-needed", nexthopmtu=mtu
+                )
+                / IP(src=src, dst=self.pg1.remote_ip4, flags=flags, len=1500)
+                / UDP(sport=1234, dport=1234)
+            )
+
+        # messages quoting packets we did not send are ignored
+        self.send_and_assert_no_replies(
+            self.pg1, too_big(1000, src=self.pg0.remote_ip4)
+        )
+        self.send_and_assert_no_replies(self.pg1, too_big(1000, flags=0))
+        self.assertIn("0 valid entries", self.vapi.cli("show ip path-mtu cache"))
+
+        # the path to pg1's peer is 1000 bytes further along
+        self.send_and_assert_no_replies(self.pg1, too_big(1000))
+        self.assertIn("1 valid entries", self.vapi.cli("show ip path-mtu cache"))
+
+        # without DF packets are fragmented to the learnt MTU
+        p4 = p_ether / p_ip4 / p_payload
+        p4_reply = p_ip4 / p_payload
+        p4_reply.ttl -= 1
+        self.pg_enable_capture()
+        self.pg0.add_stream(p4 * 1)
+        self.pg_start()
+        rx = self.pg1.get_capture(2)
+        for p in rx:
+            self.assertLessEqual(len(p[IP]), 1000)
+        reass_pkt = reassemble4(rx)
+        self.assertEqual(bytes(reass_pkt[UDP]), bytes(p4_reply[UDP]))
+
+        # with DF set the sender is told the path MTU
+        p4[IP].flags = "DF"
+        rx = self.send_and_expect_some(self.pg0, p4 * 3, self.pg0)
+        for p in rx:
+            self.assertEqual(p[ICMP].type, 3)
+            self.assertEqual(p[ICMP].code, 4)
+            self.assertEqual(p[ICMP].nexthopmtu, 1000)
+
+        # tiny MTUs are raised to the minimum
+        self.send_and_assert_no_replies(self.pg1, too_big(100))
+        self.assertIn("mtu 552", self.vapi.cli("show ip path-mtu cache verbose"))
+
+        # once disabled the egress MTU applies again
+        self.vapi.cli("set ip path-mtu cache disable")
+        p4[IP].flags = 0
+        self.send_and_expect(self.pg0, p4 * 3, self.pg1)
+
+    def verify_fragments(self, rx, sent, mtu):
+        """Reassemble the fragments in rx per IP id, compare with sent"""
+        by_id = {}
+        for p in rx:
+            self.assertLessEqual(len(p[IP]), mtu)
+            by_id.setdefault(p[IP].id, []).append(p)
+        self.assertEqual(len(by_id), len(sent))
+        for frags, p in zip(by_id.values(), sent):
+            frags.sort(key=lambda f: f[IP].frag)
+            reass_pkt = reassemble4(frags)
+            self.assertEqual(bytes(reass_pkt[UDP]), bytes(p[UDP]))
+
+    def test_ip4_frag_chained(self):
+        """IP4 fragmentation of chained buffers"""
+
+        current_mtu = self.get_mtu(self.pg1.sw_if_index)
+        self.vapi.sw_interface_set_mtu(self.pg1.sw_if_index, [1500, 0, 0, 0])
+
+        #
+        # packets larger than a buffer arrive chained and are split
+        # without copying their payload; sizes straddle buffer boundaries
+        #
+        p_ether = Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+        p_ip4 = IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+        sent = []
+        n_frags = 0
+        for size in [1600, 2048, 2100, 4097, 6000, 9000]:
+            p_payload = UDP(sport=1234, dport=1234) / self.payload(size - 20 - 8)
+            sent.append(p_ether / p_ip4 / p_payload)
+            n_frags += (size - 20 + 1479) // 1480
+
+        self.pg_enable_capture()
+        self.pg0.add_stream(sent)
+        self.pg_start()
+        rx = self.pg1.get_capture(n_frags)
+        self.verify_fragments(rx, sent, 1500)
+
+        #
+        # replicated multicast packets share their payload buffers, so are
+        # fragmented by copying, leaving the other copy intact
+        #
+        MRouteItfFlags = VppEnum.vl_api_mfib_itf_flags_t
+        MRouteEntryFlags = VppEnum.vl_api_mfib_entry_flags_t
+        self.vapi.sw_interface_set_mtu(self.pg2.sw_if_index, [1500, 0, 0, 0])
+        route_232_1_1_1 = VppIpMRoute(
+            self,
+            "0.0.0.0",
+            "232.1.1.1",
+            32,
+            MRouteEntryFlags.MFIB_API_ENTRY_FLAG_NONE,
+            [
+                VppMRoutePath(
+                    self.pg0.sw_if_index, MRouteItfFlags.MFIB_API_ITF_FLAG_ACCEPT
+                ),
+                VppMRoutePath(
+                    self.pg1.sw_if_index, MRouteItfFlags.MFIB_API_ITF_FLAG_FORWARD
+                ),
+                VppMRoutePath(
+                    self.pg2.sw_if_index, MRouteItfFlags.MFIB_API_ITF_FLAG_FORWARD
+                ),
+            ],
+        )
+        route_232_1_1_1.add_vpp_config()
+
+        p_payload = UDP(sport=1234, dport=1234) / self.payload(6000 - 20 - 8)
+        p4 = (
+            Ether(src=self.pg0.remote_mac, dst="01:00:5e:01:01:01")
+            / IP(src=self.pg0.remote_ip4, dst="232.1.1.1")
+            / p_payload
+        )
+        self.pg_enable_capture()
+        self.pg0.add_stream(p4 * 3)
+        self.pg_start()
+        for itf in [self.pg1, self.pg2]:
+            rx = itf.get_capture(3 * 5)
+            self.verify_fragments(rx, [p4] * 3, 1500)
+
+        route_232_1_1_1.remove_vpp_config()
+        self.vapi.sw_interface_set_mtu(self.pg2.sw_if_index, [current_mtu, 0, 0, 0])
+        self.vapi.sw_interface_set_mtu(self.pg1.sw_if_index, [current_mtu, 0, 0, 0])
+
     def test_ip6_mtu(self):
         """IP6 MTU test"""
 
@@ -4,10 +4,14 @@ import unittest
 from io import BytesIO
 from random import randint, choice
 
+import ipaddress
 import re
+import socket
+import struct
 import scapy.compat
 from framework import tag_fixme_ubuntu2204, is_distro_ubuntu2204
 from framework import VppTestCase, VppTestRunner, VppLoInterface
+from ipfix import IPFIX, Set, Template, Data, IPFIXDecoder
 from scapy.data import IP_PROTOS
 from scapy.layers.inet import IP, TCP, UDP, ICMP, GRE
 from scapy.layers.inet import IPerror, TCPerror
@@ -19,6 +23,7 @@ from util import ppp, pr, ip4_range
 from vpp_acl import AclRule, VppAcl, VppAclInterface
 from vpp_ip_route import VppIpRoute, VppRoutePath
 from vpp_papi import VppEnum
+from vpp_papi_provider import CliFailedCommandError
 from util import StatsDiff
 
 
@@ -1120,6 +1125,103 @@ class TestNAT44ED(VppTestCase):
 
         self.pg0.get_capture(1)
 
+    def flow_offload_count(self):
+        out = self.vapi.cli("show nat44 flow-offload")
+        return int(re.search(r"(\d+) flows offloaded", out).group(1))
+
+    def test_flow_offload_config(self):
+        """NAT44ED flow offload configuration"""
+        self.vapi.cli("set nat44 flow-offload threshold 5 idle-timeout 30")
+        self.vapi.cli("nat44 flow-offload pg1")
+        out = self.vapi.cli("show nat44 flow-offload")
+        self.assertIn(self.pg1.name, out)
+        self.assertIn("threshold 5 packets, idle timeout 30 sec", out)
+
+        with self.assertRaises(CliFailedCommandError):
+            self.vapi.cli("nat44 flow-offload pg1")
+        with self.assertRaises(CliFailedCommandError):
+            self.vapi.cli("set nat44 flow-offload idle-timeout 0")
+
+        # interfaces which cannot program flows are refused
+        lo = VppLoInterface(self)
+        with self.assertRaises(CliFailedCommandError):
+            self.vapi.cli("nat44 flow-offload %s" % lo.name)
+        lo.remove_vpp_config()
+
+        self.vapi.cli("nat44 flow-offload pg1 del")
+        with self.assertRaises(CliFailedCommandError):
+            self.vapi.cli("nat44 flow-offload pg1 del")
+        self.assertNotIn(self.pg1.name, self.vapi.cli("show nat44 flow-offload"))
+        self.vapi.cli("set nat44 flow-offload threshold 1000 idle-timeout 10")
+
+    def test_flow_offload(self):
+        """NAT44ED offload the flows of big sessions"""
+        threshold = 5
+
+        self.nat_add_address(self.nat_addr)
+        self.nat_add_inside_interface(self.pg0)
+        self.nat_add_outside_interface(self.pg1)
+        self.vapi.cli("set nat44 flow-offload threshold %d" % threshold)
+        # pg0 emulates a NIC marking the packets of its flows, pg1 cannot
+        # program flows so its direction stays in software
+        self.vapi.cli("packet-generator flow-offload pg0")
+        self.vapi.cli("nat44 flow-offload pg0")
+        self.vapi.cli("nat44 flow-offload pg1")
+
+        in2out = (
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+            / UDP(sport=self.udp_port_in, dport=20)
+        )
+        capture = self.send_and_expect(self.pg0, in2out * (threshold - 1), self.pg1)
+        nat_port = capture[0][UDP].sport
+        out2in = (
+            Ether(dst=self.pg1.local_mac, src=self.pg1.remote_mac)
+            / IP(src=self.pg1.remote_ip4, dst=self.nat_addr)
+            / UDP(sport=20, dport=nat_port)
+        )
+
+        # below the threshold nothing is offloaded
+        self.sleep(1.5, "flow offload process")
+        self.assertEqual(self.flow_offload_count(), 0)
+
+        self.send_and_expect(self.pg0, in2out * 2, self.pg1)
+        self.send_and_expect(self.pg1, out2in, self.pg0)
+        self.sleep(1.5, "flow offload process")
+        self.assertEqual(self.flow_offload_count(), 1)
+        self.logger.info(self.vapi.cli("show flow entry"))
+
+        # marked and unmarked packets are translated the same
+        capture = self.send_and_expect(self.pg0, in2out * 2, self.pg1)
+        for p in capture:
+            self.assertEqual(p[IP].src, self.nat_addr)
+            self.assertEqual(p[UDP].sport, nat_port)
+            self.assert_packet_checksums_valid(p)
+        if not self.vpp_worker_count:
+            self.assertIn("lookup skipped", self.vapi.cli("show trace"))
+        capture = self.send_and_expect(self.pg1, out2in * 2, self.pg0)
+        for p in capture:
+            self.assertEqual(p[IP].dst, self.pg0.remote_ip4)
+            self.assertEqual(p[UDP].dport, self.udp_port_in)
+            self.assert_packet_checksums_valid(p)
+
+        # the flow goes away with its session, even once the NIC stopped
+        # accepting new ones
+        self.vapi.cli("packet-generator flow-offload pg0 disable")
+        self.vapi.nat44_del_session(
+            address=self.pg0.remote_ip4,
+            port=self.udp_port_in,
+            protocol=IP_PROTOS.udp,
+            flags=self.config_flags.NAT_IS_INSIDE,
+        )
+        self.sleep(1.5, "flow offload process")
+        self.assertEqual(self.flow_offload_count(), 0)
+        self.assertEqual(self.vapi.cli("show flow entry").strip(), "")
+
+        self.vapi.cli("nat44 flow-offload pg0 del")
+        self.vapi.cli("nat44 flow-offload pg1 del")
+        self.vapi.cli("set nat44 flow-offload threshold 1000")
+
     def test_users_dump(self):
         """NAT44ED API test - nat44_user_dump"""
 
@@ -2373,6 +2475,137 @@ class TestNAT44ED(VppTestCase):
                 % (p_sent[IP].src, p_recvd[IP].src, a),
             )
 
+    def test_port_block(self):
+        """NAT44ED port block reservation per subscriber"""
+
+        worker_count = self.vpp_worker_count or 1
+        port_offset = 1024
+        port_per_thread = (65536 - port_offset) // worker_count
+        block_size = 64
+        n_flows = 10
+
+        self.vapi.cli("set nat44 port-block-size %d" % block_size)
+        self.nat_add_address(self.nat_addr)
+        self.nat_add_inside_interface(self.pg0)
+        self.nat_add_outside_interface(self.pg1)
+
+        pkts = [
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+            / UDP(sport=7000 + i, dport=80)
+            for i in range(n_flows)
+        ]
+        capture = self.send_and_expect(self.pg0, pkts, self.pg1)
+
+        # all the subscriber's ports come from a single block
+        blocks = set(
+            ((p[UDP].sport - port_offset) % port_per_thread) // block_size
+            for p in capture
+        )
+        self.assertEqual(len(blocks), 1)
+        self.assertEqual(len(set(p[UDP].sport for p in capture)), n_flows)
+
+        out = self.vapi.cli("show nat44 addresses")
+        self.logger.info(out)
+        self.assertIn("udp %d/%d" % (n_flows, port_per_thread), out)
+        self.assertIn("blocks reserved 1/", out)
+
+    def test_ipfix_port_block(self):
+        """NAT44ED IPFIX logging of port blocks"""
+
+        worker_count = self.vpp_worker_count or 1
+        port_offset = 1024
+        port_per_thread = (65536 - port_offset) // worker_count
+        block_size = 64
+        n_flows = 5
+        subscribers = [h.ip4 for h in self.pg0.remote_hosts[:2]]
+
+        self.vapi.cli("set nat44 port-block-size %d" % block_size)
+        self.nat_add_address(self.nat_addr)
+        self.nat_add_inside_interface(self.pg0)
+        self.nat_add_outside_interface(self.pg1)
+        self.vapi.set_ipfix_exporter(
+            collector_address=self.pg3.remote_ip4,
+            src_address=self.pg3.local_ip4,
+            path_mtu=512,
+            template_interval=10,
+            collector_port=4739,
+        )
+        self.vapi.nat_ipfix_enable_disable(domain_id=1, src_port=4739, enable=1)
+
+        pkts = [
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / IP(src=src, dst=self.pg1.remote_ip4)
+            / UDP(sport=7000 + i, dport=80 + j)
+            for j, src in enumerate(subscribers)
+            for i in range(n_flows)
+        ]
+        capture = self.send_and_expect(self.pg0, pkts, self.pg1)
+        ports = {src: [] for src in subscribers}
+        for p in capture:
+            ports[subscribers[p[UDP].dport - 80]].append(p[UDP].sport)
+        threads = set((p[UDP].sport - port_offset) // port_per_thread for p in capture)
+
+        # removing the address releases the blocks, their sessions are not
+        # logged one by one
+        self.nat_add_address(self.nat_addr, is_add=0)
+        self.vapi.ipfix_flush()
+
+        block_fields = [
+            (323, 8),  # observationTimeMilliseconds
+            (230, 1),  # natEvent
+            (8, 4),  # sourceIPv4Address
+            (225, 4),  # postNATSourceIPv4Address
+            (361, 2),  # portRangeStart
+            (362, 2),  # portRangeEnd
+            (234, 4),  # ingressVRFID
+        ]
+
+        # a template per event type and a data set per worker
+        capture = self.pg3.get_capture(8 + len(threads))
+        ipfix = IPFIXDecoder()
+        template_id = None
+        for p in capture:
+            self.assertTrue(p.haslayer(IPFIX))
+            if p.haslayer(Template):
+                t = p.getlayer(Template)
+                ipfix.add_template(t)
+                fields = [
+                    (f.informationElement, f.fieldLength) for f in t.templateFields
+                ]
+                if (361, 2) in fields:
+                    template_id = t.templateID
+                    self.assertEqual(fields, block_fields)
+                    self.assertEqual(sum(f[1] for f in fields), 25)
+        self.assertIsNotNone(template_id)
+
+        events = []
+        for p in capture:
+            if p.haslayer(Data):
+                self.assertEqual(p[Set].setID, template_id)
+                for record in ipfix.decode_data_set(p.getlayer(Set)):
+                    src = str(ipaddress.IPv4Address(record[8]))
+                    start = struct.unpack("!H", record[361])[0]
+                    end = struct.unpack("!H", record[362])[0]
+                    events.append((scapy.compat.orb(record[230]), src, start, end))
+                    self.assertEqual(
+                        socket.inet_pton(socket.AF_INET, self.nat_addr), record[225]
+                    )
+                    self.assertEqual(struct.pack("!I", 0), record[234])
+
+        # one allocation and one de-allocation per subscriber's block
+        self.assertEqual(len(events), 2 * len(subscribers))
+        for src in subscribers:
+            blocks = [e for e in events if e[1] == src]
+            self.assertEqual(sorted(e[0] for e in blocks), [16, 17])
+            self.assertEqual(blocks[0][2:], blocks[1][2:])
+            start, end = blocks[0][2:]
+            self.assertEqual(end - start + 1, block_size)
+            for port in ports[src]:
+                self.assertTrue(start <= port <= end)
+
+        self.vapi.nat_ipfix_enable_disable(domain_id=1, src_port=4739, enable=0)
+
     def test_dynamic_edge_ports(self):
         """NAT44ED dynamic translation test: edge ports"""
 
@@ -2779,6 +3012,68 @@ class TestNAT44EDMW(TestNAT44ED):
             len(recvd_tcp_ports) + len(recvd_udp_ports) + len(recvd_icmp_ids),
         )
 
+    def test_session_sharing(self):
+        """NAT44ED out2in translated without handoff"""
+        n_pkts = 10
+        handoff = "/err/nat44-out2in-worker-handoff/do handoff"
+
+        self.nat_add_address(self.nat_addr)
+        self.nat_add_inside_interface(self.pg0)
+        self.nat_add_outside_interface(self.pg1)
+
+        # the second packet is translated by the owner's fast path, which
+        # lets the other workers use the session
+        p = (
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+            / UDP(sport=4321, dport=20)
+        )
+        capture = self.send_and_expect(self.pg0, p, self.pg1)
+        nat_port = capture[0][UDP].sport
+        self.send_and_expect(self.pg0, p, self.pg1)
+
+        p = (
+            Ether(dst=self.pg1.local_mac, src=self.pg1.remote_mac)
+            / IP(src=self.pg1.remote_ip4, dst=self.nat_addr)
+            / UDP(sport=20, dport=nat_port)
+        )
+
+        def send_on_all_workers():
+            for i in range(self.vpp_worker_count):
+                self.pg1.add_stream(p * n_pkts, worker=i)
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            capture = self.pg0.get_capture(n_pkts * self.vpp_worker_count)
+            for rx in capture:
+                self.assertEqual(rx[IP].dst, self.pg0.remote_ip4)
+                self.assertEqual(rx[UDP].dport, 4321)
+                self.assert_packet_checksums_valid(rx)
+
+        # sharing is off by default
+        h1 = self.get_err_counter(handoff)
+        send_on_all_workers()
+        h2 = self.get_err_counter(handoff)
+        self.assertEqual(h2 - h1, n_pkts * (self.vpp_worker_count - 1))
+
+        self.vapi.cli("set nat44 session-sharing enable")
+        send_on_all_workers()
+        h3 = self.get_err_counter(handoff)
+        self.assertEqual(h3 - h2, 0)
+
+        # once the session is gone no worker translates with a stale copy
+        self.vapi.nat44_del_session(
+            address=self.pg0.remote_ip4,
+            port=4321,
+            protocol=IP_PROTOS.udp,
+            flags=self.config_flags.NAT_IS_INSIDE,
+        )
+        for i in range(self.vpp_worker_count):
+            self.pg1.add_stream(p * n_pkts, worker=i)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+        self.pg0.assert_nothing_captured()
+        self.vapi.cli("set nat44 session-sharing disable")
+
     def test_frag_in_order(self):
         """NAT44ED translate fragments arriving in order"""
 
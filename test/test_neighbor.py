@@ -18,6 +18,7 @@ from vpp_ip_route import (
 )
 from vpp_papi import VppEnum
 from vpp_ip import VppIpPuntRedirect
+from vpp_sub_interface import VppDot1QSubint
 
 import scapy.compat
 from scapy.packet import Raw
@@ -1262,6 +1263,59 @@ class ARPTestCase(VppTestCase):
         self.pg1.admin_down()
         self.pg1.admin_up()
 
+    def test_arp_learn_repeats(self):
+        """ARP learning from repeated requests"""
+
+        #
+        # Generate some hosts on the LAN
+        #
+        self.pg1.generate_remote_hosts(16)
+
+        #
+        # each host asks for our address several times in the same burst;
+        # a host that changes its MAC half way through is learnt with
+        # the later one
+        #
+        pkts = []
+        for _ in range(4):
+            for h in self.pg1.remote_hosts:
+                pkts.append(
+                    Ether(dst="ff:ff:ff:ff:ff:ff", src=h.mac)
+                    / ARP(
+                        op="who-has",
+                        hwsrc=h.mac,
+                        pdst=self.pg1.local_ip4,
+                        psrc=h.ip4,
+                    )
+                )
+        pkts.append(
+            Ether(dst="ff:ff:ff:ff:ff:ff", src=self.pg1.remote_hosts[1].mac)
+            / ARP(
+                op="who-has",
+                hwsrc=self.pg1.remote_hosts[1].mac,
+                pdst=self.pg1.local_ip4,
+                psrc=self.pg1.remote_hosts[0].ip4,
+            )
+        )
+
+        self.send_and_expect(self.pg1, pkts, self.pg1)
+
+        for h in self.pg1.remote_hosts[1:]:
+            self.assertTrue(
+                find_nbr(self, self.pg1.sw_if_index, h.ip4, mac=h.mac)
+            )
+        self.assertTrue(
+            find_nbr(
+                self,
+                self.pg1.sw_if_index,
+                self.pg1.remote_hosts[0].ip4,
+                mac=self.pg1.remote_hosts[1].mac,
+            )
+        )
+
+        af = VppEnum.vl_api_address_family_t
+        self.vapi.ip_neighbor_flush(af.ADDRESS_IP4, self.pg1.sw_if_index)
+
     def test_arp_duplicates(self):
         """ARP Duplicates"""
 
@@ -2152,6 +2206,80 @@ class NeighborStatsTestCase(VppTestCase):
         rx = self.send_and_expect(self.pg0, p1 * NUM_PKTS, self.pg1)
         self.assertEqual(NUM_PKTS * 2, arp1.get_stats()["packets"])
 
+    def test_arp_stats_runs(self):
+        """ARP Counters with runs of mixed adjacencies"""
+
+        self.vapi.cli("adj counters enable")
+        self.pg1.generate_remote_hosts(2)
+
+        # two ethernet adjacencies and a dot1q one with a longer rewrite
+        sub = VppDot1QSubint(self, self.pg1, 10)
+        sub.admin_up()
+        sub.config_ip4()
+
+        nbrs = [
+            VppNeighbor(self, self.pg1.sw_if_index, h.mac, h.ip4)
+            for h in self.pg1.remote_hosts
+        ]
+        nbrs.append(
+            VppNeighbor(self, sub.sw_if_index, sub.remote_mac, sub.remote_ip4)
+        )
+        for n in nbrs:
+            n.add_vpp_config()
+        dsts = [h.ip4 for h in self.pg1.remote_hosts] + [sub.remote_ip4]
+        macs = [h.mac for h in self.pg1.remote_hosts] + [sub.remote_mac]
+
+        #
+        # runs long and short enough to take both the per adjacency run
+        # and the per packet paths of ip4-rewrite, with an expired TTL in
+        # the middle of a run
+        #
+        runs = [(0, 6), (1, 2), (0, 1), (2, 5), (1, 4), (0, 3), (2, 1)]
+        order = [nbr for nbr, n in runs for i in range(n)]
+        expired = 15
+        pkts = [
+            (
+                Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+                / IP(
+                    src=self.pg0.remote_ip4,
+                    dst=dsts[nbr],
+                    ttl=1 if i == expired else 64,
+                )
+                / UDP(sport=1234, dport=1234)
+                / Raw(b"\xa5" * (64 + i))
+            )
+            for i, nbr in enumerate(order)
+        ]
+        sent = list(zip(order, pkts))
+        del sent[expired]
+
+        rx = self.send_and_expect(self.pg0, pkts, self.pg1, n_rx=len(sent))
+
+        n_pkts = [0] * len(nbrs)
+        n_bytes = [0] * len(nbrs)
+        for (nbr, p), r in zip(sent, rx):
+            self.assertEqual(r[Ether].dst, macs[nbr])
+            self.assertEqual(r[Ether].src, self.pg1.local_mac)
+            if nbr == 2:
+                self.assertEqual(r[Dot1Q].vlan, 10)
+            else:
+                self.assertFalse(r.haslayer(Dot1Q))
+            self.assertEqual(r[IP].dst, p[IP].dst)
+            self.assertEqual(r[IP].ttl, 63)
+            self.assertEqual(r[Raw].load, p[Raw].load)
+            n_pkts[nbr] += 1
+            # ip4-rewrite counts the rewrite on top of the rewritten buffer
+            n_bytes[nbr] += len(r) + len(r) - len(r[IP])
+
+        for i, n in enumerate(nbrs):
+            stats = n.get_stats()
+            self.assertEqual(n_pkts[i], stats["packets"])
+            self.assertEqual(n_bytes[i], stats["bytes"])
+
+        nbrs[2].remove_vpp_config()
+        sub.unconfig_ip4()
+        sub.remove_vpp_config()
+
     def test_nd_stats(self):
         """ND Counters"""
 
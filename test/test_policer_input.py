@@ -259,6 +259,69 @@ class TestPolicerInput(VppTestCase):
         """Worker thread handoff policer output"""
         self.policer_handoff_test(Dir.TX)
 
+    def policer_distributed_test(self, dir: Dir):
+        pkts = self.pkt * NUM_PKTS
+
+        action_tx = PolicerAction(
+            VppEnum.vl_api_sse2_qos_action_type_t.SSE2_QOS_ACTION_API_TRANSMIT, 0
+        )
+        policer = VppPolicer(
+            self,
+            "pol3",
+            80,
+            0,
+            1000,
+            0,
+            conform_action=action_tx,
+            exceed_action=action_tx,
+            violate_action=action_tx,
+        )
+        policer.add_vpp_config()
+
+        sw_if_index = self.pg0.sw_if_index if dir == Dir.RX else self.pg1.sw_if_index
+
+        # Police on each worker rather than handing off
+        policer.distribute_vpp_config(True, quantum=200)
+
+        # Start policing on pg0
+        policer.apply_vpp_config(sw_if_index, dir, True)
+
+        for worker in [0, 1]:
+            self.send_and_expect(self.pg0, pkts, self.pg1, worker=worker)
+            self.logger.debug(self.vapi.cli("show trace max 100"))
+
+        stats = policer.get_stats()
+        stats0 = policer.get_stats(worker=0)
+        stats1 = policer.get_stats(worker=1)
+
+        # Both workers policed their own packets
+        self.assertEqual(
+            stats0["conform_packets"] + stats0["violate_packets"], NUM_PKTS
+        )
+        self.assertEqual(
+            stats1["conform_packets"] + stats1["violate_packets"], NUM_PKTS
+        )
+        self.assertEqual(stats["exceed_packets"], 0)
+
+        # From the one shared burst
+        self.assertGreater(stats["conform_packets"], 0)
+        self.assertGreater(stats["violate_packets"], 0)
+
+        self.logger.debug(self.vapi.cli("show policer"))
+
+        # Stop policing on pg0
+        policer.apply_vpp_config(sw_if_index, dir, False)
+        policer.distribute_vpp_config(False)
+
+        policer.remove_vpp_config()
+
+    def test_policer_distributed_input(self):
+        """Distributed policer input"""
+        self.policer_distributed_test(Dir.RX)
+
+    def test_policer_distributed_output(self):
+        """Distributed policer output"""
+        self.policer_distributed_test(Dir.TX)
 
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
@@ -93,6 +93,11 @@ class VppPolicer(VppObject):
             policer_index=self._policer_index, worker_index=worker, bind_enable=bind
         )
 
+    def distribute_vpp_config(self, enable, quantum=0):
+        self._test.vapi.policer_distribute(
+            policer_index=self._policer_index, quantum=quantum, enable=enable
+        )
+
     def apply_vpp_config(self, if_index, dir: Dir, apply):
         if dir == Dir.RX:
             self._test.vapi.policer_input_v2(